@@ -0,0 +1,242 @@
+// Load-time peephole optimizer implementation
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#include "bytecode_peephole.hpp"
+
+#include <cstring>
+
+namespace v4rtos
+{
+
+namespace
+{
+
+constexpr uint8_t FLAG_START = 0x01;   // An instruction starts here
+constexpr uint8_t FLAG_TARGET = 0x02;  // A branch lands here
+
+int32_t read_operand(const uint8_t* p, uint8_t bytes)
+{
+  switch (bytes)
+  {
+    case 1:
+      return static_cast<int8_t>(p[0]);
+    case 2:
+      return static_cast<int16_t>(p[0] | (p[1] << 8));
+    case 4:
+      return static_cast<int32_t>(static_cast<uint32_t>(p[0]) |
+                                  (static_cast<uint32_t>(p[1]) << 8) |
+                                  (static_cast<uint32_t>(p[2]) << 16) |
+                                  (static_cast<uint32_t>(p[3]) << 24));
+    default:
+      return 0;
+  }
+}
+
+void write_u16(uint8_t* p, uint16_t v)
+{
+  p[0] = static_cast<uint8_t>(v);
+  p[1] = static_cast<uint8_t>(v >> 8);
+}
+
+// Branch target in the same coordinate system as @p pos
+long branch_target(const uint8_t* operand, PeepholeBranch kind, size_t insn_end)
+{
+  int32_t v = read_operand(operand, 2);
+  if (kind == PeepholeBranch::REL16)
+  {
+    return static_cast<long>(insn_end) + v;
+  }
+  return static_cast<uint16_t>(v);
+}
+
+}  // namespace
+
+BytecodePeephole::BytecodePeephole(const PeepholeIsa& isa, size_t max_code)
+    : isa_(isa),
+      max_code_(max_code),
+      new_offset_(new uint16_t[max_code + 1]),
+      flags_(new uint8_t[max_code + 1]),
+      fixups_(new Fixup[max_code / 3 + 1]),
+      rule_hits_(new uint64_t[isa.rule_count]()),
+      rule_ok_(new bool[isa.rule_count])
+{
+  // The superinstruction must carry exactly the operand it takes over
+  for (size_t r = 0; r < isa.rule_count; r++)
+  {
+    const PeepholeRule& rule = isa.rules[r];
+    const PeepholeOp& out = isa.ops[rule.replacement];
+    bool ok = rule.length >= 2 && rule.length <= PeepholeRule::MAX_PATTERN &&
+              rule.operand_from < static_cast<int>(rule.length);
+    if (ok && rule.operand_from < 0)
+    {
+      ok = out.operand_bytes == 0;
+    }
+    else if (ok)
+    {
+      const PeepholeOp& src = isa.ops[rule.pattern[rule.operand_from].op];
+      ok = out.operand_bytes == src.operand_bytes && out.branch == src.branch;
+    }
+    rule_ok_[r] = ok;
+  }
+}
+
+bool BytecodePeephole::decode(const uint8_t* code, size_t len)
+{
+  memset(flags_.get(), 0, len + 1);
+
+  // Instruction boundaries
+  for (size_t pos = 0; pos < len; pos += insn_size(code[pos]))
+  {
+    if (pos + insn_size(code[pos]) > len)
+    {
+      return false;  // Truncated operand
+    }
+    flags_[pos] |= FLAG_START;
+  }
+  flags_[len] |= FLAG_START;  // Falling off the end is a valid target
+
+  // Branch targets must be instruction boundaries inside this payload
+  for (size_t pos = 0; pos < len; pos += insn_size(code[pos]))
+  {
+    const PeepholeOp& op = isa_.ops[code[pos]];
+    if (op.branch == PeepholeBranch::NONE)
+    {
+      continue;
+    }
+    if (op.operand_bytes != 2)
+    {
+      return false;  // Malformed ISA table
+    }
+    size_t end = pos + insn_size(code[pos]);
+    long target = branch_target(code + pos + 1, op.branch, end);
+    if (target < 0 || static_cast<size_t>(target) > len ||
+        !(flags_[target] & FLAG_START))
+    {
+      return false;
+    }
+    flags_[target] |= FLAG_TARGET;
+  }
+  return true;
+}
+
+bool BytecodePeephole::match(const PeepholeRule& rule, const uint8_t* code, size_t len,
+                             size_t pos, size_t* end) const
+{
+  for (size_t i = 0; i < rule.length; i++)
+  {
+    // Only the first instruction of a fused sequence may be a branch target
+    if (pos >= len || (i > 0 && (flags_[pos] & FLAG_TARGET)))
+    {
+      return false;
+    }
+    const PeepholeMatch& m = rule.pattern[i];
+    if (code[pos] != m.op)
+    {
+      return false;
+    }
+    if (m.match_value &&
+        read_operand(code + pos + 1, isa_.ops[m.op].operand_bytes) != m.value)
+    {
+      return false;
+    }
+    pos += insn_size(code[pos]);
+  }
+  *end = pos;
+  return true;
+}
+
+size_t BytecodePeephole::run(uint8_t* code, size_t len)
+{
+  stats_.runs++;
+  mapped_ = false;
+  if (len == 0 || len > max_code_ || len > 0xFFFF || !decode(code, len))
+  {
+    if (len > 0)
+    {
+      stats_.rejected++;
+    }
+    return len;
+  }
+
+  // Compact in place: the write position never passes the read position,
+  // and every instruction is read completely before it is overwritten
+  size_t w = 0;
+  size_t fixup_count = 0;
+  size_t pos = 0;
+  while (pos < len)
+  {
+    uint8_t out_op = code[pos];
+    size_t operand_at = pos + 1;
+    size_t next = pos + insn_size(code[pos]);
+
+    for (size_t r = 0; r < isa_.rule_count; r++)
+    {
+      const PeepholeRule& rule = isa_.rules[r];
+      size_t end = 0;
+      if (!rule_ok_[r] || !match(rule, code, len, pos, &end))
+      {
+        continue;
+      }
+      // Locate the operand source inside the matched sequence
+      operand_at = 0;
+      size_t p = pos;
+      for (int i = 0; i < rule.length; i++)
+      {
+        if (i == rule.operand_from)
+        {
+          operand_at = p + 1;
+        }
+        new_offset_[p] = static_cast<uint16_t>(w);
+        p += insn_size(code[p]);
+      }
+      out_op = rule.replacement;
+      next = end;
+      rule_hits_[r]++;
+      stats_.fused++;
+      break;
+    }
+
+    const PeepholeOp& op = isa_.ops[out_op];
+    size_t insn_end = w + 1 + op.operand_bytes;
+    if (op.branch != PeepholeBranch::NONE)
+    {
+      // Old target, computed from the source instruction's own end
+      size_t src_end = operand_at + op.operand_bytes;
+      long target = branch_target(code + operand_at, op.branch, src_end);
+      fixups_[fixup_count++] = Fixup{static_cast<uint16_t>(w + 1),
+                                     static_cast<uint16_t>(insn_end),
+                                     static_cast<uint16_t>(target), op.branch};
+    }
+
+    new_offset_[pos] = static_cast<uint16_t>(w);
+    uint8_t operand[4];
+    memcpy(operand, code + operand_at, op.operand_bytes);
+    code[w] = out_op;
+    memcpy(code + w + 1, operand, op.operand_bytes);
+    w = insn_end;
+    pos = next;
+  }
+  new_offset_[len] = static_cast<uint16_t>(w);
+  mapped_ = true;
+
+  for (size_t i = 0; i < fixup_count; i++)
+  {
+    const Fixup& f = fixups_[i];
+    uint16_t target = new_offset_[f.old_target];
+    uint16_t value = f.kind == PeepholeBranch::REL16
+                         ? static_cast<uint16_t>(target - f.insn_end)
+                         : target;
+    write_u16(code + f.operand_pos, value);
+  }
+
+  stats_.bytes_saved += len - w;
+  return w;
+}
+
+size_t BytecodePeephole::filter(void* user, uint8_t* code, size_t len)
+{
+  return static_cast<BytecodePeephole*>(user)->run(code, len);
+}
+
+}  // namespace v4rtos
@@ -0,0 +1,174 @@
+// Load-time peephole optimizer for uploaded bytecode
+//
+// Fuses common instruction sequences into superinstructions before an
+// EXEC payload reaches V4-link and the VM arena. The pass knows nothing
+// about a particular instruction set: operand sizes, branch encodings and
+// fusion rules come from a PeepholeIsa table, so the same code serves
+// V4-engine and the host reference VM in bsp/posix/bench.
+//
+// Branches are re-targeted after fusion. A sequence is never fused if a
+// branch lands inside it, and code whose branches cannot be resolved is
+// left untouched.
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace v4rtos
+{
+
+/** How an opcode's operand encodes a branch target */
+enum class PeepholeBranch : uint8_t
+{
+  NONE,   ///< Not a branch
+  REL16,  ///< int16 LE, relative to the end of the instruction
+  ABS16   ///< uint16 LE, offset from the start of the code
+};
+
+/** Static description of one opcode */
+struct PeepholeOp
+{
+  uint8_t operand_bytes;  ///< Inline operand size (0, 1, 2 or 4)
+  PeepholeBranch branch;  ///< Branch encoding of the operand
+};
+
+/** One instruction of a rule pattern */
+struct PeepholeMatch
+{
+  uint8_t op;        ///< Opcode
+  bool match_value;  ///< Also require the operand to equal @p value
+  int32_t value;     ///< Required operand (sign-extended)
+};
+
+/**
+ * @brief Fusion rule: pattern -> superinstruction
+ *
+ * The superinstruction takes the operand of pattern[operand_from] (same
+ * size and branch encoding), or no operand if operand_from is -1. Rules
+ * that break this are ignored.
+ */
+struct PeepholeRule
+{
+  static constexpr size_t MAX_PATTERN = 6;
+
+  const char* name;                    ///< For statistics and logs
+  PeepholeMatch pattern[MAX_PATTERN];  ///< Instructions to match
+  uint8_t length;                      ///< Pattern length (2..MAX_PATTERN)
+  uint8_t replacement;                 ///< Superinstruction opcode
+  int8_t operand_from;                 ///< Pattern index supplying the operand
+};
+
+/** Instruction set description */
+struct PeepholeIsa
+{
+  const PeepholeOp* ops;      ///< 256 entries, indexed by opcode
+  const PeepholeRule* rules;  ///< Rules, tried in order
+  size_t rule_count;          ///< Number of rules
+};
+
+/**
+ * @brief Peephole pass with preallocated scratch space
+ */
+class BytecodePeephole
+{
+ public:
+  /** Pass counters */
+  struct Stats
+  {
+    uint64_t runs;         ///< Payloads processed
+    uint64_t rejected;     ///< Payloads left untouched (undecodable)
+    uint64_t fused;        ///< Superinstructions emitted
+    uint64_t bytes_saved;  ///< Bytes removed
+  };
+
+  /**
+   * @brief Construct pass
+   * @param isa Instruction set (must outlive the pass)
+   * @param max_code Largest payload that will be optimized (bytes)
+   */
+  BytecodePeephole(const PeepholeIsa& isa, size_t max_code);
+
+  /**
+   * @brief Optimize code in place
+   *
+   * @param code Bytecode, rewritten in place
+   * @param len Code length
+   * @return New length (== @p len if nothing was fused or the code was
+   *         rejected)
+   */
+  size_t run(uint8_t* code, size_t len);
+
+  /**
+   * @brief Map an offset in the last run()'s input to the optimized code
+   *
+   * Needed for entry points that are not at offset 0.
+   */
+  size_t remap(size_t offset) const
+  {
+    return mapped_ ? new_offset_[offset] : offset;
+  }
+
+  /**
+   * @brief Link port EXEC filter adapter (@p user is the pass)
+   */
+  static size_t filter(void* user, uint8_t* code, size_t len);
+
+  /**
+   * @brief Get pass counters
+   */
+  const Stats& stats() const
+  {
+    return stats_;
+  }
+
+  /**
+   * @brief Get number of times a rule fired
+   */
+  uint64_t rule_hits(size_t rule) const
+  {
+    return rule_hits_[rule];
+  }
+
+ private:
+  /** Branch operand to re-target once all instructions have moved */
+  struct Fixup
+  {
+    uint16_t operand_pos;  ///< New operand offset
+    uint16_t insn_end;     ///< New end of the branch instruction
+    uint16_t old_target;   ///< Target in the original code
+    PeepholeBranch kind;   ///< Encoding
+  };
+
+  bool decode(const uint8_t* code, size_t len);
+  bool match(const PeepholeRule& rule, const uint8_t* code, size_t len, size_t pos,
+             size_t* end) const;
+  size_t insn_size(uint8_t op) const
+  {
+    return 1 + isa_.ops[op].operand_bytes;
+  }
+
+  const PeepholeIsa& isa_;                  ///< Instruction set
+  size_t max_code_;                         ///< Scratch capacity
+  std::unique_ptr<uint16_t[]> new_offset_;  ///< Old offset -> new offset
+  std::unique_ptr<uint8_t[]> flags_;        ///< Per-byte START/TARGET flags
+  std::unique_ptr<Fixup[]> fixups_;         ///< Pending branch fixups
+  std::unique_ptr<uint64_t[]> rule_hits_;   ///< Hits per rule
+  std::unique_ptr<bool[]> rule_ok_;         ///< Rule is well-formed
+  bool mapped_ = false;                     ///< new_offset_ is valid
+  Stats stats_ = {};                        ///< Counters
+};
+
+}  // namespace v4rtos
+
+/**
+ * @brief Instruction set of the linked V4-engine
+ *
+ * Exported by V4-engine builds with V4_SUPERINSTRUCTIONS (opcode operand
+ * layout, superinstruction handlers and their fusion rules). Only
+ * referenced by runtimes built with V4_PEEPHOLE.
+ */
+extern "C" const v4rtos::PeepholeIsa* v4_peephole_isa(void);
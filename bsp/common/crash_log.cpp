@@ -0,0 +1,139 @@
+// Persistent VM crash log implementation
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#include "crash_log.hpp"
+
+#include <cstring>
+
+#include "crc32.hpp"
+#include "link_runtime_commands.hpp"
+
+namespace v4rtos
+{
+
+const char* panic_policy_name(PanicPolicy policy)
+{
+  switch (policy)
+  {
+    case PanicPolicy::HALT:
+      return "halt";
+    case PanicPolicy::RESET_VM:
+      return "reset-vm";
+    case PanicPolicy::RESTART_TASK:
+      return "restart-task";
+    case PanicPolicy::REBOOT:
+      return "reboot";
+  }
+  return "?";
+}
+
+CrashLog::CrashLog(Storage* storage, PanicPolicy policy)
+    : storage_(storage), policy_(policy), restored_(false)
+{
+  uint32_t crc =
+      crc32(reinterpret_cast<const uint8_t*>(storage_), offsetof(Storage, crc));
+  restored_ = storage_->magic == STORAGE_MAGIC && storage_->crc == crc;
+  if (!restored_)
+  {
+    reset_storage();
+  }
+  storage_->boots++;
+  seal();
+}
+
+void CrashLog::reset_storage()
+{
+  memset(storage_, 0, sizeof(Storage));
+  storage_->magic = STORAGE_MAGIC;
+}
+
+void CrashLog::seal()
+{
+  storage_->crc =
+      crc32(reinterpret_cast<const uint8_t*>(storage_), offsetof(Storage, crc));
+}
+
+void CrashLog::record(const Entry& entry)
+{
+  Entry& slot = storage_->entries[storage_->panics % MAX_ENTRIES];
+  slot = entry;
+  slot.seq = storage_->panics;
+  slot.boot = storage_->boots;
+  storage_->panics++;
+  seal();
+}
+
+void CrashLog::clear()
+{
+  uint32_t boots = storage_->boots;
+  reset_storage();
+  storage_->boots = boots;
+  seal();
+}
+
+size_t CrashLog::count() const
+{
+  return storage_->panics < MAX_ENTRIES ? storage_->panics : MAX_ENTRIES;
+}
+
+const CrashLog::Entry& CrashLog::entry(size_t i) const
+{
+  return storage_->entries[(storage_->panics - 1 - i) % MAX_ENTRIES];
+}
+
+void CrashLog::handle_command(void* user, const LinkFrameView& frame, LinkReply* reply)
+{
+  CrashLog* self = static_cast<CrashLog*>(user);
+  if (frame.len < 1)
+  {
+    reply->status = link_wire::STATUS_ERROR;
+    return;
+  }
+
+  switch (frame.payload[0])
+  {
+    case OP_READ:
+      reply->put_u32(self->boots());
+      reply->put_u32(self->panics());
+      reply->put_u8(static_cast<uint8_t>(self->policy_));
+      reply->put_u8(static_cast<uint8_t>(self->count()));
+      for (size_t i = 0; i < self->count(); i++)
+      {
+        const Entry& e = self->entry(i);
+        reply->put_u32(e.seq);
+        reply->put_u32(e.boot);
+        reply->put_u32(e.uptime_ms);
+        reply->put_u32(static_cast<uint32_t>(e.error));
+        reply->put_u32(e.pc);
+        reply->put_u8(e.task_id);
+        reply->put_u8(e.vm_id);
+        reply->put_u8(e.action);
+        reply->put_u16(static_cast<uint16_t>(e.ds_depth));
+        reply->put_u16(static_cast<uint16_t>(e.rs_depth));
+        reply->put_u8(e.stack_count);
+        for (size_t k = 0; k < STACK_CELLS; k++)
+        {
+          reply->put_u32(static_cast<uint32_t>(e.stack[k]));
+        }
+      }
+      break;
+    case OP_CLEAR:
+      self->clear();
+      break;
+    case OP_POLICY:
+      if (frame.len < 2 || frame.payload[1] >= PANIC_POLICY_COUNT)
+      {
+        reply->status = link_wire::STATUS_ERROR;
+        break;
+      }
+      self->policy_ = static_cast<PanicPolicy>(frame.payload[1]);
+      reply->put_u8(frame.payload[1]);
+      break;
+    default:
+      reply->status = link_wire::STATUS_ERROR;
+      break;
+  }
+}
+
+}  // namespace v4rtos
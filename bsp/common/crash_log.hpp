@@ -0,0 +1,171 @@
+// Persistent VM crash log and panic recovery policy
+//
+// Keeps the last few VM panics (error code, PC, task, stack snapshot) in
+// memory that survives a reset: RTC no-init RAM on the ESP32-C6, a shared
+// file mapping on POSIX. The BSP places the Storage block; a CRC tells a
+// log left by the previous boot apart from power-on garbage. The host
+// reads it with CMD_CRASH_LOG, which also selects the PanicPolicy the
+// panic handlers apply.
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "link_frame_scanner.hpp"
+
+namespace v4rtos
+{
+
+struct LinkReply;
+
+/** What the panic handler does after recording a VM panic */
+enum class PanicPolicy : uint8_t
+{
+  HALT = 0,          ///< Stop the device (LED blinks) until reset
+  RESET_VM = 1,      ///< Recreate only the faulting VM
+  RESTART_TASK = 2,  ///< Restart only the faulting task (needs V4-engine support)
+  REBOOT = 3         ///< Reset the device (POSIX: exit)
+};
+
+/** Number of PanicPolicy values */
+constexpr uint8_t PANIC_POLICY_COUNT = 4;
+
+/**
+ * @brief Get printable policy name
+ */
+const char* panic_policy_name(PanicPolicy policy);
+
+/**
+ * @brief Crash log over reset-surviving storage
+ *
+ * record() runs inside the panic handler and does no allocation or I/O.
+ * Not locked: the link task reads while the VM it runs is stopped.
+ */
+class CrashLog
+{
+ public:
+  static constexpr size_t MAX_ENTRIES = 4;  ///< Panics kept (oldest dropped)
+  static constexpr size_t STACK_CELLS = 4;  ///< Data stack cells kept per panic
+  static constexpr uint8_t NO_VM = 0xFF;    ///< Entry::vm_id outside a VM pool
+
+  /** CMD_CRASH_LOG request operations (first payload byte) */
+  enum Op : uint8_t
+  {
+    OP_READ = 0,   ///< Counters and entries, newest first
+    OP_CLEAR = 1,  ///< Drop all entries (boot count is kept)
+    OP_POLICY = 2  ///< Set the panic policy: [policy u8]
+  };
+
+  /** One recorded panic */
+  struct Entry
+  {
+    uint32_t seq;                ///< Panic number since the log was cleared
+    uint32_t boot;               ///< Boot count at the time of the panic
+    uint32_t uptime_ms;          ///< Time since boot
+    int32_t error;               ///< V4 error code
+    uint32_t pc;                 ///< Faulting instruction address
+    uint8_t task_id;             ///< Faulting V4 task
+    uint8_t vm_id;               ///< VM pool index (NO_VM: none)
+    uint8_t action;              ///< PanicPolicy applied
+    uint8_t stack_count;         ///< Valid cells in @p stack
+    int16_t ds_depth;            ///< Data stack depth
+    int16_t rs_depth;            ///< Return stack depth
+    int32_t stack[STACK_CELLS];  ///< Top of the data stack, top first
+  };
+
+  /** Reset-surviving block; the BSP decides where it lives */
+  struct Storage
+  {
+    uint32_t magic;                ///< STORAGE_MAGIC once initialized
+    uint32_t boots;                ///< Boots since the log was created
+    uint32_t panics;               ///< Panics since the last clear
+    Entry entries[MAX_ENTRIES];    ///< Ring, indexed by seq % MAX_ENTRIES
+    uint32_t crc;                  ///< CRC-32 of everything above
+  };
+
+  /**
+   * @brief Attach to storage and count one boot
+   *
+   * Storage with a bad magic or CRC is reset to an empty log.
+   *
+   * @param storage Reset-surviving block
+   * @param policy Initial panic policy
+   */
+  CrashLog(Storage* storage, PanicPolicy policy);
+
+  CrashLog(const CrashLog&) = delete;
+  CrashLog& operator=(const CrashLog&) = delete;
+
+  /**
+   * @brief Store a panic
+   *
+   * seq and boot are filled in here.
+   */
+  void record(const Entry& entry);
+
+  /**
+   * @brief Drop all entries
+   */
+  void clear();
+
+  /** true if the storage held a valid log at boot */
+  bool restored() const
+  {
+    return restored_;
+  }
+
+  /** Boots since the log was created */
+  uint32_t boots() const
+  {
+    return storage_->boots;
+  }
+
+  /** Panics since the last clear */
+  uint32_t panics() const
+  {
+    return storage_->panics;
+  }
+
+  /** Number of entries held */
+  size_t count() const;
+
+  /**
+   * @brief Get an entry
+   * @param i 0 for the newest, up to count() - 1
+   */
+  const Entry& entry(size_t i) const;
+
+  /** Current panic policy */
+  PanicPolicy policy() const
+  {
+    return policy_;
+  }
+
+  /** Change the panic policy */
+  void set_policy(PanicPolicy policy)
+  {
+    policy_ = policy;
+  }
+
+  /**
+   * @brief Answer a CMD_CRASH_LOG request
+   *
+   * RuntimeCmdHandler signature; @p user is the CrashLog.
+   */
+  static void handle_command(void* user, const LinkFrameView& frame, LinkReply* reply);
+
+ private:
+  static constexpr uint32_t STORAGE_MAGIC = 0x56344352;  // "V4CR"
+
+  void seal();
+  void reset_storage();
+
+  Storage* storage_;     ///< Reset-surviving block
+  PanicPolicy policy_;   ///< Applied by the panic handlers
+  bool restored_;        ///< Valid log found at boot
+};
+
+}  // namespace v4rtos
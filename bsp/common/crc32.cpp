@@ -0,0 +1,46 @@
+// CRC-32 (IEEE 802.3) implementation
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#include "crc32.hpp"
+
+namespace v4rtos
+{
+
+namespace
+{
+
+// CRC-32 lookup table (reflected poly 0xEDB88320), generated at compile time
+struct Crc32Table
+{
+  uint32_t v[256];
+
+  constexpr Crc32Table() : v()
+  {
+    for (uint32_t i = 0; i < 256; i++)
+    {
+      uint32_t crc = i;
+      for (int bit = 0; bit < 8; bit++)
+      {
+        crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+      }
+      v[i] = crc;
+    }
+  }
+};
+
+constexpr Crc32Table CRC32_TABLE{};
+
+}  // namespace
+
+uint32_t crc32(const uint8_t* data, size_t len, uint32_t crc)
+{
+  crc = ~crc;
+  for (size_t i = 0; i < len; i++)
+  {
+    crc = CRC32_TABLE.v[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+}  // namespace v4rtos
@@ -0,0 +1,29 @@
+// CRC-32 (IEEE 802.3)
+//
+// Reflected polynomial 0xEDB88320, initial value and final XOR 0xFFFFFFFF,
+// i.e. the zlib/PNG/Ethernet CRC. Used for records that must be told
+// apart from leftover RAM or flash contents.
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace v4rtos
+{
+
+/**
+ * @brief Compute CRC-32 over a buffer, table driven
+ *
+ * Pass the previous result as @p crc to continue over several buffers.
+ *
+ * @param data Input bytes
+ * @param len Number of bytes
+ * @param crc Running CRC (0 to start)
+ * @return Updated CRC
+ */
+uint32_t crc32(const uint8_t* data, size_t len, uint32_t crc = 0);
+
+}  // namespace v4rtos
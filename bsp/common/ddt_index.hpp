@@ -0,0 +1,165 @@
+// Constant-time Device Descriptor Table lookup
+//
+// A board lists its devices once (boards/<board>/board_devices.def, from
+// the pin macros of board.h) in a constexpr descriptor array. DdtIndex
+// hashes the (kind, role, index) key of every descriptor into an
+// open-addressing table that the compiler builds, so finding a device is
+// one hash and, for a table without collisions, one compare: no virtual
+// DdtProvider call and no scan over the array, however many devices the
+// board has.
+//
+// The descriptor type is a template parameter (v4dev_desc_t on the boards)
+// with uint8_t kind, role and index members.
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace v4rtos
+{
+
+/**
+ * @brief Lookup key of a device
+ */
+constexpr uint32_t ddt_key(uint8_t kind, uint8_t role, uint8_t index)
+{
+  return ((uint32_t)kind << 16) | ((uint32_t)role << 8) | index;
+}
+
+/**
+ * @brief log2 of the hash slots for @p n devices (at least 2 * @p n slots)
+ */
+constexpr uint32_t ddt_slot_bits(size_t n)
+{
+  uint32_t bits = 1;
+  while (((size_t)1 << bits) < 2 * n)
+  {
+    bits++;
+  }
+  return bits;
+}
+
+/**
+ * @brief Hash table over a constant descriptor array
+ *
+ * @tparam Desc Descriptor type
+ * @tparam N    Number of descriptors (at most 254)
+ */
+template <class Desc, size_t N>
+class DdtIndex
+{
+ public:
+  static_assert(N > 0 && N < 255, "DdtIndex: 1 to 254 descriptors");
+
+  static constexpr uint32_t SLOT_BITS = ddt_slot_bits(N);  ///< log2(SLOTS)
+  static constexpr size_t SLOTS = (size_t)1 << SLOT_BITS;   ///< Hash slots
+
+  constexpr explicit DdtIndex(const Desc (&devices)[N])
+      : devices_(devices), slots_{}, max_probe_(0), valid_(true)
+  {
+    for (uint8_t& slot : slots_)
+    {
+      slot = EMPTY;
+    }
+    for (size_t i = 0; i < N; i++)
+    {
+      uint32_t key = key_of(devices[i]);
+      size_t s = home(key);
+      size_t probe = 0;
+      while (slots_[s] != EMPTY)
+      {
+        if (key_of(devices[slots_[s]]) == key)
+        {
+          valid_ = false;  // Listed twice; the first one wins
+          break;
+        }
+        s = (s + 1) & (SLOTS - 1);
+        probe++;
+      }
+      if (slots_[s] == EMPTY)
+      {
+        slots_[s] = (uint8_t)i;
+        max_probe_ = probe > max_probe_ ? (uint8_t)probe : max_probe_;
+      }
+    }
+  }
+
+  /**
+   * @brief Find a device
+   * @return Descriptor, or nullptr if the board has no such device
+   */
+  constexpr const Desc* find(uint8_t kind, uint8_t role, uint8_t index) const
+  {
+    uint32_t key = ddt_key(kind, role, index);
+    size_t s = home(key);
+    for (size_t probe = 0; probe <= max_probe_; probe++)
+    {
+      uint8_t i = slots_[s];
+      if (i == EMPTY)
+      {
+        return nullptr;
+      }
+      if (key_of(devices_[i]) == key)
+      {
+        return &devices_[i];
+      }
+      s = (s + 1) & (SLOTS - 1);
+    }
+    return nullptr;
+  }
+
+  /** No (kind, role, index) is listed twice */
+  constexpr bool valid() const
+  {
+    return valid_;
+  }
+
+  /** Longest probe sequence past the home slot (0: no collisions) */
+  constexpr size_t max_probe() const
+  {
+    return max_probe_;
+  }
+
+  constexpr const Desc* data() const
+  {
+    return devices_;
+  }
+
+  constexpr size_t size() const
+  {
+    return N;
+  }
+
+ private:
+  static constexpr uint8_t EMPTY = 0xFF;
+
+  static constexpr uint32_t key_of(const Desc& desc)
+  {
+    return ddt_key(desc.kind, desc.role, desc.index);
+  }
+
+  // Fibonacci hashing: the top SLOT_BITS bits of key * 2^32 / phi
+  static constexpr size_t home(uint32_t key)
+  {
+    return (size_t)((uint32_t)(key * 2654435769u) >> (32 - SLOT_BITS));
+  }
+
+  const Desc* devices_;   ///< Descriptor array
+  uint8_t slots_[SLOTS];  ///< Descriptor number per slot (EMPTY: free)
+  uint8_t max_probe_;     ///< Longest probe sequence
+  bool valid_;            ///< No duplicate keys
+};
+
+/**
+ * @brief Index a constexpr descriptor array (deduces its size)
+ */
+template <class Desc, size_t N>
+constexpr DdtIndex<Desc, N> make_ddt_index(const Desc (&devices)[N])
+{
+  return DdtIndex<Desc, N>(devices);
+}
+
+}  // namespace v4rtos
@@ -0,0 +1,104 @@
+// Deferred-format binary log implementation
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#include "deferred_log.hpp"
+
+#include "link_runtime_commands.hpp"
+
+namespace v4rtos
+{
+
+namespace
+{
+
+DeferredLog* g_log = nullptr;
+
+constexpr size_t READ_HEADER_SIZE = 5;     // [more u8][dropped u32]
+constexpr size_t RECORD_HEADER_SIZE = 10;  // [time u32][id u32][level u8][nargs u8]
+constexpr size_t MAX_RECORD_SIZE = RECORD_HEADER_SIZE + 4 * LogRecord::MAX_ARGS;
+
+}  // namespace
+
+DeferredLog::DeferredLog(Clock clock, size_t records, uint8_t level)
+    : clock_(clock), level_(level), ring_(records)
+{
+}
+
+void DeferredLog::encode_records(LinkReply* reply)
+{
+  if (reply->cap - reply->len < READ_HEADER_SIZE)
+  {
+    reply->status = link_wire::STATUS_ERROR;
+    return;
+  }
+  uint8_t* more = reply->data + reply->len;
+  reply->put_u8(0);
+  reply->put_u32(ring_.dropped());
+
+  // Records are variable-sized on the wire: only pop one that surely fits
+  LogRecord rec;
+  while (reply->cap - reply->len >= MAX_RECORD_SIZE && ring_.pop(&rec))
+  {
+    reply->put_u32(rec.time);
+    reply->put_u32(rec.id);
+    reply->put_u8(rec.level);
+    reply->put_u8(rec.nargs);
+    for (size_t i = 0; i < rec.nargs; i++)
+    {
+      reply->put_u32(rec.args[i]);
+    }
+  }
+  *more = reply->cap - reply->len < MAX_RECORD_SIZE && ring_.pending() > 0 ? 1 : 0;
+}
+
+void DeferredLog::handle_command(void* user, const LinkFrameView& frame,
+                                 LinkReply* reply)
+{
+  DeferredLog* self = static_cast<DeferredLog*>(user);
+  if (frame.len < 1)
+  {
+    reply->status = link_wire::STATUS_ERROR;
+    return;
+  }
+
+  switch (frame.payload[0])
+  {
+    case OP_INFO:
+      reply->put_u16(static_cast<uint16_t>(self->ring_.capacity()));
+      reply->put_u16(static_cast<uint16_t>(self->ring_.pending()));
+      reply->put_u32(self->ring_.dropped());
+      reply->put_u8(self->level_.load(std::memory_order_relaxed));
+      break;
+    case OP_READ:
+      self->encode_records(reply);
+      break;
+    case OP_LEVEL:
+      if (frame.len < 2 || frame.payload[1] > LOG_DEBUG)
+      {
+        reply->status = link_wire::STATUS_ERROR;
+        break;
+      }
+      self->set_level(frame.payload[1]);
+      reply->put_u8(self->level_.load(std::memory_order_relaxed));
+      break;
+    default:
+      reply->status = link_wire::STATUS_ERROR;
+      break;
+  }
+}
+
+void dlog_install(DeferredLog* log)
+{
+  g_log = log;
+}
+
+void dlog_write(uint8_t level, uint32_t id, size_t nargs, const uint32_t* args)
+{
+  if (g_log != nullptr)
+  {
+    g_log->write(level, id, nargs, args);
+  }
+}
+
+}  // namespace v4rtos
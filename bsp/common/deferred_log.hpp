@@ -0,0 +1,269 @@
+// Deferred-format binary log
+//
+// A log call stores a 32-bit message ID and its raw integer arguments
+// instead of a formatted line. The ID is a hash of the tag and format
+// string that the compiler computes, so neither string ends up in flash;
+// scripts/v4log.py extracts the same table from the sources at build time
+// and formats the records on the host. Records go into a lock-free ring
+// (MpscRing) that the link task drains with CMD_LOG, so a log call costs a
+// timestamp and a few stores, and log output no longer shares the console
+// with V4-link frames.
+//
+// Formats take integer conversions only (%d %i %u %x %X %o %c with flags,
+// width, precision and length modifiers, up to LogRecord::MAX_ARGS of
+// them) and must be plain string literals so that the extractor sees the
+// same bytes as the compiler. %s, %p, floating point, '*' widths and a
+// mismatched argument count are compile errors; tags must be constexpr
+// character arrays.
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "link_frame_scanner.hpp"
+#include "mpsc_ring.hpp"
+
+namespace v4rtos
+{
+
+struct LinkReply;
+
+/** Log levels (same values as esp_log_level_t) */
+enum LogLevel : uint8_t
+{
+  LOG_NONE = 0,
+  LOG_ERROR = 1,
+  LOG_WARN = 2,
+  LOG_INFO = 3,
+  LOG_DEBUG = 4
+};
+
+/**
+ * @brief Message ID: FNV-1a over the tag, a NUL and the format
+ */
+constexpr uint32_t dlog_id(const char* tag, const char* fmt)
+{
+  uint32_t h = 2166136261u;
+  for (const char* p = tag; *p != '\0'; p++)
+  {
+    h = (h ^ static_cast<uint8_t>(*p)) * 16777619u;
+  }
+  h = h * 16777619u;  // The NUL separator
+  for (const char* p = fmt; *p != '\0'; p++)
+  {
+    h = (h ^ static_cast<uint8_t>(*p)) * 16777619u;
+  }
+  return h;
+}
+
+/**
+ * @brief Number of arguments a format takes
+ * @return Argument count, or -1 if a conversion cannot be deferred
+ */
+constexpr int dlog_arg_count(const char* fmt)
+{
+  int count = 0;
+  for (const char* p = fmt; *p != '\0'; p++)
+  {
+    if (*p != '%')
+    {
+      continue;
+    }
+    p++;
+    if (*p == '%')
+    {
+      continue;
+    }
+    while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0')
+    {
+      p++;
+    }
+    while (*p >= '0' && *p <= '9')
+    {
+      p++;
+    }
+    if (*p == '.')
+    {
+      p++;
+      while (*p >= '0' && *p <= '9')
+      {
+        p++;
+      }
+    }
+    while (*p == 'h' || *p == 'l' || *p == 'j' || *p == 'z' || *p == 't')
+    {
+      p++;
+    }
+    switch (*p)
+    {
+      case 'd':
+      case 'i':
+      case 'u':
+      case 'x':
+      case 'X':
+      case 'o':
+      case 'c':
+        count++;
+        break;
+      default:
+        return -1;  // %s, %p, %f, '*', or a truncated conversion
+    }
+  }
+  return count;
+}
+
+/** One log call */
+struct LogRecord
+{
+  static constexpr size_t MAX_ARGS = 4;  ///< Arguments per call
+
+  uint32_t time;            ///< Milliseconds since boot
+  uint32_t id;              ///< dlog_id() of tag and format
+  uint8_t level;            ///< LogLevel
+  uint8_t nargs;            ///< Arguments used
+  uint32_t args[MAX_ARGS];  ///< Arguments, each widened to 32 bits
+};
+
+/**
+ * @brief Log ring with its clock and level filter
+ */
+class DeferredLog
+{
+ public:
+  /** Millisecond timestamp source */
+  using Clock = uint32_t (*)(void);
+
+  /** CMD_LOG request operations (first payload byte) */
+  enum Op : uint8_t
+  {
+    OP_INFO = 0,  ///< Capacity, fill, drops, level
+    OP_READ = 1,  ///< Remove the oldest records
+    OP_LEVEL = 2  ///< Set the most verbose level recorded: [level u8]
+  };
+
+  /**
+   * @brief Construct log
+   * @param clock Timestamp source
+   * @param records Ring capacity (rounded up to a power of two)
+   * @param level Most verbose level recorded
+   */
+  DeferredLog(Clock clock, size_t records, uint8_t level);
+
+  /**
+   * @brief Record a log call (any task)
+   */
+  void write(uint8_t level, uint32_t id, size_t nargs, const uint32_t* args)
+  {
+    if (level > level_.load(std::memory_order_relaxed))
+    {
+      return;
+    }
+    LogRecord rec;
+    rec.time = clock_();
+    rec.id = id;
+    rec.level = level;
+    rec.nargs = static_cast<uint8_t>(nargs);
+    for (size_t i = 0; i < nargs; i++)
+    {
+      rec.args[i] = args[i];
+    }
+    ring_.push(rec);
+  }
+
+  /**
+   * @brief Set the most verbose level recorded
+   */
+  void set_level(uint8_t level)
+  {
+    level_.store(level, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Get the record ring
+   */
+  MpscRing<LogRecord>& ring()
+  {
+    return ring_;
+  }
+
+  /**
+   * @brief Answer a CMD_LOG request
+   *
+   * RuntimeCmdHandler signature; @p user is the DeferredLog. The link port
+   * serializes frames, so the ring keeps a single consumer.
+   */
+  static void handle_command(void* user, const LinkFrameView& frame, LinkReply* reply);
+
+ private:
+  void encode_records(LinkReply* reply);
+
+  Clock clock_;                 ///< Timestamp source
+  std::atomic<uint8_t> level_;  ///< Most verbose level recorded
+  MpscRing<LogRecord> ring_;    ///< Records not yet read
+};
+
+/**
+ * @brief Route V4_DLOG() calls to @p log
+ *
+ * @param log Deferred log, or nullptr to drop log calls
+ */
+void dlog_install(DeferredLog* log);
+
+/**
+ * @brief Record a log call (no-op until dlog_install())
+ */
+void dlog_write(uint8_t level, uint32_t id, size_t nargs, const uint32_t* args);
+
+/**
+ * @brief Widen one log argument to 32 bits
+ */
+template <class T>
+constexpr uint32_t dlog_arg(T value)
+{
+  static_assert(std::is_integral<T>::value || std::is_enum<T>::value,
+                "V4_DLOG: arguments must be integers");
+  static_assert(sizeof(T) <= sizeof(uint32_t), "V4_DLOG: arguments must fit 32 bits");
+  return static_cast<uint32_t>(value);
+}
+
+/**
+ * @brief Record a call whose format takes @p N arguments
+ */
+template <int N, class... Args>
+inline void dlog(uint8_t level, uint32_t id, Args... args)
+{
+  static_assert(N >= 0, "V4_DLOG: only integer conversions can be deferred");
+  static_assert(N == sizeof...(Args), "V4_DLOG: argument count does not match format");
+  static_assert(N <= (int)LogRecord::MAX_ARGS, "V4_DLOG: too many arguments");
+  const uint32_t values[sizeof...(Args) + 1] = {dlog_arg(args)...};
+  dlog_write(level, id, sizeof...(Args), values);
+}
+
+/** Lets the compiler check arguments against the format; never called */
+__attribute__((format(printf, 1, 2))) inline void dlog_check(const char*, ...) {}
+
+}  // namespace v4rtos
+
+/**
+ * @brief Deferred-format log call
+ *
+ * Only the ID and arguments reach the device image; @p tag and @p fmt are
+ * evaluated by the compiler. The format check runs on " " fmt so that an
+ * empty format (a blank log line) does not trip -Wformat-zero-length.
+ */
+#define V4_DLOG(level, tag, fmt, ...)                                                  \
+  do                                                                                   \
+  {                                                                                    \
+    if constexpr (false)                                                               \
+    {                                                                                  \
+      ::v4rtos::dlog_check(" " fmt, ##__VA_ARGS__);                                    \
+    }                                                                                  \
+    ::v4rtos::dlog<::v4rtos::dlog_arg_count(fmt)>(                                     \
+        (level), std::integral_constant<uint32_t, ::v4rtos::dlog_id(tag, fmt)>::value, \
+        ##__VA_ARGS__);                                                                \
+  } while (0)
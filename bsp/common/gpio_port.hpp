@@ -0,0 +1,113 @@
+// Batched GPIO port access
+//
+// Drives several pins of one 32-pin GPIO port with a single call through
+// the port's write-1-to-set / write-1-to-clear registers, so a bit-banged
+// bus (data and clock lines) changes with one SYS call instead of one
+// LED-SET per pin. Levels are physical: no active-low inversion.
+//
+// The register block is a template parameter so that the stores inline
+// into the SYS handler. A Regs type provides:
+//
+//   void set(uint32_t mask);    // W1TS: drive the pins in mask high
+//   void clear(uint32_t mask);  // W1TC: drive the pins in mask low
+//   uint32_t out() const;       // Output latch
+//   uint32_t in() const;        // Pad levels
+//
+// (Esp32GpioRegs in hal_esp32, PosixGpioRegs in hal_posix.)
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include <cstdint>
+
+namespace v4rtos
+{
+
+/**
+ * @brief Pins of one GPIO port that V4 code may drive
+ *
+ * @tparam Regs Set/clear register block of the port
+ */
+template <class Regs>
+class GpioPort
+{
+ public:
+  /** Result codes (pushed by the SYS handlers) */
+  enum Status : int32_t
+  {
+    OK = 0,            ///< Pins updated
+    ERR_INVALID = -1,  ///< Mask names a pin outside allowed()
+  };
+
+  /**
+   * @param regs    Register block of the port
+   * @param allowed Pins V4 code may drive (already configured as outputs)
+   */
+  GpioPort(Regs& regs, uint32_t allowed) : regs_(regs), allowed_(allowed) {}
+
+  /**
+   * @brief Drive every pin in @p mask to its bit in @p values
+   *
+   * At most one set and one clear store, in that order, whatever the
+   * number of pins; pins outside @p mask keep their level.
+   */
+  Status write(uint32_t mask, uint32_t values)
+  {
+    if ((mask & ~allowed_) != 0)
+    {
+      return ERR_INVALID;
+    }
+    store(mask & values, mask & ~values);
+    return OK;
+  }
+
+  /**
+   * @brief Invert every pin in @p mask (one latch read, up to two stores)
+   */
+  Status toggle(uint32_t mask)
+  {
+    if ((mask & ~allowed_) != 0)
+    {
+      return ERR_INVALID;
+    }
+    uint32_t out = regs_.out();
+    store(~out & mask, out & mask);
+    return OK;
+  }
+
+  /**
+   * @brief Pad levels of the whole port
+   */
+  uint32_t read() const
+  {
+    return regs_.in();
+  }
+
+  /**
+   * @brief Pins V4 code may drive
+   */
+  uint32_t allowed() const
+  {
+    return allowed_;
+  }
+
+ private:
+  // Skip empty stores: a single-pin update costs one register write
+  void store(uint32_t high, uint32_t low)
+  {
+    if (high != 0)
+    {
+      regs_.set(high);
+    }
+    if (low != 0)
+    {
+      regs_.clear(low);
+    }
+  }
+
+  Regs& regs_;        ///< Register block
+  uint32_t allowed_;  ///< Drivable pins
+};
+
+}  // namespace v4rtos
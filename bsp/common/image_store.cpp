@@ -0,0 +1,358 @@
+// Bytecode image store implementation
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#include "image_store.hpp"
+
+#include <cstring>
+
+#include "crc32.hpp"
+#include "link_runtime_commands.hpp"
+
+namespace v4rtos
+{
+
+static uint32_t get_u32(const uint8_t* p)
+{
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+         ((uint32_t)p[3] << 24);
+}
+
+ImageStore::ImageStore(const ImageFlash& flash, uint32_t (*clock_ms)(void),
+                       uint32_t trial_ms)
+    : flash_(flash),
+      slot_size_((flash.size / SLOTS) & ~(flash.erase_size - 1)),
+      clock_ms_(clock_ms),
+      trial_ms_(trial_ms),
+      lz4_(lz4_sink, this, lz4_stage_, sizeof(lz4_stage_))
+{
+  for (uint8_t id = 0; id < SLOTS; id++)
+  {
+    valid_[id] = check(id);
+  }
+}
+
+uint32_t ImageStore::image_crc(const uint8_t* code, size_t size, uint16_t flags,
+                               uint32_t seq)
+{
+  Header h = {MAGIC, VERSION, flags, static_cast<uint32_t>(size), seq, 0, 0, 0, 0};
+  uint32_t crc = crc32(reinterpret_cast<const uint8_t*>(&h), offsetof(Header, crc));
+  return crc32(code, size, crc);
+}
+
+bool ImageStore::check(uint8_t id) const
+{
+  if (flash_.map == nullptr || slot_size_ < sizeof(Header))
+  {
+    return false;
+  }
+  const Header* h = header(id);
+  if (h->magic != MAGIC || h->version != VERSION || h->size > capacity())
+  {
+    return false;
+  }
+  return image_crc(slot(id) + sizeof(Header), h->size, h->flags, h->seq) == h->crc;
+}
+
+ImageStore::SlotState ImageStore::state(uint8_t id) const
+{
+  if (id >= SLOTS || !valid_[id])
+  {
+    return SlotState::EMPTY;
+  }
+  const Header* h = header(id);
+  if (h->revoked == 0)
+  {
+    return SlotState::REVOKED;
+  }
+  if (h->confirmed == 0)
+  {
+    return SlotState::CONFIRMED;
+  }
+  return h->tried == 0 ? SlotState::TRIAL : SlotState::PENDING;
+}
+
+uint8_t ImageStore::select() const
+{
+  uint8_t best = NO_SLOT;
+  for (uint8_t id = 0; id < SLOTS; id++)
+  {
+    SlotState s = state(id);
+    if (s != SlotState::EMPTY && s != SlotState::REVOKED &&
+        (best == NO_SLOT || header(id)->seq > header(best)->seq))
+    {
+      best = id;
+    }
+  }
+  return best;
+}
+
+uint8_t ImageStore::update_slot() const
+{
+  if (active_ != NO_SLOT)
+  {
+    return active_ == 0 ? 1 : 0;
+  }
+  // Nothing runs: keep going with a committed image, else spare the newest
+  uint8_t id = select();
+  if (id == NO_SLOT)
+  {
+    return 0;
+  }
+  if (state(id) == SlotState::PENDING)
+  {
+    return id;
+  }
+  return id == 0 ? 1 : 0;
+}
+
+bool ImageStore::in_trial()
+{
+  // service() first: a window that has passed confirms the image now
+  return service() != NO_DEADLINE;
+}
+
+uint32_t ImageStore::next_seq() const
+{
+  uint32_t seq = 0;
+  for (uint8_t id = 0; id < SLOTS; id++)
+  {
+    if (valid_[id] && header(id)->seq >= seq)
+    {
+      seq = header(id)->seq + 1;
+    }
+  }
+  return seq;
+}
+
+bool ImageStore::clear_word(uint8_t id, size_t field)
+{
+  static const uint8_t zero[4] = {0, 0, 0, 0};
+  return flash_.write(flash_.user, id * slot_size_ + field, zero, sizeof(zero));
+}
+
+void ImageStore::start_trial(uint8_t id)
+{
+  clear_word(id, offsetof(Header, tried));
+  trial_ = true;
+  trial_start_ = clock_ms_();
+}
+
+bool ImageStore::boot()
+{
+  // Still on trial from the last boot: the device reset before the image
+  // was confirmed, so fall back to the previous one
+  uint8_t id = select();
+  while (id != NO_SLOT && state(id) == SlotState::TRIAL)
+  {
+    clear_word(id, offsetof(Header, revoked));
+    rollbacks_++;
+    id = select();
+  }
+
+  active_ = id;
+  if (id != NO_SLOT && state(id) == SlotState::PENDING)
+  {
+    start_trial(id);
+  }
+  return id != NO_SLOT;
+}
+
+bool ImageStore::activate()
+{
+  uint8_t id = update_slot();
+  if (state(id) != SlotState::PENDING)
+  {
+    return false;
+  }
+
+  // The header written by commit() made the switch durable; this makes it
+  // take effect without a reset
+  active_ = id;
+  start_trial(id);
+  if (switch_ != nullptr && !switch_(switch_user_))
+  {
+    if (fault())
+    {
+      switch_(switch_user_);
+    }
+    return false;
+  }
+  return true;
+}
+
+bool ImageStore::fault()
+{
+  if (!trial_)
+  {
+    return false;
+  }
+  trial_ = false;
+  if (clock_ms_() - trial_start_ >= trial_ms_)
+  {
+    // Window passed before service() ran: the panic is not the update's
+    clear_word(active_, offsetof(Header, confirmed));
+    return false;
+  }
+  clear_word(active_, offsetof(Header, revoked));
+  rollbacks_++;
+  active_ = select();
+  return true;
+}
+
+uint32_t ImageStore::service()
+{
+  if (!trial_)
+  {
+    return NO_DEADLINE;
+  }
+  uint32_t elapsed = clock_ms_() - trial_start_;
+  if (elapsed < trial_ms_)
+  {
+    return trial_ms_ - elapsed;
+  }
+  clear_word(active_, offsetof(Header, confirmed));
+  trial_ = false;
+  return NO_DEADLINE;
+}
+
+uint32_t ImageStore::timer_hook(void* user)
+{
+  return static_cast<ImageStore*>(user)->service();
+}
+
+bool ImageStore::erase()
+{
+  // The update slot holds the image a rollback returns to
+  if (in_trial())
+  {
+    return false;
+  }
+  uint8_t id = update_slot();
+  valid_[id] = false;
+  lz4_.start(slot(id) + sizeof(Header), capacity());
+  return flash_.erase(flash_.user, id * slot_size_, slot_size_);
+}
+
+bool ImageStore::write(size_t offset, const uint8_t* data, size_t len)
+{
+  // Code under a valid header cannot change; erase() first
+  uint8_t id = update_slot();
+  if (in_trial() || valid_[id] || offset > capacity() || len > capacity() - offset)
+  {
+    return false;
+  }
+  return flash_.write(flash_.user, id * slot_size_ + sizeof(Header) + offset, data,
+                      len);
+}
+
+bool ImageStore::lz4_sink(void* user, size_t offset, const uint8_t* data, size_t len)
+{
+  return static_cast<ImageStore*>(user)->write(offset, data, len);
+}
+
+bool ImageStore::write_lz4(const uint8_t* data, size_t len)
+{
+  return !in_trial() && !valid_[update_slot()] && lz4_.feed(data, len);
+}
+
+bool ImageStore::commit(size_t size, uint32_t crc, uint16_t flags)
+{
+  if (in_trial())
+  {
+    return false;
+  }
+
+  // A compressed upload ends here; its last bytes are still staged
+  bool lz4_ok = lz4_.idle() || (lz4_.finish() && lz4_.size() == size);
+  lz4_.start(nullptr, 0);
+  if (!lz4_ok)
+  {
+    return false;
+  }
+
+  uint8_t id = update_slot();
+  uint32_t seq = next_seq();
+  if (valid_[id] || size > capacity() ||
+      image_crc(slot(id) + sizeof(Header), size, flags, seq) != crc)
+  {
+    return false;
+  }
+
+  // Only the CRC-covered fields: the state words stay erased (0xFFFFFFFF)
+  Header h = {MAGIC, VERSION, flags, static_cast<uint32_t>(size), seq, crc, 0, 0, 0};
+  if (!flash_.write(flash_.user, id * slot_size_, reinterpret_cast<const uint8_t*>(&h),
+                    offsetof(Header, tried)))
+  {
+    return false;
+  }
+  valid_[id] = check(id);
+  return valid_[id];
+}
+
+void ImageStore::handle_command(void* user, const LinkFrameView& frame, LinkReply* reply)
+{
+  ImageStore* self = static_cast<ImageStore*>(user);
+  if (frame.len < 1)
+  {
+    reply->status = link_wire::STATUS_ERROR;
+    return;
+  }
+
+  const uint8_t* p = frame.payload + 1;
+  bool ok = true;
+  switch (frame.payload[0])
+  {
+    case OP_INFO:
+    {
+      uint32_t left = self->service();
+      reply->put_u8(self->active_);
+      reply->put_u8(self->update_slot());
+      reply->put_u32(self->next_seq());
+      reply->put_u32(left != NO_DEADLINE ? left : 0);
+      reply->put_u32(self->rollbacks_);
+      reply->put_u32(static_cast<uint32_t>(self->capacity()));
+      for (uint8_t id = 0; id < SLOTS; id++)
+      {
+        const Header* h = self->header(id);
+        bool valid = self->valid_[id];
+        reply->put_u8(static_cast<uint8_t>(self->state(id)));
+        reply->put_u16(valid ? h->flags : 0);
+        reply->put_u32(valid ? h->size : 0);
+        reply->put_u32(valid ? h->seq : 0);
+        reply->put_u32(valid ? h->crc : 0);
+      }
+      break;
+    }
+    case OP_ERASE:
+      ok = self->erase();
+      break;
+    case OP_WRITE:
+      ok = frame.len >= 5 && self->write(get_u32(p), p + 4, frame.len - 5);
+      break;
+    case OP_COMMIT:
+      ok = frame.len >= 11 &&
+           self->commit(get_u32(p), get_u32(p + 4), (uint16_t)(p[8] | (p[9] << 8)));
+      if (ok)
+      {
+        reply->put_u32(self->header(self->update_slot())->seq);
+      }
+      break;
+    case OP_WRITE_LZ4:
+      ok = self->write_lz4(p, frame.len - 1);
+      break;
+    case OP_ACTIVATE:
+      ok = self->activate();
+      reply->put_u8(self->active_);
+      break;
+    default:
+      ok = false;
+      break;
+  }
+  if (!ok)
+  {
+    reply->status = link_wire::STATUS_ERROR;
+  }
+}
+
+}  // namespace v4rtos
@@ -0,0 +1,301 @@
+// A/B bytecode image slots on a memory-mapped flash region
+//
+// Keeps validated bytecode images in a dedicated region (an ESP32-C6 data
+// partition mapped through the flash cache, a file mapping on POSIX) so a
+// program survives power cycles. The VM runs the active image straight
+// from the mapping: the code is never copied into RAM.
+//
+// The region is split into two slots. Updates stream into the slot that
+// is not running (CMD_IMAGE), plain or LZ4-compressed and decoded on the
+// fly, are checked with a CRC-32 over the whole image, and become the
+// next image when their header is written. An
+// activated image runs on trial: if its VM panics within the trial window,
+// or the device resets before the window ends, the slot is revoked and the
+// previous image takes over again.
+//
+// Slot layout:
+//
+//   [Header 32 bytes][code ...][erased 0xFF ...]
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "link_frame_scanner.hpp"
+#include "lz4_stream.hpp"
+
+namespace v4rtos
+{
+
+struct LinkReply;
+
+/**
+ * @brief Flash region backing an ImageStore
+ *
+ * @p map is the read-only view the VM executes from; changes go through
+ * @p erase and @p write, which follow NOR flash rules (erase sets bytes
+ * to 0xFF, writes can only clear bits).
+ */
+struct ImageFlash
+{
+  const uint8_t* map;  ///< Mapped region
+  size_t size;         ///< Region size (bytes)
+  size_t erase_size;   ///< Erase granularity (bytes, power of two)
+
+  /** Erase [offset, offset + len), both multiples of erase_size */
+  bool (*erase)(void* user, size_t offset, size_t len);
+
+  /** Program @p len bytes at @p offset */
+  bool (*write)(void* user, size_t offset, const uint8_t* data, size_t len);
+
+  void* user;  ///< Passed to @p erase and @p write
+};
+
+/**
+ * @brief Two bytecode image slots in an ImageFlash region
+ *
+ * Not locked: all calls must come from the task that runs the link port
+ * (or from startup code before it runs). fault() may also be called from
+ * inside the VM running the image, e.g. its panic handler.
+ */
+class ImageStore
+{
+ public:
+  static constexpr uint32_t MAGIC = 0x4D493456;        ///< "V4IM"
+  static constexpr uint16_t VERSION = 1;               ///< Header format
+  static constexpr uint16_t FLAG_AUTOSTART = 0x0001;   ///< Run at boot
+  static constexpr uint8_t SLOTS = 2;                  ///< A/B
+  static constexpr uint8_t NO_SLOT = 0xFF;             ///< No image
+  static constexpr uint32_t NO_DEADLINE = 0xFFFFFFFF;  ///< service(): no trial
+
+  /** Slot state (CMD_IMAGE INFO) */
+  enum class SlotState : uint8_t
+  {
+    EMPTY = 0,      ///< No valid image
+    PENDING = 1,    ///< Committed, not run yet
+    TRIAL = 2,      ///< Running (or reset) before its trial ended
+    CONFIRMED = 3,  ///< Survived its trial
+    REVOKED = 4     ///< Failed its trial
+  };
+
+  /** CMD_IMAGE request operations (first payload byte) */
+  enum Op : uint8_t
+  {
+    OP_INFO = 0,      ///< Active slot, trial, per-slot state
+    OP_ERASE = 1,     ///< Erase the update slot
+    OP_WRITE = 2,     ///< [offset u32][code...] into the update slot
+    OP_COMMIT = 3,    ///< [size u32][crc u32][flags u16]: verify, write header
+    OP_ACTIVATE = 4,  ///< Run the committed image now, on trial
+    OP_WRITE_LZ4 = 5  ///< [LZ4 block data...] continuing the update slot code
+  };
+
+  /** Slot header; the state words are cleared in place, without an erase */
+  struct Header
+  {
+    uint32_t magic;      ///< MAGIC
+    uint16_t version;    ///< VERSION
+    uint16_t flags;      ///< FLAG_* bits
+    uint32_t size;       ///< Code bytes after the header
+    uint32_t seq;        ///< Update number; the highest usable slot is active
+    uint32_t crc;        ///< CRC-32 over the fields above and the code
+    uint32_t tried;      ///< 0 once the image has been run
+    uint32_t confirmed;  ///< 0 once the image survived its trial
+    uint32_t revoked;    ///< 0 once the image failed its trial
+  };
+
+  /**
+   * @brief Run the newly active image (activate() and rollbacks)
+   *
+   * Typically restarts the VM that runs images, which then runs
+   * active_code().
+   *
+   * @return false if the image could not be started
+   */
+  using SwitchFn = bool (*)(void* user);
+
+  /**
+   * @brief Attach to a region and validate both slots
+   *
+   * @param flash Mapped region (must outlive the store)
+   * @param clock_ms Millisecond clock for the trial window
+   * @param trial_ms Trial window of an activated image
+   */
+  ImageStore(const ImageFlash& flash, uint32_t (*clock_ms)(void), uint32_t trial_ms);
+
+  ImageStore(const ImageStore&) = delete;
+  ImageStore& operator=(const ImageStore&) = delete;
+
+  /**
+   * @brief Pick the image to run at boot
+   *
+   * An image that was still on trial when the device reset is revoked
+   * first. A committed image that never ran starts its trial now.
+   *
+   * @return true if there is an active image
+   */
+  bool boot();
+
+  /**
+   * @brief Set the callback that runs a newly active image
+   */
+  void set_switch(SwitchFn fn, void* user)
+  {
+    switch_ = fn;
+    switch_user_ = user;
+  }
+
+  /**
+   * @brief Run the committed image in the update slot, on trial
+   * @return false if there is none or it failed to start (rolled back)
+   */
+  bool activate();
+
+  /**
+   * @brief Report a panic of the VM running the active image
+   *
+   * Inside the trial window this revokes the image and makes the previous
+   * one active; the caller's VM restart then runs it.
+   *
+   * @return true if a rollback happened
+   */
+  bool fault();
+
+  /**
+   * @brief Confirm the image on trial once its window has passed
+   * @return Milliseconds until the next call is due, or NO_DEADLINE
+   */
+  uint32_t service();
+
+  /**
+   * @brief Link port timer hook adapter (@p user is the store)
+   */
+  static uint32_t timer_hook(void* user);
+
+  /** Slot that runs (NO_SLOT: none) */
+  uint8_t active() const
+  {
+    return active_;
+  }
+
+  /** true while the active image is on trial */
+  bool on_trial() const
+  {
+    return trial_;
+  }
+
+  /** Number of rollbacks since boot (including the one boot() did) */
+  uint32_t rollbacks() const
+  {
+    return rollbacks_;
+  }
+
+  /** Active image code in the mapping (nullptr: none) */
+  const uint8_t* active_code() const
+  {
+    return active_ != NO_SLOT ? slot(active_) + sizeof(Header) : nullptr;
+  }
+
+  /** Active image header (nullptr: none) */
+  const Header* active_header() const
+  {
+    return active_ != NO_SLOT ? header(active_) : nullptr;
+  }
+
+  /** State of a slot */
+  SlotState state(uint8_t slot) const;
+
+  /** Largest image code size per slot */
+  size_t capacity() const
+  {
+    return slot_size_ > sizeof(Header) ? slot_size_ - sizeof(Header) : 0;
+  }
+
+  /**
+   * @brief Erase the update slot (never the active one)
+   *
+   * Like write(), write_lz4() and commit(), fails while an image is on
+   * trial: the update slot then holds the image a rollback returns to.
+   */
+  bool erase();
+
+  /**
+   * @brief Program image code into the erased update slot
+   * @param offset Offset into the code area
+   */
+  bool write(size_t offset, const uint8_t* data, size_t len);
+
+  /**
+   * @brief Decode the next chunk of an LZ4-compressed image
+   *
+   * The stream starts at code offset 0 after erase() and is decoded
+   * straight into the slot, so the image is never held in RAM either
+   * compressed or plain. commit() ends the stream.
+   */
+  bool write_lz4(const uint8_t* data, size_t len);
+
+  /**
+   * @brief Verify the update slot against @p crc and write its header
+   *
+   * @param size Code bytes written
+   * @param crc CRC-32 the host computed over the image (see image_crc())
+   * @param flags FLAG_* bits
+   * @return true if the slot holds a PENDING image afterwards
+   */
+  bool commit(size_t size, uint32_t crc, uint16_t flags);
+
+  /**
+   * @brief Header::seq the next commit() writes (part of its CRC)
+   */
+  uint32_t next_seq() const;
+
+  /**
+   * @brief CRC-32 of an image as stored in Header::crc
+   */
+  static uint32_t image_crc(const uint8_t* code, size_t size, uint16_t flags,
+                            uint32_t seq);
+
+  /**
+   * @brief Answer a CMD_IMAGE request
+   *
+   * RuntimeCmdHandler signature; @p user is the ImageStore.
+   */
+  static void handle_command(void* user, const LinkFrameView& frame, LinkReply* reply);
+
+ private:
+  const uint8_t* slot(uint8_t id) const
+  {
+    return flash_.map + id * slot_size_;
+  }
+
+  const Header* header(uint8_t id) const
+  {
+    return reinterpret_cast<const Header*>(slot(id));
+  }
+
+  bool check(uint8_t id) const;
+  uint8_t select() const;
+  uint8_t update_slot() const;
+  bool in_trial();
+  bool clear_word(uint8_t id, size_t field);
+  static bool lz4_sink(void* user, size_t offset, const uint8_t* data, size_t len);
+  void start_trial(uint8_t id);
+
+  ImageFlash flash_;             ///< Backing region
+  size_t slot_size_;             ///< Bytes per slot (erase aligned)
+  uint32_t (*clock_ms_)(void);   ///< Trial clock
+  uint32_t trial_ms_;            ///< Trial window
+  bool valid_[SLOTS];            ///< Header and CRC checked
+  SwitchFn switch_ = nullptr;    ///< Runs a newly active image
+  void* switch_user_ = nullptr;  ///< SwitchFn user
+  uint8_t active_ = NO_SLOT;     ///< Running slot
+  bool trial_ = false;           ///< Active slot is on trial
+  uint32_t trial_start_ = 0;     ///< clock_ms() when the trial started
+  uint32_t rollbacks_ = 0;       ///< Rollbacks since boot
+  uint8_t lz4_stage_[256];       ///< Decoded bytes per flash write (one page)
+  Lz4StreamDecoder lz4_;         ///< OP_WRITE_LZ4 stream
+};
+
+}  // namespace v4rtos
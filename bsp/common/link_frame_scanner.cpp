@@ -0,0 +1,178 @@
+// Bulk V4-link frame scanner implementation
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#include "link_frame_scanner.hpp"
+
+#include <cstring>
+
+#include "v4link_wire.hpp"
+
+namespace v4rtos
+{
+
+using namespace link_wire;
+
+static inline size_t payload_length(const uint8_t* header)
+{
+  return static_cast<size_t>(header[1]) | (static_cast<size_t>(header[2]) << 8);
+}
+
+LinkFrameScanner::LinkFrameScanner(size_t max_payload, FrameHandler handler, void* user)
+    : max_payload_(max_payload),
+      handler_(handler),
+      user_(user),
+      stage_(new uint8_t[max_payload + OVERHEAD])
+{
+}
+
+void LinkFrameScanner::reset()
+{
+  stage_len_ = 0;
+}
+
+void LinkFrameScanner::deliver(const uint8_t* frame, size_t payload_len)
+{
+  size_t raw_len = payload_len + OVERHEAD;
+  LinkFrameView view;
+  view.cmd = frame[3];
+  view.payload = frame + HEADER_SIZE;
+  view.len = payload_len;
+  view.raw = frame;
+  view.raw_len = raw_len;
+  view.crc_ok = crc8(frame + 1, raw_len - 2) == frame[raw_len - 1];
+
+  if (view.crc_ok)
+  {
+    stats_.frames++;
+    if (payload_len > stats_.payload_high_water)
+    {
+      stats_.payload_high_water = payload_len;
+    }
+  }
+  else
+  {
+    stats_.crc_errors++;
+  }
+  handler_(user_, view);
+}
+
+size_t LinkFrameScanner::feed_staged(const uint8_t* data, size_t len)
+{
+  size_t used = 0;
+
+  // Complete the header first
+  while (stage_len_ < HEADER_SIZE)
+  {
+    size_t n = HEADER_SIZE - stage_len_;
+    n = n < len - used ? n : len - used;
+    memcpy(stage_.get() + stage_len_, data + used, n);
+    stage_len_ += n;
+    used += n;
+    if (stage_len_ < HEADER_SIZE)
+    {
+      return used;
+    }
+    if (payload_length(stage_.get()) <= max_payload_)
+    {
+      break;
+    }
+
+    // Not a frame we can hold: skip its STX and rescan the rest, as feed()
+    // does. Bytes of this chunk go back to feed(); staged ones are searched
+    // here
+    stats_.oversize++;
+    stats_.discarded_bytes++;
+    stage_len_ -= n;
+    used -= n;
+    const uint8_t* stx =
+        static_cast<const uint8_t*>(memchr(stage_.get() + 1, STX, stage_len_ - 1));
+    if (stx == nullptr)
+    {
+      stats_.discarded_bytes += stage_len_ - 1;
+      stage_len_ = 0;
+      return used;
+    }
+    size_t skip = static_cast<size_t>(stx - stage_.get());
+    stats_.discarded_bytes += skip - 1;
+    stage_len_ -= skip;
+    memmove(stage_.get(), stx, stage_len_);
+  }
+
+  // Then the payload and CRC
+  size_t total = payload_length(stage_.get()) + OVERHEAD;
+  size_t n = total - stage_len_;
+  n = n < len - used ? n : len - used;
+  memcpy(stage_.get() + stage_len_, data + used, n);
+  stage_len_ += n;
+  used += n;
+
+  if (stage_len_ == total)
+  {
+    if (total > stats_.stage_high_water)
+    {
+      stats_.stage_high_water = total;
+    }
+    stats_.staged_frames++;
+    stage_len_ = 0;
+    deliver(stage_.get(), total - OVERHEAD);
+  }
+  return used;
+}
+
+void LinkFrameScanner::feed(const uint8_t* data, size_t len)
+{
+  // Finish a frame that started in a previous chunk
+  if (stage_len_ > 0)
+  {
+    size_t used = feed_staged(data, len);
+    data += used;
+    len -= used;
+  }
+
+  while (len > 0)
+  {
+    // Skip inter-frame bytes in bulk
+    const uint8_t* stx = static_cast<const uint8_t*>(memchr(data, STX, len));
+    if (stx == nullptr)
+    {
+      stats_.discarded_bytes += len;
+      return;
+    }
+    stats_.discarded_bytes += static_cast<size_t>(stx - data);
+    len -= static_cast<size_t>(stx - data);
+    data = stx;
+
+    if (len < HEADER_SIZE)
+    {
+      // Header split across chunks
+      feed_staged(data, len);
+      return;
+    }
+
+    size_t payload_len = payload_length(data);
+    if (payload_len > max_payload_)
+    {
+      stats_.oversize++;
+      stats_.discarded_bytes++;
+      data++;
+      len--;
+      continue;
+    }
+
+    size_t total = payload_len + OVERHEAD;
+    if (len < total)
+    {
+      // Frame continues in the next chunk
+      feed_staged(data, len);
+      return;
+    }
+
+    // Whole frame inside this chunk: hand it out in place
+    deliver(data, payload_len);
+    data += total;
+    len -= total;
+  }
+}
+
+}  // namespace v4rtos
@@ -0,0 +1,108 @@
+// Bulk V4-link frame scanner
+//
+// Finds frame boundaries in whole receive chunks instead of stepping a
+// state machine once per byte. Frames that lie entirely inside a chunk
+// are handed out as views into that chunk (no copy); only frames split
+// across chunks are staged.
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace v4rtos
+{
+
+/**
+ * @brief View of one received frame
+ *
+ * Pointers are only valid for the duration of the handler call.
+ */
+struct LinkFrameView
+{
+  uint8_t cmd;             ///< Command byte
+  const uint8_t* payload;  ///< Payload bytes
+  size_t len;              ///< Payload length
+  const uint8_t* raw;      ///< Whole frame (STX..CRC)
+  size_t raw_len;          ///< Whole frame length
+  bool crc_ok;             ///< CRC matched
+};
+
+/**
+ * @brief Bulk frame scanner for V4-link byte streams
+ */
+class LinkFrameScanner
+{
+ public:
+  /**
+   * @brief Frame handler callback
+   *
+   * Called for every complete frame, including frames with a CRC error
+   * (crc_ok == false) so the owner can reply as V4-link would.
+   */
+  using FrameHandler = void (*)(void* user, const LinkFrameView& frame);
+
+  /** Scanner counters */
+  struct Stats
+  {
+    uint64_t frames;            ///< Frames delivered with a valid CRC
+    uint64_t crc_errors;        ///< Frames delivered with a bad CRC
+    uint64_t oversize;          ///< Headers rejected for exceeding max_payload
+    uint64_t discarded_bytes;   ///< Bytes skipped outside frames
+    uint64_t staged_frames;     ///< Frames reassembled across chunks
+    size_t stage_high_water;    ///< Largest staged frame (bytes)
+    size_t payload_high_water;  ///< Largest payload delivered (bytes)
+  };
+
+  /**
+   * @brief Construct scanner
+   * @param max_payload Largest accepted payload (bytes)
+   * @param handler Frame handler
+   * @param user User pointer passed to @p handler
+   */
+  LinkFrameScanner(size_t max_payload, FrameHandler handler, void* user);
+
+  /**
+   * @brief Feed a chunk of received bytes
+   * @param data Received bytes
+   * @param len Number of bytes
+   */
+  void feed(const uint8_t* data, size_t len);
+
+  /**
+   * @brief Drop any partially received frame
+   */
+  void reset();
+
+  /**
+   * @brief Get scanner counters
+   */
+  const Stats& stats() const
+  {
+    return stats_;
+  }
+
+  /**
+   * @brief Get maximum accepted payload size
+   */
+  size_t max_payload() const
+  {
+    return max_payload_;
+  }
+
+ private:
+  size_t feed_staged(const uint8_t* data, size_t len);
+  void deliver(const uint8_t* frame, size_t payload_len);
+
+  size_t max_payload_;                ///< Largest accepted payload
+  FrameHandler handler_;              ///< Frame handler
+  void* user_;                        ///< Handler user pointer
+  std::unique_ptr<uint8_t[]> stage_;  ///< Reassembly buffer for split frames
+  size_t stage_len_ = 0;              ///< Bytes currently staged
+  Stats stats_ = {};                  ///< Counters
+};
+
+}  // namespace v4rtos
@@ -0,0 +1,149 @@
+// Runtime-owned V4-link commands implementation
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#include "link_runtime_commands.hpp"
+
+#include <cstring>
+
+namespace v4rtos
+{
+
+using namespace link_wire;
+
+bool LinkReply::put_u8(uint8_t v)
+{
+  if (len >= cap)
+  {
+    status = STATUS_ERROR;
+    return false;
+  }
+  data[len++] = v;
+  return true;
+}
+
+bool LinkReply::put_u16(uint16_t v)
+{
+  if (cap - len < 2)
+  {
+    status = STATUS_ERROR;
+    return false;
+  }
+  data[len++] = static_cast<uint8_t>(v);
+  data[len++] = static_cast<uint8_t>(v >> 8);
+  return true;
+}
+
+bool LinkReply::put_u32(uint32_t v)
+{
+  if (cap - len < 4)
+  {
+    status = STATUS_ERROR;
+    return false;
+  }
+  for (int i = 0; i < 4; i++)
+  {
+    data[len++] = static_cast<uint8_t>(v >> (8 * i));
+  }
+  return true;
+}
+
+LinkRuntimeCommands::LinkRuntimeCommands(size_t max_payload)
+    : max_payload_(max_payload), reply_buf_(new uint8_t[max_payload + OVERHEAD])
+{
+  add(CMD_CAPS, handle_caps, this);
+}
+
+void LinkRuntimeCommands::handle_caps(void* user, const LinkFrameView& frame,
+                                      LinkReply* reply)
+{
+  (void)frame;  // No request data
+  LinkRuntimeCommands* self = static_cast<LinkRuntimeCommands*>(user);
+
+  // [caps u32][max payload u16][served commands: 64-bit map from 0x40]
+  uint64_t served = 0;
+  for (size_t i = 0; i < COUNT; i++)
+  {
+    if (self->entries_[i].handler != nullptr)
+    {
+      served |= 1ull << i;
+    }
+  }
+  reply->put_u32(self->caps_);
+  reply->put_u16(static_cast<uint16_t>(self->max_payload_));
+  reply->put_u32(static_cast<uint32_t>(served));
+  reply->put_u32(static_cast<uint32_t>(served >> 32));
+}
+
+bool LinkRuntimeCommands::add(uint8_t cmd, RuntimeCmdHandler handler, void* user)
+{
+  if (!is_runtime_cmd(cmd) || entries_[cmd - CMD_RUNTIME_FIRST].handler != nullptr)
+  {
+    return false;
+  }
+  entries_[cmd - CMD_RUNTIME_FIRST] = Entry{handler, user};
+  return true;
+}
+
+void LinkRuntimeCommands::dispatch(const LinkFrameView& frame, LinkReply* reply)
+{
+  const Entry& entry = entries_[frame.cmd - CMD_RUNTIME_FIRST];
+  if (!frame.crc_ok)
+  {
+    reply->status = STATUS_ERR_CRC;
+  }
+  else if (entry.handler == nullptr)
+  {
+    reply->status = STATUS_ERROR;
+  }
+  else
+  {
+    entry.handler(entry.user, frame, reply);
+  }
+}
+
+const uint8_t* LinkRuntimeCommands::handle(const LinkFrameView& frame, size_t* out_len)
+{
+  LinkReply reply = {STATUS_OK, reply_buf_.get() + HEADER_SIZE, 0, max_payload_};
+  dispatch(frame, &reply);
+
+  // Error responses carry no payload
+  size_t len = reply.status == STATUS_OK ? reply.len : 0;
+  *out_len = encode_frame(reply.status, reply.data, len, reply_buf_.get());
+  return reply_buf_.get();
+}
+
+void LinkRuntimeCommands::set_exec_filter(ExecFilter filter, void* user)
+{
+  if (filter != nullptr && !exec_buf_)
+  {
+    exec_buf_.reset(new uint8_t[max_payload_ + OVERHEAD]);
+  }
+  exec_filter_ = filter;
+  exec_filter_user_ = user;
+}
+
+const uint8_t* LinkRuntimeCommands::filter_exec(const LinkFrameView& frame,
+                                                size_t* out_len)
+{
+  *out_len = frame.raw_len;
+  if (exec_filter_ == nullptr || frame.cmd != CMD_EXEC || !frame.crc_ok ||
+      frame.len > max_payload_)
+  {
+    return frame.raw;
+  }
+
+  // The frame is a view into the receive buffer: filter a copy, then
+  // re-encode it so V4-link still sees a well-formed frame
+  uint8_t* code = exec_buf_.get() + HEADER_SIZE;
+  memcpy(code, frame.payload, frame.len);
+  size_t len = exec_filter_(exec_filter_user_, code, frame.len);
+  if (len > frame.len)
+  {
+    return frame.raw;  // Filters may only shrink the code
+  }
+  *out_len = encode_frame(CMD_EXEC, code, len, exec_buf_.get());
+  return exec_buf_.get();
+}
+
+}  // namespace v4rtos
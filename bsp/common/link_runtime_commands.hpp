@@ -0,0 +1,152 @@
+// Runtime-owned V4-link commands
+//
+// Commands 0x40..0x7F are answered by the runtime link port instead of
+// being replayed into v4::link::Link. Each BSP module registers the
+// commands it serves (memory statistics, profiling, ...) in this table.
+// The table can also carry a filter that rewrites EXEC payloads (e.g. the
+// peephole optimizer) before they are replayed into V4-link. It answers
+// CMD_CAPS itself, so hosts can negotiate optional features (such as
+// compressed uploads) before using them.
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "link_frame_scanner.hpp"
+#include "v4link_wire.hpp"
+
+namespace v4rtos
+{
+
+/**
+ * @brief Response being built by a runtime command handler
+ *
+ * The payload is written in place behind the frame header, so handing
+ * the finished frame to the TX path needs no further copy.
+ */
+struct LinkReply
+{
+  uint8_t status;  ///< Status code (STATUS_OK unless the handler changes it)
+  uint8_t* data;   ///< Payload buffer
+  size_t len;      ///< Payload bytes written
+  size_t cap;      ///< Payload capacity
+
+  /** Append one byte; returns false (and sets STATUS_ERROR) if full */
+  bool put_u8(uint8_t v);
+
+  /** Append a little-endian 16-bit value */
+  bool put_u16(uint16_t v);
+
+  /** Append a little-endian 32-bit value */
+  bool put_u32(uint32_t v);
+};
+
+/**
+ * @brief Runtime command handler
+ *
+ * @param user User pointer given to LinkRuntimeCommands::add()
+ * @param frame Request frame (CRC already checked)
+ * @param reply Response to fill
+ */
+using RuntimeCmdHandler = void (*)(void* user, const LinkFrameView& frame,
+                                   LinkReply* reply);
+
+/**
+ * @brief EXEC payload filter
+ *
+ * @param user User pointer given to LinkRuntimeCommands::set_exec_filter()
+ * @param code Bytecode, may be rewritten in place
+ * @param len Bytecode length
+ * @return New length (at most @p len)
+ */
+using ExecFilter = size_t (*)(void* user, uint8_t* code, size_t len);
+
+/**
+ * @brief Dispatch table for runtime link commands
+ */
+class LinkRuntimeCommands
+{
+ public:
+  /**
+   * @brief Construct table
+   * @param max_payload Largest response payload (bytes)
+   */
+  explicit LinkRuntimeCommands(size_t max_payload);
+
+  /**
+   * @brief Register a handler
+   * @param cmd Command in CMD_RUNTIME_FIRST..CMD_RUNTIME_LAST
+   * @return false if @p cmd is out of range or already taken
+   */
+  bool add(uint8_t cmd, RuntimeCmdHandler handler, void* user);
+
+  /**
+   * @brief Handle a runtime frame
+   *
+   * Bad CRC answers STATUS_ERR_CRC, unknown commands STATUS_ERROR.
+   *
+   * @param frame Request frame (is_runtime_cmd(frame.cmd) must hold)
+   * @param out_len Encoded response length
+   * @return Encoded response frame, valid until the next call
+   */
+  const uint8_t* handle(const LinkFrameView& frame, size_t* out_len);
+
+  /**
+   * @brief Run the handler of a runtime frame into @p reply
+   *
+   * handle() without the encoding, for commands that wrap other runtime
+   * commands (LinkWindow). Sets STATUS_ERR_CRC / STATUS_ERROR like handle().
+   */
+  void dispatch(const LinkFrameView& frame, LinkReply* reply);
+
+  /**
+   * @brief Advertise capability bits (link_wire::CAP_*) in CMD_CAPS
+   */
+  void add_caps(uint32_t caps)
+  {
+    caps_ |= caps;
+  }
+
+  /**
+   * @brief Install a filter for EXEC payloads (nullptr removes it)
+   */
+  void set_exec_filter(ExecFilter filter, void* user);
+
+  /**
+   * @brief Apply the EXEC filter to a core frame
+   *
+   * Frames other than valid-CRC EXEC frames, and all frames while no
+   * filter is installed, are returned unchanged.
+   *
+   * @param frame Core frame
+   * @param out_len Length of the returned frame
+   * @return Frame to replay into V4-link, valid until the next call
+   */
+  const uint8_t* filter_exec(const LinkFrameView& frame, size_t* out_len);
+
+ private:
+  struct Entry
+  {
+    RuntimeCmdHandler handler;
+    void* user;
+  };
+
+  static constexpr size_t COUNT =
+      link_wire::CMD_RUNTIME_LAST - link_wire::CMD_RUNTIME_FIRST + 1;
+
+  static void handle_caps(void* user, const LinkFrameView& frame, LinkReply* reply);
+
+  Entry entries_[COUNT] = {};             ///< Handlers by command
+  size_t max_payload_;                    ///< Response payload capacity
+  uint32_t caps_ = 0;                     ///< CMD_CAPS capability bits
+  std::unique_ptr<uint8_t[]> reply_buf_;  ///< Encoded response frame
+  ExecFilter exec_filter_ = nullptr;      ///< EXEC payload filter
+  void* exec_filter_user_ = nullptr;      ///< EXEC payload filter user
+  std::unique_ptr<uint8_t[]> exec_buf_;   ///< Filtered EXEC frame
+};
+
+}  // namespace v4rtos
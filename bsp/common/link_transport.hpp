@@ -0,0 +1,65 @@
+// Byte transport under a V4-link port
+//
+// A link port only needs to read received bytes with a timeout and to
+// hand response bytes over with a bounded wait; everything above that
+// (framing, runtime commands, VM routing) is the same whether the bytes
+// travel over USB Serial/JTAG, a UART or a host socket. Several ports,
+// each on its own transport, can serve the same VMs at once.
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace v4rtos
+{
+
+/**
+ * @brief Bidirectional byte stream carrying V4-link frames
+ */
+class LinkTransport
+{
+ public:
+  static constexpr uint32_t WAIT_FOREVER = UINT32_MAX;  ///< read() timeout: block
+
+  virtual ~LinkTransport() = default;
+
+  /**
+   * @brief Short transport name for logs ("usb", "uart1", "tcp:4000", ...)
+   */
+  virtual const char* name() const = 0;
+
+  /**
+   * @brief Read received bytes
+   *
+   * Returns as soon as at least one byte is available; never waits for
+   * @p cap bytes.
+   *
+   * @param buf Destination
+   * @param cap Size of @p buf
+   * @param timeout_ms Longest wait for the first byte (0: do not block,
+   *                   WAIT_FOREVER: block until data or close)
+   * @return Bytes read, 0 on timeout or signal, -1 once the peer is gone
+   *         for good
+   */
+  virtual int read(uint8_t* buf, size_t cap, uint32_t timeout_ms) = 0;
+
+  /**
+   * @brief Send bytes, waiting at most @p timeout_ms for room
+   *
+   * @return Bytes accepted (may be short; the rest is the caller's to retry)
+   */
+  virtual size_t write(const uint8_t* data, size_t len, uint32_t timeout_ms) = 0;
+
+  /**
+   * @brief TxRing sink forwarding to write() (user: LinkTransport)
+   */
+  static size_t tx_sink(void* user, const uint8_t* data, size_t len, uint32_t timeout_ms)
+  {
+    return static_cast<LinkTransport*>(user)->write(data, len, timeout_ms);
+  }
+};
+
+}  // namespace v4rtos
@@ -0,0 +1,169 @@
+// Windowed V4-link transfers implementation
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#include "link_window.hpp"
+
+#include <cstring>
+
+namespace v4rtos
+{
+
+using namespace link_wire;
+
+LinkWindow::LinkWindow(LinkRuntimeCommands* cmds, size_t buffer_capacity, size_t budget)
+    : cmds_(cmds),
+      slot_size_(buffer_capacity > DATA_HEADER ? buffer_capacity - DATA_HEADER : 0),
+      slots_(0)
+{
+  size_t slots = buffer_capacity > 0 ? budget / buffer_capacity : 0;
+  slots_ = static_cast<uint8_t>(slots < MAX_WINDOW ? slots : MAX_WINDOW);
+  if (slots_ > 0 && slot_size_ > 0)
+  {
+    buf_.reset(new uint8_t[slots_ * slot_size_]);
+    slot_.reset(new Slot[slots_]());
+    scratch_.reset(new uint8_t[slot_size_]);
+  }
+  else
+  {
+    slots_ = 0;
+  }
+}
+
+void LinkWindow::open(uint8_t window)
+{
+  window_ = window == 0 || window > slots_ ? slots_ : window;
+  next_ = 0;
+  head_ = 0;
+  fail_status_ = STATUS_OK;
+  fail_seq_ = 0;
+  for (uint8_t i = 0; i < slots_; i++)
+  {
+    slot_[i].held = false;
+  }
+}
+
+void LinkWindow::run(uint16_t seq, uint8_t cmd, const uint8_t* payload, size_t len)
+{
+  stats_.delivered++;
+  if (fail_status_ != STATUS_OK)
+  {
+    return;  // The host aborts the transfer; later frames are moot
+  }
+
+  // Only runtime commands answered by the table, never CMD_WINDOW itself
+  LinkReply reply = {STATUS_OK, scratch_.get(), 0, slot_size_};
+  if (!is_runtime_cmd(cmd) || cmd == CMD_WINDOW)
+  {
+    reply.status = STATUS_ERROR;
+  }
+  else
+  {
+    LinkFrameView inner = {cmd, payload, len, nullptr, 0, true};
+    cmds_->dispatch(inner, &reply);
+  }
+  if (reply.status != STATUS_OK)
+  {
+    fail_status_ = reply.status;
+    fail_seq_ = seq;
+  }
+}
+
+void LinkWindow::receive(uint16_t seq, uint8_t cmd, const uint8_t* payload, size_t len)
+{
+  uint16_t ahead = static_cast<uint16_t>(seq - next_);
+  if (ahead >= 0x8000)
+  {
+    stats_.duplicates++;  // Already run; the acknowledgement got lost
+    return;
+  }
+  if (ahead >= window_)
+  {
+    stats_.dropped++;
+    return;
+  }
+
+  if (ahead > 0)
+  {
+    // Ahead of a gap: park it until the missing frames arrive
+    Slot& s = slot_[index(ahead)];
+    if (s.held)
+    {
+      stats_.duplicates++;
+      return;
+    }
+    memcpy(buf_.get() + index(ahead) * slot_size_, payload, len);
+    s = Slot{true, cmd, static_cast<uint16_t>(len)};
+    stats_.reordered++;
+    return;
+  }
+
+  // In order: run straight from the receive buffer, then whatever it unblocks
+  run(next_, cmd, payload, len);
+  for (;;)
+  {
+    next_++;
+    head_ = static_cast<uint8_t>(index(1));
+    Slot& s = slot_[head_];
+    if (!s.held)
+    {
+      break;
+    }
+    s.held = false;
+    run(next_, s.cmd, buf_.get() + head_ * slot_size_, s.len);
+  }
+}
+
+void LinkWindow::acknowledge(LinkReply* reply) const
+{
+  uint32_t sack = 0;
+  for (uint8_t i = 1; i < window_; i++)
+  {
+    if (slot_[index(i)].held)
+    {
+      sack |= 1u << (i - 1);
+    }
+  }
+  reply->put_u16(next_);
+  reply->put_u32(sack);
+  reply->put_u8(fail_status_);
+  reply->put_u16(fail_seq_);
+}
+
+void LinkWindow::handle_command(void* user, const LinkFrameView& frame, LinkReply* reply)
+{
+  auto* self = static_cast<LinkWindow*>(user);
+  if (frame.len < 1 || self->slots_ == 0)
+  {
+    reply->status = STATUS_ERROR;
+    return;
+  }
+
+  const uint8_t* p = frame.payload + 1;
+  switch (frame.payload[0])
+  {
+    case OP_OPEN:
+      self->open(frame.len >= 2 ? p[0] : 0);
+      reply->put_u8(self->window_);
+      reply->put_u16(static_cast<uint16_t>(self->slot_size_));
+      return;
+
+    case OP_DATA:
+      if (self->window_ == 0 || frame.len < DATA_HEADER ||
+          frame.len - DATA_HEADER > self->slot_size_)
+      {
+        reply->status = STATUS_ERROR;
+        return;
+      }
+      self->receive(static_cast<uint16_t>(p[0] | (p[1] << 8)), p[2],
+                    frame.payload + DATA_HEADER, frame.len - DATA_HEADER);
+      self->acknowledge(reply);
+      return;
+
+    default:
+      reply->status = STATUS_ERROR;
+      return;
+  }
+}
+
+}  // namespace v4rtos
@@ -0,0 +1,136 @@
+// Windowed (pipelined) V4-link transfers
+//
+// Plain runtime commands are stop-and-wait: the host sends a frame and
+// waits a round trip for its response. CMD_WINDOW wraps runtime command
+// frames in 16-bit sequence numbers so the host can keep several of them
+// in flight. Every DATA frame is answered with the next sequence number
+// expected and a bitmap of the frames already held behind it (selective
+// acknowledgement); the host resends only the frames missing there.
+// Frames arriving ahead of a gap wait in a reorder buffer and are run in
+// sequence order, each exactly once, so a resent WRITE never lands twice.
+//
+// The reorder buffer holds whole payloads, so the window (in frames) is
+// the memory budget divided by the link buffer capacity.
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "link_frame_scanner.hpp"
+#include "link_runtime_commands.hpp"
+
+namespace v4rtos
+{
+
+/**
+ * @brief Sequence-numbered, selectively acknowledged runtime commands
+ */
+class LinkWindow
+{
+ public:
+  /** CMD_WINDOW operations (first payload byte) */
+  enum Op : uint8_t
+  {
+    OP_OPEN = 0,  ///< [window u8] -> [window u8][max_len u16]; restarts at seq 0
+    OP_DATA = 1   ///< [seq u16][cmd u8][payload...] -> acknowledgement
+  };
+
+  static constexpr uint8_t MAX_WINDOW = 32;  ///< Width of the SACK bitmap
+  static constexpr size_t DATA_HEADER = 4;   ///< op + seq + cmd
+
+  /** Transfer counters */
+  struct Stats
+  {
+    uint64_t delivered;   ///< Frames run, in sequence order
+    uint64_t reordered;   ///< Frames held until a gap was filled
+    uint64_t duplicates;  ///< Frames received again (already run or held)
+    uint64_t dropped;     ///< Frames beyond the window
+  };
+
+  /**
+   * @brief Construct window
+   *
+   * @param cmds Table the wrapped commands are dispatched through
+   * @param buffer_capacity V4-link buffer capacity (largest frame payload)
+   * @param budget Reorder buffer size in bytes; the window is
+   *               budget / buffer_capacity frames (at most MAX_WINDOW)
+   */
+  LinkWindow(LinkRuntimeCommands* cmds, size_t buffer_capacity, size_t budget);
+
+  LinkWindow(const LinkWindow&) = delete;
+  LinkWindow& operator=(const LinkWindow&) = delete;
+
+  /** Largest window the reorder buffer allows (0: disabled) */
+  uint8_t capacity() const
+  {
+    return slots_;
+  }
+
+  /** Window negotiated by the last OP_OPEN */
+  uint8_t window() const
+  {
+    return window_;
+  }
+
+  /** Largest payload of a wrapped command */
+  size_t max_len() const
+  {
+    return slot_size_;
+  }
+
+  /** Transfer counters */
+  const Stats& stats() const
+  {
+    return stats_;
+  }
+
+  /**
+   * @brief CMD_WINDOW handler (user: LinkWindow)
+   *
+   * DATA frames are acknowledged with
+   * [next u16][sack u32][status u8][fail_seq u16]: bit i of sack is set if
+   * frame next + 1 + i is held, status is that of the first wrapped
+   * command that failed (STATUS_OK: none) and fail_seq its sequence
+   * number. Frames after a failure are acknowledged but not run.
+   */
+  static void handle_command(void* user, const LinkFrameView& frame, LinkReply* reply);
+
+ private:
+  /** Reorder buffer entry */
+  struct Slot
+  {
+    bool held;     ///< Payload waiting for earlier frames
+    uint8_t cmd;   ///< Wrapped command
+    uint16_t len;  ///< Payload length
+  };
+
+  /** Slot of the frame @p ahead sequence numbers past next_ */
+  size_t index(uint16_t ahead) const
+  {
+    return (head_ + ahead) % window_;
+  }
+
+  void open(uint8_t window);
+  void receive(uint16_t seq, uint8_t cmd, const uint8_t* payload, size_t len);
+  void run(uint16_t seq, uint8_t cmd, const uint8_t* payload, size_t len);
+  void acknowledge(LinkReply* reply) const;
+
+  LinkRuntimeCommands* cmds_;                   ///< Dispatch table
+  size_t slot_size_;                            ///< Payload bytes per slot
+  uint8_t slots_;                               ///< Reorder slots allocated
+  uint8_t window_ = 0;                          ///< Negotiated window (0: not open)
+  uint8_t head_ = 0;                            ///< Slot of sequence number next_
+  uint16_t next_ = 0;                           ///< Next sequence number to run
+  uint8_t fail_status_ = link_wire::STATUS_OK;  ///< First failed command status
+  uint16_t fail_seq_ = 0;                       ///< Its sequence number
+  std::unique_ptr<uint8_t[]> buf_;              ///< Slot payloads
+  std::unique_ptr<Slot[]> slot_;                ///< Slot state
+  std::unique_ptr<uint8_t[]> scratch_;          ///< Wrapped replies (dropped)
+  Stats stats_ = {};                            ///< Counters
+};
+
+}  // namespace v4rtos
@@ -0,0 +1,198 @@
+// Streaming LZ4 block decoder implementation
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#include "lz4_stream.hpp"
+
+#include <cstring>
+
+namespace v4rtos
+{
+
+static constexpr size_t MIN_MATCH = 4;  ///< Match length bias of the format
+
+Lz4StreamDecoder::Lz4StreamDecoder(WriteFn write, void* user, uint8_t* stage,
+                                   size_t stage_size)
+    : write_(write), user_(user), stage_(stage), stage_size_(stage_size)
+{
+  start(nullptr, 0);
+}
+
+void Lz4StreamDecoder::start(const uint8_t* out, size_t capacity)
+{
+  out_ = out;
+  capacity_ = capacity;
+  flushed_ = 0;
+  pos_ = 0;
+  state_ = State::TOKEN;
+  token_ = 0;
+  lit_len_ = 0;
+  match_len_ = 0;
+  offset_ = 0;
+}
+
+bool Lz4StreamDecoder::flush()
+{
+  if (pos_ > flushed_ && !write_(user_, flushed_, stage_, pos_ - flushed_))
+  {
+    return false;
+  }
+  flushed_ = pos_;
+  return true;
+}
+
+bool Lz4StreamDecoder::copy_match()
+{
+  size_t len = match_len_ + MIN_MATCH;
+  if (len > capacity_ - pos_)
+  {
+    return false;
+  }
+
+  while (len > 0)
+  {
+    size_t staged = pos_ - flushed_;
+    size_t n = stage_size_ - staged;
+    n = n < len ? n : len;
+    size_t src = pos_ - offset_;
+
+    if (src >= flushed_ && offset_ >= n)
+    {
+      // History still staged, no overlap with the bytes being produced
+      memcpy(stage_ + staged, stage_ + (src - flushed_), n);
+    }
+    else if (src + n <= flushed_)
+    {
+      // History already in the destination
+      memcpy(stage_ + staged, out_ + src, n);
+    }
+    else
+    {
+      // Overlapping run (offset < length) or straddling the flush point
+      for (size_t i = 0; i < n; i++, src++)
+      {
+        stage_[staged + i] = src >= flushed_ ? stage_[src - flushed_] : out_[src];
+      }
+    }
+    pos_ += n;
+    len -= n;
+    if (pos_ - flushed_ == stage_size_ && !flush())
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool Lz4StreamDecoder::feed(const uint8_t* data, size_t len)
+{
+  const uint8_t* p = data;
+  const uint8_t* end = data + len;
+
+  while (p < end && state_ != State::FAILED)
+  {
+    switch (state_)
+    {
+      case State::TOKEN:
+        token_ = *p++;
+        lit_len_ = token_ >> 4;
+        state_ = lit_len_ == 15 ? State::LIT_LEN
+                 : lit_len_ > 0 ? State::LITERALS
+                                : State::OFFSET_LO;
+        break;
+
+      case State::LIT_LEN:
+      {
+        uint8_t b = *p++;
+        lit_len_ += b;
+        if (b != 255)
+        {
+          state_ = State::LITERALS;
+        }
+        break;
+      }
+
+      case State::LITERALS:
+      {
+        size_t n = stage_size_ - (pos_ - flushed_);
+        n = n < lit_len_ ? n : lit_len_;
+        n = n < static_cast<size_t>(end - p) ? n : static_cast<size_t>(end - p);
+        if (n > capacity_ - pos_)
+        {
+          state_ = State::FAILED;
+          break;
+        }
+        memcpy(stage_ + (pos_ - flushed_), p, n);
+        p += n;
+        pos_ += n;
+        lit_len_ -= n;
+        if (pos_ - flushed_ == stage_size_ && !flush())
+        {
+          state_ = State::FAILED;
+          break;
+        }
+        if (lit_len_ == 0)
+        {
+          state_ = State::OFFSET_LO;
+        }
+        break;
+      }
+
+      case State::OFFSET_LO:
+        offset_ = *p++;
+        state_ = State::OFFSET_HI;
+        break;
+
+      case State::OFFSET_HI:
+        offset_ |= static_cast<size_t>(*p++) << 8;
+        match_len_ = token_ & 0x0F;
+        if (offset_ == 0 || offset_ > pos_)
+        {
+          state_ = State::FAILED;
+        }
+        else if (match_len_ == 15)
+        {
+          state_ = State::MATCH_LEN;
+        }
+        else
+        {
+          state_ = copy_match() ? State::TOKEN : State::FAILED;
+        }
+        break;
+
+      case State::MATCH_LEN:
+      {
+        uint8_t b = *p++;
+        match_len_ += b;
+        if (b != 255)
+        {
+          state_ = copy_match() ? State::TOKEN : State::FAILED;
+        }
+        break;
+      }
+
+      case State::FAILED:
+        break;
+    }
+  }
+  return state_ != State::FAILED;
+}
+
+bool Lz4StreamDecoder::finish()
+{
+  // A block ends with a literal-only sequence (OFFSET_LO); also accept a
+  // stream cut after a complete match
+  if (state_ != State::OFFSET_LO && state_ != State::TOKEN)
+  {
+    state_ = State::FAILED;
+    return false;
+  }
+  if (!flush())
+  {
+    state_ = State::FAILED;
+    return false;
+  }
+  return true;
+}
+
+}  // namespace v4rtos
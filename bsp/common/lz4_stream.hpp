@@ -0,0 +1,113 @@
+// Streaming LZ4 block decoder
+//
+// Decodes the LZ4 block format (as produced by LZ4_compress_default() or
+// scripts/v4image.py) fed in arbitrary chunks, e.g. one V4-link frame at
+// a time, straight into its destination. Match copies read their history
+// back from the destination itself (RAM or a flash mapping), so no
+// window buffer is kept: only a small staging buffer batches writes,
+// which matters for flash pages.
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace v4rtos
+{
+
+/**
+ * @brief LZ4 block decoder writing through a callback
+ */
+class Lz4StreamDecoder
+{
+ public:
+  /**
+   * @brief Store decoded bytes at @p offset of the destination
+   * @return false to abort decoding
+   */
+  using WriteFn = bool (*)(void* user, size_t offset, const uint8_t* data, size_t len);
+
+  /**
+   * @brief Construct decoder
+   *
+   * @param write Stores decoded bytes
+   * @param user Passed to @p write
+   * @param stage Staging buffer (caller-owned)
+   * @param stage_size Staging buffer size, the largest single write
+   */
+  Lz4StreamDecoder(WriteFn write, void* user, uint8_t* stage, size_t stage_size);
+
+  Lz4StreamDecoder(const Lz4StreamDecoder&) = delete;
+  Lz4StreamDecoder& operator=(const Lz4StreamDecoder&) = delete;
+
+  /**
+   * @brief Start a new stream at offset 0 of a destination
+   *
+   * @param out Read view of the destination (history for match copies)
+   * @param capacity Destination size; decoding past it fails
+   */
+  void start(const uint8_t* out, size_t capacity);
+
+  /**
+   * @brief Decode the next chunk of the stream
+   * @return false once the stream is corrupt, overflows or a write failed
+   */
+  bool feed(const uint8_t* data, size_t len);
+
+  /**
+   * @brief Flush staged bytes and check the stream ended cleanly
+   * @return true if all input formed complete sequences
+   */
+  bool finish();
+
+  /** Bytes decoded so far (staged ones included) */
+  size_t size() const
+  {
+    return pos_;
+  }
+
+  /** true once the stream failed */
+  bool failed() const
+  {
+    return state_ == State::FAILED;
+  }
+
+  /** true if nothing was fed since start() */
+  bool idle() const
+  {
+    return pos_ == 0 && state_ == State::TOKEN;
+  }
+
+ private:
+  enum class State : uint8_t
+  {
+    TOKEN,      ///< Expecting a sequence token
+    LIT_LEN,    ///< Literal length extension bytes
+    LITERALS,   ///< Copying literals
+    OFFSET_LO,  ///< Match offset, low byte (or end of block)
+    OFFSET_HI,  ///< Match offset, high byte
+    MATCH_LEN,  ///< Match length extension bytes
+    FAILED      ///< Corrupt stream or write error
+  };
+
+  bool flush();
+  bool copy_match();
+
+  const uint8_t* out_;  ///< Destination read view
+  size_t capacity_;     ///< Destination size
+  WriteFn write_;       ///< Destination writer
+  void* user_;          ///< WriteFn user
+  uint8_t* stage_;      ///< Pending output
+  size_t stage_size_;   ///< Staging capacity
+  size_t flushed_;      ///< Bytes already written (stage_ starts here)
+  size_t pos_;          ///< Bytes decoded
+  State state_;         ///< Parser state
+  uint8_t token_;       ///< Current sequence token
+  size_t lit_len_;      ///< Literal bytes left / length being read
+  size_t match_len_;    ///< Match length being read
+  size_t offset_;       ///< Match offset being read
+};
+
+}  // namespace v4rtos
@@ -0,0 +1,96 @@
+// Memory high-water-mark tracking implementation
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#include "mem_watermark.hpp"
+
+#include <cstring>
+
+#include "link_runtime_commands.hpp"
+
+namespace v4rtos
+{
+
+static constexpr uint8_t PAINT = 0xCD;
+static constexpr uint32_t PAINT_WORD = 0xCDCDCDCDu;
+
+void mem_paint(uint8_t* base, size_t size)
+{
+  memset(base, PAINT, size);
+}
+
+size_t mem_painted_high_water(const uint8_t* base, size_t size)
+{
+  // Word-wise scan down from the top; regions are 4-byte aligned
+  size_t end = size;
+  while (end >= 4)
+  {
+    uint32_t word;
+    memcpy(&word, base + end - 4, 4);
+    if (word != PAINT_WORD)
+    {
+      break;
+    }
+    end -= 4;
+  }
+  while (end > 0 && base[end - 1] == PAINT)
+  {
+    end--;
+  }
+  return end;
+}
+
+const char* mem_region_name(MemRegion region)
+{
+  switch (region)
+  {
+    case MemRegion::VM_ARENA:
+      return "vm arena";
+    case MemRegion::NAME_ARENA:
+      return "name arena";
+    case MemRegion::DATA_STACK:
+      return "data stack";
+    case MemRegion::RETURN_STACK:
+      return "return stack";
+    case MemRegion::LINK_TASK_STACK:
+      return "link task stack";
+    case MemRegion::MAIN_TASK_STACK:
+      return "main task stack";
+    case MemRegion::LINK_RX_CHUNK:
+      return "link rx read";
+    case MemRegion::LINK_PAYLOAD:
+      return "link payload";
+    case MemRegion::LINK_STAGE:
+      return "link stage";
+    case MemRegion::LINK_TX_RING:
+      return "link tx ring";
+    default:
+      return "?";
+  }
+}
+
+void MemWatermarks::update(MemRegion region, size_t used, size_t capacity)
+{
+  Entry& e = entries_[static_cast<size_t>(region)];
+  e.capacity = static_cast<uint32_t>(capacity);
+  if (used > e.used)
+  {
+    e.used = static_cast<uint32_t>(used);
+  }
+}
+
+void MemWatermarks::encode(LinkReply* reply) const
+{
+  for (size_t i = 0; i < static_cast<size_t>(MemRegion::COUNT); i++)
+  {
+    if (entries_[i].capacity == 0)
+    {
+      continue;
+    }
+    reply->put_u8(static_cast<uint8_t>(i));
+    reply->put_u32(entries_[i].used);
+    reply->put_u32(entries_[i].capacity);
+  }
+}
+
+}  // namespace v4rtos
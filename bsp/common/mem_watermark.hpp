@@ -0,0 +1,96 @@
+// Memory high-water-mark tracking
+//
+// Regions whose fill level is not otherwise observable (VM arena, word
+// name arena) are painted with a known pattern before use; the high-water
+// mark is the highest byte that no longer holds the pattern. Other regions
+// (task stacks, link buffers) report a measured peak directly.
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "runtime_sys_ids.hpp"  // SYS_MEM_WATERMARK
+
+namespace v4rtos
+{
+
+struct LinkReply;
+
+/** Memory regions with a tracked high-water mark (wire IDs, keep stable) */
+enum class MemRegion : uint8_t
+{
+  VM_ARENA = 0,         ///< VmConfig.mem (dictionary, stacks, temporaries)
+  NAME_ARENA = 1,       ///< VmConfig.arena (word names)
+  DATA_STACK = 2,       ///< VM data stack (cells)
+  RETURN_STACK = 3,     ///< VM return stack (cells)
+  LINK_TASK_STACK = 4,  ///< Link task stack (bytes)
+  MAIN_TASK_STACK = 5,  ///< Startup task stack (bytes)
+  LINK_RX_CHUNK = 6,    ///< Largest single transport read vs. read buffer
+  LINK_PAYLOAD = 7,     ///< Largest frame payload vs. V4-link buffer_size
+  LINK_STAGE = 8,       ///< Largest frame reassembled across reads
+  LINK_TX_RING = 9,     ///< Peak queued response bytes vs. TX ring size
+  COUNT
+};
+
+/** VM stack capacities (cells), as built into V4-engine */
+constexpr uint32_t V4_DS_CAPACITY = 256;
+constexpr uint32_t V4_RS_CAPACITY = 64;
+
+/**
+ * @brief Fill a region with the watermark pattern
+ */
+void mem_paint(uint8_t* base, size_t size);
+
+/**
+ * @brief Get number of bytes from @p base up to the last overwritten byte
+ *
+ * Assumes bottom-up allocation (bump allocators, dictionary growth).
+ */
+size_t mem_painted_high_water(const uint8_t* base, size_t size);
+
+/**
+ * @brief Get printable region name
+ */
+const char* mem_region_name(MemRegion region);
+
+/**
+ * @brief Peak usage per region
+ */
+class MemWatermarks
+{
+ public:
+  /** One region's high-water mark (capacity 0: region not present) */
+  struct Entry
+  {
+    uint32_t used;      ///< Peak usage
+    uint32_t capacity;  ///< Region size
+  };
+
+  /**
+   * @brief Record a usage sample (keeps the maximum)
+   */
+  void update(MemRegion region, size_t used, size_t capacity);
+
+  /**
+   * @brief Get a region's high-water mark
+   */
+  const Entry& get(MemRegion region) const
+  {
+    return entries_[static_cast<size_t>(region)];
+  }
+
+  /**
+   * @brief Append all present regions to a CMD_MEM_STATS reply
+   *
+   * Record format: [region u8][used u32 LE][capacity u32 LE]
+   */
+  void encode(LinkReply* reply) const;
+
+ private:
+  Entry entries_[static_cast<size_t>(MemRegion::COUNT)] = {};
+};
+
+}  // namespace v4rtos
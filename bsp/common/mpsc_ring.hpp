@@ -0,0 +1,143 @@
+// Lock-free multi-producer, single-consumer ring of fixed-size records
+//
+// Producers (tasks and interrupts) reserve a slot with one compare-and-swap
+// on the head index and publish it with a release store of the slot's
+// sequence number, so pushing never blocks; a full ring drops the record
+// and counts it. The one consumer removes records in reservation order.
+// Used by the event trace (TraceBuffer) and the deferred log (DeferredLog).
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace v4rtos
+{
+
+/**
+ * @brief Lock-free MPSC ring
+ *
+ * A producer preempted between reserving and publishing its record holds
+ * back the records reserved after it until it resumes; none are lost.
+ *
+ * @tparam T Record type (trivially copyable)
+ */
+template <class T>
+class MpscRing
+{
+ public:
+  static constexpr size_t MAX_CAPACITY = 0x8000;  ///< Records (fits a u16 count)
+
+  /**
+   * @brief Construct ring
+   * @param capacity Records (rounded up to a power of two, at most MAX_CAPACITY)
+   */
+  explicit MpscRing(size_t capacity)
+      : capacity_(round_up(capacity)), slots_(new Slot[capacity_])
+  {
+  }
+
+  /**
+   * @brief Append a record (any producer)
+   * @return false if the ring was full and the record was dropped
+   */
+  bool push(const T& rec)
+  {
+    uint32_t head = head_.load(std::memory_order_relaxed);
+    do
+    {
+      if (head - tail_.load(std::memory_order_acquire) >= capacity_)
+      {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+    } while (!head_.compare_exchange_weak(head, head + 1, std::memory_order_relaxed));
+
+    Slot& slot = slots_[head & (capacity_ - 1)];
+    slot.rec = rec;
+    slot.seq.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Remove the oldest published record (consumer only)
+   * @return false if none is published yet
+   */
+  bool pop(T* rec)
+  {
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+    Slot& slot = slots_[tail & (capacity_ - 1)];
+    if (slot.seq.load(std::memory_order_acquire) != tail + 1)
+    {
+      return false;  // Empty, or the oldest record is still being written
+    }
+    *rec = slot.rec;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Discard all published records (consumer only)
+   */
+  void clear()
+  {
+    T rec;
+    while (pop(&rec))
+    {
+    }
+  }
+
+  /**
+   * @brief Get number of reserved records not yet removed
+   */
+  size_t pending() const
+  {
+    return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief Get number of records dropped because the ring was full
+   */
+  uint32_t dropped() const
+  {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Get ring capacity in records
+   */
+  size_t capacity() const
+  {
+    return capacity_;
+  }
+
+ private:
+  /** Record with its publication stamp (index + 1) */
+  struct Slot
+  {
+    std::atomic<uint32_t> seq{0};
+    T rec;
+  };
+
+  static uint32_t round_up(size_t capacity)
+  {
+    uint32_t size = 1;
+    while (size < capacity && size < MAX_CAPACITY)
+    {
+      size <<= 1;
+    }
+    return size;
+  }
+
+  uint32_t capacity_;                 ///< Records (power of two)
+  std::unique_ptr<Slot[]> slots_;     ///< Ring storage
+  std::atomic<uint32_t> head_{0};     ///< Next index to reserve (free-running)
+  std::atomic<uint32_t> tail_{0};     ///< Next index to remove (free-running)
+  std::atomic<uint32_t> dropped_{0};  ///< Records lost to a full ring
+};
+
+}  // namespace v4rtos
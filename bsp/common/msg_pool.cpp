@@ -0,0 +1,296 @@
+// Pooled zero-copy message passing between tasks
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#include "msg_pool.hpp"
+
+#include <cstring>
+
+#include "trace_buffer.hpp"
+
+namespace v4rtos
+{
+
+namespace
+{
+
+/** Holds the Sync lock for a scope */
+class SyncGuard
+{
+ public:
+  explicit SyncGuard(const MsgPool::Sync& sync) : sync_(sync)
+  {
+    sync_.lock(sync_.user);
+  }
+
+  ~SyncGuard()
+  {
+    sync_.unlock(sync_.user);
+  }
+
+  SyncGuard(const SyncGuard&) = delete;
+  SyncGuard& operator=(const SyncGuard&) = delete;
+
+ private:
+  const MsgPool::Sync& sync_;
+};
+
+}  // namespace
+
+MsgPool::MsgPool(const Sync& sync) : sync_(sync)
+{
+  memset(free_, 0, sizeof(free_));
+  memset(refs_, 0, sizeof(refs_));
+  memset(queued_, 0, sizeof(queued_));
+  memset(queues_, 0, sizeof(queues_));
+  memset(waiters_, 0, sizeof(waiters_));
+}
+
+MsgPool::Status MsgPool::setup(uint32_t base, uint32_t block_size, uint16_t count)
+{
+  if (block_size == 0 || block_size > UINT16_MAX || count == 0 || count > MAX_BLOCKS ||
+      (uint64_t)base + (uint64_t)block_size * count > UINT32_MAX + 1ull)
+  {
+    return ERR_INVALID;
+  }
+
+  SyncGuard guard(sync_);
+  base_ = base;
+  block_size_ = block_size;
+  count_ = count;
+
+  // Stack the blocks so the first alloc() returns the lowest address
+  for (uint16_t i = 0; i < count; i++)
+  {
+    free_[i] = (uint8_t)(count - 1 - i);
+  }
+  free_top_ = count;
+  memset(refs_, 0, sizeof(refs_));
+  memset(queued_, 0, sizeof(queued_));
+  memset(queues_, 0, sizeof(queues_));
+  stats_ = {};
+
+  // Tasks blocked on the old layout must not pick up blocks of the new one
+  epoch_++;
+  for (uint8_t channel = 0; channel < CHANNELS; channel++)
+  {
+    notify(channel);
+  }
+  return OK;
+}
+
+MsgPool::Status MsgPool::alloc(uint32_t* addr, uint32_t timeout_ms)
+{
+  SyncGuard guard(sync_);
+  uint32_t epoch = epoch_;
+  uint32_t start_ms = start_time(timeout_ms);
+  bool waited = false;
+
+  for (;;)
+  {
+    if (!ready())
+    {
+      return ERR_NOMEM;
+    }
+    if (free_top_ > 0)
+    {
+      uint8_t index = free_[--free_top_];
+      refs_[index] = 1;
+      stats_.in_use++;
+      if (stats_.in_use > stats_.in_use_peak)
+      {
+        stats_.in_use_peak = stats_.in_use;
+      }
+      *addr = base_ + index * block_size_;
+      return OK;
+    }
+
+    if (!waited)
+    {
+      stats_.alloc_waits++;
+      waited = true;
+    }
+    Status status = wait_for_change(ALLOC_CHANNEL, start_ms, timeout_ms, epoch);
+    if (status != OK)
+    {
+      return status;
+    }
+  }
+}
+
+MsgPool::Status MsgPool::retain(uint32_t addr)
+{
+  SyncGuard guard(sync_);
+  int index = block_index(addr);
+  if (index < 0 || refs_[index] == 0)
+  {
+    return ERR_INVALID;
+  }
+  if (refs_[index] == UINT8_MAX)
+  {
+    return ERR_BUSY;
+  }
+  refs_[index]++;
+  return OK;
+}
+
+MsgPool::Status MsgPool::release(uint32_t addr)
+{
+  SyncGuard guard(sync_);
+  int index = block_index(addr);
+
+  // A reference sitting in a queue belongs to the receiver, not the caller
+  if (index < 0 || refs_[index] <= queued_[index])
+  {
+    return ERR_INVALID;
+  }
+
+  if (--refs_[index] == 0)
+  {
+    free_[free_top_++] = (uint8_t)index;
+    stats_.in_use--;
+    notify(ALLOC_CHANNEL);
+  }
+  return OK;
+}
+
+MsgPool::Status MsgPool::send(uint8_t task, uint32_t addr, uint32_t len,
+                              uint32_t timeout_ms)
+{
+  SyncGuard guard(sync_);
+  uint32_t epoch = epoch_;
+  uint32_t start_ms = start_time(timeout_ms);
+  bool waited = false;
+
+  int index = block_index(addr);
+  if (task >= MAX_QUEUES || index < 0 || refs_[index] <= queued_[index] ||
+      len > block_size_)
+  {
+    return ready() ? ERR_INVALID : ERR_NOMEM;
+  }
+
+  Queue& queue = queues_[task];
+  while (queue.size == QUEUE_DEPTH)
+  {
+    if (!waited)
+    {
+      stats_.send_waits++;
+      waited = true;
+    }
+    Status status = wait_for_change(MAX_QUEUES + task, start_ms, timeout_ms, epoch);
+    if (status != OK)
+    {
+      return status;
+    }
+  }
+
+  queue.slots[(queue.head + queue.size) % QUEUE_DEPTH] = {addr, (uint16_t)len};
+  queue.size++;
+  queued_[index]++;
+  stats_.sent++;
+  trace_event(TRACE_MSG_SEND, task, (uint16_t)len, addr);
+  notify(task);
+  return OK;
+}
+
+MsgPool::Status MsgPool::recv(uint8_t task, Message* msg, uint32_t timeout_ms)
+{
+  SyncGuard guard(sync_);
+  uint32_t epoch = epoch_;
+  uint32_t start_ms = start_time(timeout_ms);
+
+  if (task >= MAX_QUEUES)
+  {
+    return ERR_INVALID;
+  }
+
+  Queue& queue = queues_[task];
+  for (;;)
+  {
+    if (!ready())
+    {
+      return ERR_NOMEM;
+    }
+    if (queue.size > 0)
+    {
+      break;
+    }
+    Status status = wait_for_change(task, start_ms, timeout_ms, epoch);
+    if (status != OK)
+    {
+      return status;
+    }
+  }
+
+  *msg = queue.slots[queue.head];
+  queue.head = (uint8_t)((queue.head + 1) % QUEUE_DEPTH);
+  queue.size--;
+  queued_[block_index(msg->addr)]--;
+  stats_.received++;
+  trace_event(TRACE_MSG_RECV, task, msg->len, msg->addr);
+
+  // Room in the queue for a blocked sender
+  notify(MAX_QUEUES + task);
+  return OK;
+}
+
+MsgPool::Stats MsgPool::stats()
+{
+  SyncGuard guard(sync_);
+  return stats_;
+}
+
+int MsgPool::block_index(uint32_t addr) const
+{
+  if (!ready() || addr < base_)
+  {
+    return -1;
+  }
+  uint32_t offset = addr - base_;
+  if (offset % block_size_ != 0 || offset / block_size_ >= count_)
+  {
+    return -1;
+  }
+  return (int)(offset / block_size_);
+}
+
+uint32_t MsgPool::start_time(uint32_t timeout_ms) const
+{
+  // Only finite, non-zero timeouts need a clock
+  if (timeout_ms == 0 || timeout_ms == WAIT_FOREVER)
+  {
+    return 0;
+  }
+  return sync_.now_ms(sync_.user);
+}
+
+MsgPool::Status MsgPool::wait_for_change(uint8_t channel, uint32_t start_ms,
+                                         uint32_t timeout_ms, uint32_t epoch)
+{
+  uint32_t wait_ms = timeout_ms;
+  if (timeout_ms != WAIT_FOREVER)
+  {
+    uint32_t elapsed = timeout_ms == 0 ? 0 : sync_.now_ms(sync_.user) - start_ms;
+    if (elapsed >= timeout_ms)
+    {
+      stats_.timeouts++;
+      return ERR_TIMEOUT;
+    }
+    wait_ms = timeout_ms - elapsed;
+  }
+
+  waiters_[channel]++;
+  sync_.wait(sync_.user, channel, wait_ms);
+  waiters_[channel]--;
+  return epoch == epoch_ ? OK : ERR_INVALID;
+}
+
+void MsgPool::notify(uint8_t channel)
+{
+  if (waiters_[channel] > 0)
+  {
+    sync_.wake(sync_.user, channel);
+  }
+}
+
+}  // namespace v4rtos
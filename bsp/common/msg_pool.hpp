@@ -0,0 +1,202 @@
+// Pooled zero-copy message passing between tasks
+//
+// Messages are fixed-size blocks carved out of memory the tasks already
+// share (a buffer in VM memory for Forth tasks). A block is reference
+// counted and only its address travels through the queues: the sender
+// fills it in place and hands its reference to the receiver, which reads
+// it in place and frees it. Each task has its own bounded queue, so
+// producers only contend with other producers for the same consumer.
+//
+// The pool never dereferences block addresses, so they may be VM
+// addresses. Locking and blocking are supplied by the BSP (Sync), keeping
+// this module free of SDK dependencies.
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "runtime_sys_ids.hpp"  // SYS_MSG_POOL .. SYS_MSG_FREE
+
+namespace v4rtos
+{
+
+/**
+ * @brief Reference-counted message blocks with per-task queues
+ *
+ * All operations are thread-safe through Sync. Operations taking a
+ * timeout block on Sync::wait() until they can complete; 0 fails
+ * immediately and WAIT_FOREVER never times out.
+ */
+class MsgPool
+{
+ public:
+  static constexpr uint16_t MAX_BLOCKS = 64;            ///< Blocks per pool
+  static constexpr uint8_t MAX_QUEUES = 8;              ///< Task ids 0..MAX_QUEUES-1
+  static constexpr uint8_t QUEUE_DEPTH = 16;            ///< Messages per task queue
+  static constexpr uint32_t WAIT_FOREVER = UINT32_MAX;  ///< No timeout
+
+  /** Wait channels: receivers per queue, senders per queue, then alloc() */
+  static constexpr uint8_t CHANNELS = 2 * MAX_QUEUES + 1;
+
+  /** Result codes (the SYS-ERR-* values seen by Forth code) */
+  enum Status : int32_t
+  {
+    OK = 0,            ///< Done
+    ERR_INVALID = -1,  ///< Bad address, length or task id, or pool reset meanwhile
+    ERR_TIMEOUT = -2,  ///< Nothing to receive, no free block or queue full
+    ERR_NOMEM = -3,    ///< Pool not set up
+    ERR_BUSY = -4      ///< Reference count saturated
+  };
+
+  /**
+   * @brief Platform lock and condition variable
+   *
+   * wait() is called with the lock held; it releases the lock, sleeps
+   * until wake() on the same channel or @p timeout_ms, and takes the lock
+   * again before returning. Spurious returns are allowed, lost wakeups
+   * are not. wake() is called with the lock held and wakes every waiter
+   * of a channel (0..CHANNELS-1), so a send only wakes the receivers of
+   * its queue rather than every blocked task.
+   */
+  struct Sync
+  {
+    void (*lock)(void* user);
+    void (*unlock)(void* user);
+    void (*wait)(void* user, uint8_t channel, uint32_t timeout_ms);
+    void (*wake)(void* user, uint8_t channel);
+    uint32_t (*now_ms)(void* user);
+    void* user;
+  };
+
+  /** A received message; the receiver owns one reference to @p addr */
+  struct Message
+  {
+    uint32_t addr;  ///< Block address
+    uint16_t len;   ///< Payload length set by the sender
+  };
+
+  /** Pool counters (since the last setup()) */
+  struct Stats
+  {
+    uint32_t sent;         ///< Messages queued
+    uint32_t received;     ///< Messages dequeued
+    uint32_t alloc_waits;  ///< alloc() calls that found no free block
+    uint32_t send_waits;   ///< send() calls that found the queue full
+    uint32_t timeouts;     ///< Operations that gave up
+    uint16_t in_use;       ///< Blocks currently referenced
+    uint16_t in_use_peak;  ///< Largest in_use
+  };
+
+  explicit MsgPool(const Sync& sync);
+
+  MsgPool(const MsgPool&) = delete;
+  MsgPool& operator=(const MsgPool&) = delete;
+
+  /**
+   * @brief Carve @p count blocks of @p block_size bytes starting at @p base
+   *
+   * Any previous setup is discarded together with its queued messages;
+   * tasks blocked on the pool return ERR_INVALID.
+   *
+   * @param base Address of the first block
+   * @param block_size Block size in bytes (1..65535)
+   * @param count Number of blocks (1..MAX_BLOCKS)
+   * @return OK or ERR_INVALID
+   */
+  Status setup(uint32_t base, uint32_t block_size, uint16_t count);
+
+  /**
+   * @brief Take a free block with a reference count of one
+   * @param addr Receives the block address
+   * @param timeout_ms Time to wait for a block to be freed
+   */
+  Status alloc(uint32_t* addr, uint32_t timeout_ms);
+
+  /**
+   * @brief Add a reference (e.g. before sending one block to several tasks)
+   */
+  Status retain(uint32_t addr);
+
+  /**
+   * @brief Drop a reference; the block is free again at zero
+   */
+  Status release(uint32_t addr);
+
+  /**
+   * @brief Queue a block for a task, moving one reference to the queue
+   *
+   * On failure the caller keeps its reference.
+   *
+   * @param task Receiving task id
+   * @param addr Block address (must be referenced)
+   * @param len Payload length (at most the block size)
+   * @param timeout_ms Time to wait for room in the task's queue
+   */
+  Status send(uint8_t task, uint32_t addr, uint32_t len, uint32_t timeout_ms);
+
+  /**
+   * @brief Dequeue the oldest message of a task
+   *
+   * The reference moves to the caller, which must release() it.
+   *
+   * @param task Task id whose queue to read
+   * @param msg Receives the message
+   * @param timeout_ms Time to wait for a message
+   */
+  Status recv(uint8_t task, Message* msg, uint32_t timeout_ms);
+
+  /**
+   * @brief Check whether setup() succeeded
+   */
+  bool ready() const
+  {
+    return count_ > 0;
+  }
+
+  /**
+   * @brief Get block size in bytes
+   */
+  uint32_t block_size() const
+  {
+    return block_size_;
+  }
+
+  /**
+   * @brief Get a snapshot of the counters
+   */
+  Stats stats();
+
+ private:
+  struct Queue
+  {
+    Message slots[QUEUE_DEPTH];  ///< Ring storage
+    uint8_t head;                ///< Next slot to read
+    uint8_t size;                ///< Messages queued
+  };
+
+  int block_index(uint32_t addr) const;
+  uint32_t start_time(uint32_t timeout_ms) const;
+  Status wait_for_change(uint8_t channel, uint32_t start_ms, uint32_t timeout_ms,
+                         uint32_t epoch);
+  void notify(uint8_t channel);
+
+  static constexpr uint8_t ALLOC_CHANNEL = 2 * MAX_QUEUES;  ///< Waiting for a block
+
+  Sync sync_;                   ///< Platform lock and wakeups
+  uint32_t base_ = 0;           ///< First block address
+  uint32_t block_size_ = 0;     ///< Bytes per block
+  uint16_t count_ = 0;          ///< Blocks (0: not set up)
+  uint16_t free_top_ = 0;       ///< Entries on free_
+  uint32_t epoch_ = 0;          ///< Bumped by setup()
+  uint8_t waiters_[CHANNELS];   ///< Tasks inside wait() per channel
+  uint8_t free_[MAX_BLOCKS];    ///< Free block stack (LIFO reuses cache-warm blocks)
+  uint8_t refs_[MAX_BLOCKS];    ///< References (queued ones included)
+  uint8_t queued_[MAX_BLOCKS];  ///< References held by queues
+  Queue queues_[MAX_QUEUES];    ///< Per-task queues
+  Stats stats_ = {};            ///< Counters
+};
+
+}  // namespace v4rtos
@@ -0,0 +1,16 @@
+// SYS ids of the runtime's words, from runtime_sys.def
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include <cstdint>
+
+namespace v4rtos
+{
+
+/** SYS_<NAME> for every word in runtime_sys.def (see docs/api-reference/syscalls.md) */
+#define V4_SYS(id, name, handler, effect) constexpr uint16_t SYS_##name = id;
+#include "runtime_sys.def"
+
+}  // namespace v4rtos
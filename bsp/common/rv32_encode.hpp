@@ -0,0 +1,157 @@
+// RV32I/M instruction encoders
+//
+// Just enough of the base integer ISA and the M extension for the
+// template JIT (rv32_jit) and the host simulator to agree on encodings.
+// All functions are constexpr and return one 32-bit instruction word.
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include <cstdint>
+
+namespace v4rtos
+{
+namespace rv32
+{
+
+/** Integer registers (ABI names) */
+enum Reg : uint8_t
+{
+  ZERO = 0,
+  RA = 1,
+  SP = 2,
+  T0 = 5,
+  T1 = 6,
+  T2 = 7,
+  A0 = 10,
+  A1 = 11,
+  A2 = 12,
+  A3 = 13,
+  A4 = 14,
+  A5 = 15,
+  T3 = 28,
+  T4 = 29,
+  T5 = 30,
+  T6 = 31
+};
+
+constexpr uint32_t OPC_LUI = 0x37;
+constexpr uint32_t OPC_JAL = 0x6F;
+constexpr uint32_t OPC_JALR = 0x67;
+constexpr uint32_t OPC_BRANCH = 0x63;
+constexpr uint32_t OPC_LOAD = 0x03;
+constexpr uint32_t OPC_STORE = 0x23;
+constexpr uint32_t OPC_OP_IMM = 0x13;
+constexpr uint32_t OPC_OP = 0x33;
+
+constexpr uint32_t r_type(uint32_t f7, Reg rs2, Reg rs1, uint32_t f3, Reg rd,
+                          uint32_t opc)
+{
+  return (f7 << 25) | (uint32_t(rs2) << 20) | (uint32_t(rs1) << 15) | (f3 << 12) |
+         (uint32_t(rd) << 7) | opc;
+}
+
+constexpr uint32_t i_type(int32_t imm, Reg rs1, uint32_t f3, Reg rd, uint32_t opc)
+{
+  return ((uint32_t(imm) & 0xFFF) << 20) | (uint32_t(rs1) << 15) | (f3 << 12) |
+         (uint32_t(rd) << 7) | opc;
+}
+
+constexpr uint32_t s_type(int32_t imm, Reg rs2, Reg rs1, uint32_t f3, uint32_t opc)
+{
+  return ((uint32_t(imm) >> 5 & 0x7F) << 25) | (uint32_t(rs2) << 20) |
+         (uint32_t(rs1) << 15) | (f3 << 12) | ((uint32_t(imm) & 0x1F) << 7) | opc;
+}
+
+constexpr uint32_t b_type(int32_t off, Reg rs2, Reg rs1, uint32_t f3)
+{
+  uint32_t o = uint32_t(off);
+  return ((o >> 12 & 1) << 31) | ((o >> 5 & 0x3F) << 25) | (uint32_t(rs2) << 20) |
+         (uint32_t(rs1) << 15) | (f3 << 12) | ((o >> 1 & 0xF) << 8) |
+         ((o >> 11 & 1) << 7) | OPC_BRANCH;
+}
+
+constexpr uint32_t j_type(int32_t off, Reg rd)
+{
+  uint32_t o = uint32_t(off);
+  return ((o >> 20 & 1) << 31) | ((o >> 1 & 0x3FF) << 21) | ((o >> 11 & 1) << 20) |
+         ((o >> 12 & 0xFF) << 12) | (uint32_t(rd) << 7) | OPC_JAL;
+}
+
+// Base integer instructions
+constexpr uint32_t lui(Reg rd, uint32_t imm20)
+{
+  return (imm20 << 12) | (uint32_t(rd) << 7) | OPC_LUI;
+}
+constexpr uint32_t addi(Reg rd, Reg rs1, int32_t imm)
+{
+  return i_type(imm, rs1, 0, rd, OPC_OP_IMM);
+}
+constexpr uint32_t lw(Reg rd, Reg rs1, int32_t off)
+{
+  return i_type(off, rs1, 2, rd, OPC_LOAD);
+}
+constexpr uint32_t sw(Reg rs2, Reg rs1, int32_t off)
+{
+  return s_type(off, rs2, rs1, 2, OPC_STORE);
+}
+constexpr uint32_t add(Reg rd, Reg rs1, Reg rs2)
+{
+  return r_type(0x00, rs2, rs1, 0, rd, OPC_OP);
+}
+constexpr uint32_t sub(Reg rd, Reg rs1, Reg rs2)
+{
+  return r_type(0x20, rs2, rs1, 0, rd, OPC_OP);
+}
+constexpr uint32_t slt(Reg rd, Reg rs1, Reg rs2)
+{
+  return r_type(0x00, rs2, rs1, 2, rd, OPC_OP);
+}
+constexpr uint32_t and_(Reg rd, Reg rs1, Reg rs2)
+{
+  return r_type(0x00, rs2, rs1, 7, rd, OPC_OP);
+}
+constexpr uint32_t mul(Reg rd, Reg rs1, Reg rs2)
+{
+  return r_type(0x01, rs2, rs1, 0, rd, OPC_OP);
+}
+constexpr uint32_t jal(Reg rd, int32_t off)
+{
+  return j_type(off, rd);
+}
+constexpr uint32_t jalr(Reg rd, Reg rs1, int32_t off)
+{
+  return i_type(off, rs1, 0, rd, OPC_JALR);
+}
+constexpr uint32_t beq(Reg rs1, Reg rs2, int32_t off)
+{
+  return b_type(off, rs2, rs1, 0);
+}
+constexpr uint32_t bne(Reg rs1, Reg rs2, int32_t off)
+{
+  return b_type(off, rs2, rs1, 1);
+}
+constexpr uint32_t blt(Reg rs1, Reg rs2, int32_t off)
+{
+  return b_type(off, rs2, rs1, 4);
+}
+constexpr uint32_t bge(Reg rs1, Reg rs2, int32_t off)
+{
+  return b_type(off, rs2, rs1, 5);
+}
+constexpr uint32_t bltu(Reg rs1, Reg rs2, int32_t off)
+{
+  return b_type(off, rs2, rs1, 6);
+}
+constexpr uint32_t bgeu(Reg rs1, Reg rs2, int32_t off)
+{
+  return b_type(off, rs2, rs1, 7);
+}
+constexpr uint32_t ret()
+{
+  return jalr(ZERO, RA, 0);
+}
+
+}  // namespace rv32
+}  // namespace v4rtos
@@ -0,0 +1,378 @@
+// Template JIT implementation
+//
+// Register use (all caller-saved):
+//   a0  JitFrame*            t0  data stack pointer
+//   t1  data stack base      t2  data stack end
+//   a1  return stack pointer a2  return stack base
+//   a3  return stack end     a4  return stack pointer at entry
+//   t3..t5 scratch           t6  bound checks
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#include "rv32_jit.hpp"
+
+#include "rv32_encode.hpp"
+
+namespace v4rtos
+{
+
+using namespace rv32;
+
+namespace
+{
+
+constexpr size_t MAX_FIXUPS = 2 * Rv32Jit::MAX_WORD_BYTES + 1;
+constexpr uint16_t NO_LABEL = 0xFFFF;
+
+// JitFrame field offsets
+constexpr int32_t F_SP = 0;
+constexpr int32_t F_DS_LO = 4;
+constexpr int32_t F_DS_HI = 8;
+constexpr int32_t F_RP = 12;
+constexpr int32_t F_RS_LO = 16;
+constexpr int32_t F_RS_HI = 20;
+constexpr int32_t F_EXIT_IP = 24;
+
+int32_t read_i32(const uint8_t* p)
+{
+  return static_cast<int32_t>(static_cast<uint32_t>(p[0]) |
+                              (static_cast<uint32_t>(p[1]) << 8) |
+                              (static_cast<uint32_t>(p[2]) << 16) |
+                              (static_cast<uint32_t>(p[3]) << 24));
+}
+
+int16_t read_i16(const uint8_t* p)
+{
+  return static_cast<int16_t>(p[0] | (p[1] << 8));
+}
+
+}  // namespace
+
+Rv32Jit::Rv32Jit(const JitIsa& isa)
+    : isa_(isa),
+      label_(new uint16_t[MAX_WORD_BYTES + 1]),
+      fixups_(new Fixup[MAX_FIXUPS]),
+      stub_ip_(new uint16_t[MAX_FIXUPS]),
+      stub_at_(new uint16_t[MAX_FIXUPS])
+{
+}
+
+void Rv32Jit::emit(uint32_t insn)
+{
+  // Keep counting past the end so compile() can tell how much was needed
+  if (n_ < cap_)
+  {
+    out_[n_] = insn;
+  }
+  n_++;
+}
+
+void Rv32Jit::emit_li(uint8_t rd, int32_t value)
+{
+  int32_t lo = static_cast<int32_t>(static_cast<uint32_t>(value) << 20) >> 20;
+  uint32_t hi = (static_cast<uint32_t>(value) - static_cast<uint32_t>(lo)) >> 12;
+  if (hi == 0)
+  {
+    emit(addi(Reg(rd), ZERO, lo));
+    return;
+  }
+  emit(lui(Reg(rd), hi & 0xFFFFF));
+  if (lo != 0)
+  {
+    emit(addi(Reg(rd), Reg(rd), lo));
+  }
+}
+
+void Rv32Jit::emit_jump(size_t ip, bool exit)
+{
+  fixups_[fixup_count_++] =
+      Fixup{static_cast<uint16_t>(n_), static_cast<uint16_t>(ip), exit};
+  emit(jal(ZERO, 0));
+}
+
+void Rv32Jit::check(uint8_t ptr, uint8_t bound, int32_t delta, size_t ip)
+{
+  // Pops need ptr + delta >= base, pushes ptr + delta <= end; otherwise
+  // the interpreter re-runs the opcode and reports the error itself
+  emit(addi(T6, Reg(ptr), delta));
+  emit(delta < 0 ? bgeu(T6, Reg(bound), 8) : bgeu(Reg(bound), T6, 8));
+  emit_jump(ip, true);
+}
+
+size_t Rv32Jit::stub_for(size_t ip)
+{
+  for (size_t i = 0; i < stub_count_; i++)
+  {
+    if (stub_ip_[i] == ip)
+    {
+      return stub_at_[i];
+    }
+  }
+  // li t3, ip; j common_exit
+  size_t at = n_;
+  emit_li(T3, static_cast<int32_t>(ip));
+  emit(jal(ZERO, (static_cast<int32_t>(exit_at_) - static_cast<int32_t>(n_)) * 4));
+  stub_ip_[stub_count_] = static_cast<uint16_t>(ip);
+  stub_at_[stub_count_] = static_cast<uint16_t>(at);
+  stub_count_++;
+  return at;
+}
+
+void Rv32Jit::emit_op(JitOp op, const uint8_t* operand, size_t ip, size_t next)
+{
+  switch (op)
+  {
+    case JitOp::LIT:
+      check(T0, T2, 4, ip);
+      emit_li(T3, read_i32(operand));
+      emit(sw(T3, T0, 0));
+      emit(addi(T0, T0, 4));
+      break;
+    case JitOp::DUP:
+      check(T0, T1, -4, ip);
+      check(T0, T2, 4, ip);
+      emit(lw(T3, T0, -4));
+      emit(sw(T3, T0, 0));
+      emit(addi(T0, T0, 4));
+      break;
+    case JitOp::DROP:
+      check(T0, T1, -4, ip);
+      emit(addi(T0, T0, -4));
+      break;
+    case JitOp::SWAP:
+      check(T0, T1, -8, ip);
+      emit(lw(T3, T0, -4));
+      emit(lw(T4, T0, -8));
+      emit(sw(T3, T0, -8));
+      emit(sw(T4, T0, -4));
+      break;
+    case JitOp::OVER:
+      check(T0, T1, -8, ip);
+      check(T0, T2, 4, ip);
+      emit(lw(T3, T0, -8));
+      emit(sw(T3, T0, 0));
+      emit(addi(T0, T0, 4));
+      break;
+    case JitOp::ROT:
+      check(T0, T1, -12, ip);
+      emit(lw(T3, T0, -12));
+      emit(lw(T4, T0, -8));
+      emit(lw(T5, T0, -4));
+      emit(sw(T4, T0, -12));
+      emit(sw(T5, T0, -8));
+      emit(sw(T3, T0, -4));
+      break;
+    case JitOp::ADD:
+    case JitOp::SUB:
+    case JitOp::MUL:
+    case JitOp::AND:
+    case JitOp::LT:
+      check(T0, T1, -8, ip);
+      emit(lw(T3, T0, -8));
+      emit(lw(T4, T0, -4));
+      if (op == JitOp::ADD)
+      {
+        emit(add(T3, T3, T4));
+      }
+      else if (op == JitOp::SUB)
+      {
+        emit(sub(T3, T3, T4));
+      }
+      else if (op == JitOp::MUL)
+      {
+        emit(mul(T3, T3, T4));
+      }
+      else if (op == JitOp::AND)
+      {
+        emit(and_(T3, T3, T4));
+      }
+      else
+      {
+        emit(slt(T3, T3, T4));
+        emit(sub(T3, ZERO, T3));
+      }
+      emit(sw(T3, T0, -8));
+      emit(addi(T0, T0, -4));
+      break;
+    case JitOp::LIT_ADD:
+      check(T0, T1, -4, ip);
+      emit(lw(T3, T0, -4));
+      emit_li(T4, read_i32(operand));
+      emit(add(T3, T3, T4));
+      emit(sw(T3, T0, -4));
+      break;
+    case JitOp::TOR:
+      check(T0, T1, -4, ip);
+      check(A1, A3, 4, ip);
+      emit(lw(T3, T0, -4));
+      emit(addi(T0, T0, -4));
+      emit(sw(T3, A1, 0));
+      emit(addi(A1, A1, 4));
+      break;
+    case JitOp::FROMR:
+      check(A1, A2, -4, ip);
+      check(T0, T2, 4, ip);
+      emit(lw(T3, A1, -4));
+      emit(addi(A1, A1, -4));
+      emit(sw(T3, T0, 0));
+      emit(addi(T0, T0, 4));
+      break;
+    case JitOp::JMP:
+      emit_jump(next + read_i16(operand), false);
+      break;
+    case JitOp::JZ:
+      check(T0, T1, -4, ip);
+      emit(lw(T3, T0, -4));
+      emit(addi(T0, T0, -4));
+      emit(bne(T3, ZERO, 8));
+      emit_jump(next + read_i16(operand), false);
+      break;
+    case JitOp::DUP_JZ:
+      check(T0, T1, -4, ip);
+      emit(lw(T3, T0, -4));
+      emit(bne(T3, ZERO, 8));
+      emit_jump(next + read_i16(operand), false);
+      break;
+    case JitOp::DEC_JNN:
+      check(T0, T1, -4, ip);
+      emit(lw(T3, T0, -4));
+      emit(addi(T3, T3, -1));
+      emit(sw(T3, T0, -4));
+      emit(blt(T3, ZERO, 8));
+      emit_jump(next + read_i16(operand), false);
+      break;
+    case JitOp::DO:
+      check(T0, T1, -8, ip);
+      check(A1, A3, 8, ip);
+      emit(lw(T3, T0, -8));
+      emit(lw(T4, T0, -4));
+      emit(sw(T3, A1, 0));
+      emit(sw(T4, A1, 4));
+      emit(addi(A1, A1, 8));
+      emit(addi(T0, T0, -8));
+      break;
+    case JitOp::LOOP:
+      check(A1, A2, -8, ip);
+      emit(lw(T3, A1, -4));
+      emit(addi(T3, T3, 1));
+      emit(sw(T3, A1, -4));
+      emit(lw(T4, A1, -8));
+      emit(bge(T3, T4, 8));
+      emit_jump(next + read_i16(operand), false);
+      emit(addi(A1, A1, -8));
+      break;
+    case JitOp::RET:
+      // Anything left on the return stack belongs to the interpreter
+      emit(beq(A1, A4, 8));
+      emit_jump(ip, true);
+      emit(sw(T0, A0, F_SP));
+      emit(sw(A1, A0, F_RP));
+      emit(addi(A0, ZERO, JIT_DONE));
+      emit(ret());
+      break;
+    case JitOp::UNSUPPORTED:
+    default:
+      emit_jump(ip, true);
+      break;
+  }
+}
+
+size_t Rv32Jit::compile(const uint8_t* code, size_t len, size_t entry, uint32_t* out,
+                        size_t cap)
+{
+  out_ = out;
+  cap_ = cap < NO_LABEL ? cap : NO_LABEL - 1;
+  n_ = 0;
+  entry_ = entry;
+  fixup_count_ = 0;
+  stub_count_ = 0;
+  if (entry >= len || len > NO_LABEL)
+  {
+    stats_.failed++;
+    return 0;
+  }
+
+  // Region: entry up to and including the first RET
+  size_t pos = entry;
+  bool ends_in_ret = false;
+  while (pos < len)
+  {
+    const JitOpInfo& info = isa_.ops[code[pos]];
+    size_t next = pos + 1 + info.operand_bytes;
+    if (next > len || next - entry > MAX_WORD_BYTES)
+    {
+      break;
+    }
+    pos = next;
+    if (info.kind == JitOp::RET)
+    {
+      ends_in_ret = true;
+      break;
+    }
+  }
+  end_ = pos;
+  for (size_t i = 0; i <= MAX_WORD_BYTES; i++)
+  {
+    label_[i] = NO_LABEL;
+  }
+
+  emit(lw(T0, A0, F_SP));
+  emit(lw(T1, A0, F_DS_LO));
+  emit(lw(T2, A0, F_DS_HI));
+  emit(lw(A1, A0, F_RP));
+  emit(lw(A2, A0, F_RS_LO));
+  emit(lw(A3, A0, F_RS_HI));
+  emit(addi(A4, A1, 0));
+
+  for (pos = entry; pos < end_;)
+  {
+    const JitOpInfo& info = isa_.ops[code[pos]];
+    size_t next = pos + 1 + info.operand_bytes;
+    label_[pos - entry] = static_cast<uint16_t>(n_ < NO_LABEL ? n_ : NO_LABEL - 1);
+    emit_op(info.kind, code + pos + 1, pos, next);
+    pos = next;
+  }
+  if (!ends_in_ret)
+  {
+    emit_jump(end_, true);
+  }
+
+  // Common exit; each stub loads its offset into t3 and jumps here
+  exit_at_ = n_;
+  emit(sw(T0, A0, F_SP));
+  emit(sw(A1, A0, F_RP));
+  emit(sw(T3, A0, F_EXIT_IP));
+  emit(addi(A0, ZERO, JIT_EXIT));
+  emit(ret());
+
+  for (size_t i = 0; i < fixup_count_; i++)
+  {
+    const Fixup& f = fixups_[i];
+    size_t target;
+    bool inside = f.ip >= entry && f.ip < end_ && label_[f.ip - entry] != NO_LABEL;
+    if (!f.exit && inside)
+    {
+      target = label_[f.ip - entry];
+    }
+    else
+    {
+      target = stub_for(f.ip);
+    }
+    if (f.at < cap_)
+    {
+      out_[f.at] = jal(ZERO, (static_cast<int32_t>(target) - f.at) * 4);
+    }
+  }
+
+  if (n_ > cap_)
+  {
+    stats_.failed++;
+    return 0;
+  }
+  stats_.words++;
+  stats_.bytecode_bytes += static_cast<uint32_t>(end_ - entry);
+  stats_.native_bytes += static_cast<uint32_t>(n_ * 4);
+  return n_;
+}
+
+}  // namespace v4rtos
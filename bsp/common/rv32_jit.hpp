@@ -0,0 +1,185 @@
+// Template JIT: V4 bytecode words -> RV32IM machine code
+//
+// Translates one word (from its entry point up to the first RET) into
+// straight-line RV32IM code, one fixed template per opcode. Both stacks
+// stay in memory, so the interpreter can take over at any bytecode offset:
+// every opcode the JIT does not handle, every branch leaving the word and
+// every stack bound violation ends the native code with JIT_EXIT and the
+// offset to resume at.
+//
+// The compiler only emits code; it runs on any host. On the ESP32-C6 the
+// output is executed from IRAM (vm_jit), on Linux by the RV32 simulator in
+// bsp/posix/bench.
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace v4rtos
+{
+
+/**
+ * @brief Operations the JIT has templates for
+ *
+ * Operand conventions: LIT and LIT_ADD take an int32, branches an int16
+ * relative to the end of the instruction (all little-endian).
+ */
+enum class JitOp : uint8_t
+{
+  UNSUPPORTED,  ///< Leave native code here (CALL, SYS, HALT, ...)
+  LIT,          ///< ( -- n )
+  DUP,          ///< ( a -- a a )
+  DROP,         ///< ( a -- )
+  SWAP,         ///< ( a b -- b a )
+  OVER,         ///< ( a b -- a b a )
+  ROT,          ///< ( a b c -- b c a )
+  ADD,          ///< ( a b -- a+b )
+  SUB,          ///< ( a b -- a-b )
+  MUL,          ///< ( a b -- a*b )
+  AND,          ///< ( a b -- a&b )
+  LT,           ///< ( a b -- flag ), true is -1
+  TOR,          ///< >R
+  FROMR,        ///< R>
+  JMP,          ///< Unconditional branch
+  JZ,           ///< Branch if TOS (popped) is zero
+  DO,           ///< ( limit start -- ) R: ( -- limit index )
+  LOOP,         ///< Increment index, branch while index < limit
+  RET,          ///< End of word
+  LIT_ADD,      ///< ( a -- a+n )
+  DUP_JZ,       ///< Branch if TOS (kept) is zero
+  DEC_JNN       ///< Decrement TOS, branch while TOS >= 0
+};
+
+/** Static description of one opcode */
+struct JitOpInfo
+{
+  JitOp kind;             ///< Template
+  uint8_t operand_bytes;  ///< Inline operand size
+};
+
+/** Instruction set description (256 entries, indexed by opcode) */
+struct JitIsa
+{
+  const JitOpInfo* ops;  ///< Per-opcode templates
+};
+
+/**
+ * @brief VM state shared with native code
+ *
+ * Addresses are 32-bit (target addresses when run in the simulator).
+ * Stack pointers point at the next free cell.
+ */
+struct JitFrame
+{
+  uint32_t sp;       ///< Data stack pointer
+  uint32_t ds_lo;    ///< Data stack base
+  uint32_t ds_hi;    ///< Data stack end (one past the last cell)
+  uint32_t rp;       ///< Return stack pointer
+  uint32_t rs_lo;    ///< Return stack base
+  uint32_t rs_hi;    ///< Return stack end
+  uint32_t exit_ip;  ///< Bytecode offset to resume at (JIT_EXIT)
+};
+
+/**
+ * @brief Native code results
+ *
+ * The caller runs native code in place of the word's body, i.e. after
+ * CALL has pushed the return address.
+ */
+enum : uint32_t
+{
+  JIT_DONE = 0,  ///< Reached RET with the return stack as on entry; execute RET
+  JIT_EXIT = 1   ///< Continue interpreting at exit_ip
+};
+
+/**
+ * @brief Native entry point: uint32_t fn(JitFrame* frame)
+ *
+ * Standard RISC-V calling convention; only caller-saved registers are
+ * used, so there is no prologue spill.
+ */
+using JitFn = uint32_t (*)(JitFrame* frame);
+
+/**
+ * @brief Template compiler
+ */
+class Rv32Jit
+{
+ public:
+  /** Longest word compiled (bytecode bytes) */
+  static constexpr size_t MAX_WORD_BYTES = 256;
+
+  /** Compiler counters */
+  struct Stats
+  {
+    uint32_t words;           ///< Words compiled
+    uint32_t failed;          ///< Words that did not fit the output buffer
+    uint32_t bytecode_bytes;  ///< Bytecode compiled
+    uint32_t native_bytes;    ///< Machine code emitted
+  };
+
+  /**
+   * @brief Construct compiler
+   * @param isa Instruction set (must outlive the compiler)
+   */
+  explicit Rv32Jit(const JitIsa& isa);
+
+  /**
+   * @brief Compile the word at @p entry
+   *
+   * @param code Bytecode
+   * @param len Bytecode length
+   * @param entry Word entry offset
+   * @param out Output buffer (instruction words)
+   * @param cap Output capacity (instruction words)
+   * @return Instruction words written, 0 if @p out is too small or
+   *         @p entry is not inside the code
+   */
+  size_t compile(const uint8_t* code, size_t len, size_t entry, uint32_t* out,
+                 size_t cap);
+
+  /**
+   * @brief Get compiler counters
+   */
+  const Stats& stats() const
+  {
+    return stats_;
+  }
+
+ private:
+  /** Jump to patch once all labels and exit stubs are known */
+  struct Fixup
+  {
+    uint16_t at;  ///< Index of the JAL
+    uint16_t ip;  ///< Bytecode target
+    bool exit;    ///< Always go through the exit stub for @p ip
+  };
+
+  void emit(uint32_t insn);
+  void emit_li(uint8_t rd, int32_t value);
+  void emit_jump(size_t ip, bool exit);
+  void check(uint8_t ptr, uint8_t bound, int32_t delta, size_t ip);
+  void emit_op(JitOp op, const uint8_t* operand, size_t ip, size_t next);
+  size_t stub_for(size_t ip);
+
+  const JitIsa& isa_;                    ///< Instruction set
+  uint32_t* out_ = nullptr;              ///< Current output
+  size_t cap_ = 0;                       ///< Output capacity
+  size_t n_ = 0;                         ///< Words emitted
+  size_t entry_ = 0;                     ///< Word entry
+  size_t end_ = 0;                       ///< End of compiled region
+  size_t exit_at_ = 0;                   ///< Native index of the common exit
+  std::unique_ptr<uint16_t[]> label_;    ///< Region offset -> native index
+  std::unique_ptr<Fixup[]> fixups_;      ///< Pending jumps
+  size_t fixup_count_ = 0;               ///< Pending jump count
+  std::unique_ptr<uint16_t[]> stub_ip_;  ///< Exit stub bytecode offsets
+  std::unique_ptr<uint16_t[]> stub_at_;  ///< Exit stub native indices
+  size_t stub_count_ = 0;                ///< Exit stubs emitted
+  Stats stats_ = {};                     ///< Counters
+};
+
+}  // namespace v4rtos
@@ -0,0 +1,61 @@
+// Compile-time SYS dispatch table
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#include "sys_table.hpp"
+
+// Only V4-engine builds with V4_SYS_TABLE read the table
+#ifdef V4_SYS_TABLE
+
+#include <cstddef>
+
+namespace v4rtos
+{
+
+/** One runtime_sys.def line */
+struct SysEntry
+{
+  uint16_t id;        ///< SYS id
+  v4_sys_fn handler;  ///< Handler
+};
+
+#ifndef V4_SCHED_PRIORITY
+#define V4_SYS_SCHED(id, name, handler, effect)  // No scheduler, no words
+#endif
+static constexpr SysEntry SYS_ENTRIES[] = {
+#define V4_SYS(id, name, handler, effect) {id, handler},
+#include "runtime_sys.def"
+};
+
+// Ids fit the table and ascend (no word listed twice)
+static constexpr bool entries_valid()
+{
+  for (size_t i = 0; i < sizeof(SYS_ENTRIES) / sizeof(SYS_ENTRIES[0]); i++)
+  {
+    if (SYS_ENTRIES[i].id >= V4_SYS_TABLE_SIZE ||
+        (i > 0 && SYS_ENTRIES[i].id <= SYS_ENTRIES[i - 1].id))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+static_assert(entries_valid(),
+              "runtime_sys.def: ids must ascend below V4_SYS_TABLE_SIZE");
+
+static constexpr v4_sys_table_t build_table()
+{
+  v4_sys_table_t table = {};
+  for (const SysEntry& entry : SYS_ENTRIES)
+  {
+    table.handler[entry.id] = entry.handler;
+  }
+  return table;
+}
+
+}  // namespace v4rtos
+
+// Constant-initialized: no code runs at startup
+extern "C" constexpr v4_sys_table_t v4_sys_table = v4rtos::build_table();
+
+#endif  // V4_SYS_TABLE
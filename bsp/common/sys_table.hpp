@@ -0,0 +1,52 @@
+// Compile-time SYS dispatch table
+//
+// The runtime's SYS words (runtime_sys.def) in a dense, constant table
+// indexed by SYS id. V4-engine built with V4_SYS_TABLE dispatches a SYS
+// instruction as
+//
+//   id < V4_SYS_TABLE_SIZE && v4_sys_table.handler[id]
+//       ? v4_sys_table.handler[id](vm) : <V4-std registry>
+//
+// so these words need no register_sys_handler() call at startup and no
+// lookup per call. The table is constant-initialized into read-only data; words
+// of features left out of the build are not in it, so their handlers are
+// not referenced and --gc-sections drops them. Ids without a runtime word
+// are nullptr and reach the handlers V4-std registered (LED words).
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include <cstdint>
+
+#include "runtime_sys_ids.hpp"
+#include "v4/vm_api.h"
+
+/** Dispatch table capacity (SYS ids 0..V4_SYS_TABLE_SIZE-1) */
+#define V4_SYS_TABLE_SIZE 128
+
+extern "C"
+{
+  /** SYS handler: pops its arguments, pushes its results */
+  typedef v4_err (*v4_sys_fn)(struct Vm* vm);
+
+  /** Dense SYS dispatch table (nullptr: not a runtime word) */
+  typedef struct
+  {
+    v4_sys_fn handler[V4_SYS_TABLE_SIZE];  ///< Handler per SYS id
+  } v4_sys_table_t;
+
+  /**
+   * @brief Engine symbol: the runtime's SYS words by id
+   */
+  extern const v4_sys_table_t v4_sys_table;
+}
+
+namespace v4rtos
+{
+
+/** Handler of every word in runtime_sys.def, defined by the BSP */
+#define V4_SYS(id, name, handler, effect) v4_err handler(Vm* vm);
+#include "runtime_sys.def"
+
+}  // namespace v4rtos
@@ -0,0 +1,634 @@
+// Fixed-priority task scheduling with priority-inheritance mutexes
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#include "task_sched.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+#include "link_runtime_commands.hpp"
+
+namespace v4rtos
+{
+
+namespace
+{
+
+constexpr size_t MAX_ATTACHED = 4;  // One scheduler per pool VM (VmPool::MAX_VMS)
+
+struct Attached
+{
+  const Vm* vm;
+  TaskScheduler* sched;
+};
+
+Attached g_attached[MAX_ATTACHED];
+
+uint8_t lowest_bit(uint8_t mask)
+{
+  return static_cast<uint8_t>(__builtin_ctz(mask));
+}
+
+}  // namespace
+
+TaskScheduler::TaskScheduler(Clock clock) : clock_(clock)
+{
+  for (uint8_t p = 0; p < PRIORITIES; p++)
+  {
+    slice_ms_[p] = DEFAULT_SLICE_MS;
+  }
+  memset(tasks_, 0, sizeof(tasks_));
+  for (Task& t : tasks_)
+  {
+    t.waiting_on = NO_TASK;
+  }
+  for (Mutex& m : mutexes_)
+  {
+    m.owner = NO_TASK;
+    m.waiters = 0;
+  }
+  memset(ready_, 0, sizeof(ready_));
+  memset(latency_, 0, sizeof(latency_));
+}
+
+void TaskScheduler::set_slice(uint8_t priority, uint16_t ms)
+{
+  if (priority < PRIORITIES)
+  {
+    slice_ms_[priority] = ms;
+  }
+}
+
+bool TaskScheduler::parse_slices(const char* text, uint16_t* slices)
+{
+  uint8_t count = 0;
+  const char* p = text;
+  while (*p != '\0' && count < PRIORITIES)
+  {
+    if (*p == ' ' || *p == ',')
+    {
+      p++;
+      continue;
+    }
+    char* end;
+    unsigned long ms = strtoul(p, &end, 10);
+    if (end == p || ms > UINT16_MAX)
+    {
+      return false;
+    }
+    slices[count++] = static_cast<uint16_t>(ms);
+    p = end;
+  }
+  if (count == 0)
+  {
+    return false;
+  }
+  for (uint8_t i = count; i < PRIORITIES; i++)
+  {
+    slices[i] = slices[count - 1];
+  }
+  return true;
+}
+
+bool TaskScheduler::create(uint8_t task, uint8_t priority)
+{
+  if (task >= MAX_TASKS || priority >= PRIORITIES || tasks_[task].state != State::UNUSED)
+  {
+    return false;
+  }
+  Task& t = tasks_[task];
+  t = {};
+  t.state = State::BLOCKED;
+  t.base = priority;
+  t.effective = priority;
+  t.waiting_on = NO_TASK;
+  make_ready(task);
+  return true;
+}
+
+void TaskScheduler::remove(uint8_t task)
+{
+  if (task >= MAX_TASKS || tasks_[task].state == State::UNUSED)
+  {
+    return;
+  }
+
+  Task& t = tasks_[task];
+  if (t.state == State::READY)
+  {
+    dequeue(task);
+  }
+  uint8_t waited_owner = NO_TASK;
+  if (t.waiting_on != NO_TASK)
+  {
+    Mutex& m = mutexes_[t.waiting_on];
+    m.waiters = static_cast<uint8_t>(m.waiters & ~(1u << task));
+    waited_owner = m.owner;
+  }
+  t.state = State::UNUSED;
+  t.waiting_on = NO_TASK;
+
+  // A deleted task cannot unlock; its mutexes go to their waiters
+  for (uint8_t m = 0; m < MAX_MUTEXES; m++)
+  {
+    if (mutexes_[m].owner == task)
+    {
+      hand_over(m);
+    }
+  }
+  if (current_ == task)
+  {
+    current_ = NO_TASK;
+  }
+  if (waited_owner != NO_TASK)
+  {
+    update_priority(waited_owner);
+  }
+}
+
+void TaskScheduler::ready(uint8_t task)
+{
+  // A mutex waiter is only woken by hand_over()
+  if (task < MAX_TASKS && tasks_[task].state == State::BLOCKED &&
+      tasks_[task].waiting_on == NO_TASK)
+  {
+    make_ready(task);
+  }
+}
+
+void TaskScheduler::block(uint8_t task)
+{
+  if (task >= MAX_TASKS)
+  {
+    return;
+  }
+  Task& t = tasks_[task];
+  if (t.state == State::READY)
+  {
+    dequeue(task);
+  }
+  if (t.state != State::UNUSED)
+  {
+    t.state = State::BLOCKED;
+    t.woken = false;
+  }
+}
+
+uint8_t TaskScheduler::pick(uint32_t* slice_ms)
+{
+  uint32_t now = clock_();
+  uint8_t previous = current_;
+  bool was_running = previous != NO_TASK && tasks_[previous].state == State::RUNNING;
+
+  if (was_running)
+  {
+    // Slice used up: behind its peers; preempted early: first in line again
+    Task& t = tasks_[previous];
+    bool expired = slice_ms_[t.effective] > 0 &&
+                   now - slice_start_us_ >= slice_ms_[t.effective] * 1000u;
+    t.state = State::READY;
+    enqueue(previous, !expired);
+  }
+
+  if (ready_mask_ == 0)
+  {
+    current_ = NO_TASK;
+    if (slice_ms != nullptr)
+    {
+      *slice_ms = 0;
+    }
+    return NO_TASK;
+  }
+
+  ReadyQueue& q = ready_[lowest_bit(ready_mask_)];
+  uint8_t task = q.tasks[q.head];
+  q.head = static_cast<uint8_t>((q.head + 1) % MAX_TASKS);
+  if (--q.size == 0)
+  {
+    ready_mask_ = static_cast<uint8_t>(ready_mask_ & ~(1u << tasks_[task].effective));
+  }
+
+  Task& t = tasks_[task];
+  t.state = State::RUNNING;
+  if (task != previous)
+  {
+    t.switches++;
+    if (was_running)
+    {
+      tasks_[previous].preemptions++;
+    }
+  }
+  if (t.woken)
+  {
+    Latency& l = latency_[t.base];
+    uint32_t waited = now - t.ready_us;
+    l.wakeups++;
+    l.total_us += waited;
+    if (waited > l.max_us)
+    {
+      l.max_us = waited;
+    }
+    t.woken = false;
+  }
+
+  current_ = task;
+  slice_start_us_ = now;
+  if (slice_ms != nullptr)
+  {
+    *slice_ms = slice_ms_[t.effective];
+  }
+  return task;
+}
+
+bool TaskScheduler::preempt() const
+{
+  if (current_ == NO_TASK)
+  {
+    return ready_mask_ != 0;
+  }
+  const Task& t = tasks_[current_];
+  if (t.state != State::RUNNING)
+  {
+    return true;
+  }
+  if (ready_mask_ == 0)
+  {
+    return false;
+  }
+
+  uint8_t top = lowest_bit(ready_mask_);
+  if (top != t.effective)
+  {
+    return top < t.effective;
+  }
+  uint16_t slice = slice_ms_[t.effective];
+  return slice > 0 && clock_() - slice_start_us_ >= slice * 1000u;
+}
+
+TaskScheduler::Status TaskScheduler::set_priority(uint8_t task, uint8_t priority)
+{
+  if (task >= MAX_TASKS || priority >= PRIORITIES || tasks_[task].state == State::UNUSED)
+  {
+    return ERR_INVALID;
+  }
+  tasks_[task].base = priority;
+  update_priority(task);
+  return OK;
+}
+
+TaskScheduler::Status TaskScheduler::lock(uint8_t mutex, uint8_t task)
+{
+  if (mutex >= MAX_MUTEXES || task >= MAX_TASKS || tasks_[task].state == State::UNUSED)
+  {
+    return ERR_INVALID;
+  }
+
+  Mutex& m = mutexes_[mutex];
+  if (m.owner == NO_TASK)
+  {
+    m.owner = task;
+    return OK;
+  }
+
+  // Refuse relocking and cycles of owners waiting on each other
+  uint8_t owner = m.owner;
+  for (uint8_t hops = 0; owner != NO_TASK && hops < MAX_TASKS; hops++)
+  {
+    if (owner == task)
+    {
+      return ERR_INVALID;
+    }
+    uint8_t waited = tasks_[owner].waiting_on;
+    owner = waited != NO_TASK ? mutexes_[waited].owner : NO_TASK;
+  }
+
+  m.waiters = static_cast<uint8_t>(m.waiters | (1u << task));
+  block(task);
+  tasks_[task].waiting_on = mutex;
+  if (inheritance_)
+  {
+    update_priority(m.owner);
+  }
+  return BLOCKED;
+}
+
+TaskScheduler::Status TaskScheduler::try_lock(uint8_t mutex, uint8_t task)
+{
+  if (mutex >= MAX_MUTEXES || task >= MAX_TASKS || tasks_[task].state == State::UNUSED ||
+      mutexes_[mutex].owner == task)
+  {
+    return ERR_INVALID;
+  }
+  if (mutexes_[mutex].owner != NO_TASK)
+  {
+    return ERR_BUSY;
+  }
+  mutexes_[mutex].owner = task;
+  return OK;
+}
+
+TaskScheduler::Status TaskScheduler::unlock(uint8_t mutex, uint8_t task)
+{
+  if (mutex >= MAX_MUTEXES || task >= MAX_TASKS || mutexes_[mutex].owner != task)
+  {
+    return ERR_INVALID;
+  }
+  hand_over(mutex);
+  update_priority(task);  // Drop what the waiters lent
+  return OK;
+}
+
+TaskScheduler::TaskInfo TaskScheduler::info(uint8_t task) const
+{
+  TaskInfo out = {State::UNUSED, 0, 0, NO_TASK, 0, 0};
+  if (task < MAX_TASKS)
+  {
+    const Task& t = tasks_[task];
+    out = {t.state, t.base, t.effective, t.waiting_on, t.switches, t.preemptions};
+  }
+  return out;
+}
+
+void TaskScheduler::reset_stats()
+{
+  memset(latency_, 0, sizeof(latency_));
+  for (Task& t : tasks_)
+  {
+    t.switches = 0;
+    t.preemptions = 0;
+  }
+}
+
+void TaskScheduler::enqueue(uint8_t task, bool front)
+{
+  uint8_t priority = tasks_[task].effective;
+  ReadyQueue& q = ready_[priority];
+  if (front)
+  {
+    q.head = static_cast<uint8_t>((q.head + MAX_TASKS - 1) % MAX_TASKS);
+    q.tasks[q.head] = task;
+  }
+  else
+  {
+    q.tasks[(q.head + q.size) % MAX_TASKS] = task;
+  }
+  q.size++;
+  ready_mask_ = static_cast<uint8_t>(ready_mask_ | (1u << priority));
+}
+
+void TaskScheduler::dequeue(uint8_t task)
+{
+  uint8_t priority = tasks_[task].effective;
+  ReadyQueue& q = ready_[priority];
+  for (uint8_t i = 0; i < q.size; i++)
+  {
+    if (q.tasks[(q.head + i) % MAX_TASKS] != task)
+    {
+      continue;
+    }
+    for (uint8_t j = i + 1; j < q.size; j++)
+    {
+      q.tasks[(q.head + j - 1) % MAX_TASKS] = q.tasks[(q.head + j) % MAX_TASKS];
+    }
+    if (--q.size == 0)
+    {
+      ready_mask_ = static_cast<uint8_t>(ready_mask_ & ~(1u << priority));
+    }
+    return;
+  }
+}
+
+void TaskScheduler::make_ready(uint8_t task)
+{
+  Task& t = tasks_[task];
+  t.state = State::READY;
+  t.woken = true;
+  t.ready_us = clock_();
+  enqueue(task, false);
+}
+
+void TaskScheduler::update_priority(uint8_t task)
+{
+  // Walk the chain of owners: a boosted owner blocked on another mutex
+  // lends its new priority to that mutex's owner in turn
+  for (uint8_t hops = 0; task != NO_TASK && hops < MAX_TASKS; hops++)
+  {
+    Task& t = tasks_[task];
+    uint8_t priority = t.base;
+    for (const Mutex& m : mutexes_)
+    {
+      if (!inheritance_ || m.owner != task)
+      {
+        continue;
+      }
+      for (uint8_t w = 0; w < MAX_TASKS; w++)
+      {
+        if ((m.waiters & (1u << w)) != 0 && tasks_[w].effective < priority)
+        {
+          priority = tasks_[w].effective;
+        }
+      }
+    }
+    if (priority == t.effective)
+    {
+      return;
+    }
+
+    if (t.state == State::READY)
+    {
+      dequeue(task);
+      t.effective = priority;
+      enqueue(task, false);
+    }
+    else
+    {
+      t.effective = priority;
+    }
+    task = t.waiting_on != NO_TASK ? mutexes_[t.waiting_on].owner : NO_TASK;
+  }
+}
+
+void TaskScheduler::hand_over(uint8_t mutex)
+{
+  // Highest priority first, lowest task ID among equals
+  Mutex& m = mutexes_[mutex];
+  uint8_t next = NO_TASK;
+  for (uint8_t w = 0; w < MAX_TASKS; w++)
+  {
+    if ((m.waiters & (1u << w)) != 0 &&
+        (next == NO_TASK || tasks_[w].effective < tasks_[next].effective))
+    {
+      next = w;
+    }
+  }
+
+  m.owner = next;
+  if (next == NO_TASK)
+  {
+    return;
+  }
+  m.waiters = static_cast<uint8_t>(m.waiters & ~(1u << next));
+  tasks_[next].waiting_on = NO_TASK;
+  make_ready(next);
+  update_priority(next);  // It now owns the remaining waiters
+}
+
+void TaskScheduler::encode_status(LinkReply* reply) const
+{
+  reply->put_u8(current_);
+  reply->put_u8(inheritance_ ? 1 : 0);
+  reply->put_u8(PRIORITIES);
+  for (uint8_t p = 0; p < PRIORITIES; p++)
+  {
+    const Latency& l = latency_[p];
+    reply->put_u16(slice_ms_[p]);
+    reply->put_u32(l.wakeups);
+    reply->put_u32(l.max_us);
+    reply->put_u32(l.wakeups > 0 ? static_cast<uint32_t>(l.total_us / l.wakeups) : 0);
+  }
+
+  for (uint8_t id = 0; id < MAX_TASKS; id++)
+  {
+    const Task& t = tasks_[id];
+    if (t.state == State::UNUSED)
+    {
+      continue;
+    }
+    reply->put_u8(id);
+    reply->put_u8(static_cast<uint8_t>(t.state));
+    reply->put_u8(t.base);
+    reply->put_u8(t.effective);
+    reply->put_u8(t.waiting_on);
+    reply->put_u32(t.switches);
+    reply->put_u32(t.preemptions);
+  }
+}
+
+void TaskScheduler::handle_command(void* user, const LinkFrameView& frame,
+                                   LinkReply* reply)
+{
+  TaskScheduler* self = static_cast<TaskScheduler*>(user);
+  if (frame.len < 1)
+  {
+    reply->status = link_wire::STATUS_ERROR;
+    return;
+  }
+
+  switch (frame.payload[0])
+  {
+    case OP_STATUS:
+      self->encode_status(reply);
+      break;
+    case OP_RESET:
+      self->reset_stats();
+      break;
+    default:
+      reply->status = link_wire::STATUS_ERROR;
+      break;
+  }
+}
+
+bool task_sched_attach(const Vm* vm, TaskScheduler* sched)
+{
+  Attached* free_slot = nullptr;
+  for (Attached& a : g_attached)
+  {
+    if (a.vm == vm)
+    {
+      a.sched = sched;
+      return true;
+    }
+    if (a.vm == nullptr && free_slot == nullptr)
+    {
+      free_slot = &a;
+    }
+  }
+  if (free_slot == nullptr)
+  {
+    return false;
+  }
+  *free_slot = {vm, sched};
+  return true;
+}
+
+void task_sched_detach(const Vm* vm)
+{
+  for (Attached& a : g_attached)
+  {
+    if (a.vm == vm)
+    {
+      a = {nullptr, nullptr};
+    }
+  }
+}
+
+TaskScheduler* task_sched_of(const Vm* vm)
+{
+  for (const Attached& a : g_attached)
+  {
+    if (a.vm == vm && vm != nullptr)
+    {
+      return a.sched;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace v4rtos
+
+// ==============================================================================
+// V4-engine hooks
+// ==============================================================================
+
+extern "C" void v4_sched_task_create(Vm* vm, uint8_t task, uint8_t priority)
+{
+  if (v4rtos::TaskScheduler* sched = v4rtos::task_sched_of(vm))
+  {
+    sched->create(task, priority);
+  }
+}
+
+extern "C" void v4_sched_task_delete(Vm* vm, uint8_t task)
+{
+  if (v4rtos::TaskScheduler* sched = v4rtos::task_sched_of(vm))
+  {
+    sched->remove(task);
+  }
+}
+
+extern "C" void v4_sched_task_ready(Vm* vm, uint8_t task)
+{
+  if (v4rtos::TaskScheduler* sched = v4rtos::task_sched_of(vm))
+  {
+    sched->ready(task);
+  }
+}
+
+extern "C" void v4_sched_task_block(Vm* vm, uint8_t task)
+{
+  if (v4rtos::TaskScheduler* sched = v4rtos::task_sched_of(vm))
+  {
+    sched->block(task);
+  }
+}
+
+extern "C" uint8_t v4_sched_pick(Vm* vm, uint32_t* slice_ms)
+{
+  v4rtos::TaskScheduler* sched = v4rtos::task_sched_of(vm);
+  if (sched == nullptr)
+  {
+    if (slice_ms != nullptr)
+    {
+      *slice_ms = 0;
+    }
+    return V4_SCHED_NO_TASK;
+  }
+  return sched->pick(slice_ms);
+}
+
+extern "C" int v4_sched_preempt(Vm* vm)
+{
+  v4rtos::TaskScheduler* sched = v4rtos::task_sched_of(vm);
+  return sched != nullptr && sched->preempt() ? 1 : 0;
+}
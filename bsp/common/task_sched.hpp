@@ -0,0 +1,353 @@
+// Fixed-priority task scheduling with priority-inheritance mutexes
+//
+// Scheduling policy for the V4 tasks of one VM. V4-engine built with
+// V4_SCHED_PRIORITY asks the policy which task to run through the
+// v4_sched_* hooks below, instead of rotating through all tasks on a
+// fixed 10 ms slice. The highest-priority ready task always runs (0 is
+// highest, as for TASK-CREATE); tasks of equal priority share the CPU in
+// slices whose length is set per priority (0: run until blocking).
+//
+// Mutexes hand ownership directly to their highest-priority waiter, and
+// an owner runs at the priority of its highest-priority waiter (through
+// chains of owners waiting on further mutexes), so a low-priority task
+// holding a lock cannot be held off by medium-priority work.
+//
+// Wakeup latency (ready until running) is recorded per priority and read
+// out over V4-link with CMD_SCHED.
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "link_frame_scanner.hpp"
+#include "runtime_sys_ids.hpp"  // SYS_TASK_PRIORITY .. SYS_MUTEX_UNLOCK
+
+extern "C"
+{
+  typedef struct Vm Vm;
+
+  /**
+   * @brief Engine hook: task created with a TASK-CREATE priority (0-7)
+   */
+  void v4_sched_task_create(Vm* vm, uint8_t task, uint8_t priority);
+
+  /**
+   * @brief Engine hook: task deleted (its mutexes pass to their waiters)
+   */
+  void v4_sched_task_delete(Vm* vm, uint8_t task);
+
+  /**
+   * @brief Engine hook: task became runnable (delay expired, message arrived)
+   */
+  void v4_sched_task_ready(Vm* vm, uint8_t task);
+
+  /**
+   * @brief Engine hook: task blocked (TASK-DELAY, RECV)
+   */
+  void v4_sched_task_block(Vm* vm, uint8_t task);
+
+  /**
+   * @brief Engine hook: choose the task to run next
+   *
+   * @param slice_ms Receives the task's time slice (0: no slicing; may be NULL)
+   * @return Task ID, or V4_SCHED_NO_TASK to idle
+   */
+  uint8_t v4_sched_pick(Vm* vm, uint32_t* slice_ms);
+
+  /**
+   * @brief Engine hook: check whether the running task must give up the CPU
+   *
+   * Called after every SYS call and on each scheduler tick.
+   *
+   * @return Non-zero to call v4_sched_pick()
+   */
+  int v4_sched_preempt(Vm* vm);
+}
+
+/** Task ID returned by v4_sched_pick() when no task is ready */
+#define V4_SCHED_NO_TASK 0xFF
+
+namespace v4rtos
+{
+
+struct LinkReply;
+
+/**
+ * @brief Fixed-priority preemptive scheduler with PI mutexes
+ *
+ * Not locked: all calls except the statistics readers come from the VM
+ * (engine hooks and SYS handlers) inside the engine's critical section.
+ * Statistics read from the link task may be off by one update.
+ */
+class TaskScheduler
+{
+ public:
+  /** Microsecond clock supplied by the BSP */
+  using Clock = uint32_t (*)(void);
+
+  static constexpr uint8_t MAX_TASKS = 8;               ///< V4 scheduler task limit
+  static constexpr uint8_t PRIORITIES = 8;              ///< 0 (highest) .. 7
+  static constexpr uint8_t MAX_MUTEXES = 8;             ///< Mutex ids 0..MAX_MUTEXES-1
+  static constexpr uint16_t DEFAULT_SLICE_MS = 10;      ///< Former fixed slice
+  static constexpr uint8_t NO_TASK = V4_SCHED_NO_TASK;  ///< No task / no owner
+
+  /** Task state */
+  enum class State : uint8_t
+  {
+    UNUSED = 0,   ///< No task with this ID
+    READY = 1,    ///< Waiting for the CPU
+    RUNNING = 2,  ///< Picked last
+    BLOCKED = 3   ///< Delayed, receiving or waiting for a mutex
+  };
+
+  /** Result codes (the SYS-ERR-* values seen by Forth code) */
+  enum Status : int32_t
+  {
+    OK = 0,            ///< Done
+    BLOCKED = 1,       ///< lock(): caller blocked, owns the mutex when resumed
+    ERR_INVALID = -1,  ///< Bad task/mutex id, not the owner, or relocking
+    ERR_BUSY = -4      ///< try_lock(): mutex held
+  };
+
+  /** CMD_SCHED request operations (first payload byte) */
+  enum Op : uint8_t
+  {
+    OP_STATUS = 0,  ///< Per-priority latency and per-task state
+    OP_RESET = 1    ///< Clear latency and switch counters
+  };
+
+  /** Wakeup latency of one priority */
+  struct Latency
+  {
+    uint32_t wakeups;   ///< Ready-to-running transitions
+    uint32_t max_us;    ///< Worst case
+    uint64_t total_us;  ///< Sum (for the average)
+  };
+
+  /** Task accounting */
+  struct TaskInfo
+  {
+    State state;           ///< Task state
+    uint8_t base;          ///< Priority set by TASK-CREATE / TASK-PRIORITY
+    uint8_t effective;     ///< Priority after inheritance
+    uint8_t waiting_on;    ///< Mutex waited for (NO_TASK: none)
+    uint32_t switches;     ///< Times switched to
+    uint32_t preemptions;  ///< Times preempted by a slice or a higher priority
+  };
+
+  /**
+   * @brief Construct scheduler with DEFAULT_SLICE_MS for every priority
+   * @param clock Microsecond clock
+   */
+  explicit TaskScheduler(Clock clock);
+
+  /**
+   * @brief Set the time slice of one priority
+   * @param priority Priority (0-7)
+   * @param ms Slice length (0: run until blocking or preempted)
+   */
+  void set_slice(uint8_t priority, uint16_t ms);
+
+  /**
+   * @brief Get the time slice of one priority
+   */
+  uint16_t slice(uint8_t priority) const
+  {
+    return slice_ms_[priority < PRIORITIES ? priority : PRIORITIES - 1];
+  }
+
+  /**
+   * @brief Parse per-priority slices ("0 5 10 10 10 10 20 20")
+   *
+   * Numbers are separated by spaces or commas; fewer than PRIORITIES
+   * numbers repeat the last one.
+   *
+   * @param text Slice list
+   * @param slices Receives PRIORITIES slice lengths
+   * @return false if @p text holds no number or a value above 65535
+   */
+  static bool parse_slices(const char* text, uint16_t* slices);
+
+  /**
+   * @brief Enable or disable priority inheritance (on by default)
+   *
+   * Off only to measure priority inversion.
+   */
+  void set_inheritance(bool enabled)
+  {
+    inheritance_ = enabled;
+  }
+
+  /**
+   * @brief Add a ready task
+   * @return false if @p task or @p priority is out of range or in use
+   */
+  bool create(uint8_t task, uint8_t priority);
+
+  /**
+   * @brief Remove a task, handing its mutexes to their waiters
+   */
+  void remove(uint8_t task);
+
+  /**
+   * @brief Make a blocked task ready (no effect while it waits for a mutex)
+   */
+  void ready(uint8_t task);
+
+  /**
+   * @brief Block a ready or running task
+   */
+  void block(uint8_t task);
+
+  /**
+   * @brief Choose the task to run
+   *
+   * A running task preempted by its slice goes behind the other ready
+   * tasks of its priority; one preempted by a higher priority stays in
+   * front.
+   *
+   * @param slice_ms Receives the slice of the chosen task (may be nullptr)
+   * @return Task ID, or NO_TASK
+   */
+  uint8_t pick(uint32_t* slice_ms);
+
+  /**
+   * @brief Check whether pick() would choose a different task now
+   */
+  bool preempt() const;
+
+  /**
+   * @brief Get the task picked last (NO_TASK: none)
+   */
+  uint8_t current() const
+  {
+    return current_;
+  }
+
+  /**
+   * @brief Change a task's base priority
+   */
+  Status set_priority(uint8_t task, uint8_t priority);
+
+  /**
+   * @brief Take a mutex, blocking @p task while another task owns it
+   * @return OK, BLOCKED or ERR_INVALID
+   */
+  Status lock(uint8_t mutex, uint8_t task);
+
+  /**
+   * @brief Take a mutex if it is free
+   * @return OK, ERR_BUSY or ERR_INVALID
+   */
+  Status try_lock(uint8_t mutex, uint8_t task);
+
+  /**
+   * @brief Release a mutex owned by @p task
+   *
+   * Ownership passes to the highest-priority waiter, which becomes ready.
+   */
+  Status unlock(uint8_t mutex, uint8_t task);
+
+  /**
+   * @brief Get the owner of a mutex (NO_TASK: free)
+   */
+  uint8_t owner(uint8_t mutex) const
+  {
+    return mutex < MAX_MUTEXES ? mutexes_[mutex].owner : NO_TASK;
+  }
+
+  /**
+   * @brief Get a task's state and accounting
+   */
+  TaskInfo info(uint8_t task) const;
+
+  /**
+   * @brief Get the wakeup latency of one priority
+   */
+  const Latency& latency(uint8_t priority) const
+  {
+    return latency_[priority];
+  }
+
+  /**
+   * @brief Clear latency and switch counters
+   */
+  void reset_stats();
+
+  /**
+   * @brief Answer a CMD_SCHED request
+   *
+   * RuntimeCmdHandler signature; @p user is the TaskScheduler.
+   */
+  static void handle_command(void* user, const LinkFrameView& frame, LinkReply* reply);
+
+ private:
+  struct Task
+  {
+    State state;           ///< Task state
+    uint8_t base;          ///< Base priority
+    uint8_t effective;     ///< Priority after inheritance
+    uint8_t waiting_on;    ///< Mutex waited for (NO_TASK: none)
+    bool woken;            ///< Became ready since it last ran
+    uint32_t ready_us;     ///< Clock when it became ready
+    uint32_t switches;     ///< Times switched to
+    uint32_t preemptions;  ///< Times preempted
+  };
+
+  struct Mutex
+  {
+    uint8_t owner;    ///< Owning task (NO_TASK: free)
+    uint8_t waiters;  ///< Bit per waiting task
+  };
+
+  /** FIFO of ready tasks of one priority */
+  struct ReadyQueue
+  {
+    uint8_t tasks[MAX_TASKS];  ///< Ring storage
+    uint8_t head;              ///< Oldest entry
+    uint8_t size;              ///< Entries
+  };
+
+  void enqueue(uint8_t task, bool front);
+  void dequeue(uint8_t task);
+  void make_ready(uint8_t task);
+  void update_priority(uint8_t task);
+  void hand_over(uint8_t mutex);
+  void encode_status(LinkReply* reply) const;
+
+  Clock clock_;                    ///< Microsecond clock
+  bool inheritance_ = true;        ///< Priority inheritance enabled
+  uint8_t current_ = NO_TASK;      ///< Task picked last
+  uint8_t ready_mask_ = 0;         ///< Bit per non-empty ready queue
+  uint32_t slice_start_us_ = 0;    ///< Clock when current_ was picked
+  uint16_t slice_ms_[PRIORITIES];  ///< Slice per priority
+  Task tasks_[MAX_TASKS];          ///< Per-task state
+  Mutex mutexes_[MAX_MUTEXES];     ///< Mutex ownership
+  ReadyQueue ready_[PRIORITIES];   ///< Ready tasks per effective priority
+  Latency latency_[PRIORITIES];    ///< Wakeup latency per base priority
+};
+
+/**
+ * @brief Route the engine hooks of @p vm to @p sched
+ *
+ * Call before vm_task_init() so the first task is seen. One scheduler per
+ * VM, up to four VMs (the VM pool size).
+ *
+ * @return false if every slot is taken
+ */
+bool task_sched_attach(const Vm* vm, TaskScheduler* sched);
+
+/**
+ * @brief Stop routing the engine hooks of @p vm (before vm_destroy())
+ */
+void task_sched_detach(const Vm* vm);
+
+/**
+ * @brief Get the scheduler attached to @p vm (nullptr: none)
+ */
+TaskScheduler* task_sched_of(const Vm* vm);
+
+}  // namespace v4rtos
@@ -0,0 +1,177 @@
+// Binary event trace implementation
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#include "trace_buffer.hpp"
+
+#include "link_runtime_commands.hpp"
+
+namespace v4rtos
+{
+
+namespace
+{
+
+TraceBuffer* g_trace = nullptr;
+
+constexpr size_t READ_HEADER_SIZE = 10;  // [core u8][more u8][now u32][dropped u32]
+
+void write_u32(uint8_t* p, uint32_t v)
+{
+  for (int i = 0; i < 4; i++)
+  {
+    p[i] = static_cast<uint8_t>(v >> (8 * i));
+  }
+}
+
+}  // namespace
+
+// ==============================================================================
+// TraceBuffer
+// ==============================================================================
+
+TraceBuffer::TraceBuffer(Clock clock, uint32_t ticks_per_us, CoreId core_id,
+                         size_t cores, size_t records)
+    : clock_(clock),
+      ticks_per_us_(ticks_per_us),
+      core_id_(core_id),
+      cores_(cores == 0 ? 1 : (cores > MAX_CORES ? MAX_CORES : cores))
+{
+  for (size_t i = 0; i < cores_; i++)
+  {
+    rings_[i].reset(new TraceRing(records));
+  }
+}
+
+uint32_t TraceBuffer::dropped() const
+{
+  uint32_t total = 0;
+  for (size_t i = 0; i < cores_; i++)
+  {
+    total += rings_[i]->dropped();
+  }
+  return total;
+}
+
+void TraceBuffer::encode_info(LinkReply* reply) const
+{
+  reply->put_u8(static_cast<uint8_t>(cores_));
+  reply->put_u32(ticks_per_us_);
+  reply->put_u32(enabled_.load(std::memory_order_relaxed));
+  reply->put_u16(static_cast<uint16_t>(rings_[0]->capacity()));
+  for (size_t i = 0; i < cores_; i++)
+  {
+    reply->put_u16(static_cast<uint16_t>(rings_[i]->pending()));
+    reply->put_u32(rings_[i]->dropped());
+  }
+}
+
+void TraceBuffer::encode_records(uint8_t core, LinkReply* reply)
+{
+  TraceRing& ring = *rings_[core];
+  if (reply->cap - reply->len < READ_HEADER_SIZE)
+  {
+    reply->status = link_wire::STATUS_ERROR;
+    return;
+  }
+  uint8_t* header = reply->data + reply->len;
+  reply->len += READ_HEADER_SIZE;
+
+  TraceRecord rec;
+  while (reply->cap - reply->len >= WIRE_RECORD && ring.pop(&rec))
+  {
+    reply->put_u32(rec.time);
+    reply->put_u8(rec.type);
+    reply->put_u8(rec.task);
+    reply->put_u16(rec.arg16);
+    reply->put_u32(rec.arg);
+  }
+
+  // Read after the records so that none is newer than "now": the host
+  // unwraps 32-bit timestamps against it
+  header[0] = core;
+  header[1] = reply->cap - reply->len < WIRE_RECORD && ring.pending() > 0 ? 1 : 0;
+  write_u32(header + 2, clock_());
+  write_u32(header + 6, ring.dropped());
+}
+
+void TraceBuffer::handle_command(void* user, const LinkFrameView& frame,
+                                 LinkReply* reply)
+{
+  TraceBuffer* self = static_cast<TraceBuffer*>(user);
+  if (frame.len < 1)
+  {
+    reply->status = link_wire::STATUS_ERROR;
+    return;
+  }
+
+  switch (frame.payload[0])
+  {
+    case OP_INFO:
+      self->encode_info(reply);
+      break;
+    case OP_READ:
+      if (frame.len < 2 || frame.payload[1] >= self->cores_)
+      {
+        reply->status = link_wire::STATUS_ERROR;
+        break;
+      }
+      self->encode_records(frame.payload[1], reply);
+      break;
+    case OP_ENABLE:
+      if (frame.len < 5)
+      {
+        reply->status = link_wire::STATUS_ERROR;
+        break;
+      }
+      self->set_enabled(static_cast<uint32_t>(frame.payload[1]) |
+                        (static_cast<uint32_t>(frame.payload[2]) << 8) |
+                        (static_cast<uint32_t>(frame.payload[3]) << 16) |
+                        (static_cast<uint32_t>(frame.payload[4]) << 24));
+      reply->put_u32(self->enabled_.load(std::memory_order_relaxed));
+      break;
+    case OP_CLEAR:
+      for (size_t i = 0; i < self->cores_; i++)
+      {
+        self->rings_[i]->clear();
+      }
+      break;
+    default:
+      reply->status = link_wire::STATUS_ERROR;
+      break;
+  }
+}
+
+void trace_install(TraceBuffer* trace)
+{
+  g_trace = trace;
+}
+
+void trace_event(TraceEvent type, uint8_t task, uint16_t arg16, uint32_t arg)
+{
+  if (g_trace != nullptr)
+  {
+    g_trace->emit(type, task, arg16, arg);
+  }
+}
+
+}  // namespace v4rtos
+
+// ==============================================================================
+// V4-engine hooks
+// ==============================================================================
+
+extern "C" void v4_trace_task_switch(uint8_t from, uint8_t to, int preempted)
+{
+  v4rtos::trace_event(v4rtos::TRACE_TASK_SWITCH, to, from, preempted != 0 ? 1 : 0);
+}
+
+extern "C" void v4_trace_sys_enter(uint8_t task, uint16_t id)
+{
+  v4rtos::trace_event(v4rtos::TRACE_SYS_ENTER, task, id, 0);
+}
+
+extern "C" void v4_trace_sys_exit(uint8_t task, uint16_t id, int32_t err)
+{
+  v4rtos::trace_event(v4rtos::TRACE_SYS_EXIT, task, id, static_cast<uint32_t>(err));
+}
@@ -0,0 +1,196 @@
+// Binary event trace
+//
+// Records scheduling and I/O events (task switches, SYS calls, pooled
+// messages, V4-link frames, panics) as fixed-size binary records with a
+// cycle-counter timestamp instead of formatted log lines. Every CPU core
+// has its own lock-free ring (MpscRing): tasks and interrupts on that core
+// reserve a record with one compare-and-swap and publish it with a release
+// store, so an event costs a clock read and a few stores and never blocks.
+// A full ring drops new events and counts them.
+//
+// The link task drains the rings with CMD_TRACE; scripts/v4trace.py turns
+// the records into a Perfetto (JSON) or CTF trace. V4-engine built with
+// V4_TRACE reports task switches and SYS calls through the hooks below;
+// the runtime adds the rest with trace_event().
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "link_frame_scanner.hpp"
+#include "mpsc_ring.hpp"
+
+extern "C"
+{
+  /**
+   * @brief Engine hook: scheduler switched tasks
+   *
+   * @param from Task that stopped running (V4_TRACE_NO_TASK: none)
+   * @param to Task that starts running (V4_TRACE_NO_TASK: idle)
+   * @param preempted Non-zero if @p from was preempted
+   */
+  void v4_trace_task_switch(uint8_t from, uint8_t to, int preempted);
+
+  /**
+   * @brief Engine hook: about to run a SYS handler
+   */
+  void v4_trace_sys_enter(uint8_t task, uint16_t id);
+
+  /**
+   * @brief Engine hook: SYS handler returned @p err
+   */
+  void v4_trace_sys_exit(uint8_t task, uint16_t id, int32_t err);
+}
+
+/** Task ID of events outside any V4 task */
+#define V4_TRACE_NO_TASK 0xFF
+
+namespace v4rtos
+{
+
+struct LinkReply;
+
+/** Event types (record type byte; bit n of the enable mask) */
+enum TraceEvent : uint8_t
+{
+  TRACE_TASK_SWITCH = 0,  ///< task: next, arg16: previous, arg: preempted
+  TRACE_SYS_ENTER = 1,    ///< task: caller, arg16: SYS id
+  TRACE_SYS_EXIT = 2,     ///< task: caller, arg16: SYS id, arg: error
+  TRACE_MSG_SEND = 3,     ///< task: receiver, arg16: length, arg: address
+  TRACE_MSG_RECV = 4,     ///< task: receiver, arg16: length, arg: address
+  TRACE_LINK_RX = 5,      ///< arg16: command, arg: payload length
+  TRACE_LINK_TX = 6,      ///< arg16: status, arg: frame length
+  TRACE_PANIC = 7,        ///< task: faulting task, arg16: VM, arg: error
+  TRACE_EVENT_COUNT = 8
+};
+
+/** One event */
+struct TraceRecord
+{
+  uint32_t time;   ///< Clock ticks (32-bit, wraps)
+  uint8_t type;    ///< TraceEvent
+  uint8_t task;    ///< V4 task (V4_TRACE_NO_TASK: none)
+  uint16_t arg16;  ///< Event argument
+  uint32_t arg;    ///< Event argument
+};
+
+/** Ring of one core: tasks and interrupts of that core push, the link task pops */
+using TraceRing = MpscRing<TraceRecord>;
+
+/**
+ * @brief Per-core trace rings with their clock and event filter
+ */
+class TraceBuffer
+{
+ public:
+  /** Timestamp source (cycle counter or fine-grained timer) */
+  using Clock = uint32_t (*)(void);
+
+  /** Index of the calling core */
+  using CoreId = uint32_t (*)(void);
+
+  static constexpr size_t MAX_CORES = 2;     ///< Rings
+  static constexpr size_t WIRE_RECORD = 12;  ///< Record bytes in a READ response
+  static constexpr uint32_t ALL_EVENTS = (1u << TRACE_EVENT_COUNT) - 1;
+
+  /** CMD_TRACE request operations (first payload byte) */
+  enum Op : uint8_t
+  {
+    OP_INFO = 0,    ///< Clock, event mask, per-core fill and drops
+    OP_READ = 1,    ///< Remove records of one core: [core u8]
+    OP_ENABLE = 2,  ///< Set the event mask: [mask u32]
+    OP_CLEAR = 3    ///< Discard all published records
+  };
+
+  /**
+   * @brief Construct trace buffer
+   * @param clock Timestamp source
+   * @param ticks_per_us Clock rate, reported to the host
+   * @param core_id Core of the caller (nullptr: single core)
+   * @param cores Rings, one per core (1..MAX_CORES)
+   * @param records Records per ring
+   */
+  TraceBuffer(Clock clock, uint32_t ticks_per_us, CoreId core_id, size_t cores,
+              size_t records);
+
+  /**
+   * @brief Record an event on the calling core's ring
+   */
+  void emit(TraceEvent type, uint8_t task, uint16_t arg16, uint32_t arg)
+  {
+    if ((enabled_.load(std::memory_order_relaxed) & (1u << type)) == 0)
+    {
+      return;
+    }
+    uint32_t core = core_id_ != nullptr ? core_id_() : 0;
+    TraceRecord rec = {clock_(), type, task, arg16, arg};
+    rings_[core < cores_ ? core : 0]->push(rec);
+  }
+
+  /**
+   * @brief Select the events to record (bit n: TraceEvent n)
+   */
+  void set_enabled(uint32_t mask)
+  {
+    enabled_.store(mask & ALL_EVENTS, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Get the ring of core @p core
+   */
+  TraceRing& ring(size_t core)
+  {
+    return *rings_[core];
+  }
+
+  /**
+   * @brief Get number of rings
+   */
+  size_t cores() const
+  {
+    return cores_;
+  }
+
+  /**
+   * @brief Get number of events dropped on all cores
+   */
+  uint32_t dropped() const;
+
+  /**
+   * @brief Answer a CMD_TRACE request
+   *
+   * RuntimeCmdHandler signature; @p user is the TraceBuffer. The link
+   * port serializes frames, so the rings keep a single consumer.
+   */
+  static void handle_command(void* user, const LinkFrameView& frame, LinkReply* reply);
+
+ private:
+  void encode_info(LinkReply* reply) const;
+  void encode_records(uint8_t core, LinkReply* reply);
+
+  Clock clock_;                                  ///< Timestamp source
+  uint32_t ticks_per_us_;                        ///< Clock rate
+  CoreId core_id_;                               ///< Core of the caller
+  size_t cores_;                                 ///< Rings in use
+  std::atomic<uint32_t> enabled_{ALL_EVENTS};    ///< Event mask
+  std::unique_ptr<TraceRing> rings_[MAX_CORES];  ///< Ring per core
+};
+
+/**
+ * @brief Route trace_event() and the engine trace hooks to @p trace
+ *
+ * @param trace Trace buffer, or nullptr to ignore events
+ */
+void trace_install(TraceBuffer* trace);
+
+/**
+ * @brief Record a runtime event (no-op until trace_install())
+ */
+void trace_event(TraceEvent type, uint8_t task, uint16_t arg16, uint32_t arg);
+
+}  // namespace v4rtos
@@ -0,0 +1,113 @@
+// Outbound byte ring implementation
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#include "tx_ring.hpp"
+
+#include <cstring>
+
+namespace v4rtos
+{
+
+static size_t round_up_pow2(size_t n)
+{
+  size_t p = 1;
+  while (p < n)
+  {
+    p <<= 1;
+  }
+  return p;
+}
+
+TxRing::TxRing(size_t capacity, Sink sink, void* user, uint32_t max_wait_ms)
+    : capacity_(round_up_pow2(capacity)),
+      sink_(sink),
+      user_(user),
+      max_wait_ms_(max_wait_ms),
+      buf_(new uint8_t[round_up_pow2(capacity)])
+{
+}
+
+bool TxRing::write(const uint8_t* data, size_t len)
+{
+  if (capacity_ - pending() < len)
+  {
+    // Bounded wait for the transport to make room, then give up. Once a
+    // wait has timed out, later writes drop immediately until the
+    // transport makes progress again instead of paying the wait each time.
+    flush(stalled_ ? 0 : max_wait_ms_);
+    if (capacity_ - pending() < len)
+    {
+      stats_.dropped_bytes += len;
+      stats_.dropped_writes++;
+      return false;
+    }
+  }
+
+  size_t head = head_.load(std::memory_order_relaxed);
+  size_t pos = head & (capacity_ - 1);
+  size_t first = capacity_ - pos < len ? capacity_ - pos : len;
+  memcpy(&buf_[pos], data, first);
+  memcpy(&buf_[0], data + first, len - first);
+  head_.store(head + len, std::memory_order_release);
+
+  stats_.queued_bytes += len;
+  size_t now_pending = pending();
+  if (now_pending > stats_.high_water)
+  {
+    stats_.high_water = now_pending;
+  }
+
+  // Coalesce small responses, but stream large outputs
+  if (now_pending >= capacity_ / 2)
+  {
+    flush(0);
+  }
+  return true;
+}
+
+size_t TxRing::flush(uint32_t timeout_ms)
+{
+  size_t total = 0;
+  size_t head = head_.load(std::memory_order_acquire);
+  size_t tail = tail_.load(std::memory_order_relaxed);
+
+  // At most two contiguous segments (before and after the wrap)
+  while (tail != head)
+  {
+    size_t pos = tail & (capacity_ - 1);
+    size_t len = head - tail;
+    size_t seg = capacity_ - pos < len ? capacity_ - pos : len;
+
+    size_t sent = sink_(user_, &buf_[pos], seg, timeout_ms);
+    stats_.flushes++;
+    tail += sent;
+    total += sent;
+    tail_.store(tail, std::memory_order_release);
+
+    if (sent < seg)
+    {
+      stats_.stalls++;
+      break;
+    }
+  }
+
+  if (total > 0)
+  {
+    stalled_ = false;
+  }
+  else if (timeout_ms > 0 && tail != head)
+  {
+    stalled_ = true;
+  }
+
+  stats_.flushed_bytes += total;
+  return total;
+}
+
+void TxRing::reset()
+{
+  tail_.store(head_.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+}  // namespace v4rtos
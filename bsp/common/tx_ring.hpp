@@ -0,0 +1,123 @@
+// Outbound byte ring for V4-link responses
+//
+// Responses (ACKs, REPL output) are queued without blocking and pushed to
+// the transport in coalesced flushes. When the transport cannot keep up,
+// a write waits at most a bounded time for room and is then dropped as a
+// whole, so a stalled host never blocks bytecode ingestion and never sees
+// a truncated frame.
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace v4rtos
+{
+
+/**
+ * @brief Outbound ring buffer with coalesced flushes
+ *
+ * write() and flush() are called from the thread that owns the link
+ * (the link task on the device). pending() and stats() may be read from
+ * other threads for diagnostics.
+ */
+class TxRing
+{
+ public:
+  /**
+   * @brief Transport sink
+   *
+   * Write up to @p len bytes, waiting at most @p timeout_ms for room.
+   *
+   * @return Number of bytes accepted (0 on timeout or error)
+   */
+  using Sink = size_t (*)(void* user, const uint8_t* data, size_t len,
+                          uint32_t timeout_ms);
+
+  /** Ring counters */
+  struct Stats
+  {
+    uint64_t queued_bytes;    ///< Bytes accepted by write()
+    uint64_t flushed_bytes;   ///< Bytes handed to the sink
+    uint64_t dropped_bytes;   ///< Bytes rejected because the ring stayed full
+    uint64_t dropped_writes;  ///< Writes rejected (each one a whole response)
+    uint64_t flushes;         ///< Sink calls
+    uint64_t stalls;          ///< Flushes the sink could not complete
+    size_t high_water;        ///< Largest number of pending bytes
+  };
+
+  /**
+   * @brief Construct ring
+   * @param capacity Ring size in bytes (rounded up to a power of two)
+   * @param sink Transport sink
+   * @param user User pointer passed to @p sink
+   * @param max_wait_ms Longest time write() waits for room before dropping
+   */
+  TxRing(size_t capacity, Sink sink, void* user, uint32_t max_wait_ms);
+
+  /**
+   * @brief Queue bytes for transmission (all or nothing)
+   *
+   * Never blocks longer than max_wait_ms, and not at all while the
+   * transport is known to be stalled. Flushes early once the ring is half
+   * full so large outputs stream instead of piling up.
+   *
+   * @param data Bytes to send
+   * @param len Number of bytes
+   * @return true if queued, false if dropped
+   */
+  bool write(const uint8_t* data, size_t len);
+
+  /**
+   * @brief Push pending bytes to the sink
+   * @param timeout_ms Time the sink may wait for room (0: non-blocking)
+   * @return Number of bytes flushed
+   */
+  size_t flush(uint32_t timeout_ms);
+
+  /**
+   * @brief Discard pending bytes (counters are kept)
+   */
+  void reset();
+
+  /**
+   * @brief Get number of bytes waiting to be flushed
+   */
+  size_t pending() const
+  {
+    return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief Get ring capacity in bytes
+   */
+  size_t capacity() const
+  {
+    return capacity_;
+  }
+
+  /**
+   * @brief Get ring counters
+   */
+  const Stats& stats() const
+  {
+    return stats_;
+  }
+
+ private:
+  size_t capacity_;                 ///< Ring size (power of two)
+  Sink sink_;                       ///< Transport sink
+  void* user_;                      ///< Sink user pointer
+  uint32_t max_wait_ms_;            ///< Bounded wait in write()
+  std::unique_ptr<uint8_t[]> buf_;  ///< Ring storage
+  std::atomic<size_t> head_{0};     ///< Write index (free-running)
+  std::atomic<size_t> tail_{0};     ///< Read index (free-running)
+  bool stalled_ = false;            ///< Last bounded wait made no progress
+  Stats stats_ = {};                ///< Counters
+};
+
+}  // namespace v4rtos
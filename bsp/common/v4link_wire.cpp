@@ -0,0 +1,65 @@
+// V4-link wire format helpers
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#include "v4link_wire.hpp"
+
+#include <cstring>
+
+namespace v4rtos
+{
+namespace link_wire
+{
+
+namespace
+{
+
+// CRC8 lookup table (poly 0x07), generated at compile time
+struct Crc8Table
+{
+  uint8_t v[256];
+
+  constexpr Crc8Table() : v()
+  {
+    for (int i = 0; i < 256; i++)
+    {
+      uint8_t crc = static_cast<uint8_t>(i);
+      for (int bit = 0; bit < 8; bit++)
+      {
+        crc = (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ 0x07)
+                           : static_cast<uint8_t>(crc << 1);
+      }
+      v[i] = crc;
+    }
+  }
+};
+
+constexpr Crc8Table CRC8_TABLE{};
+
+}  // namespace
+
+uint8_t crc8(const uint8_t* data, size_t len, uint8_t crc)
+{
+  for (size_t i = 0; i < len; i++)
+  {
+    crc = CRC8_TABLE.v[crc ^ data[i]];
+  }
+  return crc;
+}
+
+size_t encode_frame(uint8_t cmd, const uint8_t* payload, size_t len, uint8_t* out)
+{
+  out[0] = STX;
+  out[1] = static_cast<uint8_t>(len & 0xFF);
+  out[2] = static_cast<uint8_t>((len >> 8) & 0xFF);
+  out[3] = cmd;
+  if (len > 0 && payload != out + HEADER_SIZE)
+  {
+    memcpy(out + HEADER_SIZE, payload, len);
+  }
+  out[HEADER_SIZE + len] = crc8(out + 1, HEADER_SIZE - 1 + len);
+  return len + OVERHEAD;
+}
+
+}  // namespace link_wire
+}  // namespace v4rtos
@@ -0,0 +1,88 @@
+// V4-link wire format shared by the runtime link ports
+//
+// Frame: [STX][LEN_L][LEN_H][CMD][PAYLOAD...][CRC8]
+//   - LEN is the payload length (little-endian, CMD excluded)
+//   - CRC8 (poly 0x07, init 0x00) covers LEN_L..PAYLOAD
+//
+// Responses use the same framing with a status code in the CMD slot.
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace v4rtos
+{
+namespace link_wire
+{
+
+constexpr uint8_t STX = 0xA5;      ///< Start-of-frame marker
+constexpr size_t HEADER_SIZE = 4;  ///< STX + LEN_L + LEN_H + CMD
+constexpr size_t CRC_SIZE = 1;     ///< Trailing CRC8
+constexpr size_t OVERHEAD = HEADER_SIZE + CRC_SIZE;
+
+// Core commands (handled by v4::link::Link)
+constexpr uint8_t CMD_EXEC = 0x10;   ///< Execute bytecode
+constexpr uint8_t CMD_PING = 0x20;   ///< Liveness check
+constexpr uint8_t CMD_RESET = 0xFF;  ///< Reset VM
+
+// Runtime extension commands (handled by the runtime link port)
+constexpr uint8_t CMD_RUNTIME_FIRST = 0x40;
+constexpr uint8_t CMD_RUNTIME_LAST = 0x7F;
+constexpr uint8_t CMD_MEM_STATS = 0x40;  ///< Memory high-water marks
+constexpr uint8_t CMD_PROFILE = 0x41;    ///< VM profiler (V4_PROFILE builds)
+constexpr uint8_t CMD_VM_SELECT = 0x42;  ///< Route core frames to a pool VM
+constexpr uint8_t CMD_VM_CTRL = 0x43;    ///< VM pool status and restart
+constexpr uint8_t CMD_CRASH_LOG = 0x44;  ///< Persisted panics, panic policy
+constexpr uint8_t CMD_IMAGE = 0x45;      ///< Flash bytecode image (write, info)
+constexpr uint8_t CMD_CAPS = 0x46;       ///< Capabilities and commands served
+constexpr uint8_t CMD_WINDOW = 0x47;     ///< Pipelined runtime commands (LinkWindow)
+constexpr uint8_t CMD_SCHED = 0x48;      ///< Task scheduler latency (V4_SCHED_PRIORITY)
+constexpr uint8_t CMD_TRACE = 0x49;      ///< Binary event trace (V4_TRACE)
+constexpr uint8_t CMD_LOG = 0x4A;        ///< Deferred-format log (V4_LOG_DEFERRED)
+
+// Capability bits (CMD_CAPS)
+constexpr uint32_t CAP_IMAGE_LZ4 = 1u << 0;    ///< CMD_IMAGE takes LZ4 streams
+constexpr uint32_t CAP_LINK_WINDOW = 1u << 1;  ///< CMD_WINDOW is served
+
+// Response status codes
+constexpr uint8_t STATUS_OK = 0x00;
+constexpr uint8_t STATUS_ERROR = 0x01;
+constexpr uint8_t STATUS_ERR_CRC = 0x02;
+constexpr uint8_t STATUS_ERR_BUFFER_FULL = 0x03;
+constexpr uint8_t STATUS_ERR_INVALID_FRAME = 0x04;
+
+/**
+ * @brief Check whether a command is owned by the runtime
+ */
+constexpr bool is_runtime_cmd(uint8_t cmd)
+{
+  return cmd >= CMD_RUNTIME_FIRST && cmd <= CMD_RUNTIME_LAST;
+}
+
+/**
+ * @brief Compute CRC8 (poly 0x07) over a buffer, table driven
+ *
+ * @param data Input bytes
+ * @param len Number of bytes
+ * @param crc Initial/running CRC value
+ * @return Updated CRC
+ */
+uint8_t crc8(const uint8_t* data, size_t len, uint8_t crc = 0);
+
+/**
+ * @brief Encode a frame into @p out
+ *
+ * @param cmd Command (or status code for responses)
+ * @param payload Payload bytes (may be nullptr if @p len is 0, or
+ *                out + HEADER_SIZE if the payload was built in place)
+ * @param len Payload length
+ * @param out Output buffer, at least len + OVERHEAD bytes
+ * @return Encoded frame size
+ */
+size_t encode_frame(uint8_t cmd, const uint8_t* payload, size_t len, uint8_t* out);
+
+}  // namespace link_wire
+}  // namespace v4rtos
@@ -0,0 +1,121 @@
+// Hot-word JIT cache implementation
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#include "vm_jit.hpp"
+
+namespace v4rtos
+{
+
+namespace
+{
+
+JitCache* g_jit = nullptr;
+
+// Give up after this many probes; the call is simply not counted
+constexpr size_t MAX_PROBE = 8;
+
+}  // namespace
+
+JitCache::JitCache(Rv32Jit* jit, uint32_t* exec, size_t exec_words, uint32_t threshold,
+                   SyncFn sync)
+    : jit_(jit), exec_(exec), exec_words_(exec_words), threshold_(threshold), sync_(sync)
+{
+  flush();
+}
+
+void JitCache::flush()
+{
+  for (Slot& slot : slots_)
+  {
+    slot = Slot{nullptr, 0, 0, 0, State::EMPTY};
+  }
+  exec_next_ = 0;
+  stats_.exec_used = 0;
+}
+
+JitCache::Slot* JitCache::find(const uint8_t* code, size_t entry)
+{
+  size_t h = (static_cast<uint32_t>(entry) * 2654435761u) >> 26;
+  for (size_t i = 0; i < MAX_PROBE; i++)
+  {
+    Slot& slot = slots_[(h + i) % SLOTS];
+    if (slot.state == State::EMPTY)
+    {
+      slot = Slot{code, static_cast<uint32_t>(entry), 0, 0, State::COUNTING};
+      return &slot;
+    }
+    if (slot.code == code && slot.entry == entry)
+    {
+      return &slot;
+    }
+  }
+  return nullptr;
+}
+
+const uint32_t* JitCache::lookup(const uint8_t* code, size_t len, size_t entry)
+{
+  stats_.lookups++;
+  Slot* slot = find(code, entry);
+  if (slot == nullptr)
+  {
+    stats_.untracked++;
+    return nullptr;
+  }
+
+  if (slot->state == State::COUNTING && ++slot->count >= threshold_)
+  {
+    uint32_t* out = exec_ + exec_next_;
+    size_t n = jit_->compile(code, len, entry, out, exec_words_ - exec_next_);
+    if (n == 0)
+    {
+      slot->state = State::FAILED;
+      stats_.failed++;
+      return nullptr;
+    }
+    if (sync_ != nullptr)
+    {
+      sync_(out, n * sizeof(uint32_t));
+    }
+    slot->native = static_cast<uint32_t>(exec_next_);
+    slot->state = State::NATIVE;
+    exec_next_ += n;
+    stats_.exec_used = exec_next_ * sizeof(uint32_t);
+    stats_.compiled++;
+  }
+
+  if (slot->state != State::NATIVE)
+  {
+    return nullptr;
+  }
+  stats_.native_runs++;
+  return exec_ + slot->native;
+}
+
+void vm_jit_install(JitCache* cache)
+{
+  g_jit = cache;
+}
+
+}  // namespace v4rtos
+
+// ==============================================================================
+// V4-engine hooks
+// ==============================================================================
+
+extern "C" const void* v4_jit_lookup(const uint8_t* code, uint32_t len, uint32_t entry)
+{
+  if (v4rtos::g_jit == nullptr)
+  {
+    return nullptr;
+  }
+  return v4rtos::g_jit->lookup(code, len, entry);
+}
+
+extern "C" void v4_jit_flush(void)
+{
+  if (v4rtos::g_jit != nullptr)
+  {
+    v4rtos::g_jit->flush();
+  }
+}
@@ -0,0 +1,143 @@
+// Hot-word JIT cache
+//
+// Counts how often each word is called and hands words that reach the
+// threshold to Rv32Jit, placing the machine code in an executable buffer
+// (IRAM on the ESP32-C6). Fed by the V4-engine JIT hooks below, which the
+// engine calls when built with V4_JIT; words that cannot be compiled stay
+// interpreted.
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "rv32_jit.hpp"
+
+extern "C"
+{
+  /**
+   * @brief Engine hook: CALL to the word at @p entry
+   *
+   * Called after the return address has been pushed. If native code is
+   * returned, the engine runs it with a JitFrame for the current task
+   * instead of interpreting the word (see JIT_DONE / JIT_EXIT).
+   *
+   * @param code Base of the bytecode the word lives in
+   * @param len Length of that bytecode
+   * @param entry Word offset within @p code
+   * @return Native code (a v4rtos::JitFn), or nullptr to interpret
+   */
+  const void* v4_jit_lookup(const uint8_t* code, uint32_t len, uint32_t entry);
+
+  /**
+   * @brief Engine hook: bytecode was reset or replaced
+   *
+   * Drops all counters and compiled words.
+   */
+  void v4_jit_flush(void);
+}
+
+namespace v4rtos
+{
+
+/**
+ * @brief Call counters and compiled-code cache
+ */
+class JitCache
+{
+ public:
+  /** Words tracked at once (open addressing) */
+  static constexpr size_t SLOTS = 64;
+
+  /** Make freshly written code visible to instruction fetch */
+  using SyncFn = void (*)(const void* code, size_t bytes);
+
+  /** Cache counters */
+  struct Stats
+  {
+    uint32_t lookups;      ///< Calls seen
+    uint32_t native_runs;  ///< Calls answered with native code
+    uint32_t compiled;     ///< Words compiled
+    uint32_t failed;       ///< Words that did not fit the executable buffer
+    uint32_t untracked;    ///< Calls not counted (table full)
+    size_t exec_used;      ///< Executable buffer used (bytes)
+  };
+
+  /**
+   * @brief Construct cache
+   *
+   * @param jit Compiler
+   * @param exec Executable buffer (4-byte aligned)
+   * @param exec_words Buffer size in instruction words
+   * @param threshold Calls before a word is compiled
+   * @param sync Called after each compile (nullptr: nothing to do)
+   */
+  JitCache(Rv32Jit* jit, uint32_t* exec, size_t exec_words, uint32_t threshold,
+           SyncFn sync);
+
+  /**
+   * @brief Count a call; compile the word once it is hot
+   * @return Native code for the word, or nullptr
+   */
+  const uint32_t* lookup(const uint8_t* code, size_t len, size_t entry);
+
+  /**
+   * @brief Forget all words and free the executable buffer
+   */
+  void flush();
+
+  /**
+   * @brief Get cache counters
+   */
+  const Stats& stats() const
+  {
+    return stats_;
+  }
+
+ private:
+  enum class State : uint8_t
+  {
+    EMPTY,     ///< Free slot
+    COUNTING,  ///< Interpreted, counting calls
+    NATIVE,    ///< Compiled
+    FAILED     ///< Not compilable; stays interpreted
+  };
+
+  struct Slot
+  {
+    const uint8_t* code;  ///< Bytecode base
+    uint32_t entry;       ///< Word offset
+    uint32_t count;       ///< Calls so far
+    uint32_t native;      ///< Offset in the executable buffer (words)
+    State state;          ///< Slot state
+  };
+
+  Slot* find(const uint8_t* code, size_t entry);
+
+  Rv32Jit* jit_;          ///< Compiler
+  uint32_t* exec_;        ///< Executable buffer
+  size_t exec_words_;     ///< Buffer capacity (words)
+  size_t exec_next_ = 0;  ///< Next free word
+  uint32_t threshold_;    ///< Calls before compiling
+  SyncFn sync_;           ///< I-cache sync
+  Slot slots_[SLOTS];     ///< Tracked words
+  Stats stats_ = {};      ///< Counters
+};
+
+/**
+ * @brief Route the engine JIT hooks to @p cache
+ *
+ * @param cache Cache, or nullptr to interpret everything
+ */
+void vm_jit_install(JitCache* cache);
+
+}  // namespace v4rtos
+
+/**
+ * @brief Instruction set of the linked V4-engine
+ *
+ * Exported by V4-engine builds with V4_JIT (opcode to template mapping).
+ */
+extern "C" const v4rtos::JitIsa* v4_jit_isa(void);
@@ -0,0 +1,166 @@
+// VM pool implementation
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#include "vm_pool.hpp"
+
+#include "link_runtime_commands.hpp"
+#include "mem_watermark.hpp"
+
+namespace v4rtos
+{
+
+VmPool::VmPool(uint8_t* arena, size_t arena_size, size_t count, CreateFn create,
+               DestroyFn destroy, void* user)
+    : arena_(arena), create_(create), destroy_(destroy), user_(user)
+{
+  count_ = count < 1 ? 1 : (count > MAX_VMS ? MAX_VMS : count);
+  slice_size_ = (arena_size / count_) & ~(SLICE_ALIGN - 1);
+  for (size_t i = 0; i < MAX_VMS; i++)
+  {
+    slots_[i] = Slot{this, static_cast<uint8_t>(i), nullptr, Info{}};
+  }
+}
+
+VmPool::~VmPool()
+{
+  for (size_t i = 0; i < count_; i++)
+  {
+    stop(static_cast<uint8_t>(i));
+  }
+}
+
+bool VmPool::create(Slot* slot)
+{
+  uint8_t* mem = slice(slot->id);
+  mem_paint(mem, slice_size_);
+  slot->vm = create_(user_, slot->id, mem, slice_size_);
+  slot->info.generation++;
+  slot->info.state = slot->vm != nullptr ? State::RUNNING : State::STOPPED;
+  return slot->vm != nullptr;
+}
+
+size_t VmPool::start()
+{
+  size_t running = 0;
+  for (size_t i = 0; i < count_; i++)
+  {
+    Slot& slot = slots_[i];
+    if (slot.vm != nullptr || create(&slot))
+    {
+      running++;
+    }
+  }
+  return running;
+}
+
+bool VmPool::restart(uint8_t id)
+{
+  if (id >= count_)
+  {
+    return false;
+  }
+  stop(id);
+  if (!create(&slots_[id]))
+  {
+    return false;
+  }
+  slots_[id].info.restarts++;
+  return true;
+}
+
+void VmPool::stop(uint8_t id)
+{
+  if (id >= count_)
+  {
+    return;
+  }
+  Slot& slot = slots_[id];
+  if (slot.vm != nullptr)
+  {
+    destroy_(user_, slot.vm);
+    slot.vm = nullptr;
+    slot.info.generation++;
+  }
+  slot.info.state = State::STOPPED;
+}
+
+void VmPool::fault(uint8_t id, int32_t error)
+{
+  if (id >= count_)
+  {
+    return;
+  }
+  Slot& slot = slots_[id];
+  slot.info.faults++;
+  slot.info.last_error = error;
+  if (slot.info.state == State::RUNNING)
+  {
+    slot.info.state = State::FAULTED;
+  }
+}
+
+void* VmPool::vm(uint8_t id) const
+{
+  if (id >= count_ || slots_[id].info.state != State::RUNNING)
+  {
+    return nullptr;
+  }
+  return slots_[id].vm;
+}
+
+int VmPool::find(const void* vm) const
+{
+  for (size_t i = 0; i < count_; i++)
+  {
+    if (vm != nullptr && slots_[i].vm == vm)
+    {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+void VmPool::panic_hook(void* context, int32_t error)
+{
+  Slot* slot = static_cast<Slot*>(context);
+  slot->owner->fault(slot->id, error);
+}
+
+void VmPool::handle_command(void* user, const LinkFrameView& frame, LinkReply* reply)
+{
+  VmPool* self = static_cast<VmPool*>(user);
+  if (frame.len < 1)
+  {
+    reply->status = link_wire::STATUS_ERROR;
+    return;
+  }
+
+  switch (frame.payload[0])
+  {
+    case OP_STATUS:
+      reply->put_u8(static_cast<uint8_t>(self->count_));
+      for (size_t i = 0; i < self->count_; i++)
+      {
+        const Info& info = self->slots_[i].info;
+        reply->put_u8(static_cast<uint8_t>(i));
+        reply->put_u8(static_cast<uint8_t>(info.state));
+        reply->put_u16(info.restarts);
+        reply->put_u16(info.faults);
+        reply->put_u32(static_cast<uint32_t>(info.last_error));
+        reply->put_u32(static_cast<uint32_t>(self->slice_size_));
+      }
+      break;
+    case OP_RESTART:
+      if (frame.len < 2 || !self->restart(frame.payload[1]))
+      {
+        reply->status = link_wire::STATUS_ERROR;
+      }
+      break;
+    default:
+      reply->status = link_wire::STATUS_ERROR;
+      break;
+  }
+}
+
+}  // namespace v4rtos
@@ -0,0 +1,194 @@
+// Pool of independent VM instances
+//
+// Splits one arena into equal slices and runs one VM per slice, each with
+// its own dictionary, task set and V4-link channel (CMD_VM_SELECT). A VM
+// that panics is marked faulted instead of halting the device and is
+// restarted on its own. Creating a VM is left to the BSP (vm_create() and
+// vm_task_init() on target, bench VMs on the host), so the pool has no
+// V4-engine dependency.
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "link_frame_scanner.hpp"
+
+namespace v4rtos
+{
+
+struct LinkReply;
+
+/**
+ * @brief Fixed set of VMs over one arena
+ *
+ * Not locked: start(), restart() and stop() for a VM must run on the task
+ * that executes that VM (the link task on target). fault() may be called
+ * from inside the VM, e.g. its panic handler.
+ */
+class VmPool
+{
+ public:
+  static constexpr size_t MAX_VMS = 4;       ///< Pool capacity
+  static constexpr size_t SLICE_ALIGN = 16;  ///< Arena slice alignment
+
+  /**
+   * @brief Create a VM in its arena slice
+   *
+   * @param user User pointer given to the constructor
+   * @param id VM index
+   * @param mem Arena slice (painted with the watermark pattern)
+   * @param size Slice size
+   * @return VM handle, or nullptr on failure
+   */
+  using CreateFn = void* (*)(void* user, uint8_t id, uint8_t* mem, size_t size);
+
+  /** Destroy a VM created by CreateFn */
+  using DestroyFn = void (*)(void* user, void* vm);
+
+  /** VM slot state */
+  enum class State : uint8_t
+  {
+    STOPPED = 0,  ///< No VM
+    RUNNING = 1,  ///< VM created and accepting code
+    FAULTED = 2   ///< VM panicked; restart() before use
+  };
+
+  /** CMD_VM_CTRL request operations (first payload byte) */
+  enum Op : uint8_t
+  {
+    OP_STATUS = 0,  ///< All slots
+    OP_RESTART = 1  ///< Recreate one VM: [id u8]
+  };
+
+  /** Per-VM accounting */
+  struct Info
+  {
+    State state;          ///< Slot state
+    uint16_t restarts;    ///< restart() calls that created a VM
+    uint16_t faults;      ///< fault() calls
+    int32_t last_error;   ///< Error code of the last fault
+    uint32_t generation;  ///< Bumped whenever the VM handle changes
+  };
+
+  /**
+   * @brief Construct pool
+   *
+   * @param arena Memory shared out to the VMs
+   * @param arena_size Arena size
+   * @param count Number of VMs (clamped to 1..MAX_VMS)
+   * @param create VM constructor
+   * @param destroy VM destructor
+   * @param user Passed to @p create and @p destroy
+   */
+  VmPool(uint8_t* arena, size_t arena_size, size_t count, CreateFn create,
+         DestroyFn destroy, void* user);
+
+  ~VmPool();
+
+  VmPool(const VmPool&) = delete;
+  VmPool& operator=(const VmPool&) = delete;
+
+  /**
+   * @brief Create every VM
+   * @return Number of VMs running
+   */
+  size_t start();
+
+  /**
+   * @brief Destroy and recreate one VM on a freshly painted slice
+   * @return true if the VM is running afterwards
+   */
+  bool restart(uint8_t id);
+
+  /**
+   * @brief Destroy one VM
+   */
+  void stop(uint8_t id);
+
+  /**
+   * @brief Mark a VM faulted (does not destroy it)
+   */
+  void fault(uint8_t id, int32_t error);
+
+  /**
+   * @brief Get a VM handle (nullptr unless RUNNING)
+   */
+  void* vm(uint8_t id) const;
+
+  /**
+   * @brief Find the slot of a VM handle
+   * @return VM index, or -1
+   */
+  int find(const void* vm) const;
+
+  /** Number of VMs */
+  size_t count() const
+  {
+    return count_;
+  }
+
+  /** Arena slice size per VM */
+  size_t slice_size() const
+  {
+    return slice_size_;
+  }
+
+  /** Arena slice of a VM */
+  uint8_t* slice(uint8_t id) const
+  {
+    return arena_ + id * slice_size_;
+  }
+
+  /** Accounting for a VM */
+  const Info& info(uint8_t id) const
+  {
+    return slots_[id].info;
+  }
+
+  /**
+   * @brief User pointer for panic_hook() identifying VM @p id
+   */
+  void* fault_context(uint8_t id)
+  {
+    return &slots_[id];
+  }
+
+  /**
+   * @brief Panic callback: marks the VM behind @p context faulted
+   *
+   * @param context fault_context() of the VM
+   * @param error V4 error code
+   */
+  static void panic_hook(void* context, int32_t error);
+
+  /**
+   * @brief Answer a CMD_VM_CTRL request
+   *
+   * RuntimeCmdHandler signature; @p user is the VmPool.
+   */
+  static void handle_command(void* user, const LinkFrameView& frame, LinkReply* reply);
+
+ private:
+  struct Slot
+  {
+    VmPool* owner;  ///< Pool (panic_hook() context)
+    uint8_t id;     ///< VM index
+    void* vm;       ///< VM handle
+    Info info;      ///< Accounting
+  };
+
+  bool create(Slot* slot);
+
+  uint8_t* arena_;          ///< Shared arena
+  size_t slice_size_;       ///< Bytes per VM
+  size_t count_;            ///< VMs in the pool
+  CreateFn create_;         ///< VM constructor
+  DestroyFn destroy_;       ///< VM destructor
+  void* user_;              ///< Constructor/destructor user
+  Slot slots_[MAX_VMS];     ///< Per-VM state
+};
+
+}  // namespace v4rtos
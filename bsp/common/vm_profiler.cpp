@@ -0,0 +1,237 @@
+// Per-task VM profiler implementation
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#include "vm_profiler.hpp"
+
+#include <cstring>
+
+#include "link_runtime_commands.hpp"
+
+namespace v4rtos
+{
+
+namespace
+{
+
+VmProfiler* g_profiler = nullptr;
+
+constexpr size_t MAX_PROBES = 8;          // Histogram slots tried per sample
+constexpr size_t OPCODE_RECORD_SIZE = 5;  // [op u8][count u32]
+constexpr size_t SAMPLE_RECORD_SIZE = 9;  // [task u8][pc u32][count u32]
+constexpr uint16_t PAGE_DONE = 0xFFFF;    // "next" value of the last page
+
+uint16_t read_u16(const uint8_t* p)
+{
+  return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+void write_u16(uint8_t* p, uint16_t v)
+{
+  p[0] = static_cast<uint8_t>(v);
+  p[1] = static_cast<uint8_t>(v >> 8);
+}
+
+}  // namespace
+
+VmProfiler::VmProfiler(Clock clock, uint32_t sample_period)
+    : clock_(clock), sample_period_(sample_period > 0 ? sample_period : 1)
+{
+  reset();
+}
+
+void VmProfiler::reset()
+{
+  sample_countdown_ = sample_period_;
+  reset_us_ = clock_();
+  switch_us_ = reset_us_;
+  current_ = V4_PROFILE_NO_TASK;
+  samples_ = 0;
+  samples_dropped_ = 0;
+  memset(tasks_, 0, sizeof(tasks_));
+  memset(opcode_counts_, 0, sizeof(opcode_counts_));
+  memset(pc_slots_, 0, sizeof(pc_slots_));
+}
+
+uint32_t VmProfiler::elapsed_us() const
+{
+  return clock_() - reset_us_;
+}
+
+void VmProfiler::on_task_switch(uint8_t from, uint8_t to, bool preempted)
+{
+  uint32_t now = clock_();
+  if (from < MAX_TASKS)
+  {
+    tasks_[from].run_us += now - switch_us_;
+    if (preempted)
+    {
+      tasks_[from].preemptions++;
+    }
+  }
+  if (to < MAX_TASKS)
+  {
+    tasks_[to].switches++;
+  }
+  switch_us_ = now;
+  current_ = to;
+}
+
+void VmProfiler::sample(uint32_t pc)
+{
+  samples_++;
+
+  // Fibonacci hash of (task, PC), linear probing
+  uint32_t key = (pc ^ (static_cast<uint32_t>(current_) << 24)) * 2654435761u;
+  size_t index = key >> 24;
+  for (size_t probe = 0; probe < MAX_PROBES; probe++)
+  {
+    PcSlot& slot = pc_slots_[(index + probe) % PC_SLOTS];
+    if (slot.count == 0)
+    {
+      slot.pc = pc;
+      slot.task = current_;
+      slot.count = 1;
+      return;
+    }
+    if (slot.pc == pc && slot.task == current_)
+    {
+      slot.count++;
+      return;
+    }
+  }
+  samples_dropped_++;
+}
+
+void VmProfiler::encode_summary(LinkReply* reply) const
+{
+  uint32_t now = clock_();
+  reply->put_u32(now - reset_us_);
+  reply->put_u32(sample_period_);
+  reply->put_u32(samples_);
+  reply->put_u32(samples_dropped_);
+  reply->put_u8(current_);
+
+  // Only tasks that ran; the running task is charged up to now
+  for (size_t id = 0; id < MAX_TASKS; id++)
+  {
+    TaskStats t = tasks_[id];
+    if (id == current_)
+    {
+      t.run_us += now - switch_us_;
+    }
+    if (t.switches == 0 && t.run_us == 0)
+    {
+      continue;
+    }
+    reply->put_u8(static_cast<uint8_t>(id));
+    reply->put_u32(t.run_us);
+    reply->put_u32(t.switches);
+    reply->put_u32(t.preemptions);
+  }
+}
+
+void VmProfiler::encode_opcodes(uint16_t start, LinkReply* reply) const
+{
+  uint8_t* next = reply->data + reply->len;
+  reply->put_u16(PAGE_DONE);
+
+  for (size_t op = start; op < 256; op++)
+  {
+    if (opcode_counts_[op] == 0)
+    {
+      continue;
+    }
+    if (reply->cap - reply->len < OPCODE_RECORD_SIZE)
+    {
+      write_u16(next, static_cast<uint16_t>(op));
+      return;
+    }
+    reply->put_u8(static_cast<uint8_t>(op));
+    reply->put_u32(opcode_counts_[op]);
+  }
+}
+
+void VmProfiler::encode_samples(uint16_t start, LinkReply* reply) const
+{
+  uint8_t* next = reply->data + reply->len;
+  reply->put_u16(PAGE_DONE);
+
+  for (size_t i = start; i < PC_SLOTS; i++)
+  {
+    const PcSlot& slot = pc_slots_[i];
+    if (slot.count == 0)
+    {
+      continue;
+    }
+    if (reply->cap - reply->len < SAMPLE_RECORD_SIZE)
+    {
+      write_u16(next, static_cast<uint16_t>(i));
+      return;
+    }
+    reply->put_u8(slot.task);
+    reply->put_u32(slot.pc);
+    reply->put_u32(slot.count);
+  }
+}
+
+void VmProfiler::handle_command(void* user, const LinkFrameView& frame, LinkReply* reply)
+{
+  VmProfiler* self = static_cast<VmProfiler*>(user);
+  if (frame.len < 1)
+  {
+    reply->status = link_wire::STATUS_ERROR;
+    return;
+  }
+
+  uint16_t start = frame.len >= 3 ? read_u16(frame.payload + 1) : 0;
+  switch (frame.payload[0])
+  {
+    case OP_SUMMARY:
+      self->encode_summary(reply);
+      break;
+    case OP_OPCODES:
+      self->encode_opcodes(start, reply);
+      break;
+    case OP_SAMPLES:
+      self->encode_samples(start, reply);
+      break;
+    case OP_RESET:
+      self->reset();
+      break;
+    default:
+      reply->status = link_wire::STATUS_ERROR;
+      break;
+  }
+}
+
+void vm_profiler_install(VmProfiler* profiler)
+{
+  if (profiler != nullptr)
+  {
+    profiler->reset();
+  }
+  g_profiler = profiler;
+}
+
+}  // namespace v4rtos
+
+// ==============================================================================
+// V4-engine hooks
+// ==============================================================================
+
+extern "C" void v4_profile_task_switch(uint8_t from, uint8_t to, int preempted)
+{
+  if (v4rtos::g_profiler != nullptr)
+  {
+    v4rtos::g_profiler->on_task_switch(from, to, preempted != 0);
+  }
+}
+
+extern "C" void v4_profile_opcode(uint8_t opcode, uint32_t pc)
+{
+  if (v4rtos::g_profiler != nullptr)
+  {
+    v4rtos::g_profiler->on_opcode(opcode, pc);
+  }
+}
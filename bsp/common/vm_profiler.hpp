@@ -0,0 +1,182 @@
+// Per-task VM profiler
+//
+// Collects per-task run time, context switches and preemptions, per-opcode
+// execution counts and a sampled (task, PC) histogram. Fed by the V4-engine
+// profiling hooks below, which the engine calls when built with V4_PROFILE;
+// read out over V4-link with CMD_PROFILE.
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "link_frame_scanner.hpp"
+
+extern "C"
+{
+  /**
+   * @brief Engine hook: scheduler switched tasks
+   *
+   * @param from Task that stopped running (V4_PROFILE_NO_TASK: none)
+   * @param to Task that starts running (V4_PROFILE_NO_TASK: idle)
+   * @param preempted Non-zero if @p from was preempted at the end of its
+   *                  time slice rather than blocking or yielding
+   */
+  void v4_profile_task_switch(uint8_t from, uint8_t to, int preempted);
+
+  /**
+   * @brief Engine hook: about to execute an opcode
+   *
+   * @param opcode Opcode byte
+   * @param pc Address of the opcode
+   */
+  void v4_profile_opcode(uint8_t opcode, uint32_t pc);
+}
+
+/** Task ID passed to v4_profile_task_switch() for "no task" */
+#define V4_PROFILE_NO_TASK 0xFF
+
+namespace v4rtos
+{
+
+struct LinkReply;
+
+/**
+ * @brief VM profiler state
+ *
+ * Counters are updated from the VM and read from the link task without
+ * locking; a snapshot taken while tasks run may be off by a few counts.
+ */
+class VmProfiler
+{
+ public:
+  /** Microsecond clock supplied by the BSP */
+  using Clock = uint32_t (*)(void);
+
+  static constexpr size_t MAX_TASKS = 8;                 ///< V4 scheduler task limit
+  static constexpr size_t PC_SLOTS = 256;                ///< Distinct (task, PC) pairs
+  static constexpr uint32_t DEFAULT_SAMPLE_PERIOD = 97;  ///< Opcodes per sample
+
+  /** CMD_PROFILE request operations (first payload byte) */
+  enum Op : uint8_t
+  {
+    OP_SUMMARY = 0,  ///< Per-task times and totals
+    OP_OPCODES = 1,  ///< Opcode counts, paged: [start u16]
+    OP_SAMPLES = 2,  ///< PC samples, paged: [start u16]
+    OP_RESET = 3     ///< Clear all counters
+  };
+
+  /** Per-task accounting */
+  struct TaskStats
+  {
+    uint32_t run_us;       ///< Time spent running
+    uint32_t switches;     ///< Times switched in
+    uint32_t preemptions;  ///< Times preempted by the time slice
+  };
+
+  /**
+   * @brief Construct profiler
+   * @param clock Microsecond clock
+   * @param sample_period Opcodes between PC samples (prime avoids aliasing
+   *                      with loop bodies)
+   */
+  explicit VmProfiler(Clock clock, uint32_t sample_period = DEFAULT_SAMPLE_PERIOD);
+
+  /**
+   * @brief Record a task switch
+   */
+  void on_task_switch(uint8_t from, uint8_t to, bool preempted);
+
+  /**
+   * @brief Record an executed opcode
+   */
+  void on_opcode(uint8_t opcode, uint32_t pc)
+  {
+    opcode_counts_[opcode]++;
+    if (--sample_countdown_ == 0)
+    {
+      sample_countdown_ = sample_period_;
+      sample(pc);
+    }
+  }
+
+  /**
+   * @brief Clear all counters and restart the measurement window
+   */
+  void reset();
+
+  /**
+   * @brief Get a task's accounting (time of a running task not yet added)
+   */
+  const TaskStats& task(size_t id) const
+  {
+    return tasks_[id];
+  }
+
+  /**
+   * @brief Get an opcode's execution count
+   */
+  uint32_t opcode_count(uint8_t opcode) const
+  {
+    return opcode_counts_[opcode];
+  }
+
+  /**
+   * @brief Get number of PC samples taken
+   */
+  uint32_t samples() const
+  {
+    return samples_;
+  }
+
+  /**
+   * @brief Get microseconds since the last reset
+   */
+  uint32_t elapsed_us() const;
+
+  /**
+   * @brief Answer a CMD_PROFILE request
+   *
+   * RuntimeCmdHandler signature; @p user is the VmProfiler.
+   */
+  static void handle_command(void* user, const LinkFrameView& frame, LinkReply* reply);
+
+ private:
+  /** One histogram slot (count 0: free) */
+  struct PcSlot
+  {
+    uint32_t pc;
+    uint32_t count;
+    uint8_t task;
+  };
+
+  void sample(uint32_t pc);
+  void encode_summary(LinkReply* reply) const;
+  void encode_opcodes(uint16_t start, LinkReply* reply) const;
+  void encode_samples(uint16_t start, LinkReply* reply) const;
+
+  Clock clock_;                  ///< Microsecond clock
+  uint32_t sample_period_;       ///< Opcodes between PC samples
+  uint32_t sample_countdown_;    ///< Opcodes until the next sample
+  uint32_t reset_us_;            ///< Clock at the last reset
+  uint32_t switch_us_;           ///< Clock at the last task switch
+  uint8_t current_;              ///< Running task (V4_PROFILE_NO_TASK: none)
+  uint32_t samples_;             ///< PC samples taken
+  uint32_t samples_dropped_;     ///< Samples lost to a full histogram
+  TaskStats tasks_[MAX_TASKS];   ///< Per-task accounting
+  uint32_t opcode_counts_[256];  ///< Executions per opcode
+  PcSlot pc_slots_[PC_SLOTS];    ///< (task, PC) histogram, open addressing
+};
+
+/**
+ * @brief Route the engine profiling hooks to @p profiler
+ *
+ * Resets @p profiler so the measurement window starts here.
+ *
+ * @param profiler Profiler, or nullptr to ignore hook calls
+ */
+void vm_profiler_install(VmProfiler* profiler);
+
+}  // namespace v4rtos
@@ -57,7 +57,7 @@ extern "C"
  * UART Configuration
  * ======================================================================== */
 
-/** USB Serial/JTAG (built-in) */
+/** UART0 on the header pins (V4-link with CONFIG_V4_LINK_UART) */
 #define UART_NUM UART_NUM_0
 #define UART_BAUD_RATE 115200
 
@@ -9,6 +9,8 @@
 
 #include "nanoc6_ddt_provider.hpp"
 
+#include "ddt_index.hpp"
+
 extern "C"
 {
 #include "board.h"
@@ -17,33 +19,40 @@ extern "C"
 namespace v4rtos
 {
 
+// Device descriptor table of the M5Stack NanoC6 (board_devices.def)
+static constexpr v4dev_desc_t DEVICES[] = {
+#define V4_DEVICE(kind_, role_, index_, flags_, handle_) \
+  {                                                       \
+      .kind = (kind_),                                    \
+      .role = (role_),                                    \
+      .index = (index_),                                  \
+      .flags = (flags_),                                  \
+      .handle = (handle_),                                \
+  },
+#include "board_devices.def"
+};
+
+static constexpr auto INDEX = make_ddt_index(DEVICES);
+static_assert(INDEX.valid(), "board_devices.def: (kind, role, index) listed twice");
+
 v4std::span<const v4dev_desc_t> NanoC6DdtProvider::get_devices() const
 {
-  // Device descriptor table for M5Stack NanoC6
-  // Board: M5Stack NanoC6
-  // MCU: ESP32-C6
-  static constexpr v4dev_desc_t devices[] = {
-      // STATUS LED (GPIO7, active-high)
-      {
-          .kind = V4DEV_LED,
-          .role = V4ROLE_STATUS,
-          .index = 0,
-          .flags = 0,  // Active-high (no V4DEV_FLAG_ACTIVE_LOW)
-          .handle = LED_PIN,
-      },
-      // USER BUTTON (GPIO9, active-low with pullup)
-      {
-          .kind = V4DEV_BUTTON,
-          .role = V4ROLE_USER,
-          .index = 0,
-          .flags = V4DEV_FLAG_ACTIVE_LOW,
-          .handle = BUTTON_PIN,
-      },
-      // Future: Add RGB LED (GPIO8, WS2812) once RGB support is implemented
-      // Future: Add I2C, UART, ADC devices as needed
-  };
-
-  return v4std::span<const v4dev_desc_t>{devices, 2};
+  return v4std::span<const v4dev_desc_t>{DEVICES, INDEX.size()};
+}
+
+const v4dev_desc_t* NanoC6DdtProvider::find(uint8_t kind, uint8_t role, uint8_t index)
+{
+  return INDEX.find(kind, role, index);
+}
+
+size_t NanoC6DdtProvider::count()
+{
+  return INDEX.size();
 }
 
 }  // namespace v4rtos
+
+extern "C" const v4dev_desc_t* v4_ddt_lookup(uint8_t kind, uint8_t role, uint8_t index)
+{
+  return v4rtos::INDEX.find(kind, role, index);
+}
@@ -0,0 +1,54 @@
+/**
+ * @file esp32_gpio_regs.hpp
+ * @brief Direct GPIO register access for ESP32 (ESP-IDF)
+ *
+ * Single stores to GPIO_OUT_W1TS/W1TC and loads of GPIO_OUT/GPIO_IN,
+ * inlined at the call site: no gpio_set_level() argument checks and no
+ * driver call per pin. Covers GPIO0-31 (all pins of the ESP32-C6).
+ *
+ * SPDX-License-Identifier: MIT OR Apache-2.0
+ */
+
+#ifndef ESP32_GPIO_REGS_HPP
+#define ESP32_GPIO_REGS_HPP
+
+#include <cstdint>
+
+#include "soc/gpio_reg.h"
+#include "soc/soc.h"
+#include "soc/soc_caps.h"
+
+namespace v4rtos
+{
+
+/**
+ * @brief GPIO0-31 set/clear registers (GpioPort register block)
+ */
+struct Esp32GpioRegs
+{
+  static constexpr uint32_t PIN_COUNT = SOC_GPIO_PIN_COUNT;  ///< Pins on the chip
+
+  void set(uint32_t mask)
+  {
+    REG_WRITE(GPIO_OUT_W1TS_REG, mask);
+  }
+
+  void clear(uint32_t mask)
+  {
+    REG_WRITE(GPIO_OUT_W1TC_REG, mask);
+  }
+
+  uint32_t out() const
+  {
+    return REG_READ(GPIO_OUT_REG);
+  }
+
+  uint32_t in() const
+  {
+    return REG_READ(GPIO_IN_REG);
+  }
+};
+
+}  // namespace v4rtos
+
+#endif  // ESP32_GPIO_REGS_HPP
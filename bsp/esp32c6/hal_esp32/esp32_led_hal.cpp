@@ -7,56 +7,46 @@
 
 #include "esp32_led_hal.hpp"
 
-#include "driver/gpio.h"
-#include "esp_log.h"
+#include "esp32_log.hpp"
 
-static const char* TAG = "esp32_led_hal";
+static constexpr char TAG[] = "esp32_led_hal";
 
 namespace v4rtos
 {
 
 bool Esp32LedHal::set_led(uint32_t handle, bool state, bool active_low)
 {
-  gpio_num_t gpio = static_cast<gpio_num_t>(handle);
-
-  // Apply active-low logic
-  uint32_t level = state ? 1 : 0;
-  if (active_low)
+  if (handle >= Esp32GpioRegs::PIN_COUNT)
   {
-    level = !level;
+    V4_LOGE(TAG, "Invalid GPIO%u", (unsigned)handle);
+    return false;
   }
 
-  esp_err_t err = gpio_set_level(gpio, level);
-  if (err != ESP_OK)
+  // Apply active-low logic; one W1TS or W1TC store
+  uint32_t bit = 1u << handle;
+  if (state != active_low)
   {
-    ESP_LOGE(TAG, "Failed to set GPIO%d: %d", gpio, err);
-    return false;
+    regs_.set(bit);
+  }
+  else
+  {
+    regs_.clear(bit);
   }
-
-  ESP_LOGD(TAG, "LED GPIO%d set to %s (logical=%s, active_low=%s)", gpio,
-           level ? "HIGH" : "LOW", state ? "ON" : "OFF", active_low ? "yes" : "no");
-
   return true;
 }
 
 bool Esp32LedHal::get_led(uint32_t handle, bool active_low)
 {
-  gpio_num_t gpio = static_cast<gpio_num_t>(handle);
-
-  int level = gpio_get_level(gpio);
-
-  // Apply active-low logic when reading
-  bool logical_state = (level != 0);
-  if (active_low)
+  if (handle >= Esp32GpioRegs::PIN_COUNT)
   {
-    logical_state = !logical_state;
+    V4_LOGE(TAG, "Invalid GPIO%u", (unsigned)handle);
+    return false;
   }
 
-  ESP_LOGD(TAG, "LED GPIO%d read as %s (physical=%s, active_low=%s)", gpio,
-           logical_state ? "ON" : "OFF", level ? "HIGH" : "LOW",
-           active_low ? "yes" : "no");
-
-  return logical_state;
+  // Output latch: LED pins are GPIO_MODE_OUTPUT, whose pad input (what
+  // gpio_get_level() reads) is disabled. Apply active-low logic.
+  bool level = (regs_.out() & (1u << handle)) != 0;
+  return level != active_low;
 }
 
 }  // namespace v4rtos
@@ -8,19 +8,35 @@
 #ifndef ESP32_LED_HAL_HPP
 #define ESP32_LED_HAL_HPP
 
+#include "esp32_gpio_regs.hpp"
 #include "v4std/sys_led.hpp"
 
 namespace v4rtos
 {
 
 /**
- * @brief LED HAL implementation for ESP32 using ESP-IDF GPIO API
+ * @brief LED HAL implementation for ESP32 on the GPIO registers
+ *
+ * Pins are configured by the board code (peripherals.h); set_led() and
+ * get_led() are then one register store or load each, with no driver
+ * call and no debug logging per toggle.
  */
 class Esp32LedHal : public v4std::LedHal
 {
  public:
   bool set_led(uint32_t handle, bool state, bool active_low) override;
   bool get_led(uint32_t handle, bool active_low) override;
+
+  /**
+   * @brief GPIO registers the LEDs are driven through
+   */
+  Esp32GpioRegs& regs()
+  {
+    return regs_;
+  }
+
+ private:
+  Esp32GpioRegs regs_;  ///< GPIO0-31 set/clear registers
 };
 
 }  // namespace v4rtos
@@ -0,0 +1,51 @@
+/**
+ * @file esp32_log.hpp
+ * @brief Runtime log calls for ESP32 (ESP-IDF): ESP_LOGx or deferred-format
+ *
+ * V4_LOGE/W/I/D take the same arguments as ESP_LOGE/W/I/D. By default they
+ * are ESP_LOGx. Built with V4_LOG_DEFERRED (menuconfig: "V4 Runtime" ->
+ * "Deferred-format log") they record a message ID and the raw arguments in
+ * the DeferredLog ring instead (bsp/common/deferred_log.hpp), read with
+ * scripts/v4log.py; LOG_LOCAL_LEVEL still filters at compile time.
+ *
+ * Deferred calls need integer-only formats given as plain string literals
+ * and a constexpr tag (static constexpr char TAG[] = "..."). Messages that
+ * must reach the console before V4-link runs, or that carry strings, stay
+ * on ESP_LOGx.
+ *
+ * SPDX-License-Identifier: MIT OR Apache-2.0
+ */
+
+#ifndef ESP32_LOG_HPP
+#define ESP32_LOG_HPP
+
+#include "esp_log.h"
+
+#ifdef V4_LOG_DEFERRED
+
+#include "deferred_log.hpp"
+
+#define V4_LOG_AT(level, tag, fmt, ...)           \
+  do                                              \
+  {                                               \
+    if (LOG_LOCAL_LEVEL >= (level))               \
+    {                                             \
+      V4_DLOG((level), tag, fmt, ##__VA_ARGS__);  \
+    }                                             \
+  } while (0)
+
+#define V4_LOGE(tag, fmt, ...) V4_LOG_AT(ESP_LOG_ERROR, tag, fmt, ##__VA_ARGS__)
+#define V4_LOGW(tag, fmt, ...) V4_LOG_AT(ESP_LOG_WARN, tag, fmt, ##__VA_ARGS__)
+#define V4_LOGI(tag, fmt, ...) V4_LOG_AT(ESP_LOG_INFO, tag, fmt, ##__VA_ARGS__)
+#define V4_LOGD(tag, fmt, ...) V4_LOG_AT(ESP_LOG_DEBUG, tag, fmt, ##__VA_ARGS__)
+
+#else
+
+#define V4_LOGE(tag, fmt, ...) ESP_LOGE(tag, fmt, ##__VA_ARGS__)
+#define V4_LOGW(tag, fmt, ...) ESP_LOGW(tag, fmt, ##__VA_ARGS__)
+#define V4_LOGI(tag, fmt, ...) ESP_LOGI(tag, fmt, ##__VA_ARGS__)
+#define V4_LOGD(tag, fmt, ...) ESP_LOGD(tag, fmt, ##__VA_ARGS__)
+
+#endif
+
+#endif /* ESP32_LOG_HPP */
@@ -0,0 +1,189 @@
+// V4-link transports for ESP32-C6
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#include "esp32_link_transport.hpp"
+
+#include <cstdio>
+
+#include "driver/uart.h"
+#include "driver/usb_serial_jtag.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+static const char* TAG = "V4Link";
+
+namespace v4rtos
+{
+
+static TickType_t to_ticks(uint32_t timeout_ms)
+{
+  return timeout_ms == LinkTransport::WAIT_FOREVER ? portMAX_DELAY
+                                                   : pdMS_TO_TICKS(timeout_ms);
+}
+
+// ==============================================================================
+// USB Serial/JTAG
+// ==============================================================================
+
+UsbSerialJtagTransport::UsbSerialJtagTransport()
+{
+  usb_serial_jtag_driver_config_t usb_config = {
+      .tx_buffer_size = USB_BUF_SIZE,
+      .rx_buffer_size = USB_BUF_SIZE,
+  };
+
+  esp_err_t ret = usb_serial_jtag_driver_install(&usb_config);
+  if (ret != ESP_OK)
+  {
+    ESP_LOGE(TAG, "Failed to install USB Serial/JTAG driver: %d", ret);
+    return;
+  }
+  installed_ = true;
+
+  ESP_LOGI(TAG, "USB Serial/JTAG driver installed");
+}
+
+UsbSerialJtagTransport::~UsbSerialJtagTransport()
+{
+  if (installed_)
+  {
+    usb_serial_jtag_driver_uninstall();
+  }
+}
+
+int UsbSerialJtagTransport::read(uint8_t* buf, size_t cap, uint32_t timeout_ms)
+{
+  if (!installed_)
+  {
+    return -1;
+  }
+  int len = usb_serial_jtag_read_bytes(buf, cap, to_ticks(timeout_ms));
+  return len > 0 ? len : 0;
+}
+
+size_t UsbSerialJtagTransport::write(const uint8_t* data, size_t len, uint32_t timeout_ms)
+{
+  int written = usb_serial_jtag_write_bytes(data, len, pdMS_TO_TICKS(timeout_ms));
+  return written > 0 ? static_cast<size_t>(written) : 0;
+}
+
+// ==============================================================================
+// UART
+// ==============================================================================
+
+UartTransport::UartTransport(int uart_num, uint32_t baud, int tx_pin, int rx_pin)
+    : uart_num_(uart_num)
+{
+  snprintf(name_, sizeof(name_), "uart%d", uart_num);
+  uart_port_t port = static_cast<uart_port_t>(uart_num);
+
+  uart_config_t uart_config = {};
+  uart_config.baud_rate = static_cast<int>(baud);
+  uart_config.data_bits = UART_DATA_8_BITS;
+  uart_config.parity = UART_PARITY_DISABLE;
+  uart_config.stop_bits = UART_STOP_BITS_1;
+  uart_config.flow_ctrl = UART_HW_FLOWCTRL_DISABLE;
+  uart_config.source_clk = UART_SCLK_DEFAULT;
+
+  esp_err_t ret = uart_param_config(port, &uart_config);
+  if (ret == ESP_OK)
+  {
+    ret = uart_set_pin(port, tx_pin < 0 ? UART_PIN_NO_CHANGE : tx_pin,
+                       rx_pin < 0 ? UART_PIN_NO_CHANGE : rx_pin, UART_PIN_NO_CHANGE,
+                       UART_PIN_NO_CHANGE);
+  }
+  if (ret == ESP_OK)
+  {
+    ret = uart_driver_install(port, RX_BUF_SIZE, TX_BUF_SIZE, EVENT_QUEUE_LEN, &events_,
+                              0);
+  }
+  if (ret != ESP_OK)
+  {
+    ESP_LOGE(TAG, "Failed to install UART%d driver: %d", uart_num, ret);
+    return;
+  }
+  installed_ = true;
+
+  // Fewer, larger FIFO-to-ring moves; the idle timeout ends a frame early
+  uart_set_rx_full_threshold(port, RX_FULL_THRESH);
+  uart_set_rx_timeout(port, RX_TIMEOUT_SYM);
+
+  ESP_LOGI(TAG, "UART%d driver installed (%u baud)", uart_num, (unsigned)baud);
+}
+
+UartTransport::~UartTransport()
+{
+  if (installed_)
+  {
+    uart_driver_delete(static_cast<uart_port_t>(uart_num_));
+  }
+}
+
+int UartTransport::read(uint8_t* buf, size_t cap, uint32_t timeout_ms)
+{
+  if (!installed_)
+  {
+    return -1;
+  }
+  uart_port_t port = static_cast<uart_port_t>(uart_num_);
+
+  // uart_read_bytes() waits for all @p cap bytes, so only ask for what the
+  // driver already holds and sleep on the event queue otherwise
+  size_t avail = 0;
+  uart_get_buffered_data_len(port, &avail);
+  if (avail == 0 && timeout_ms > 0)
+  {
+    uart_event_t event;
+    if (xQueueReceive(events_, &event, to_ticks(timeout_ms)) != pdTRUE)
+    {
+      return 0;
+    }
+    if (event.type == UART_FIFO_OVF || event.type == UART_BUFFER_FULL)
+    {
+      // Bytes are already lost; drop the rest of the burst and let the
+      // host time out and resend the frames it broke
+      overruns_ = overruns_ + 1;
+      uart_flush_input(port);
+      xQueueReset(events_);
+      return 0;
+    }
+    uart_get_buffered_data_len(port, &avail);
+  }
+  if (avail == 0)
+  {
+    return 0;
+  }
+
+  int len = uart_read_bytes(port, buf, avail < cap ? avail : cap, 0);
+  return len > 0 ? len : 0;
+}
+
+size_t UartTransport::write(const uint8_t* data, size_t len, uint32_t timeout_ms)
+{
+  if (!installed_)
+  {
+    return 0;
+  }
+  uart_port_t port = static_cast<uart_port_t>(uart_num_);
+
+  // uart_write_bytes() blocks until everything fits in the TX ring, so
+  // never hand it more than the free space
+  size_t room = 0;
+  uart_get_tx_buffer_free_size(port, &room);
+  if (room == 0 && timeout_ms > 0)
+  {
+    uart_wait_tx_done(port, pdMS_TO_TICKS(timeout_ms));
+    uart_get_tx_buffer_free_size(port, &room);
+  }
+  if (room == 0)
+  {
+    return 0;
+  }
+
+  int written = uart_write_bytes(port, data, len < room ? len : room);
+  return written > 0 ? static_cast<size_t>(written) : 0;
+}
+
+}  // namespace v4rtos
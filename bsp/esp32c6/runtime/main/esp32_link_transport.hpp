@@ -0,0 +1,114 @@
+// V4-link transports for ESP32-C6 (USB Serial/JTAG, UART)
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "link_transport.hpp"
+
+// Forward declarations
+extern "C"
+{
+  typedef struct QueueDefinition* QueueHandle_t;
+}
+
+namespace v4rtos
+{
+
+/**
+ * @brief V4-link over the built-in USB Serial/JTAG controller
+ *
+ * Installs the USB Serial/JTAG driver for the lifetime of the object.
+ * read() sleeps in the driver until bytes arrive.
+ */
+class UsbSerialJtagTransport : public LinkTransport
+{
+ public:
+  UsbSerialJtagTransport();
+  ~UsbSerialJtagTransport() override;
+
+  /**
+   * @brief Check whether the driver was installed
+   */
+  bool ok() const
+  {
+    return installed_;
+  }
+
+  const char* name() const override
+  {
+    return "usb";
+  }
+
+  int read(uint8_t* buf, size_t cap, uint32_t timeout_ms) override;
+  size_t write(const uint8_t* data, size_t len, uint32_t timeout_ms) override;
+
+ private:
+  bool installed_ = false;                      ///< Driver installed
+  static constexpr size_t USB_BUF_SIZE = 1024;  ///< USB driver buffer size
+};
+
+/**
+ * @brief V4-link over a UART
+ *
+ * Installs the IDF UART driver for the lifetime of the object. The RX FIFO
+ * is moved into a large driver ring buffer from the UART interrupt (the
+ * FIFO-full threshold and a short idle timeout keep bursts in one move),
+ * and read() sleeps on the driver event queue, so a frame costs a few
+ * interrupts rather than one wakeup per byte. Responses go through the
+ * driver TX ring buffer without blocking for longer than asked.
+ */
+class UartTransport : public LinkTransport
+{
+ public:
+  /**
+   * @brief Construct UART transport
+   * @param uart_num UART port number
+   * @param baud Baud rate
+   * @param tx_pin TX GPIO (-1: keep the default pin)
+   * @param rx_pin RX GPIO (-1: keep the default pin)
+   */
+  UartTransport(int uart_num, uint32_t baud, int tx_pin = -1, int rx_pin = -1);
+  ~UartTransport() override;
+
+  /**
+   * @brief Check whether the driver was installed
+   */
+  bool ok() const
+  {
+    return installed_;
+  }
+
+  const char* name() const override
+  {
+    return name_;
+  }
+
+  int read(uint8_t* buf, size_t cap, uint32_t timeout_ms) override;
+  size_t write(const uint8_t* data, size_t len, uint32_t timeout_ms) override;
+
+  /**
+   * @brief Get number of RX overruns (received bytes discarded)
+   */
+  uint32_t overruns() const
+  {
+    return overruns_;
+  }
+
+ private:
+  int uart_num_;                                 ///< UART port number
+  bool installed_ = false;                       ///< Driver installed
+  QueueHandle_t events_ = nullptr;               ///< Driver event queue
+  volatile uint32_t overruns_ = 0;               ///< RX FIFO/ring overflows
+  char name_[8];                                 ///< "uartN"
+  static constexpr size_t RX_BUF_SIZE = 4096;    ///< Driver RX ring buffer size
+  static constexpr size_t TX_BUF_SIZE = 2048;    ///< Driver TX ring buffer size
+  static constexpr int EVENT_QUEUE_LEN = 16;     ///< Driver event queue depth
+  static constexpr uint8_t RX_FULL_THRESH = 96;  ///< FIFO bytes per interrupt
+  static constexpr uint8_t RX_TIMEOUT_SYM = 4;   ///< Idle symbols before flush
+};
+
+}  // namespace v4rtos
@@ -0,0 +1,106 @@
+// GPIO port words for the ESP32-C6 runtime
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#include "gpio_sys.hpp"
+
+#include "driver/gpio.h"
+#include "esp32_gpio_regs.hpp"
+#include "esp_log.h"
+#include "gpio_port.hpp"
+#include "sys_table.hpp"
+#include "v4/vm_api.h"
+#include "v4std/sys_handlers.hpp"
+
+static const char* TAG = "GpioPort";
+
+namespace v4rtos
+{
+
+using Esp32GpioPort = GpioPort<Esp32GpioRegs>;
+
+// USB Serial/JTAG D-/D+ (12, 13) and SPI flash (24-30)
+static constexpr uint32_t RESERVED_PINS = (0x3u << 12) | (0x7Fu << 24);
+
+static Esp32GpioPort* s_port = nullptr;
+
+// ==============================================================================
+// SYS handlers
+// ==============================================================================
+
+// GPIO-PORT-WRITE ( values mask -- result )
+v4_err sys_gpio_port_write(Vm* vm)
+{
+  uint32_t mask = (uint32_t)vm_ds_pop(vm);
+  uint32_t values = (uint32_t)vm_ds_pop(vm);
+
+  Esp32GpioPort::Status status = Esp32GpioPort::ERR_INVALID;
+  if (s_port != nullptr)
+  {
+    status = s_port->write(mask, values);
+  }
+  vm_ds_push(vm, status);
+  return 0;
+}
+
+// GPIO-PORT-TOGGLE ( mask -- result )
+v4_err sys_gpio_port_toggle(Vm* vm)
+{
+  uint32_t mask = (uint32_t)vm_ds_pop(vm);
+
+  Esp32GpioPort::Status status = Esp32GpioPort::ERR_INVALID;
+  if (s_port != nullptr)
+  {
+    status = s_port->toggle(mask);
+  }
+  vm_ds_push(vm, status);
+  return 0;
+}
+
+// GPIO-PORT-READ ( -- levels )
+v4_err sys_gpio_port_read(Vm* vm)
+{
+  vm_ds_push(vm, s_port != nullptr ? (v4_i32)s_port->read() : 0);
+  return 0;
+}
+
+bool gpio_sys_init(Esp32GpioRegs* regs, uint32_t allowed)
+{
+  if ((allowed & RESERVED_PINS) != 0)
+  {
+    ESP_LOGW(TAG, "Pins 0x%08x are reserved, not driven",
+             (unsigned)(allowed & RESERVED_PINS));
+    allowed &= ~RESERVED_PINS;
+  }
+
+  if (allowed != 0)
+  {
+    // Input stays on so GPIO-PORT-READ sees the driven levels
+    gpio_config_t conf = {};
+    conf.pin_bit_mask = allowed;
+    conf.mode = GPIO_MODE_INPUT_OUTPUT;
+    conf.pull_up_en = GPIO_PULLUP_DISABLE;
+    conf.pull_down_en = GPIO_PULLDOWN_DISABLE;
+    conf.intr_type = GPIO_INTR_DISABLE;
+    esp_err_t err = gpio_config(&conf);
+    if (err != ESP_OK)
+    {
+      ESP_LOGE(TAG, "Failed to configure pins 0x%08x: %d", (unsigned)allowed, err);
+      return false;
+    }
+  }
+
+  s_port = new Esp32GpioPort(*regs, allowed);
+
+#ifndef V4_SYS_TABLE
+  // V4_SYS_TABLE builds find these in the constant table (sys_table.hpp)
+  v4std::register_sys_handler(SYS_GPIO_PORT_WRITE, sys_gpio_port_write);
+  v4std::register_sys_handler(SYS_GPIO_PORT_TOGGLE, sys_gpio_port_toggle);
+  v4std::register_sys_handler(SYS_GPIO_PORT_READ, sys_gpio_port_read);
+#endif
+
+  ESP_LOGI(TAG, "GPIO port words on pins 0x%08x", (unsigned)allowed);
+  return true;
+}
+
+}  // namespace v4rtos
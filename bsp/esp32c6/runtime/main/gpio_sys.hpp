@@ -0,0 +1,30 @@
+// GPIO port words for the ESP32-C6 runtime
+//
+// Registers GPIO-PORT-WRITE, GPIO-PORT-TOGGLE and GPIO-PORT-READ
+// (SYS_GPIO_PORT_WRITE .. SYS_GPIO_PORT_READ): several pins per SYS call,
+// stored straight to GPIO_OUT_W1TS/W1TC, for buses bit-banged from Forth.
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include <cstdint>
+
+namespace v4rtos
+{
+
+struct Esp32GpioRegs;
+
+/**
+ * @brief Configure the port pins and register the SYS handlers
+ *
+ * Pins in @p allowed become outputs with input enabled; the USB
+ * Serial/JTAG and SPI flash pins are dropped from it.
+ *
+ * @param regs    GPIO registers (Esp32LedHal::regs())
+ * @param allowed Pins the words may drive (CONFIG_V4_GPIO_PORT_MASK)
+ * @return false if the pins cannot be configured
+ */
+bool gpio_sys_init(Esp32GpioRegs* regs, uint32_t allowed);
+
+}  // namespace v4rtos
@@ -0,0 +1,63 @@
+// Bytecode image partition implementation for ESP32-C6
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#include "image_partition.hpp"
+
+#include "esp_log.h"
+#include "esp_partition.h"
+
+static const char* TAG = "ImagePart";
+
+namespace v4rtos
+{
+
+static bool partition_erase(void* user, size_t offset, size_t len)
+{
+  auto* part = static_cast<const esp_partition_t*>(user);
+  return esp_partition_erase_range(part, offset, len) == ESP_OK;
+}
+
+// esp_partition_write() invalidates the cache over the written range, so
+// the mapping sees the new bytes
+static bool partition_write(void* user, size_t offset, const uint8_t* data, size_t len)
+{
+  auto* part = static_cast<const esp_partition_t*>(user);
+  return esp_partition_write(part, offset, data, len) == ESP_OK;
+}
+
+bool image_partition_open(ImageFlash* flash)
+{
+  auto subtype = static_cast<esp_partition_subtype_t>(IMAGE_PARTITION_SUBTYPE);
+  const esp_partition_t* part =
+      esp_partition_find_first(ESP_PARTITION_TYPE_DATA, subtype, IMAGE_PARTITION_LABEL);
+  if (part == nullptr)
+  {
+    ESP_LOGW(TAG, "No \"%s\" partition, bytecode images disabled", IMAGE_PARTITION_LABEL);
+    return false;
+  }
+
+  // Data mapping: the VM fetches bytecode with ordinary loads
+  const void* map = nullptr;
+  esp_partition_mmap_handle_t handle;
+  esp_err_t err =
+      esp_partition_mmap(part, 0, part->size, ESP_PARTITION_MMAP_DATA, &map, &handle);
+  if (err != ESP_OK)
+  {
+    ESP_LOGE(TAG, "Failed to map \"%s\": %s", IMAGE_PARTITION_LABEL,
+             esp_err_to_name(err));
+    return false;
+  }
+
+  flash->map = static_cast<const uint8_t*>(map);
+  flash->size = part->size;
+  flash->erase_size = part->erase_size;
+  flash->erase = partition_erase;
+  flash->write = partition_write;
+  flash->user = const_cast<esp_partition_t*>(part);
+  ESP_LOGI(TAG, "Image partition: %u KB at flash 0x%06X, mapped @ %p",
+           (unsigned)(part->size / 1024), (unsigned)part->address, map);
+  return true;
+}
+
+}  // namespace v4rtos
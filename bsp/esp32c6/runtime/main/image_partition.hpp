@@ -0,0 +1,32 @@
+// Bytecode image partition for ESP32-C6
+//
+// Finds the "v4image" data partition (partitions.csv) and maps it through
+// the flash cache, so ImageStore can validate and run the stored image
+// without copying it into RAM.
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include "image_store.hpp"
+
+namespace v4rtos
+{
+
+/** Partition label in partitions.csv */
+constexpr const char* IMAGE_PARTITION_LABEL = "v4image";
+
+/** Data partition subtype of the image partition (custom range 0x40..0xFE) */
+constexpr uint8_t IMAGE_PARTITION_SUBTYPE = 0x40;
+
+/**
+ * @brief Map the image partition
+ *
+ * The mapping stays for the lifetime of the runtime.
+ *
+ * @param flash Region to fill (erase/write go through esp_partition)
+ * @return false if the partition is missing or cannot be mapped
+ */
+bool image_partition_open(ImageFlash* flash);
+
+}  // namespace v4rtos
@@ -4,9 +4,9 @@
  *
  * This runtime provides:
  * - V4 VM initialization with kernel APIs
- * - Preemptive task scheduler (10ms time slice)
+ * - Preemptive task scheduler (10ms time slice, or native FreeRTOS tasks)
  * - HAL initialization for peripherals
- * - Bytecode reception via USB Serial/JTAG (V4-link protocol)
+ * - Bytecode reception via USB Serial/JTAG and optionally a UART (V4-link protocol)
  * - Bytecode execution
  *
  * Flash this once to the device, then send bytecode from host using v4_cli.
@@ -31,12 +31,80 @@ extern "C"
 // V4-hal APIs
 #include "v4/hal.h"
 
-// V4-link port
+// V4-link port and transports
+#include "esp32_link_transport.hpp"
 #include "v4_link_port.hpp"
 
-// V4 panic handler
+// V4 panic handler and crash log (menuconfig: "V4 Runtime" -> "Panic handling")
+#include "crash_log.hpp"
+#include "esp_attr.h"
 #include "panic_handler.hpp"
 
+// VM memory layout (menuconfig: "V4 Runtime" -> "VM memory")
+#include "vm_memory.hpp"
+
+// Memory high-water marks (CMD_MEM_STATS, MEM-WATERMARK)
+#include "mem_stats.hpp"
+
+// VM pool (menuconfig: "V4 Runtime" -> "VM memory")
+#include "sdkconfig.h"
+#include "vm_pool.hpp"
+
+// Pooled zero-copy messages (MSG-POOL .. MSG-FREE)
+#include "msg_sys.hpp"
+
+// GPIO port words (GPIO-PORT-WRITE .. GPIO-PORT-READ)
+#include "gpio_sys.hpp"
+
+// Bytecode image partition (menuconfig: "V4 Runtime" -> "Bytecode image")
+#include "esp_timer.h"
+#include "image_partition.hpp"
+#include "image_store.hpp"
+
+// Peephole pass (menuconfig: "V4 Runtime" -> "VM interpreter")
+#ifdef V4_PEEPHOLE
+#include "bytecode_peephole.hpp"
+#endif
+
+// Hot-word JIT (menuconfig: "V4 Runtime" -> "VM interpreter")
+#ifdef V4_JIT
+#include "esp_heap_caps.h"
+#include "rv32_jit.hpp"
+#include "sdkconfig.h"
+#include "vm_jit.hpp"
+#endif
+
+// Priority scheduling (menuconfig: "V4 Runtime" -> "Task scheduling")
+#ifdef V4_SCHED_PRIORITY
+#include "sched_sys.hpp"
+#endif
+
+// Native FreeRTOS tasks (menuconfig: "V4 Runtime" -> "Task scheduling")
+#ifdef V4_TASK_NATIVE
+#include "native_tasks.hpp"
+#endif
+
+// VM profiler (menuconfig: "V4 Runtime" -> "VM profiler")
+#ifdef V4_PROFILE
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include "vm_profiler.hpp"
+#endif
+
+// Event trace (menuconfig: "V4 Runtime" -> "Binary event trace")
+#ifdef V4_TRACE
+#include "esp_cpu.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include "trace_buffer.hpp"
+#endif
+
+// Deferred-format log (menuconfig: "V4 Runtime" -> "Deferred-format log")
+#ifdef V4_LOG_DEFERRED
+#include "deferred_log.hpp"
+#include "sdkconfig.h"
+#endif
+
 // V4-std integration (chip-level)
 #include "../../hal_esp32/esp32_led_hal.hpp"
 // V4-std integration (board-level)
@@ -46,90 +114,380 @@ extern "C"
 
 // ESP-IDF APIs
 #include "driver/gpio.h"
+#include "driver/uart.h"
+#include "esp32_log.hpp"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include "freertos/task.h"
 
-static const char* TAG = "v4-runtime";
+static constexpr char TAG[] = "v4-runtime";
 
 // ==============================================================================
 // VM Memory Configuration
 // ==============================================================================
 
 /**
- * @brief V4 VM arena size
+ * @brief V4 VM memory layout
  *
- * This is the memory available for:
+ * The VM arena holds:
  * - Dictionary (compiled words)
  * - Data stack
  * - Return stack
  * - Temporary allocations
  *
- * 16KB is sufficient for basic RTOS operations.
- * Increase if running complex Forth programs.
+ * Its size and placement (static, internal heap, RTC fast memory, PSRAM)
+ * and the optional word name arena are set in menuconfig. The default
+ * 16KB arena is sufficient for basic RTOS operations.
  */
-#define VM_ARENA_SIZE (16 * 1024)
+static v4rtos::VmMemoryLayout g_vm_memory;
+
+// ==============================================================================
+// V4-link Task Configuration
+// ==============================================================================
+
+/** V4-link task stack size (bytes). Uploaded bytecode executes on this stack. */
+#define LINK_TASK_STACK_SIZE 8192
 
-/** VM memory arena (statically allocated) */
-static uint8_t vm_arena[VM_ARENA_SIZE] __attribute__((aligned(4)));
+/** V4-link task priority (above idle, below ESP-IDF system tasks) */
+#define LINK_TASK_PRIORITY 5
 
 /** Global VM instance */
 static struct Vm* g_vm = nullptr;
 
-/** Global V4-link port instance */
+/** USB Serial/JTAG transport (primary V4-link port) */
+static v4rtos::UsbSerialJtagTransport* g_usb = nullptr;
+
+/** Global V4-link port instance (USB Serial/JTAG) */
 static v4rtos::Esp32c6LinkPort* g_link = nullptr;
 
+#ifdef CONFIG_V4_LINK_UART
+/** UART transport (second V4-link port) */
+static v4rtos::UartTransport* g_uart = nullptr;
+
+/** V4-link port on the UART */
+static v4rtos::Esp32c6LinkPort* g_link_uart = nullptr;
+
+#ifndef V4_TASK_NATIVE
+/** Serializes frames of both ports; they share the VMs and handlers */
+static SemaphoreHandle_t g_link_lock = nullptr;
+#endif
+#endif
+
+/** Global VM pool (CONFIG_V4_VM_POOL_COUNT VMs; g_vm is VM 0) */
+static v4rtos::VmPool* g_pool = nullptr;
+
 /** Global DDT provider (M5Stack NanoC6) */
 static v4rtos::NanoC6DdtProvider g_ddt_provider;
 
 /** Global LED HAL (ESP32 family) */
 static v4rtos::Esp32LedHal g_led_hal;
 
+/** Crash log storage: RTC no-init RAM keeps it across resets, not power loss */
+RTC_NOINIT_ATTR static v4rtos::CrashLog::Storage g_crash_storage;
+
+/** Global crash log (read with the V4-link CRASH_LOG command) */
+static v4rtos::CrashLog* g_crash_log = nullptr;
+
+/** Mapped "v4image" partition */
+static v4rtos::ImageFlash g_image_flash;
+
+/** Global bytecode image store (nullptr: no image partition) */
+static v4rtos::ImageStore* g_image = nullptr;
+
+/** VM 0 (re)creation runs the active image once V4-std is up */
+static bool g_image_live = false;
+
+#ifdef V4_PROFILE
+static uint32_t profile_clock_us(void)
+{
+  return (uint32_t)esp_timer_get_time();
+}
+
+/** Global VM profiler (read with the V4-link PROFILE command) */
+static v4rtos::VmProfiler g_profiler(profile_clock_us, CONFIG_V4_PROFILE_SAMPLE_PERIOD);
+#endif
+
+#ifdef V4_TRACE
+#ifdef CONFIG_PM_ENABLE
+// Frequency scaling changes the cycle counter rate: microsecond timestamps
+static constexpr uint32_t TRACE_TICKS_PER_US = 1;
+
+static uint32_t trace_clock(void)
+{
+  return (uint32_t)esp_timer_get_time();
+}
+#else
+static constexpr uint32_t TRACE_TICKS_PER_US = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+
+static uint32_t trace_clock(void)
+{
+  return (uint32_t)esp_cpu_get_cycle_count();
+}
+#endif
+
+static uint32_t trace_core(void)
+{
+  return (uint32_t)esp_cpu_get_core_id();
+}
+
+/** Global event trace (drained with the V4-link TRACE command) */
+static v4rtos::TraceBuffer* g_trace = nullptr;
+#endif
+
+#ifdef V4_LOG_DEFERRED
+/** Global deferred log (V4_LOGx records, drained with the V4-link LOG command) */
+static v4rtos::DeferredLog* g_log = nullptr;
+#endif
+
+#ifdef V4_PEEPHOLE
+/** Global peephole pass (EXEC payload filter) */
+static v4rtos::BytecodePeephole* g_peephole = nullptr;
+#endif
+
+#ifdef V4_JIT
+/** Make freshly compiled words visible to instruction fetch */
+static void jit_sync(const void* code, size_t bytes)
+{
+  (void)code;
+  (void)bytes;
+  __asm__ __volatile__("fence.i" ::: "memory");
+}
+
+/** Global JIT cache (compiled hot words in IRAM) */
+static v4rtos::JitCache* g_jit = nullptr;
+#endif
+
 // ==============================================================================
 // V4 VM Initialization
 // ==============================================================================
 
+/** Panic policy selected in menuconfig */
+static v4rtos::PanicPolicy default_panic_policy(void)
+{
+#if defined(CONFIG_V4_PANIC_POLICY_HALT)
+  return v4rtos::PanicPolicy::HALT;
+#elif defined(CONFIG_V4_PANIC_POLICY_RESTART_TASK)
+  return v4rtos::PanicPolicy::RESTART_TASK;
+#elif defined(CONFIG_V4_PANIC_POLICY_REBOOT)
+  return v4rtos::PanicPolicy::REBOOT;
+#else
+  return v4rtos::PanicPolicy::RESET_VM;
+#endif
+}
+
 /**
- * @brief Initialize V4 VM and task system
+ * @brief Run the active bytecode image on VM 0
  *
- * Creates a VM instance with the configured arena and initializes
- * the preemptive task scheduler with a 10ms time slice.
+ * The image runs straight from the cache-mapped partition, without
+ * copying the code into RAM. Images without FLAG_AUTOSTART only stay
+ * stored.
  *
- * @return 0 on success, negative error code on failure
+ * @return false if an image on trial failed and was rolled back
  */
-static int v4_init(void)
+static bool image_start(struct Vm* vm)
 {
-  // Configure VM with static arena
-  VmConfig config = {
-      .mem = vm_arena,
-      .mem_size = VM_ARENA_SIZE,
-      .mmio = nullptr,  // No MMIO windows for now
-      .mmio_count = 0,
-      .arena = nullptr  // Use malloc for word names (ESP-IDF heap)
-  };
-
-  // Create VM instance
-  g_vm = vm_create(&config);
-  if (g_vm == nullptr)
+#ifdef CONFIG_V4_IMAGE_AUTOSTART
+  const v4rtos::ImageStore::Header* h = g_image->active_header();
+  if (h == nullptr || (h->flags & v4rtos::ImageStore::FLAG_AUTOSTART) == 0)
   {
-    ESP_LOGE(TAG, "Failed to create VM instance");
-    return -1;
+    return true;
   }
+  uint8_t slot = g_image->active();
+  uint32_t rollbacks = g_image->rollbacks();
+  int64_t start = esp_timer_get_time();
+  v4_err err = vm_exec_raw(vm, g_image->active_code(), (int)h->size);
+  if (err != 0)
+  {
+    V4_LOGE(TAG, "Bytecode image (slot %u) failed: %d", (unsigned)slot, (int)err);
+    // A RESET_VM panic has rolled back in pool_panic_hook already
+    return g_image->rollbacks() == rollbacks && !g_image->fault();
+  }
+  V4_LOGI(TAG, "Bytecode image (slot %u) started in place (%u us)",
+          (unsigned)g_image->active(), (unsigned)(esp_timer_get_time() - start));
+#else
+  (void)vm;
+#endif
+  return true;
+}
 
-  ESP_LOGI(TAG, "V4 VM created (arena: %d KB)", VM_ARENA_SIZE / 1024);
+/**
+ * @brief Panic hook of the pool VMs
+ *
+ * A VM 0 panic while the image is on trial revokes it; the VM restart
+ * that follows runs the previous image.
+ */
+static void pool_panic_hook(void* context, int32_t error)
+{
+  if (g_image != nullptr && context == g_pool->fault_context(0) && g_image->fault())
+  {
+    V4_LOGW(TAG, "Bytecode image on trial panicked, rolled back to slot %u",
+            (unsigned)g_image->active());
+  }
+  v4rtos::VmPool::panic_hook(context, error);
+}
 
-  // Register panic handler for fatal errors
-  panic_handler_init(g_vm);
+/** Destroy a pool VM */
+static void pool_destroy_vm(void* user, void* vm)
+{
+  (void)user;  // Unused
+#ifdef V4_SCHED_PRIORITY
+  v4rtos::sched_sys_detach(static_cast<struct Vm*>(vm));
+#endif
+#ifdef V4_TASK_NATIVE
+  // No FreeRTOS task may outlive its VM
+  v4rtos::native_tasks_detach(static_cast<struct Vm*>(vm));
+#endif
+  vm_destroy(static_cast<struct Vm*>(vm));
+}
 
-  // Initialize task system with 10ms time slice
-  v4_err err = vm_task_init(g_vm, 10);
+/**
+ * @brief Create one pool VM in its arena slice
+ *
+ * Each pool VM gets its own scheduler and a panic handler that applies
+ * the panic policy to this VM only.
+ */
+static void* pool_create_vm(void* user, uint8_t id, uint8_t* mem, size_t size)
+{
+  (void)user;  // Unused
+  VmConfig config = {
+      .mem = mem,
+      .mem_size = (uint32_t)size,
+      .mmio = nullptr,
+      .mmio_count = 0,
+      // A single VM owns the name arena (emptied on every restart); pool
+      // VMs do not share it and malloc names
+      .arena = g_pool->count() == 1 ? v4rtos::vm_memory_reset_name_arena(&g_vm_memory)
+                                    : nullptr};
+  struct Vm* vm = vm_create(&config);
+  if (vm == nullptr)
+  {
+    V4_LOGE(TAG, "Failed to create VM %u", (unsigned)id);
+    return nullptr;
+  }
+  panic_handler_init_isolated(vm, id, pool_panic_hook, g_pool->fault_context(id));
+#ifdef V4_SCHED_PRIORITY
+  // Before the task system creates the first task
+  v4rtos::sched_sys_attach(vm, id);
+#endif
+#ifdef V4_TASK_NATIVE
+  v4rtos::native_tasks_attach(vm, id);
+#endif
+  v4_err err = vm_task_init(vm, 10);
   if (err != 0)
   {
-    ESP_LOGE(TAG, "Failed to initialize task system: %d", err);
-    return -2;
+    V4_LOGE(TAG, "Failed to initialize task system of VM %u: %d", (unsigned)id,
+            (int)err);
+    pool_destroy_vm(user, vm);
+    return nullptr;
   }
 
+  // VM 0 runs the stored image; one that fails on trial was rolled back,
+  // so rebuild the VM around the previous image (pool_destroy_vm() also
+  // deletes the native tasks the failed image started)
+  if (id == 0 && g_image_live && !image_start(vm))
+  {
+    pool_destroy_vm(user, vm);
+    return pool_create_vm(user, id, mem, size);
+  }
+  return vm;
+}
+
+/**
+ * @brief Initialize V4 VM and task system
+ *
+ * Allocates the configured VM memory layout, attaches the crash log and
+ * creates a pool of CONFIG_V4_VM_POOL_COUNT VM instances (one by
+ * default), each with a preemptive task scheduler (10ms time slice, fixed
+ * priorities with per-priority slices in V4_SCHED_PRIORITY builds, or one
+ * FreeRTOS task per V4 task in V4_TASK_NATIVE builds).
+ *
+ * @return 0 on success, negative error code on failure
+ */
+static int v4_init(void)
+{
+  // Allocate VM and name arenas in their configured regions
+  if (v4rtos::vm_memory_init(&g_vm_memory) != 0)
+  {
+    return -1;
+  }
+
+#ifdef V4_LOG_DEFERRED
+  // V4_LOGx calls from here on are recorded for scripts/v4log.py
+  g_log = new v4rtos::DeferredLog(esp_log_timestamp, CONFIG_V4_LOG_RECORDS,
+                                  CONFIG_LOG_DEFAULT_LEVEL);
+  v4rtos::dlog_install(g_log);
+  ESP_LOGI(TAG, "Deferred log enabled (%u records, read with scripts/v4log.py)",
+           (unsigned)g_log->ring().capacity());
+#endif
+
+#ifdef V4_TRACE
+  // Like the profiler, before any scheduler so its first switch is recorded
+  g_trace = new v4rtos::TraceBuffer(trace_clock, TRACE_TICKS_PER_US,
+                                    portNUM_PROCESSORS > 1 ? trace_core : nullptr,
+                                    portNUM_PROCESSORS, CONFIG_V4_TRACE_RECORDS);
+  v4rtos::trace_install(g_trace);
+  ESP_LOGI(TAG, "Event trace enabled (%u records per core, %u ticks/us)",
+           (unsigned)g_trace->ring(0).capacity(), (unsigned)TRACE_TICKS_PER_US);
+#endif
+
+#ifdef V4_PROFILE
+  // Start profiling before any scheduler so its first switch is counted
+  v4rtos::vm_profiler_install(&g_profiler);
+  ESP_LOGI(TAG, "VM profiler enabled (PC sample every %u opcodes)",
+           (unsigned)CONFIG_V4_PROFILE_SAMPLE_PERIOD);
+#endif
+
+#ifdef V4_SCHED_PRIORITY
+  // Fixed priorities and per-priority slices instead of one 10ms slice
+  v4rtos::sched_sys_init(CONFIG_V4_SCHED_SLICES_MS);
+#endif
+
+#ifdef V4_TASK_NATIVE
+  // Every V4 task on its own FreeRTOS task; light sleep only on battery
+  if (!v4rtos::native_tasks_init(HAS_BATTERY))
+  {
+    return -1;
+  }
+  // Tasks created during startup wait until app_main is done with the VMs
+  v4rtos::native_tasks_lock(nullptr);
+#endif
+
+  // Crash log from the previous boot, if RTC memory kept it
+  g_crash_log = new v4rtos::CrashLog(&g_crash_storage, default_panic_policy());
+  panic_handler_set_crash_log(g_crash_log);
+  ESP_LOGI(TAG, "Crash log: boot %u, %u panic(s) recorded%s, policy %s",
+           (unsigned)g_crash_log->boots(), (unsigned)g_crash_log->panics(),
+           g_crash_log->restored() ? "" : " (new log)",
+           v4rtos::panic_policy_name(g_crash_log->policy()));
+
+  // Independent VMs, one per arena slice; a single VM is a pool of one so
+  // that it can be recreated after a panic
+  g_pool = new v4rtos::VmPool(g_vm_memory.vm_arena, g_vm_memory.vm_arena_size,
+                              CONFIG_V4_VM_POOL_COUNT, pool_create_vm, pool_destroy_vm,
+                              nullptr);
+  if (g_pool->start() != g_pool->count())
+  {
+    ESP_LOGE(TAG, "Failed to start VM pool");
+    return -1;
+  }
+  g_vm = static_cast<struct Vm*>(g_pool->vm(0));
+  if (g_pool->count() == 1)
+  {
+    ESP_LOGI(TAG, "V4 VM created (arena: %u KB)",
+             (unsigned)(g_vm_memory.vm_arena_size / 1024));
+  }
+  else
+  {
+    ESP_LOGI(TAG, "V4 VM pool created (%u VMs, %u KB each)", (unsigned)g_pool->count(),
+             (unsigned)(g_pool->slice_size() / 1024));
+  }
+  v4rtos::vm_memory_report(g_vm_memory);
+#ifdef V4_TASK_NATIVE
+  ESP_LOGI(TAG, "V4 task scheduler initialized (native FreeRTOS tasks)");
+#else
   ESP_LOGI(TAG, "V4 task scheduler initialized (10ms time slice)");
+#endif
 
   return 0;
 }
@@ -152,7 +510,8 @@ static int v4std_init(void)
 {
   // Set DDT provider
   v4std::Ddt::set_provider(&g_ddt_provider);
-  ESP_LOGI(TAG, "DDT provider registered (2 devices)");
+  ESP_LOGI(TAG, "DDT provider registered (%u devices)",
+           (unsigned)v4rtos::NanoC6DdtProvider::count());
 
   // Set LED HAL
   v4std::set_led_hal(&g_led_hal);
@@ -162,10 +521,136 @@ static int v4std_init(void)
   v4std::register_led_sys_handlers();
   ESP_LOGI(TAG, "LED SYS handlers registered");
 
+  // GPIO port words on the LED HAL's registers (menuconfig pin mask)
+  if (!v4rtos::gpio_sys_init(&g_led_hal.regs(), CONFIG_V4_GPIO_PORT_MASK))
+  {
+    return -1;
+  }
+
   ESP_LOGI(TAG, "V4-std initialized");
   return 0;
 }
 
+// ==============================================================================
+// Bytecode Image
+// ==============================================================================
+
+/** Millisecond clock of the image trial window */
+static uint32_t image_clock_ms(void)
+{
+  return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+/** Start a freshly activated image: VM 0 is rebuilt around it */
+static bool image_switch(void* user)
+{
+  (void)user;  // Unused
+  return g_pool->restart(0) && g_image->on_trial();
+}
+
+/**
+ * @brief Open the image partition and run the active image
+ *
+ * An image left on trial by the last boot is rolled back first, so the
+ * device starts its program without a host after any reset.
+ */
+static void image_autostart(void)
+{
+  if (!v4rtos::image_partition_open(&g_image_flash))
+  {
+    return;
+  }
+  g_image = new v4rtos::ImageStore(g_image_flash, image_clock_ms,
+                                   CONFIG_V4_IMAGE_TRIAL_S * 1000);
+  g_image->set_switch(image_switch, nullptr);
+  bool found = g_image->boot();
+  if (g_image->rollbacks() > 0)
+  {
+    ESP_LOGW(TAG, "Bytecode image was not confirmed before reset, rolled back");
+  }
+  g_image_live = true;
+  if (!found)
+  {
+    ESP_LOGI(TAG, "No bytecode image stored");
+    return;
+  }
+  const v4rtos::ImageStore::Header* h = g_image->active_header();
+  ESP_LOGI(TAG, "Bytecode image: slot %u, %u bytes, CRC 0x%08X%s",
+           (unsigned)g_image->active(), (unsigned)h->size, (unsigned)h->crc,
+           g_image->on_trial() ? " (on trial)" : "");
+
+  if (!image_start(g_vm))
+  {
+    g_pool->restart(0);
+    g_vm = static_cast<struct Vm*>(g_pool->vm(0));
+  }
+}
+
+// ==============================================================================
+// V4-link Ports
+// ==============================================================================
+
+#if defined(CONFIG_V4_LINK_UART) && !defined(V4_TASK_NATIVE)
+static void link_lock(void* user)
+{
+  xSemaphoreTake(static_cast<SemaphoreHandle_t>(user), portMAX_DELAY);
+}
+
+static void link_unlock(void* user)
+{
+  xSemaphoreGive(static_cast<SemaphoreHandle_t>(user));
+}
+#endif
+
+/**
+ * @brief Create a V4-link port on @p transport
+ *
+ * Every port answers the same runtime commands and routes core frames to
+ * the same VM pool; each keeps its own VM_SELECT channel and window.
+ */
+static v4rtos::Esp32c6LinkPort* link_port_create(v4rtos::LinkTransport* transport)
+{
+  auto* port = new v4rtos::Esp32c6LinkPort(g_vm, transport, 512);
+  port->attach_pool(g_pool);
+  port->add_runtime_command(v4rtos::link_wire::CMD_CRASH_LOG,
+                            v4rtos::CrashLog::handle_command, g_crash_log);
+  if (g_image != nullptr)
+  {
+    port->add_runtime_command(v4rtos::link_wire::CMD_IMAGE,
+                              v4rtos::ImageStore::handle_command, g_image);
+    port->add_caps(v4rtos::link_wire::CAP_IMAGE_LZ4);
+  }
+  // Let hosts keep several frames in flight (image uploads)
+  port->enable_window(CONFIG_V4_LINK_WINDOW_KB * 1024);
+#ifdef V4_TASK_NATIVE
+  // V4 tasks run next to the link tasks; frames wait for the VM lock
+  port->set_frame_lock(v4rtos::native_tasks_lock, v4rtos::native_tasks_unlock, nullptr);
+#endif
+#ifdef V4_PROFILE
+  port->add_runtime_command(v4rtos::link_wire::CMD_PROFILE,
+                            v4rtos::VmProfiler::handle_command, &g_profiler);
+#endif
+#ifdef V4_TRACE
+  port->add_runtime_command(v4rtos::link_wire::CMD_TRACE,
+                            v4rtos::TraceBuffer::handle_command, g_trace);
+#endif
+#ifdef V4_LOG_DEFERRED
+  port->add_runtime_command(v4rtos::link_wire::CMD_LOG,
+                            v4rtos::DeferredLog::handle_command, g_log);
+#endif
+#ifdef V4_SCHED_PRIORITY
+  port->add_runtime_command(v4rtos::link_wire::CMD_SCHED,
+                            v4rtos::sched_sys_handle_command, nullptr);
+#endif
+#ifdef V4_PEEPHOLE
+  if (g_peephole != nullptr)
+  {
+    port->set_exec_filter(v4rtos::BytecodePeephole::filter, g_peephole);
+  }
+#endif
+  return port;
+}
+
 // ==============================================================================
 // Board Initialization
 // ==============================================================================
@@ -210,8 +695,9 @@ static void board_init_runtime(void)
  * 1. HAL initialization (V4-hal)
  * 2. Board peripheral initialization
  * 3. V4 VM creation and task system initialization
- * 4. V4-link protocol initialization
- * 5. Main loop polling for V4-link bytecode
+ * 4. V4-std initialization, then the stored bytecode image (if any)
+ * 5. V4-link protocol initialization
+ * 6. Start event-driven V4-link task (app_main then returns)
  */
 extern "C" void app_main(void)
 {
@@ -274,9 +760,31 @@ extern "C" void app_main(void)
     }
   }
 
+  // SYS words an autostarted image may call at top level
+  v4rtos::mem_stats_init(g_vm, &g_vm_memory);
+  v4rtos::mem_stats_track_pool(g_pool);
+  v4rtos::msg_sys_init(g_pool);
+
+  // Run the program stored in flash; no host needed after a power cycle
+  image_autostart();
+#ifdef V4_TASK_NATIVE
+  // Startup is done with the VMs: their tasks may run from here on
+  v4rtos::native_tasks_unlock(nullptr);
+#endif
+
   // Step 5: Initialize V4-link protocol
   ESP_LOGI(TAG, "[5/5] Initializing V4-link protocol...");
-  g_link = new v4rtos::Esp32c6LinkPort(g_vm, 512);
+#ifdef V4_PEEPHOLE
+  // Fuse superinstructions into EXEC payloads before V4-link stores them
+  if (v4_peephole_isa() != nullptr)
+  {
+    g_peephole = new v4rtos::BytecodePeephole(*v4_peephole_isa(), 512);
+    ESP_LOGI(TAG, "Peephole pass enabled (%u rules)",
+             (unsigned)v4_peephole_isa()->rule_count);
+  }
+#endif
+  g_usb = new v4rtos::UsbSerialJtagTransport();
+  g_link = g_usb->ok() ? link_port_create(g_usb) : nullptr;
   if (g_link == nullptr)
   {
     ESP_LOGE(TAG, "V4-link initialization failed");
@@ -286,6 +794,56 @@ extern "C" void app_main(void)
       vTaskDelay(pdMS_TO_TICKS(1000));
     }
   }
+  v4rtos::mem_stats_attach_link(g_link, LINK_TASK_STACK_SIZE);
+  if (g_image != nullptr)
+  {
+    // One port is enough to end the trial window on time
+    g_link->set_timer_hook(v4rtos::ImageStore::timer_hook, g_image);
+  }
+#ifdef CONFIG_V4_LINK_UART
+  g_uart = new v4rtos::UartTransport(UART_NUM, CONFIG_V4_LINK_UART_BAUD);
+#ifdef V4_TASK_NATIVE
+  // Both ports already serialize frames on the VM lock
+  if (g_uart->ok())
+  {
+    g_link_uart = link_port_create(g_uart);
+  }
+#else
+  g_link_lock = xSemaphoreCreateMutex();
+  if (g_uart->ok() && g_link_lock != nullptr)
+  {
+    g_link_uart = link_port_create(g_uart);
+    g_link->set_frame_lock(link_lock, link_unlock, g_link_lock);
+    g_link_uart->set_frame_lock(link_lock, link_unlock, g_link_lock);
+  }
+#endif
+  else
+  {
+    ESP_LOGW(TAG, "V4-link UART transport unavailable");
+  }
+#endif
+#ifdef V4_JIT
+  // Compile hot words into executable IRAM; V4-engine asks at every CALL
+  if (v4_jit_isa() != nullptr)
+  {
+    size_t exec_bytes = CONFIG_V4_VM_JIT_IRAM_KB * 1024;
+    uint32_t* exec = (uint32_t*)heap_caps_malloc(exec_bytes, MALLOC_CAP_EXEC);
+    if (exec != nullptr)
+    {
+      g_jit = new v4rtos::JitCache(new v4rtos::Rv32Jit(*v4_jit_isa()), exec,
+                                   exec_bytes / 4, CONFIG_V4_VM_JIT_THRESHOLD, jit_sync);
+      v4rtos::vm_jit_install(g_jit);
+      ESP_LOGI(TAG, "JIT enabled (%u KB IRAM, threshold %u calls)",
+               (unsigned)CONFIG_V4_VM_JIT_IRAM_KB, (unsigned)CONFIG_V4_VM_JIT_THRESHOLD);
+    }
+    else
+    {
+      ESP_LOGE(TAG, "JIT disabled: no %u KB of executable memory "
+                    "(is CONFIG_ESP_SYSTEM_PMP_IDRAM_SPLIT off?)",
+               (unsigned)CONFIG_V4_VM_JIT_IRAM_KB);
+    }
+  }
+#endif
 
   // All systems ready
   ESP_LOGI(TAG, "=== V4 RTOS Runtime Ready ===");
@@ -301,13 +859,30 @@ extern "C" void app_main(void)
     vTaskDelay(pdMS_TO_TICKS(100));
   }
 
-  ESP_LOGI(TAG, "Starting main loop (polling for V4-link bytecode)...");
-
-  // Main loop: poll for V4-link bytecode
+  // Hand V4-link over to its own task: it sleeps in the USB RX driver and
+  // only wakes when bytes arrive, so there is no polling interval
   // Note: Heartbeat LED disabled to allow bytecode control of GPIO7
-  while (1)
+  if (!g_link->start_task(LINK_TASK_PRIORITY, LINK_TASK_STACK_SIZE))
+  {
+    ESP_LOGE(TAG, "Failed to start V4-link task");
+    ESP_LOGE(TAG, "System halted.");
+    while (1)
+    {
+      vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+  }
+#ifdef CONFIG_V4_LINK_UART
+  // Same for the UART, sleeping on the UART driver event queue
+  if (g_link_uart != nullptr &&
+      !g_link_uart->start_task(LINK_TASK_PRIORITY, LINK_TASK_STACK_SIZE))
   {
-    g_link->poll();
-    vTaskDelay(pdMS_TO_TICKS(1));  // 1ms polling interval
+    ESP_LOGW(TAG, "Failed to start V4-link UART task");
   }
+#endif
+
+  ESP_LOGI(TAG, "V4-link task running (event-driven)");
+
+  // Startup is done; app_main's stack is not used again after this
+  v4rtos::mem_stats_note_main_task();
+  v4rtos::mem_stats_report();
 }
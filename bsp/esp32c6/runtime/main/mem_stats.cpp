@@ -0,0 +1,181 @@
+// Memory high-water marks for the ESP32-C6 runtime
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#include "mem_stats.hpp"
+
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "link_runtime_commands.hpp"
+#include "sdkconfig.h"
+#include "sys_table.hpp"
+#include "v4/vm_api.h"
+#include "v4_link_port.hpp"
+#include "v4std/sys_handlers.hpp"
+#include "vm_memory.hpp"
+#include "vm_pool.hpp"
+
+static const char* TAG = "MemStats";
+
+namespace v4rtos
+{
+
+static Vm* s_vm = nullptr;
+static const VmMemoryLayout* s_layout = nullptr;
+static Esp32c6LinkPort* s_link = nullptr;
+static size_t s_link_stack_size = 0;
+static MemWatermarks s_marks;
+static const VmPool* s_pool = nullptr;
+
+// Data stack depth is only observable between frames
+static void sample_data_stack(void* user)
+{
+  (void)user;  // Unused
+  if (s_pool == nullptr)
+  {
+    if (s_vm != nullptr)
+    {
+      s_marks.update(MemRegion::DATA_STACK, (size_t)vm_ds_depth_public(s_vm),
+                     V4_DS_CAPACITY);
+    }
+    return;
+  }
+  // Pool VMs come and go on restart; only sample the running ones
+  for (size_t i = 0; i < s_pool->count(); i++)
+  {
+    Vm* vm = static_cast<Vm*>(s_pool->vm(static_cast<uint8_t>(i)));
+    if (vm != nullptr)
+    {
+      s_marks.update(MemRegion::DATA_STACK, (size_t)vm_ds_depth_public(vm),
+                     V4_DS_CAPACITY);
+    }
+  }
+}
+
+const MemWatermarks& mem_stats_sample(void)
+{
+  if (s_pool != nullptr)
+  {
+    // Report the fullest slice against one slice's capacity
+    for (size_t i = 0; i < s_pool->count(); i++)
+    {
+      s_marks.update(MemRegion::VM_ARENA,
+                     mem_painted_high_water(s_pool->slice(static_cast<uint8_t>(i)),
+                                            s_pool->slice_size()),
+                     s_pool->slice_size());
+    }
+  }
+  else if (s_layout != nullptr)
+  {
+    s_marks.update(MemRegion::VM_ARENA,
+                   mem_painted_high_water(s_layout->vm_arena, s_layout->vm_arena_size),
+                   s_layout->vm_arena_size);
+  }
+  if (s_layout != nullptr && s_layout->name_buf != nullptr)
+  {
+    s_marks.update(MemRegion::NAME_ARENA,
+                   mem_painted_high_water(s_layout->name_buf, s_layout->name_buf_size),
+                   s_layout->name_buf_size);
+  }
+
+  sample_data_stack(nullptr);
+
+  if (s_link != nullptr)
+  {
+    // FreeRTOS reports the minimum free stack ever seen (bytes on ESP-IDF)
+    if (s_link->task_handle() != nullptr)
+    {
+      size_t free_min = uxTaskGetStackHighWaterMark(s_link->task_handle());
+      s_marks.update(MemRegion::LINK_TASK_STACK, s_link_stack_size - free_min,
+                     s_link_stack_size);
+    }
+
+    const LinkFrameScanner::Stats& rx = s_link->scanner_stats();
+    s_marks.update(MemRegion::LINK_RX_CHUNK, s_link->rx_high_water(),
+                   Esp32c6LinkPort::rx_chunk_size());
+    s_marks.update(MemRegion::LINK_PAYLOAD, rx.payload_high_water,
+                   s_link->buffer_capacity());
+    s_marks.update(MemRegion::LINK_STAGE, rx.stage_high_water,
+                   s_link->buffer_capacity() + link_wire::OVERHEAD);
+    s_marks.update(MemRegion::LINK_TX_RING, s_link->tx_stats().high_water,
+                   s_link->tx_capacity());
+  }
+
+  return s_marks;
+}
+
+// CMD_MEM_STATS: no request payload, one record per tracked region
+static void handle_mem_stats(void* user, const LinkFrameView& frame, LinkReply* reply)
+{
+  (void)user;   // Unused
+  (void)frame;  // Unused
+  mem_stats_sample().encode(reply);
+}
+
+// MEM-WATERMARK ( region -- used capacity )
+v4_err sys_mem_watermark(Vm* vm)
+{
+  v4_i32 region = vm_ds_pop(vm);
+  MemWatermarks::Entry entry = {0, 0};
+  if (region >= 0 && region < (v4_i32)MemRegion::COUNT)
+  {
+    entry = mem_stats_sample().get((MemRegion)region);
+  }
+  vm_ds_push(vm, (v4_i32)entry.used);
+  vm_ds_push(vm, (v4_i32)entry.capacity);
+  return 0;
+}
+
+void mem_stats_init(Vm* vm, const VmMemoryLayout* layout)
+{
+  s_vm = vm;
+  s_layout = layout;
+#ifndef V4_SYS_TABLE
+  // V4_SYS_TABLE builds find it in the constant table (sys_table.hpp)
+  v4std::register_sys_handler(SYS_MEM_WATERMARK, sys_mem_watermark);
+#endif
+}
+
+void mem_stats_attach_link(Esp32c6LinkPort* link, size_t link_stack_size)
+{
+  s_link = link;
+  s_link_stack_size = link_stack_size;
+
+  link->set_frame_hook(sample_data_stack, nullptr);
+  link->add_runtime_command(link_wire::CMD_MEM_STATS, handle_mem_stats, nullptr);
+
+  ESP_LOGI(TAG, "Memory watermarks enabled (link cmd 0x%02X, SYS %u)",
+           link_wire::CMD_MEM_STATS, (unsigned)SYS_MEM_WATERMARK);
+}
+
+void mem_stats_note_main_task(void)
+{
+  size_t free_min = uxTaskGetStackHighWaterMark(nullptr);
+  s_marks.update(MemRegion::MAIN_TASK_STACK, CONFIG_ESP_MAIN_TASK_STACK_SIZE - free_min,
+                 CONFIG_ESP_MAIN_TASK_STACK_SIZE);
+}
+
+void mem_stats_track_pool(const VmPool* pool)
+{
+  s_pool = pool;
+}
+
+void mem_stats_report(void)
+{
+  const MemWatermarks& marks = mem_stats_sample();
+  ESP_LOGI(TAG, "Memory high-water marks:");
+  for (size_t i = 0; i < (size_t)MemRegion::COUNT; i++)
+  {
+    const MemWatermarks::Entry& e = marks.get((MemRegion)i);
+    if (e.capacity == 0)
+    {
+      continue;
+    }
+    ESP_LOGI(TAG, "  %-16s %7u / %7u (%u%%)", mem_region_name((MemRegion)i),
+             (unsigned)e.used, (unsigned)e.capacity,
+             (unsigned)((uint64_t)e.used * 100 / e.capacity));
+  }
+}
+
+}  // namespace v4rtos
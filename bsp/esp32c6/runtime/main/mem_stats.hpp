@@ -0,0 +1,69 @@
+// Memory high-water marks for the ESP32-C6 runtime
+//
+// Collects watermarks for the VM arenas, VM stacks, FreeRTOS task stacks
+// and V4-link buffers, and serves them over V4-link (CMD_MEM_STATS) and
+// to Forth code (SYS_MEM_WATERMARK).
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include "mem_watermark.hpp"
+
+extern "C"
+{
+  typedef struct Vm Vm;
+}
+
+namespace v4rtos
+{
+
+class Esp32c6LinkPort;
+class VmPool;
+struct VmMemoryLayout;
+
+/**
+ * @brief Start tracking and register the SYS handler
+ *
+ * Call before any bytecode runs (image autostart included), so that
+ * MEM-WATERMARK is available to it.
+ *
+ * @param vm VM whose data stack depth is sampled after each frame
+ * @param layout Painted arenas (vm_memory_init())
+ */
+void mem_stats_init(Vm* vm, const VmMemoryLayout* layout);
+
+/**
+ * @brief Track a link port's buffers and register the link command
+ *
+ * @param link Link port
+ * @param link_stack_size Stack size passed to link->start_task()
+ */
+void mem_stats_attach_link(Esp32c6LinkPort* link, size_t link_stack_size);
+
+/**
+ * @brief Record the startup task's stack watermark
+ *
+ * Call at the end of app_main, after all initialization has run.
+ */
+void mem_stats_note_main_task(void);
+
+/**
+ * @brief Sample the VMs of a pool instead of the single VM
+ *
+ * DATA_STACK then covers every running pool VM and VM_ARENA reports the
+ * fullest slice against the slice size.
+ */
+void mem_stats_track_pool(const VmPool* pool);
+
+/**
+ * @brief Sample all regions and return the high-water marks
+ */
+const MemWatermarks& mem_stats_sample(void);
+
+/**
+ * @brief Log all high-water marks
+ */
+void mem_stats_report(void);
+
+}  // namespace v4rtos
@@ -0,0 +1,298 @@
+// Pooled message words for the ESP32-C6 runtime
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#include "msg_sys.hpp"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "sys_table.hpp"
+#include "v4/vm_api.h"
+#include "v4std/sys_handlers.hpp"
+#include "vm_pool.hpp"
+
+#ifdef V4_TASK_NATIVE
+#include "native_tasks.hpp"
+#endif
+
+static const char* TAG = "Msg";
+
+namespace v4rtos
+{
+
+/** MsgPool of one VM with its lock and wakeup semaphores */
+struct MsgSlot
+{
+  static constexpr size_t MAX_WAITERS = MsgPool::MAX_QUEUES;  ///< Parked tasks
+
+  SemaphoreHandle_t mutex = nullptr;           ///< MsgPool::Sync lock
+  SemaphoreHandle_t wakeup[MAX_WAITERS] = {};  ///< Binary semaphore per parked task
+  bool parked[MAX_WAITERS] = {};               ///< wakeup[i] in use
+  uint8_t channel[MAX_WAITERS] = {};           ///< Wait channel of wakeup[i]
+  MsgPool* msgs = nullptr;                     ///< Message pool
+  uint32_t generation = 0;                     ///< VmPool generation that ran MSG-POOL
+  bool set_up = false;                         ///< MSG-POOL succeeded for that generation
+};
+
+static const VmPool* s_pool = nullptr;
+static MsgSlot s_slots[VmPool::MAX_VMS];
+
+// ==============================================================================
+// MsgPool::Sync
+// ==============================================================================
+
+static void sync_lock(void* user)
+{
+  xSemaphoreTake(static_cast<MsgSlot*>(user)->mutex, portMAX_DELAY);
+}
+
+static void sync_unlock(void* user)
+{
+  xSemaphoreGive(static_cast<MsgSlot*>(user)->mutex);
+}
+
+// Native V4 tasks run SYS calls under the VM lock: a parked task hands it
+// on so that the task it waits for can run (taken before slot->mutex)
+static void vm_release(void)
+{
+#ifdef V4_TASK_NATIVE
+  native_tasks_unlock(nullptr);
+#endif
+}
+
+static void vm_reacquire(void)
+{
+#ifdef V4_TASK_NATIVE
+  native_tasks_lock(nullptr);
+#endif
+}
+
+// FreeRTOS has no condition variable: each waiter parks on its own binary
+// semaphore, registered under the lock so a wake() cannot slip past it
+static void sync_wait(void* user, uint8_t channel, uint32_t timeout_ms)
+{
+  MsgSlot* slot = static_cast<MsgSlot*>(user);
+
+  size_t i = 0;
+  while (i < MsgSlot::MAX_WAITERS && slot->parked[i])
+  {
+    i++;
+  }
+  if (i == MsgSlot::MAX_WAITERS)
+  {
+    // More waiters than semaphores: poll once per tick instead
+    xSemaphoreGive(slot->mutex);
+    vm_release();
+    vTaskDelay(1);
+    vm_reacquire();
+    xSemaphoreTake(slot->mutex, portMAX_DELAY);
+    return;
+  }
+
+  slot->parked[i] = true;
+  slot->channel[i] = channel;
+  xSemaphoreTake(slot->wakeup[i], 0);  // Drop a wakeup that came after a timeout
+  xSemaphoreGive(slot->mutex);
+  vm_release();
+
+  TickType_t ticks = timeout_ms == MsgPool::WAIT_FOREVER ? portMAX_DELAY
+                                                         : pdMS_TO_TICKS(timeout_ms);
+  xSemaphoreTake(slot->wakeup[i], ticks > 0 ? ticks : 1);
+
+  vm_reacquire();
+  xSemaphoreTake(slot->mutex, portMAX_DELAY);
+  slot->parked[i] = false;
+}
+
+static void sync_wake(void* user, uint8_t channel)
+{
+  MsgSlot* slot = static_cast<MsgSlot*>(user);
+  for (size_t i = 0; i < MsgSlot::MAX_WAITERS; i++)
+  {
+    if (slot->parked[i] && slot->channel[i] == channel)
+    {
+      xSemaphoreGive(slot->wakeup[i]);
+    }
+  }
+}
+
+static uint32_t sync_now_ms(void* user)
+{
+  (void)user;  // Unused
+  return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+// ==============================================================================
+// SYS handlers
+// ==============================================================================
+
+// Slot of the calling VM, or nullptr
+static MsgSlot* slot_of(Vm* vm)
+{
+  int id = s_pool != nullptr ? s_pool->find(vm) : -1;
+  return id >= 0 ? &s_slots[id] : nullptr;
+}
+
+// Pool of the calling VM if this incarnation of the VM set it up
+static MsgPool* msgs_of(Vm* vm)
+{
+  int id = s_pool != nullptr ? s_pool->find(vm) : -1;
+  if (id < 0)
+  {
+    return nullptr;
+  }
+  MsgSlot& slot = s_slots[id];
+  bool current = slot.set_up && slot.generation == s_pool->info((uint8_t)id).generation;
+  return current ? slot.msgs : nullptr;
+}
+
+// Forth timeouts: negative waits forever. Without native tasks every V4
+// task of the VM runs on the thread making this SYS call, so the task that
+// would end the wait could never run: calls fail at once with ERR_TIMEOUT
+// and the caller polls (TASK-DELAY in between)
+static uint32_t to_timeout(v4_i32 timeout_ms)
+{
+#ifdef V4_TASK_NATIVE
+  return timeout_ms < 0 ? MsgPool::WAIT_FOREVER : (uint32_t)timeout_ms;
+#else
+  (void)timeout_ms;  // Unused
+  return 0;
+#endif
+}
+
+// Task ids without a queue map to one MsgPool rejects
+static uint8_t to_task(v4_i32 task)
+{
+  return task >= 0 && task < MsgPool::MAX_QUEUES ? (uint8_t)task : MsgPool::MAX_QUEUES;
+}
+
+// MSG-POOL ( addr block-size count -- result )
+v4_err sys_msg_pool(Vm* vm)
+{
+  v4_i32 count = vm_ds_pop(vm);
+  v4_i32 block_size = vm_ds_pop(vm);
+  v4_i32 addr = vm_ds_pop(vm);
+
+  MsgSlot* slot = slot_of(vm);
+  MsgPool::Status status = MsgPool::ERR_NOMEM;
+  if (slot != nullptr)
+  {
+    status = MsgPool::ERR_INVALID;
+    if (count > 0 && count <= MsgPool::MAX_BLOCKS && block_size > 0)
+    {
+      status = slot->msgs->setup((uint32_t)addr, (uint32_t)block_size, (uint16_t)count);
+    }
+    if (status == MsgPool::OK)
+    {
+      slot->generation = s_pool->info((uint8_t)s_pool->find(vm)).generation;
+      slot->set_up = true;
+    }
+  }
+  vm_ds_push(vm, status);
+  return 0;
+}
+
+// MSG-ALLOC ( timeout-ms -- addr result )
+v4_err sys_msg_alloc(Vm* vm)
+{
+  uint32_t timeout_ms = to_timeout(vm_ds_pop(vm));
+
+  MsgPool* msgs = msgs_of(vm);
+  uint32_t addr = 0;
+  MsgPool::Status status =
+      msgs != nullptr ? msgs->alloc(&addr, timeout_ms) : MsgPool::ERR_NOMEM;
+  vm_ds_push(vm, (v4_i32)addr);
+  vm_ds_push(vm, status);
+  return 0;
+}
+
+// MSG-SEND ( addr len task-id timeout-ms -- result )
+v4_err sys_msg_send(Vm* vm)
+{
+  uint32_t timeout_ms = to_timeout(vm_ds_pop(vm));
+  uint8_t task = to_task(vm_ds_pop(vm));
+  v4_i32 len = vm_ds_pop(vm);
+  v4_i32 addr = vm_ds_pop(vm);
+
+  MsgPool* msgs = msgs_of(vm);
+  MsgPool::Status status = MsgPool::ERR_NOMEM;
+  if (msgs != nullptr)
+  {
+    status = len < 0 ? MsgPool::ERR_INVALID
+                     : msgs->send(task, (uint32_t)addr, (uint32_t)len, timeout_ms);
+  }
+  vm_ds_push(vm, status);
+  return 0;
+}
+
+// MSG-RECV ( task-id timeout-ms -- addr len result )
+v4_err sys_msg_recv(Vm* vm)
+{
+  uint32_t timeout_ms = to_timeout(vm_ds_pop(vm));
+  uint8_t task = to_task(vm_ds_pop(vm));
+
+  MsgPool* msgs = msgs_of(vm);
+  MsgPool::Message msg = {0, 0};
+  MsgPool::Status status =
+      msgs != nullptr ? msgs->recv(task, &msg, timeout_ms) : MsgPool::ERR_NOMEM;
+  vm_ds_push(vm, (v4_i32)msg.addr);
+  vm_ds_push(vm, (v4_i32)msg.len);
+  vm_ds_push(vm, status);
+  return 0;
+}
+
+// MSG-RETAIN ( addr -- result )
+v4_err sys_msg_retain(Vm* vm)
+{
+  v4_i32 addr = vm_ds_pop(vm);
+
+  MsgPool* msgs = msgs_of(vm);
+  vm_ds_push(vm, msgs != nullptr ? msgs->retain((uint32_t)addr) : MsgPool::ERR_NOMEM);
+  return 0;
+}
+
+// MSG-FREE ( addr -- result )
+v4_err sys_msg_free(Vm* vm)
+{
+  v4_i32 addr = vm_ds_pop(vm);
+
+  MsgPool* msgs = msgs_of(vm);
+  vm_ds_push(vm, msgs != nullptr ? msgs->release((uint32_t)addr) : MsgPool::ERR_NOMEM);
+  return 0;
+}
+
+void msg_sys_init(const VmPool* pool)
+{
+  s_pool = pool;
+  for (size_t i = 0; i < pool->count(); i++)
+  {
+    MsgSlot& slot = s_slots[i];
+    slot.mutex = xSemaphoreCreateMutex();
+    for (size_t w = 0; w < MsgSlot::MAX_WAITERS; w++)
+    {
+      slot.wakeup[w] = xSemaphoreCreateBinary();
+    }
+    MsgPool::Sync sync = {sync_lock, sync_unlock, sync_wait, sync_wake, sync_now_ms,
+                          &slot};
+    slot.msgs = new MsgPool(sync);
+  }
+
+#ifndef V4_SYS_TABLE
+  // V4_SYS_TABLE builds find these in the constant table (sys_table.hpp)
+  v4std::register_sys_handler(SYS_MSG_POOL, sys_msg_pool);
+  v4std::register_sys_handler(SYS_MSG_ALLOC, sys_msg_alloc);
+  v4std::register_sys_handler(SYS_MSG_SEND, sys_msg_send);
+  v4std::register_sys_handler(SYS_MSG_RECV, sys_msg_recv);
+  v4std::register_sys_handler(SYS_MSG_RETAIN, sys_msg_retain);
+  v4std::register_sys_handler(SYS_MSG_FREE, sys_msg_free);
+#endif
+
+  ESP_LOGI(TAG, "Pooled messages enabled (SYS %u-%u, %u tasks x %u messages)",
+           (unsigned)SYS_MSG_POOL, (unsigned)SYS_MSG_FREE, (unsigned)MsgPool::MAX_QUEUES,
+           (unsigned)MsgPool::QUEUE_DEPTH);
+}
+
+}  // namespace v4rtos
@@ -0,0 +1,29 @@
+// Pooled message words for the ESP32-C6 runtime
+//
+// Gives every pool VM a MsgPool and registers the MSG-* SYS handlers
+// (SYS_MSG_POOL .. SYS_MSG_FREE). With native tasks (V4_TASK_NATIVE) blocked
+// Forth tasks sleep on FreeRTOS semaphores, so a waiting consumer costs no
+// CPU; otherwise the words never block and fail with ERR_TIMEOUT instead.
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include "msg_pool.hpp"
+
+namespace v4rtos
+{
+
+class VmPool;
+
+/**
+ * @brief Create one MsgPool per VM and register the SYS handlers
+ *
+ * The pools stay empty until Forth code hands them memory with MSG-POOL;
+ * a restarted VM has to do so again.
+ *
+ * @param pool VM pool
+ */
+void msg_sys_init(const VmPool* pool);
+
+}  // namespace v4rtos
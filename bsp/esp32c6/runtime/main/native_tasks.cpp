@@ -0,0 +1,330 @@
+// Native FreeRTOS tasks for V4 tasks
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#include "native_tasks.hpp"
+
+// Sizes and priorities come from the CONFIG_V4_TASK_NATIVE_* options
+#ifdef V4_TASK_NATIVE
+
+#include <cstdio>
+
+#include "esp_log.h"
+#include "esp_pm.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+#include "trace_buffer.hpp"
+#include "vm_pool.hpp"
+
+static const char* TAG = "NativeTask";
+
+namespace v4rtos
+{
+
+/** FreeRTOS task running one V4 task */
+struct NativeTask
+{
+  TaskHandle_t handle;         ///< FreeRTOS task (nullptr: slot free)
+  Vm* vm;                      ///< VM of the task
+  uint8_t id;                  ///< V4 task ID
+  v4_task_native_entry entry;  ///< Task body (V4-engine)
+  bool waiting;                ///< Counted in s_waiters
+};
+
+static constexpr uint8_t MAX_TASKS = 8;  // V4 scheduler task limit
+
+static SemaphoreHandle_t s_lock = nullptr;  // VM lock
+static volatile uint32_t s_waiters = 0;     // Tasks waiting for s_lock
+static portMUX_TYPE s_spinlock = portMUX_INITIALIZER_UNLOCKED;
+static Vm* s_vms[VmPool::MAX_VMS];  // VM attached to each table row
+static NativeTask s_tasks[VmPool::MAX_VMS][MAX_TASKS];
+static uint8_t s_owner = V4_TRACE_NO_TASK;  // V4 task holding s_lock (event trace)
+
+// Table entry of a V4 task (nullptr: VM not attached or bad ID)
+static NativeTask* find(const Vm* vm, uint8_t task)
+{
+  if (vm == nullptr || task >= MAX_TASKS)
+  {
+    return nullptr;
+  }
+  for (uint8_t i = 0; i < VmPool::MAX_VMS; i++)
+  {
+    if (s_vms[i] == vm)
+    {
+      return &s_tasks[i][task];
+    }
+  }
+  return nullptr;
+}
+
+// V4 priority 0 (highest) maps to CONFIG_V4_TASK_NATIVE_PRIORITY, one
+// FreeRTOS priority less per step, never down to the idle task
+static UBaseType_t native_priority(uint8_t priority)
+{
+  return CONFIG_V4_TASK_NATIVE_PRIORITY > priority + tskIDLE_PRIORITY
+             ? CONFIG_V4_TASK_NATIVE_PRIORITY - priority
+             : tskIDLE_PRIORITY + 1;
+}
+
+// Take the VM lock, counted as a waiter meanwhile so that yield() knows
+// to give it up; @p self is nullptr for V4-link tasks
+static void take(NativeTask* self)
+{
+  portENTER_CRITICAL(&s_spinlock);
+  s_waiters = s_waiters + 1;
+  if (self != nullptr)
+  {
+    self->waiting = true;
+  }
+  portEXIT_CRITICAL(&s_spinlock);
+
+  xSemaphoreTake(s_lock, portMAX_DELAY);
+
+  portENTER_CRITICAL(&s_spinlock);
+  s_waiters = s_waiters - 1;
+  if (self != nullptr)
+  {
+    self->waiting = false;
+  }
+  portEXIT_CRITICAL(&s_spinlock);
+
+  // The engine scheduler does not switch native tasks: a task runs V4
+  // code from the moment it holds the VM lock
+  uint8_t owner = self != nullptr ? self->id : V4_TRACE_NO_TASK;
+  if (owner != s_owner)
+  {
+    trace_event(TRACE_TASK_SWITCH, owner, s_owner, 0);
+    s_owner = owner;
+  }
+}
+
+// Entry of the calling FreeRTOS task (nullptr: not a V4 task)
+static NativeTask* current_task(void)
+{
+  TaskHandle_t handle = xTaskGetCurrentTaskHandle();
+  for (auto& row : s_tasks)
+  {
+    for (NativeTask& task : row)
+    {
+      if (task.handle == handle)
+      {
+        return &task;
+      }
+    }
+  }
+  return nullptr;
+}
+
+static void give(void)
+{
+  xSemaphoreGive(s_lock);
+}
+
+static TickType_t to_ticks(uint32_t ms)
+{
+  if (ms == UINT32_MAX)
+  {
+    return portMAX_DELAY;
+  }
+  // Never round a short wait down to a busy retry
+  TickType_t ticks = pdMS_TO_TICKS(ms);
+  return ticks > 0 ? ticks : 1;
+}
+
+static void task_main(void* arg)
+{
+  NativeTask* self = static_cast<NativeTask*>(arg);
+
+  take(self);
+  self->entry(self->vm, self->id);
+  self->handle = nullptr;  // Under the lock, so kill() cannot race the exit
+  give();
+  vTaskDelete(nullptr);
+}
+
+// Delete a task that is not the caller (VM lock held)
+static void kill(NativeTask* task)
+{
+  if (task->handle == nullptr || task->handle == xTaskGetCurrentTaskHandle())
+  {
+    return;
+  }
+  portENTER_CRITICAL(&s_spinlock);
+  if (task->waiting)
+  {
+    s_waiters = s_waiters - 1;
+    task->waiting = false;
+  }
+  portEXIT_CRITICAL(&s_spinlock);
+  vTaskDelete(task->handle);
+  task->handle = nullptr;
+}
+
+bool native_tasks_init(bool light_sleep)
+{
+  s_lock = xSemaphoreCreateMutex();
+  if (s_lock == nullptr)
+  {
+    ESP_LOGE(TAG, "Failed to create VM lock");
+    return false;
+  }
+
+#ifdef CONFIG_PM_ENABLE
+  // Full speed while anything runs, XTAL clock (and light sleep on battery
+  // boards) once every task blocks; ticks stop while idle
+  esp_pm_config_t pm = {};
+  pm.max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+  pm.min_freq_mhz = CONFIG_XTAL_FREQ;
+  pm.light_sleep_enable = light_sleep;
+  esp_err_t err = esp_pm_configure(&pm);
+  if (err != ESP_OK)
+  {
+    ESP_LOGW(TAG, "Power management unavailable: %s", esp_err_to_name(err));
+  }
+#ifndef CONFIG_FREERTOS_USE_TICKLESS_IDLE
+  ESP_LOGW(TAG, "CONFIG_FREERTOS_USE_TICKLESS_IDLE is off: idle still ticks");
+#endif
+#else
+  (void)light_sleep;  // No power management without CONFIG_PM_ENABLE
+#endif
+
+  ESP_LOGI(TAG, "V4 tasks on FreeRTOS tasks (priority %u..%u, %u byte stacks)%s",
+           (unsigned)native_priority(0), (unsigned)native_priority(7),
+           (unsigned)CONFIG_V4_TASK_NATIVE_STACK,
+           light_sleep ? ", light sleep when idle" : "");
+  return true;
+}
+
+void native_tasks_attach(Vm* vm, uint8_t id)
+{
+  if (id >= VmPool::MAX_VMS)
+  {
+    return;
+  }
+  // A VM recreated in the same slot replaces the previous one
+  for (NativeTask& task : s_tasks[id])
+  {
+    kill(&task);
+  }
+  s_vms[id] = vm;
+}
+
+void native_tasks_detach(Vm* vm)
+{
+  for (uint8_t i = 0; i < VmPool::MAX_VMS; i++)
+  {
+    if (s_vms[i] != vm)
+    {
+      continue;
+    }
+    for (NativeTask& task : s_tasks[i])
+    {
+      kill(&task);
+    }
+    s_vms[i] = nullptr;
+  }
+}
+
+void native_tasks_lock(void* user)
+{
+  (void)user;  // Unused
+  take(current_task());
+}
+
+void native_tasks_unlock(void* user)
+{
+  (void)user;  // Unused
+  give();
+}
+
+}  // namespace v4rtos
+
+using v4rtos::NativeTask;
+
+extern "C"
+{
+  int v4_task_native_spawn(Vm* vm, uint8_t task, uint8_t priority,
+                           v4_task_native_entry entry)
+  {
+    NativeTask* slot = v4rtos::find(vm, task);
+    if (slot == nullptr || slot->handle != nullptr || entry == nullptr)
+    {
+      return -1;
+    }
+    slot->vm = vm;
+    slot->id = task;
+    slot->entry = entry;
+    slot->waiting = false;
+
+    // Starts by waiting for the VM lock the caller holds
+    char name[16];
+    snprintf(name, sizeof(name), "v4task-%u", (unsigned)task);
+    if (xTaskCreate(v4rtos::task_main, name, CONFIG_V4_TASK_NATIVE_STACK, slot,
+                    v4rtos::native_priority(priority), &slot->handle) != pdPASS)
+    {
+      ESP_LOGE(TAG, "Failed to create task %u", (unsigned)task);
+      slot->handle = nullptr;
+      return -1;
+    }
+    return 0;
+  }
+
+  void v4_task_native_kill(Vm* vm, uint8_t task)
+  {
+    NativeTask* slot = v4rtos::find(vm, task);
+    if (slot != nullptr)
+    {
+      v4rtos::kill(slot);
+    }
+  }
+
+  void v4_task_native_delay(Vm* vm, uint8_t task, uint32_t ms)
+  {
+    if (ms == 0)
+    {
+      v4_task_native_yield(vm, task);
+      return;
+    }
+    v4rtos::give();
+    vTaskDelay(v4rtos::to_ticks(ms));
+    v4rtos::take(v4rtos::find(vm, task));
+  }
+
+  int v4_task_native_wait(Vm* vm, uint8_t task, uint32_t timeout_ms)
+  {
+    if (timeout_ms == 0)
+    {
+      return ulTaskNotifyTake(pdTRUE, 0) > 0;
+    }
+    v4rtos::give();
+    uint32_t notified = ulTaskNotifyTake(pdTRUE, v4rtos::to_ticks(timeout_ms));
+    v4rtos::take(v4rtos::find(vm, task));
+    return notified > 0;
+  }
+
+  void v4_task_native_notify(Vm* vm, uint8_t task)
+  {
+    NativeTask* slot = v4rtos::find(vm, task);
+    if (slot != nullptr && slot->handle != nullptr)
+    {
+      xTaskNotifyGive(slot->handle);
+    }
+  }
+
+  void v4_task_native_yield(Vm* vm, uint8_t task)
+  {
+    if (v4rtos::s_waiters == 0)
+    {
+      return;
+    }
+    // A higher-priority waiter preempts us in give(); taskYIELD() lets one
+    // of equal priority take its turn
+    v4rtos::give();
+    taskYIELD();
+    v4rtos::take(v4rtos::find(vm, task));
+  }
+}
+
+#endif  // V4_TASK_NATIVE
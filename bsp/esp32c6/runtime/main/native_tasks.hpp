@@ -0,0 +1,120 @@
+// Native FreeRTOS tasks for V4 tasks
+//
+// V4-engine built with V4_TASK_NATIVE runs every V4 task on a FreeRTOS
+// task of its own instead of switching between them on a 10 ms VM time
+// slice. TASK-DELAY and an empty RECV block that FreeRTOS task in the
+// kernel (vTaskDelay, task notification), so when every V4 task and the
+// V4-link tasks wait, only the idle task is left and tickless idle (with
+// light sleep on battery boards) can stop the CPU until the next timeout
+// or interrupt.
+//
+// V4 code of all VMs and the V4-link frames run under one VM lock, a
+// FreeRTOS mutex (priority inheritance included): a task gives it up
+// while it blocks and, at the engine's yield points, to a waiting task.
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include <cstdint>
+
+extern "C"
+{
+  typedef struct Vm Vm;
+
+  /** Body of a V4 task; runs with the VM lock held until the task ends */
+  typedef void (*v4_task_native_entry)(Vm* vm, uint8_t task);
+
+  /**
+   * @brief Engine hook: run a new V4 task on its own FreeRTOS task
+   *
+   * @param priority TASK-CREATE priority (0 highest)
+   * @return 0 on success, -1 if out of tasks or memory
+   */
+  int v4_task_native_spawn(Vm* vm, uint8_t task, uint8_t priority,
+                           v4_task_native_entry entry);
+
+  /**
+   * @brief Engine hook: delete a V4 task other than the calling one
+   *
+   * Called with the VM lock held, so the task is blocked or waiting for
+   * the lock, never inside V4 code.
+   */
+  void v4_task_native_kill(Vm* vm, uint8_t task);
+
+  /**
+   * @brief Engine hook: TASK-DELAY; releases the VM lock while sleeping
+   */
+  void v4_task_native_delay(Vm* vm, uint8_t task, uint32_t ms);
+
+  /**
+   * @brief Engine hook: RECV found no message; sleep until notified
+   *
+   * Releases the VM lock while sleeping. A notification sent after the
+   * engine checked the queue is not lost; a stale one ends the wait
+   * early, so the engine checks its queue again.
+   *
+   * @param timeout_ms Longest wait (UINT32_MAX: forever)
+   * @return Non-zero if notified, 0 on timeout
+   */
+  int v4_task_native_wait(Vm* vm, uint8_t task, uint32_t timeout_ms);
+
+  /**
+   * @brief Engine hook: a message was queued for @p task
+   */
+  void v4_task_native_notify(Vm* vm, uint8_t task);
+
+  /**
+   * @brief Engine hook: hand the VM lock to a waiting task, if any
+   *
+   * Called after SYS calls and backward branches; costs one load when
+   * nobody waits.
+   */
+  void v4_task_native_yield(Vm* vm, uint8_t task);
+}
+
+namespace v4rtos
+{
+
+/**
+ * @brief Create the VM lock and apply the power policy
+ *
+ * Call before the VM pool starts. With CONFIG_PM_ENABLE the CPU runs at
+ * CPU_FREQ_MHZ, drops to the XTAL frequency when idle and, if
+ * @p light_sleep, enters light sleep between tickless idle periods.
+ *
+ * @param light_sleep Allow light sleep (HAS_BATTERY boards)
+ * @return false if the lock cannot be created
+ */
+bool native_tasks_init(bool light_sleep);
+
+/**
+ * @brief Route the tasks of pool VM @p id to their own table slot
+ *
+ * Call before vm_task_init() so the first task is seen. Every path that
+ * destroys the VM afterwards, error paths included, must call
+ * native_tasks_detach() first.
+ */
+void native_tasks_attach(Vm* vm, uint8_t id);
+
+/**
+ * @brief Delete the remaining tasks of a VM (before vm_destroy())
+ *
+ * Call with the VM lock held.
+ */
+void native_tasks_detach(Vm* vm);
+
+/**
+ * @brief Take the VM lock (Esp32c6LinkPort frame lock signature)
+ *
+ * Also for SYS handlers that block outside the v4_task_native_* hooks:
+ * they release the lock while waiting and take it back.
+ */
+void native_tasks_lock(void* user);
+
+/**
+ * @brief Release the VM lock
+ */
+void native_tasks_unlock(void* user);
+
+}  // namespace v4rtos
@@ -21,12 +21,44 @@
 #include "v4/panic.h"  // For PanicInfo struct and vm_set_panic_handler
 #include "v4/vm_api.h"
 
-// ESP-IDF APIs
+// ESP-IDF APIs (panic reports: V4_LOGx, deferred in V4_LOG_DEFERRED builds)
+#include "esp32_log.hpp"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
-static const char* TAG = "v4-panic";
+#include "esp_system.h"  // esp_restart()
+
+// Crash log, VM stack capacities, VM pool size
+#include "crash_log.hpp"
+#include "mem_watermark.hpp"
+#include "trace_buffer.hpp"
+#include "vm_pool.hpp"
+
+#ifdef V4_TASK_RESTART
+// Provided by V4-engine built with V4_TASK_RESTART: restart @p task_id from
+// its entry word with empty stacks once the panic handler returns
+extern "C" v4_err vm_task_restart(struct Vm* vm, uint8_t task_id);
+#endif
+
+using v4rtos::CrashLog;
+using v4rtos::PanicPolicy;
+
+static constexpr char TAG[] = "v4-panic";
+
+/** Pool VM registered with panic_handler_init_isolated() */
+struct IsolatedVm
+{
+  struct Vm* vm;                               ///< VM instance
+  uint8_t id;                                  ///< Pool index
+  void (*on_fault)(void* user, int32_t code);  ///< Marks the VM faulted
+  void* user;                                  ///< @p on_fault context
+};
+
+static IsolatedVm s_isolated[v4rtos::VmPool::MAX_VMS];
+
+/** Crash log and policy (panic_handler_set_crash_log()) */
+static CrashLog* s_crash_log = nullptr;
 
 /**
  * @brief LED control functions for panic indication
@@ -77,56 +109,196 @@ static const char* get_error_name(v4_err code)
   }
 }
 
+/** Mark the panic in the event trace, ahead of the slow log output */
+static void trace_panic(const IsolatedVm* iso, const V4PanicInfo* info)
+{
+  v4rtos::trace_event(v4rtos::TRACE_PANIC,
+                      info != nullptr ? info->task_id : V4_TRACE_NO_TASK,
+                      iso != nullptr ? iso->id : CrashLog::NO_VM,
+                      info != nullptr ? (uint32_t)info->error_code : 0);
+}
+
 /**
- * @brief Panic handler callback
+ * @brief Pick the configured policy where it can work
  *
- * Called by VM when a fatal error occurs.
- * Logs error details and provides visual indication via LED.
+ * RESTART_TASK needs V4-engine with V4_TASK_RESTART (the restart is
+ * requested here) and RESET_VM a pool VM to recreate; otherwise the next
+ * weaker recovery is used.
  */
-static void handle_panic(void* user_data, const V4PanicInfo* info)
+static PanicPolicy choose_action(const IsolatedVm* iso, const V4PanicInfo* info)
+{
+  PanicPolicy action =
+      s_crash_log != nullptr ? s_crash_log->policy() : PanicPolicy::HALT;
+#ifdef V4_TASK_RESTART
+  if (action == PanicPolicy::RESTART_TASK &&
+      (iso == nullptr || info == nullptr ||
+       vm_task_restart(iso->vm, info->task_id) != 0))
+  {
+    action = PanicPolicy::RESET_VM;
+  }
+#else
+  (void)info;  // Unused
+  if (action == PanicPolicy::RESTART_TASK)
+  {
+    action = PanicPolicy::RESET_VM;
+  }
+#endif
+  if (action == PanicPolicy::RESET_VM && iso == nullptr)
+  {
+    action = PanicPolicy::HALT;
+  }
+  return action;
+}
+
+/** Store the panic in the crash log before acting on it */
+static void record_panic(const IsolatedVm* iso, const V4PanicInfo* info,
+                         PanicPolicy action)
 {
-  (void)user_data;  // Unused
+  if (s_crash_log == nullptr)
+  {
+    return;
+  }
+  CrashLog::Entry e = {};
+  e.uptime_ms = (uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS);
+  e.vm_id = iso != nullptr ? iso->id : CrashLog::NO_VM;
+  e.action = (uint8_t)action;
+  if (info != nullptr)
+  {
+    e.error = info->error_code;
+    e.pc = info->pc;
+    e.task_id = info->task_id;
+    e.ds_depth = (int16_t)info->ds_depth;
+    e.rs_depth = (int16_t)info->rs_depth;
+    if (info->has_stack_data && info->ds_depth > 0)
+    {
+      e.stack_count = (uint8_t)(info->ds_depth < (int)CrashLog::STACK_CELLS
+                                    ? info->ds_depth
+                                    : (int)CrashLog::STACK_CELLS);
+      for (size_t i = 0; i < e.stack_count; i++)
+      {
+        e.stack[i] = info->stack[i];
+      }
+    }
+  }
+  s_crash_log->record(e);
+}
 
+/**
+ * @brief Log the panic report
+ */
+static void log_panic(const V4PanicInfo* info)
+{
   if (!info)
   {
-    ESP_LOGE(TAG, "!!! VM PANIC (NULL panic info) !!!");
+    V4_LOGE(TAG, "!!! VM PANIC (NULL panic info) !!!");
     return;
   }
 
   // Log panic header
-  ESP_LOGE(TAG, "");
-  ESP_LOGE(TAG, "╔═══════════════════════════════════════════════════════════╗");
-  ESP_LOGE(TAG, "║              V4 VM PANIC - FATAL ERROR                    ║");
-  ESP_LOGE(TAG, "╚═══════════════════════════════════════════════════════════╝");
+  V4_LOGE(TAG, "");
+  V4_LOGE(TAG, "╔═══════════════════════════════════════════════════════════╗");
+  V4_LOGE(TAG, "║              V4 VM PANIC - FATAL ERROR                    ║");
+  V4_LOGE(TAG, "╚═══════════════════════════════════════════════════════════╝");
 
-  // Log error code and name
+  // Log error code and name (strings cannot be deferred)
+#ifdef V4_LOG_DEFERRED
+  V4_LOGE(TAG, "Error Code:    %d", (int)info->error_code);
+#else
   ESP_LOGE(TAG, "Error Code:    %" PRId32 " (%s)", info->error_code,
            get_error_name(info->error_code));
+#endif
 
-  // Log program counter
-  ESP_LOGE(TAG, "PC:            0x%08X", (unsigned int)info->pc);
+  // Log program counter and faulting task
+  V4_LOGE(TAG, "PC:            0x%08X", (unsigned int)info->pc);
+  V4_LOGE(TAG, "Task:          %u", (unsigned)info->task_id);
 
   // Log stack state
-  ESP_LOGE(TAG, "Stack Depth:   %d / 256", info->ds_depth);
-  ESP_LOGE(TAG, "Return Depth:  %d / 64", info->rs_depth);
+  V4_LOGE(TAG, "Stack Depth:   %d / %u", info->ds_depth,
+          (unsigned)v4rtos::V4_DS_CAPACITY);
+  V4_LOGE(TAG, "Return Depth:  %d / %u", info->rs_depth,
+          (unsigned)v4rtos::V4_RS_CAPACITY);
 
   // Log top stack values (up to 4)
   if (info->has_stack_data && info->ds_depth > 0)
   {
-    ESP_LOGE(TAG, "Stack Values:");
+    V4_LOGE(TAG, "Stack Values:");
     int count = info->ds_depth < 4 ? info->ds_depth : 4;
     for (int i = 0; i < count; i++)
     {
-      ESP_LOGE(TAG, "  [%d]: 0x%08X (%d)", i, (unsigned int)info->stack[i],
-               (int)info->stack[i]);
+      V4_LOGE(TAG, "  [%d]: 0x%08X (%d)", i, (unsigned int)info->stack[i],
+              (int)info->stack[i]);
     }
     if (info->ds_depth > 4)
     {
-      ESP_LOGE(TAG, "  ... (%d more values)", info->ds_depth - 4);
+      V4_LOGE(TAG, "  ... (%d more values)", info->ds_depth - 4);
     }
   }
+}
 
-  ESP_LOGE(TAG, "");
+#ifdef V4_LOG_DEFERRED
+/**
+ * @brief Report a panic the deferred log cannot deliver, on the console
+ *
+ * REBOOT loses the log ring and HALT may stop the task that drains it;
+ * the full report stays in the crash log.
+ */
+static void log_panic_now(const V4PanicInfo* info)
+{
+  if (info != nullptr)
+  {
+    ESP_LOGE(TAG, "VM panic: error %" PRId32 " (%s), PC 0x%08X, task %u",
+             info->error_code, get_error_name(info->error_code), (unsigned int)info->pc,
+             (unsigned)info->task_id);
+  }
+}
+#endif
+
+/**
+ * @brief Panic handler callback
+ *
+ * Called by VM when a fatal error occurs.
+ * Logs error details, stores them in the crash log and applies the panic
+ * policy. RESET_VM and RESTART_TASK return so only the VM or task stops;
+ * REBOOT resets the chip and HALT blinks the LED until a manual reset.
+ */
+static void handle_panic(void* user_data, const V4PanicInfo* info)
+{
+  IsolatedVm* iso = static_cast<IsolatedVm*>(user_data);
+  trace_panic(iso, info);
+  log_panic(info);
+
+  PanicPolicy action = choose_action(iso, info);
+  record_panic(iso, info, action);
+
+  V4_LOGE(TAG, "");
+  switch (action)
+  {
+    case PanicPolicy::RESET_VM:
+      // Stop only this VM; it is recreated before its next frame
+      V4_LOGE(TAG, "VM faulted, other VMs keep running.");
+      V4_LOGE(TAG, "");
+      iso->on_fault(iso->user, info != nullptr ? info->error_code : 0);
+      return;
+    case PanicPolicy::RESTART_TASK:
+      // V4-engine restarts the task; the VM and its other tasks keep running
+      V4_LOGE(TAG, "Task %u restarted.", (unsigned)info->task_id);
+      V4_LOGE(TAG, "");
+      return;
+    case PanicPolicy::REBOOT:
+      // The crash log lives in RTC no-init RAM and survives the reset
+#ifdef V4_LOG_DEFERRED
+      log_panic_now(info);
+#endif
+      ESP_LOGE(TAG, "Rebooting...");
+      vTaskDelay(pdMS_TO_TICKS(100));  // Let the log drain
+      esp_restart();
+      break;
+    case PanicPolicy::HALT:
+#ifdef V4_LOG_DEFERRED
+      log_panic_now(info);
+#endif
+      break;
+  }
   ESP_LOGE(TAG, "System halted. Reset required.");
   ESP_LOGE(TAG, "");
 
@@ -162,3 +334,20 @@ extern "C" void panic_handler_init(struct Vm* vm)
   vm_set_panic_handler(vm, handle_panic, nullptr);
   ESP_LOGI(TAG, "Panic handler registered");
 }
+
+extern "C" void panic_handler_init_isolated(struct Vm* vm, uint8_t id,
+                                            void (*on_fault)(void* user, int32_t code),
+                                            void* user)
+{
+  panic_handler_init(vm);
+  if (vm != nullptr && id < v4rtos::VmPool::MAX_VMS)
+  {
+    s_isolated[id] = IsolatedVm{vm, id, on_fault, user};
+    vm_set_panic_handler(vm, handle_panic, &s_isolated[id]);
+  }
+}
+
+void panic_handler_set_crash_log(CrashLog* log)
+{
+  s_crash_log = log;
+}
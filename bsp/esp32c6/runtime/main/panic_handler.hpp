@@ -3,7 +3,7 @@
  * @brief V4 VM panic handler for ESP32-C6 runtime
  *
  * Provides panic handler integration for V4 VM:
- * - Logs panic information via ESP_LOGE
+ * - Logs panic information via V4_LOGE (ESP_LOGE, or the deferred log)
  * - Provides visual indication via LED
  * - Formats error messages for debugging
  *
@@ -12,6 +12,8 @@
 
 #pragma once
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -21,9 +23,11 @@ extern "C"
    * @brief Initialize V4 panic handler for ESP32-C6
    *
    * Registers a panic handler that:
-   * - Logs error messages via ESP_LOGE
+   * - Logs error messages via V4_LOGE
    * - Blinks LED rapidly to indicate error
    * - Formats detailed panic information
+   * - Stores the panic in the crash log, if one is set, and applies its
+   *   HALT or REBOOT policy
    *
    * Must be called after vm_create() and before any VM execution.
    *
@@ -31,6 +35,37 @@ extern "C"
    */
   void panic_handler_init(struct Vm* vm);
 
+  /**
+   * @brief Initialize the panic handler for one VM of a VM pool
+   *
+   * Same report as panic_handler_init(), plus the crash log and panic
+   * policy (panic_handler_set_crash_log()). With RESET_VM the handler
+   * calls @p on_fault and returns instead of halting the device, so only
+   * this VM stops (see VmPool::panic_hook()).
+   *
+   * @param vm VM instance
+   * @param id Pool index (recorded in the crash log)
+   * @param on_fault Called with @p user and the V4 error code
+   * @param user Identifies the VM to @p on_fault
+   */
+  void panic_handler_init_isolated(struct Vm* vm, uint8_t id,
+                                   void (*on_fault)(void* user, int32_t code),
+                                   void* user);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
+
+#ifdef __cplusplus
+namespace v4rtos
+{
+class CrashLog;
+}
+
+/**
+ * @brief Record every panic in @p log and apply its panic policy
+ *
+ * Without a crash log every panic halts the device.
+ */
+void panic_handler_set_crash_log(v4rtos::CrashLog* log);
+#endif
@@ -0,0 +1,181 @@
+// Task scheduling words for the ESP32-C6 runtime
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#include "sched_sys.hpp"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "link_runtime_commands.hpp"
+#include "sys_table.hpp"
+#include "v4/vm_api.h"
+#include "v4std/sys_handlers.hpp"
+#include "vm_pool.hpp"
+
+static const char* TAG = "Sched";
+
+namespace v4rtos
+{
+
+static uint32_t clock_us(void)
+{
+  return (uint32_t)esp_timer_get_time();
+}
+
+static uint16_t s_slices[TaskScheduler::PRIORITIES];
+static TaskScheduler* s_scheds[VmPool::MAX_VMS];
+static Vm* s_vms[VmPool::MAX_VMS];  // VM attached to each scheduler
+
+// ==============================================================================
+// SYS handlers
+// ==============================================================================
+
+// TASK-PRIORITY ( task-id priority -- result )
+v4_err sys_task_priority(Vm* vm)
+{
+  v4_i32 priority = vm_ds_pop(vm);
+  v4_i32 task = vm_ds_pop(vm);
+
+  TaskScheduler* sched = task_sched_of(vm);
+  TaskScheduler::Status status = TaskScheduler::ERR_INVALID;
+  if (sched != nullptr && task >= 0 && task < TaskScheduler::MAX_TASKS && priority >= 0 &&
+      priority < TaskScheduler::PRIORITIES)
+  {
+    status = sched->set_priority((uint8_t)task, (uint8_t)priority);
+  }
+  vm_ds_push(vm, status);
+  return 0;
+}
+
+// MUTEX-LOCK ( mutex-id -- result )
+v4_err sys_mutex_lock(Vm* vm)
+{
+  v4_i32 mutex = vm_ds_pop(vm);
+
+  TaskScheduler* sched = task_sched_of(vm);
+  TaskScheduler::Status status = TaskScheduler::ERR_INVALID;
+  if (sched != nullptr && mutex >= 0 && mutex < TaskScheduler::MAX_MUTEXES)
+  {
+    status = sched->lock((uint8_t)mutex, sched->current());
+  }
+
+  // Blocked: V4-engine switches away after this call (v4_sched_preempt)
+  // and resumes the task once the owner has handed it the mutex
+  vm_ds_push(vm, status == TaskScheduler::BLOCKED ? TaskScheduler::OK : status);
+  return 0;
+}
+
+// MUTEX-TRY ( mutex-id -- result )
+v4_err sys_mutex_try(Vm* vm)
+{
+  v4_i32 mutex = vm_ds_pop(vm);
+
+  TaskScheduler* sched = task_sched_of(vm);
+  TaskScheduler::Status status = TaskScheduler::ERR_INVALID;
+  if (sched != nullptr && mutex >= 0 && mutex < TaskScheduler::MAX_MUTEXES)
+  {
+    status = sched->try_lock((uint8_t)mutex, sched->current());
+  }
+  vm_ds_push(vm, status);
+  return 0;
+}
+
+// MUTEX-UNLOCK ( mutex-id -- result )
+v4_err sys_mutex_unlock(Vm* vm)
+{
+  v4_i32 mutex = vm_ds_pop(vm);
+
+  TaskScheduler* sched = task_sched_of(vm);
+  TaskScheduler::Status status = TaskScheduler::ERR_INVALID;
+  if (sched != nullptr && mutex >= 0 && mutex < TaskScheduler::MAX_MUTEXES)
+  {
+    status = sched->unlock((uint8_t)mutex, sched->current());
+  }
+  vm_ds_push(vm, status);
+  return 0;
+}
+
+bool sched_sys_init(const char* slices)
+{
+  bool parsed = TaskScheduler::parse_slices(slices, s_slices);
+  if (!parsed)
+  {
+    ESP_LOGW(TAG, "Invalid time slices \"%s\", using %u ms", slices,
+             (unsigned)TaskScheduler::DEFAULT_SLICE_MS);
+    for (uint16_t& ms : s_slices)
+    {
+      ms = TaskScheduler::DEFAULT_SLICE_MS;
+    }
+  }
+
+  for (TaskScheduler*& sched : s_scheds)
+  {
+    sched = new TaskScheduler(clock_us);
+  }
+
+#ifndef V4_SYS_TABLE
+  // V4_SYS_TABLE builds find these in the constant table (sys_table.hpp)
+  v4std::register_sys_handler(SYS_TASK_PRIORITY, sys_task_priority);
+  v4std::register_sys_handler(SYS_MUTEX_LOCK, sys_mutex_lock);
+  v4std::register_sys_handler(SYS_MUTEX_TRY, sys_mutex_try);
+  v4std::register_sys_handler(SYS_MUTEX_UNLOCK, sys_mutex_unlock);
+#endif
+
+  ESP_LOGI(TAG,
+           "Priority scheduling enabled (SYS %u-%u, slices %u %u %u %u %u %u %u %u ms)",
+           (unsigned)SYS_TASK_PRIORITY, (unsigned)SYS_MUTEX_UNLOCK, (unsigned)s_slices[0],
+           (unsigned)s_slices[1], (unsigned)s_slices[2], (unsigned)s_slices[3],
+           (unsigned)s_slices[4], (unsigned)s_slices[5], (unsigned)s_slices[6],
+           (unsigned)s_slices[7]);
+  return parsed;
+}
+
+void sched_sys_attach(Vm* vm, uint8_t id)
+{
+  if (id >= VmPool::MAX_VMS || s_scheds[id] == nullptr)
+  {
+    return;
+  }
+  // A VM recreated in the same slot replaces the previous one
+  if (s_vms[id] != nullptr)
+  {
+    task_sched_detach(s_vms[id]);
+    s_vms[id] = nullptr;
+  }
+  TaskScheduler& sched = *s_scheds[id];
+  sched = TaskScheduler(clock_us);
+  for (uint8_t p = 0; p < TaskScheduler::PRIORITIES; p++)
+  {
+    sched.set_slice(p, s_slices[p]);
+  }
+  if (task_sched_attach(vm, &sched))
+  {
+    s_vms[id] = vm;
+  }
+}
+
+void sched_sys_detach(Vm* vm)
+{
+  for (Vm*& attached : s_vms)
+  {
+    if (attached == vm)
+    {
+      attached = nullptr;
+    }
+  }
+  task_sched_detach(vm);
+}
+
+void sched_sys_handle_command(void* user, const LinkFrameView& frame, LinkReply* reply)
+{
+  (void)user;  // Unused
+  uint8_t id = frame.len >= 2 ? frame.payload[1] : 0;
+  if (id >= VmPool::MAX_VMS || s_vms[id] == nullptr)
+  {
+    reply->status = link_wire::STATUS_ERROR;
+    return;
+  }
+  TaskScheduler::handle_command(s_scheds[id], frame, reply);
+}
+
+}  // namespace v4rtos
@@ -4,91 +4,329 @@
 
 #include "v4_link_port.hpp"
 
+#include <cstdio>
 #include <cstring>
 
-#include "driver/usb_serial_jtag.h"
+#include "esp32_log.hpp"
 #include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "trace_buffer.hpp"
 #include "v4/vm_api.h"
 #include "v4link/link.hpp"
 
-static const char* TAG = "V4Link";
+static constexpr char TAG[] = "V4Link";
 
 namespace v4rtos
 {
 
-// Static UART write callback for V4-link
-static void usb_serial_jtag_write_callback(void* user, const uint8_t* data, size_t len)
+// Trace an outgoing frame: [STX][LEN_L][LEN_H][status]...
+static void trace_tx(const uint8_t* data, size_t len)
 {
-  (void)user;  // Unused
+  trace_event(TRACE_LINK_TX, V4_TRACE_NO_TASK, len > 3 ? data[3] : 0, (uint32_t)len);
+}
+
+// Static write callback for V4-link: queue the response, never block
+static void link_write_callback(void* user, const uint8_t* data, size_t len)
+{
+  trace_tx(data, len);
+  static_cast<TxRing*>(user)->write(data, len);
+}
+
+Esp32c6LinkPort::Esp32c6LinkPort(Vm* vm, LinkTransport* transport, size_t buffer_size)
+    : transport_(transport),
+      link_(nullptr),
+      scanner_(buffer_size, on_frame, this),
+      tx_(TX_RING_SIZE, LinkTransport::tx_sink, transport, TX_MAX_WAIT_MS),
+      runtime_cmds_(buffer_size),
+      buffer_size_(buffer_size)
+{
+  ESP_LOGI(TAG, "Initializing V4-link on %s (buffer: %u bytes)", transport->name(),
+           (unsigned)buffer_size);
+
+  // Create V4-link instance with write callback
+  link_ = std::make_unique<v4::link::Link>(vm, link_write_callback, &tx_, buffer_size);
+
+  ESP_LOGI(TAG, "V4-link initialized");
+}
 
-  // Send response data over USB Serial/JTAG
-  int written = usb_serial_jtag_write_bytes((const char*)data, len, portMAX_DELAY);
-  if (written < 0)
+Esp32c6LinkPort::~Esp32c6LinkPort()
+{
+  // Stop link task before the transport it blocks in goes away
+  if (task_ != nullptr)
   {
-    ESP_LOGE(TAG, "Failed to write to USB Serial/JTAG");
+    vTaskDelete(task_);
   }
+
+  // Last chance for queued responses, bounded like any other write
+  tx_.flush(TX_MAX_WAIT_MS);
 }
 
-Esp32c6LinkPort::Esp32c6LinkPort(Vm* vm, size_t buffer_size) : link_(nullptr)
+void Esp32c6LinkPort::poll()
 {
-  ESP_LOGI(TAG, "Initializing V4-link (buffer: %d bytes)", buffer_size);
+  if (!link_)
+  {
+    return;
+  }
+
+  if (timer_hook_ != nullptr)
+  {
+    lock();
+    timer_hook_(timer_hook_user_);
+    unlock();
+  }
 
-  // Configure USB Serial/JTAG driver
-  usb_serial_jtag_driver_config_t usb_config = {
-      .tx_buffer_size = USB_BUF_SIZE,
-      .rx_buffer_size = USB_BUF_SIZE,
-  };
+  // Read available data from the transport (non-blocking)
+  uint8_t buffer[RX_CHUNK];
+  int len = transport_->read(buffer, sizeof(buffer), 0);
 
-  // Install USB Serial/JTAG driver
-  esp_err_t ret = usb_serial_jtag_driver_install(&usb_config);
-  if (ret != ESP_OK)
+  if (len > 0)
   {
-    ESP_LOGE(TAG, "Failed to install USB Serial/JTAG driver: %d", ret);
-    return;
+    feed(buffer, static_cast<size_t>(len));
   }
 
-  ESP_LOGI(TAG, "USB Serial/JTAG driver installed");
+  // One coalesced flush per poll
+  flush_tx();
+}
 
-  // Create V4-link instance with write callback
-  link_ = std::make_unique<v4::link::Link>(vm, usb_serial_jtag_write_callback, nullptr,
-                                           buffer_size);
+bool Esp32c6LinkPort::start_task(unsigned priority, size_t stack_size)
+{
+  if (!link_ || task_ != nullptr)
+  {
+    return false;
+  }
 
-  ESP_LOGI(TAG, "V4-link initialized");
+  char name[16];
+  snprintf(name, sizeof(name), "v4link-%s", transport_->name());
+  BaseType_t ret = xTaskCreate(task_entry, name, stack_size, this, priority, &task_);
+  if (ret != pdPASS)
+  {
+    ESP_LOGE(TAG, "Failed to create link task");
+    task_ = nullptr;
+    return false;
+  }
+
+  ESP_LOGI(TAG, "Link task started on %s (priority: %u, stack: %u bytes)",
+           transport_->name(), priority, (unsigned)stack_size);
+  return true;
 }
 
-Esp32c6LinkPort::~Esp32c6LinkPort()
+void Esp32c6LinkPort::task_entry(void* arg)
 {
-  // Uninstall USB Serial/JTAG driver
-  usb_serial_jtag_driver_uninstall();
+  auto* self = static_cast<Esp32c6LinkPort*>(arg);
+  uint8_t buffer[RX_CHUNK];
+
+  while (1)
+  {
+    // Sleep in the transport until at least one byte arrives; while
+    // responses are still queued, wake up periodically to retry them
+    uint32_t wait = self->tx_.pending() > 0 ? TX_RETRY_MS : LinkTransport::WAIT_FOREVER;
+    if (self->timer_hook_ != nullptr)
+    {
+      self->lock();
+      uint32_t due_ms = self->timer_hook_(self->timer_hook_user_);
+      self->unlock();
+      // One extra tick so the deadline has passed when the hook runs again
+      if (due_ms != UINT32_MAX && due_ms + portTICK_PERIOD_MS < wait)
+      {
+        wait = due_ms + portTICK_PERIOD_MS;
+      }
+    }
+    int len = self->transport_->read(buffer, sizeof(buffer), wait);
+    self->wakeups_ = self->wakeups_ + 1;
+
+    // Drain everything the transport has buffered before sleeping again
+    while (len > 0)
+    {
+      self->feed(buffer, static_cast<size_t>(len));
+      len = self->transport_->read(buffer, sizeof(buffer), 0);
+    }
+
+    // Responses produced by this batch go out in one flush
+    self->flush_tx();
+  }
 }
 
-void Esp32c6LinkPort::poll()
+void Esp32c6LinkPort::feed(const uint8_t* data, size_t len)
 {
   if (!link_)
   {
     return;
   }
 
-  // Read available data from USB Serial/JTAG (non-blocking)
-  uint8_t buffer[128];
-  int len = usb_serial_jtag_read_bytes(buffer, sizeof(buffer), 0);
+  if (len > rx_high_water_)
+  {
+    rx_high_water_ = len;
+  }
+  scanner_.feed(data, len);
+}
 
-  if (len > 0)
+void Esp32c6LinkPort::flush_tx()
+{
+  tx_.flush(0);
+}
+
+void Esp32c6LinkPort::lock()
+{
+  if (lock_ != nullptr)
   {
-    // Feed received bytes to V4-link
-    for (int i = 0; i < len; ++i)
+    lock_(lock_user_);
+  }
+}
+
+void Esp32c6LinkPort::unlock()
+{
+  if (unlock_ != nullptr)
+  {
+    unlock_(lock_user_);
+  }
+}
+
+void Esp32c6LinkPort::on_frame(void* user, const LinkFrameView& frame)
+{
+  auto* self = static_cast<Esp32c6LinkPort*>(user);
+  self->lock();
+  self->handle_frame(frame);
+  self->unlock();
+}
+
+void Esp32c6LinkPort::handle_frame(const LinkFrameView& frame)
+{
+  // Trace drains stay out of the trace they read
+  bool traced = frame.cmd != link_wire::CMD_TRACE;
+  if (traced)
+  {
+    trace_event(TRACE_LINK_RX, V4_TRACE_NO_TASK, frame.cmd, (uint32_t)frame.len);
+  }
+
+  // Runtime commands are answered here, straight into the TX ring
+  if (link_wire::is_runtime_cmd(frame.cmd))
+  {
+    size_t len = 0;
+    const uint8_t* resp = runtime_cmds_.handle(frame, &len);
+    if (traced)
     {
-      link_->feed_byte(buffer[i]);
+      trace_tx(resp, len);
     }
+    tx_.write(resp, len);
+    return;
+  }
+
+  // Core commands: V4-link only exposes byte-wise input, so replay the
+  // already delimited frame (including bad-CRC frames, which it NAKs).
+  // EXEC payloads go through the exec filter (peephole pass) first
+  v4::link::Link* link = route();
+  if (link == nullptr)
+  {
+    uint8_t nak[link_wire::OVERHEAD];
+    size_t len = link_wire::encode_frame(link_wire::STATUS_ERROR, nullptr, 0, nak);
+    trace_tx(nak, len);
+    tx_.write(nak, len);
+    return;
+  }
+  size_t raw_len = 0;
+  const uint8_t* raw = runtime_cmds_.filter_exec(frame, &raw_len);
+  for (size_t i = 0; i < raw_len; ++i)
+  {
+    link->feed_byte(raw[i]);
+  }
+
+  if (frame_hook_ != nullptr)
+  {
+    frame_hook_(frame_hook_user_);
   }
 }
 
+void Esp32c6LinkPort::attach_pool(VmPool* pool)
+{
+  pool_ = pool;
+  channel_ = 0;
+  runtime_cmds_.add(link_wire::CMD_VM_SELECT, handle_select, this);
+  runtime_cmds_.add(link_wire::CMD_VM_CTRL, VmPool::handle_command, pool);
+  ESP_LOGI(TAG, "VM pool attached (%u VMs, link cmds 0x%02X/0x%02X)",
+           (unsigned)pool->count(), link_wire::CMD_VM_SELECT, link_wire::CMD_VM_CTRL);
+}
+
+bool Esp32c6LinkPort::enable_window(size_t budget)
+{
+  if (window_)
+  {
+    return false;
+  }
+  window_ = std::make_unique<LinkWindow>(&runtime_cmds_, buffer_size_, budget);
+  if (window_->capacity() == 0)
+  {
+    window_.reset();
+    return false;
+  }
+  runtime_cmds_.add(link_wire::CMD_WINDOW, LinkWindow::handle_command, window_.get());
+  runtime_cmds_.add_caps(link_wire::CAP_LINK_WINDOW);
+  ESP_LOGI(TAG, "Windowed transfers enabled (%u frames, link cmd 0x%02X)",
+           (unsigned)window_->capacity(), link_wire::CMD_WINDOW);
+  return true;
+}
+
+// CMD_VM_SELECT: [id u8] -> [id u8][state u8]
+void Esp32c6LinkPort::handle_select(void* user, const LinkFrameView& frame,
+                                    LinkReply* reply)
+{
+  auto* self = static_cast<Esp32c6LinkPort*>(user);
+  if (self->pool_ == nullptr || frame.len < 1 || frame.payload[0] >= self->pool_->count())
+  {
+    reply->status = link_wire::STATUS_ERROR;
+    return;
+  }
+  self->channel_ = frame.payload[0];
+  reply->put_u8(self->channel_);
+  reply->put_u8(static_cast<uint8_t>(self->pool_->info(self->channel_).state));
+}
+
+v4::link::Link* Esp32c6LinkPort::route()
+{
+  if (pool_ == nullptr)
+  {
+    return link_.get();
+  }
+
+  // A faulted VM gets a fresh instance before it sees more code
+  const VmPool::Info& info = pool_->info(channel_);
+  if (info.state == VmPool::State::FAULTED)
+  {
+    V4_LOGW(TAG, "VM %u faulted (error %d), restarting", (unsigned)channel_,
+            (int)info.last_error);
+    pool_->restart(channel_);
+  }
+  Vm* vm = static_cast<Vm*>(pool_->vm(channel_));
+  if (vm == nullptr)
+  {
+    return nullptr;
+  }
+
+  // Rebind when the VM behind the channel was recreated
+  Channel& ch = channels_[channel_];
+  if (!ch.link || ch.generation != info.generation)
+  {
+    ch.link = std::make_unique<v4::link::Link>(vm, link_write_callback, &tx_,
+                                               buffer_size_);
+    ch.generation = info.generation;
+  }
+  return ch.link.get();
+}
+
 void Esp32c6LinkPort::reset()
 {
+  for (Channel& ch : channels_)
+  {
+    if (ch.link)
+    {
+      ch.link->reset();
+    }
+  }
   if (link_)
   {
     link_->reset();
-    ESP_LOGI(TAG, "V4-link reset");
+    scanner_.reset();
+    V4_LOGI(TAG, "V4-link reset");
   }
 }
 
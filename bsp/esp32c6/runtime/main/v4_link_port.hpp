@@ -1,18 +1,27 @@
-// V4-link port for ESP32-C6 USB Serial/JTAG
+// V4-link port for ESP32-C6
 //
-// Provides bytecode transfer over USB Serial/JTAG interface
+// Provides bytecode transfer over a LinkTransport (USB Serial/JTAG, UART)
 //
 // SPDX-License-Identifier: MIT OR Apache-2.0
 
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 
+#include "link_frame_scanner.hpp"
+#include "link_runtime_commands.hpp"
+#include "link_transport.hpp"
+#include "link_window.hpp"
+#include "tx_ring.hpp"
+#include "vm_pool.hpp"
+
 // Forward declarations
 extern "C"
 {
   typedef struct Vm Vm;
+  typedef struct tskTaskControlBlock* TaskHandle_t;
 }
 
 namespace v4
@@ -27,10 +36,16 @@ namespace v4rtos
 {
 
 /**
- * @brief V4-link port for ESP32-C6 USB Serial/JTAG
+ * @brief V4-link port for ESP32-C6
+ *
+ * Wraps V4-link protocol implementation on top of a LinkTransport.
+ * Runs either as its own FreeRTOS task that sleeps in the transport until
+ * it has data (start_task()), or polled from a loop (poll()).
+ * Responses are queued in a TxRing and flushed once per receive batch,
+ * so a slow or disconnected host cannot stall bytecode ingestion.
  *
- * Wraps V4-link protocol implementation and handles USB Serial/JTAG I/O.
- * Non-blocking design suitable for polling from main loop.
+ * Several ports, one per transport, may serve the same VMs; they must
+ * then share a frame lock (set_frame_lock()).
  */
 class Esp32c6LinkPort
 {
@@ -38,9 +53,10 @@ class Esp32c6LinkPort
   /**
    * @brief Construct V4-link port
    * @param vm V4 VM instance
+   * @param transport Byte transport (not owned; must outlive the port)
    * @param buffer_size V4-link receive buffer size (default: 512 bytes)
    */
-  Esp32c6LinkPort(Vm* vm, size_t buffer_size = 512);
+  Esp32c6LinkPort(Vm* vm, LinkTransport* transport, size_t buffer_size = 512);
 
   /**
    * @brief Destructor
@@ -50,11 +66,202 @@ class Esp32c6LinkPort
   /**
    * @brief Poll for incoming data (non-blocking)
    *
-   * Reads from USB Serial/JTAG and feeds bytes to V4-link.
+   * Reads from the transport and feeds the chunk to feed().
    * Should be called regularly from main loop.
    */
   void poll();
 
+  /**
+   * @brief Start the event-driven link task
+   *
+   * The task blocks in the transport until data arrives, then drains it
+   * completely before blocking again. No wakeups happen while the link
+   * is idle.
+   *
+   * @param priority FreeRTOS task priority
+   * @param stack_size Task stack size in bytes (VM code runs on this stack)
+   * @return true if the task was created
+   */
+  bool start_task(unsigned priority, size_t stack_size);
+
+  /**
+   * @brief Get link task handle (nullptr if not started)
+   */
+  TaskHandle_t task_handle() const
+  {
+    return task_;
+  }
+
+  /**
+   * @brief Get number of link task wakeups
+   */
+  uint32_t wakeups() const
+  {
+    return wakeups_;
+  }
+
+  /**
+   * @brief Feed a chunk of received bytes
+   *
+   * Frame boundaries are found in bulk by LinkFrameScanner. Frames that
+   * lie entirely inside @p data are dispatched in place; only frames
+   * split across chunks are staged.
+   *
+   * @param data Received bytes
+   * @param len Number of bytes
+   */
+  void feed(const uint8_t* data, size_t len);
+
+  /**
+   * @brief Register a handler for a runtime command (0x40..0x7F)
+   *
+   * Runtime commands are answered by the port itself; all other commands
+   * go to V4-link.
+   *
+   * @return false if @p cmd is out of range or already taken
+   */
+  bool add_runtime_command(uint8_t cmd, RuntimeCmdHandler handler, void* user)
+  {
+    return runtime_cmds_.add(cmd, handler, user);
+  }
+
+  /**
+   * @brief Advertise capability bits (link_wire::CAP_*) in CMD_CAPS
+   */
+  void add_caps(uint32_t caps)
+  {
+    runtime_cmds_.add_caps(caps);
+  }
+
+  /**
+   * @brief Set a filter applied to EXEC payloads before V4-link sees them
+   */
+  void set_exec_filter(ExecFilter filter, void* user)
+  {
+    runtime_cmds_.set_exec_filter(filter, user);
+  }
+
+  /**
+   * @brief Set a callback run after each core frame has been handled by V4-link
+   */
+  void set_frame_hook(void (*hook)(void* user), void* user)
+  {
+    frame_hook_ = hook;
+    frame_hook_user_ = user;
+  }
+
+  /**
+   * @brief Set a callback run by the link task on every wakeup
+   *
+   * The hook returns the milliseconds until it needs to run again
+   * (UINT32_MAX: only on traffic); the task's RX wait is capped to that
+   * instead of adding a periodic tick.
+   */
+  void set_timer_hook(uint32_t (*hook)(void* user), void* user)
+  {
+    timer_hook_ = hook;
+    timer_hook_user_ = user;
+  }
+
+  /**
+   * @brief Serialize frame handling with other ports
+   *
+   * Runtime commands, core frames and the timer hook run between
+   * @p lock and @p unlock, so ports on other tasks can share the VMs and
+   * command handlers. Not needed with a single port.
+   */
+  void set_frame_lock(void (*lock)(void* user), void (*unlock)(void* user), void* user)
+  {
+    lock_ = lock;
+    unlock_ = unlock;
+    lock_user_ = user;
+  }
+
+  /**
+   * @brief Serve the VMs of @p pool on separate channels
+   *
+   * Registers CMD_VM_SELECT (answered by the port) and CMD_VM_CTRL
+   * (VmPool::handle_command()). Core frames go to the selected VM,
+   * channel 0 until the host selects another, each through its own
+   * V4-link instance. A faulted VM is restarted before its next frame.
+   */
+  void attach_pool(VmPool* pool);
+
+  /**
+   * @brief Serve windowed transfers (CMD_WINDOW, LinkWindow)
+   *
+   * The window is @p budget / buffer_capacity() frames; CMD_CAPS then
+   * advertises CAP_LINK_WINDOW.
+   *
+   * @param budget Reorder buffer size (bytes)
+   * @return false if the budget holds no frame or a window exists
+   */
+  bool enable_window(size_t budget);
+
+  /**
+   * @brief Get the windowed transfer state (nullptr: not enabled)
+   */
+  const LinkWindow* window() const
+  {
+    return window_.get();
+  }
+
+  /**
+   * @brief Get the pool VM core frames currently go to
+   */
+  uint8_t channel() const
+  {
+    return channel_;
+  }
+
+  /**
+   * @brief Get largest single transport read (bytes)
+   */
+  size_t rx_high_water() const
+  {
+    return rx_high_water_;
+  }
+
+  /**
+   * @brief Get transport read buffer size (bytes)
+   */
+  static constexpr size_t rx_chunk_size()
+  {
+    return RX_CHUNK;
+  }
+
+  /**
+   * @brief Get TX ring capacity (bytes)
+   */
+  size_t tx_capacity() const
+  {
+    return tx_.capacity();
+  }
+
+  /**
+   * @brief Push queued responses to the transport (non-blocking)
+   *
+   * Called by poll() and the link task after each receive batch; callers
+   * using feed() directly must call it themselves.
+   */
+  void flush_tx();
+
+  /**
+   * @brief Get number of response bytes waiting to be sent
+   */
+  size_t tx_pending() const
+  {
+    return tx_.pending();
+  }
+
+  /**
+   * @brief Get TX ring counters (queued, flushed, dropped)
+   */
+  const TxRing::Stats& tx_stats() const
+  {
+    return tx_.stats();
+  }
+
   /**
    * @brief Reset V4-link state
    */
@@ -66,9 +273,62 @@ class Esp32c6LinkPort
    */
   size_t buffer_capacity() const;
 
+  /**
+   * @brief Get the transport the port reads from and writes to
+   */
+  LinkTransport* transport() const
+  {
+    return transport_;
+  }
+
+  /**
+   * @brief Get frame scanner counters
+   */
+  const LinkFrameScanner::Stats& scanner_stats() const
+  {
+    return scanner_.stats();
+  }
+
  private:
-  std::unique_ptr<v4::link::Link> link_;        ///< V4-link instance
-  static constexpr size_t USB_BUF_SIZE = 1024;  ///< USB driver buffer size
+  /** V4-link instance of one pool VM */
+  struct Channel
+  {
+    std::unique_ptr<v4::link::Link> link;  ///< Link bound to the VM
+    uint32_t generation = 0;               ///< VmPool generation it was built for
+  };
+
+  static void on_frame(void* user, const LinkFrameView& frame);
+  void handle_frame(const LinkFrameView& frame);
+  static void handle_select(void* user, const LinkFrameView& frame, LinkReply* reply);
+  v4::link::Link* route();
+  void lock();
+  void unlock();
+  static void task_entry(void* arg);
+
+  LinkTransport* transport_;                      ///< Byte transport
+  std::unique_ptr<v4::link::Link> link_;          ///< V4-link instance
+  LinkFrameScanner scanner_;                      ///< Bulk frame scanner
+  TxRing tx_;                                     ///< Outbound response ring
+  LinkRuntimeCommands runtime_cmds_;              ///< Runtime command handlers
+  void (*frame_hook_)(void*) = nullptr;           ///< Post-frame callback
+  void* frame_hook_user_ = nullptr;               ///< Post-frame callback user
+  uint32_t (*timer_hook_)(void*) = nullptr;       ///< Link task wakeup callback
+  void* timer_hook_user_ = nullptr;               ///< Wakeup callback user
+  void (*lock_)(void*) = nullptr;                 ///< Frame lock (shared VMs)
+  void (*unlock_)(void*) = nullptr;               ///< Frame unlock
+  void* lock_user_ = nullptr;                     ///< Frame lock user
+  size_t rx_high_water_ = 0;                      ///< Largest single read
+  size_t buffer_size_;                            ///< V4-link buffer size
+  VmPool* pool_ = nullptr;                        ///< VM pool (nullptr: single VM)
+  uint8_t channel_ = 0;                           ///< Selected pool VM
+  Channel channels_[VmPool::MAX_VMS];             ///< Per-VM links (pool mode)
+  std::unique_ptr<LinkWindow> window_;            ///< Windowed transfers
+  TaskHandle_t task_ = nullptr;                   ///< Link task (event-driven mode)
+  volatile uint32_t wakeups_ = 0;                 ///< Link task wakeup counter
+  static constexpr size_t RX_CHUNK = 512;         ///< Bytes read per poll
+  static constexpr size_t TX_RING_SIZE = 2048;    ///< Outbound ring size
+  static constexpr uint32_t TX_MAX_WAIT_MS = 20;  ///< Longest wait before a drop
+  static constexpr uint32_t TX_RETRY_MS = 10;     ///< Retry period with TX pending
 };
 
 }  // namespace v4rtos
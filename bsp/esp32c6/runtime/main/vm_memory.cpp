@@ -0,0 +1,187 @@
+// VM memory layout implementation for ESP32-C6
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#include "vm_memory.hpp"
+
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "mem_watermark.hpp"
+#include "sdkconfig.h"
+
+static const char* TAG = "VmMemory";
+
+// ==============================================================================
+// Build Configuration
+// ==============================================================================
+
+#define VM_ARENA_SIZE (CONFIG_V4_VM_ARENA_SIZE_KB * 1024)
+
+#if defined(CONFIG_V4_VM_ARENA_PLACEMENT_HEAP)
+#define VM_ARENA_PLACEMENT v4rtos::MemPlacement::HEAP
+#elif defined(CONFIG_V4_VM_ARENA_PLACEMENT_RTC)
+#define VM_ARENA_PLACEMENT v4rtos::MemPlacement::RTC_FAST
+#elif defined(CONFIG_V4_VM_ARENA_PLACEMENT_PSRAM)
+#define VM_ARENA_PLACEMENT v4rtos::MemPlacement::PSRAM
+#else
+#define VM_ARENA_PLACEMENT v4rtos::MemPlacement::STATIC
+#endif
+
+#define NAME_ARENA_SIZE (CONFIG_V4_NAME_ARENA_SIZE_KB * 1024)
+
+#if defined(CONFIG_V4_NAME_ARENA_PLACEMENT_HEAP)
+#define NAME_ARENA_PLACEMENT v4rtos::MemPlacement::HEAP
+#elif defined(CONFIG_V4_NAME_ARENA_PLACEMENT_RTC)
+#define NAME_ARENA_PLACEMENT v4rtos::MemPlacement::RTC_FAST
+#elif defined(CONFIG_V4_NAME_ARENA_PLACEMENT_PSRAM)
+#define NAME_ARENA_PLACEMENT v4rtos::MemPlacement::PSRAM
+#else
+#define NAME_ARENA_PLACEMENT v4rtos::MemPlacement::STATIC
+#endif
+
+// Static storage only exists for arenas placed in .bss
+#if defined(CONFIG_V4_VM_ARENA_PLACEMENT_STATIC)
+static uint8_t vm_arena_static[VM_ARENA_SIZE] __attribute__((aligned(4)));
+#endif
+#if NAME_ARENA_SIZE > 0 && defined(CONFIG_V4_NAME_ARENA_PLACEMENT_STATIC)
+static uint8_t name_arena_static[NAME_ARENA_SIZE] __attribute__((aligned(4)));
+#endif
+
+namespace v4rtos
+{
+
+static uint32_t heap_caps_for(MemPlacement placement)
+{
+  switch (placement)
+  {
+    case MemPlacement::RTC_FAST:
+      return MALLOC_CAP_RTCRAM;
+    case MemPlacement::PSRAM:
+      return MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT;
+    default:
+      return MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+  }
+}
+
+static uint8_t* alloc_region(MemPlacement placement, uint8_t* static_buf, size_t size)
+{
+  if (placement == MemPlacement::STATIC)
+  {
+    return static_buf;
+  }
+  return static_cast<uint8_t*>(
+      heap_caps_aligned_alloc(4, size, heap_caps_for(placement)));
+}
+
+const char* mem_placement_name(MemPlacement placement)
+{
+  switch (placement)
+  {
+    case MemPlacement::STATIC:
+      return "static";
+    case MemPlacement::HEAP:
+      return "heap";
+    case MemPlacement::RTC_FAST:
+      return "rtc-fast";
+    case MemPlacement::PSRAM:
+      return "psram";
+  }
+  return "?";
+}
+
+int vm_memory_init(VmMemoryLayout* layout)
+{
+  uint8_t* vm_static = nullptr;
+  uint8_t* name_static = nullptr;
+#if defined(CONFIG_V4_VM_ARENA_PLACEMENT_STATIC)
+  vm_static = vm_arena_static;
+#endif
+#if NAME_ARENA_SIZE > 0 && defined(CONFIG_V4_NAME_ARENA_PLACEMENT_STATIC)
+  name_static = name_arena_static;
+#endif
+
+  *layout = VmMemoryLayout{};
+
+  // VM arena
+  layout->vm_placement = VM_ARENA_PLACEMENT;
+  layout->vm_arena_size = VM_ARENA_SIZE;
+  layout->vm_arena = alloc_region(layout->vm_placement, vm_static, VM_ARENA_SIZE);
+  if (layout->vm_arena == nullptr)
+  {
+    ESP_LOGE(TAG, "Failed to allocate %d KB VM arena (%s)", VM_ARENA_SIZE / 1024,
+             mem_placement_name(layout->vm_placement));
+    return -1;
+  }
+  mem_paint(layout->vm_arena, layout->vm_arena_size);
+
+  // Word name arena (optional)
+  layout->name_placement = NAME_ARENA_PLACEMENT;
+  if (NAME_ARENA_SIZE > 0)
+  {
+    layout->name_buf_size = NAME_ARENA_SIZE;
+    layout->name_buf = alloc_region(layout->name_placement, name_static, NAME_ARENA_SIZE);
+    if (layout->name_buf == nullptr)
+    {
+      ESP_LOGE(TAG, "Failed to allocate %d KB name arena (%s)", NAME_ARENA_SIZE / 1024,
+               mem_placement_name(layout->name_placement));
+      return -1;
+    }
+    mem_paint(layout->name_buf, layout->name_buf_size);
+    v4_arena_init(&layout->name_arena, layout->name_buf, layout->name_buf_size);
+  }
+
+  return 0;
+}
+
+V4Arena* vm_memory_name_arena(VmMemoryLayout* layout)
+{
+  return layout->name_buf != nullptr ? &layout->name_arena : nullptr;
+}
+
+V4Arena* vm_memory_reset_name_arena(VmMemoryLayout* layout)
+{
+  if (layout->name_buf == nullptr)
+  {
+    return nullptr;
+  }
+  mem_paint(layout->name_buf, layout->name_buf_size);
+  v4_arena_init(&layout->name_arena, layout->name_buf, layout->name_buf_size);
+  return &layout->name_arena;
+}
+
+static void report_heap(const char* name, uint32_t caps)
+{
+  size_t total = heap_caps_get_total_size(caps);
+  if (total == 0)
+  {
+    return;  // Region not present in this configuration
+  }
+  size_t free_bytes = heap_caps_get_free_size(caps);
+  ESP_LOGI(TAG, "  %-9s heap: %6u / %6u bytes used (largest free block: %u)", name,
+           (unsigned)(total - free_bytes), (unsigned)total,
+           (unsigned)heap_caps_get_largest_free_block(caps));
+}
+
+void vm_memory_report(const VmMemoryLayout& layout)
+{
+  ESP_LOGI(TAG, "VM memory layout:");
+  ESP_LOGI(TAG, "  VM arena:   %6u bytes  %-8s @ %p", (unsigned)layout.vm_arena_size,
+           mem_placement_name(layout.vm_placement), layout.vm_arena);
+  if (layout.name_buf != nullptr)
+  {
+    ESP_LOGI(TAG, "  Name arena: %6u bytes  %-8s @ %p", (unsigned)layout.name_buf_size,
+             mem_placement_name(layout.name_placement), layout.name_buf);
+  }
+  else
+  {
+    ESP_LOGI(TAG, "  Name arena: none (word names use malloc)");
+  }
+
+  // Heap regions after the arenas have been carved out
+  ESP_LOGI(TAG, "Memory regions:");
+  report_heap("internal", MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  report_heap("rtc-fast", MALLOC_CAP_RTCRAM);
+  report_heap("psram", MALLOC_CAP_SPIRAM);
+}
+
+}  // namespace v4rtos
@@ -0,0 +1,78 @@
+// VM memory layout for ESP32-C6
+//
+// Allocates the VM arena and the word name arena in the regions selected
+// in menuconfig ("V4 Runtime" -> "VM memory") and reports region usage.
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "v4/arena.h"
+
+namespace v4rtos
+{
+
+/** Memory region an arena is placed in */
+enum class MemPlacement
+{
+  STATIC,    ///< .bss, reserved at link time
+  HEAP,      ///< Internal SRAM heap
+  RTC_FAST,  ///< RTC (LP) fast memory heap
+  PSRAM      ///< External PSRAM heap
+};
+
+/**
+ * @brief VM memory layout
+ *
+ * Filled by vm_memory_init() from the build configuration. Both arenas
+ * are painted with the watermark pattern (mem_watermark.hpp) so their
+ * high-water marks can be measured later.
+ */
+struct VmMemoryLayout
+{
+  uint8_t* vm_arena;            ///< VmConfig.mem
+  uint32_t vm_arena_size;       ///< VmConfig.mem_size
+  MemPlacement vm_placement;    ///< VM arena region
+  uint8_t* name_buf;            ///< Name arena backing store (nullptr: malloc)
+  size_t name_buf_size;         ///< Name arena size
+  MemPlacement name_placement;  ///< Name arena region
+  V4Arena name_arena;           ///< V4Arena over name_buf
+};
+
+/**
+ * @brief Allocate VM and name arenas
+ * @param layout Layout to fill
+ * @return 0 on success, -1 if an arena could not be allocated
+ */
+int vm_memory_init(VmMemoryLayout* layout);
+
+/**
+ * @brief Get word name arena for VmConfig.arena
+ * @return Name arena, or nullptr to let the VM use malloc
+ */
+V4Arena* vm_memory_name_arena(VmMemoryLayout* layout);
+
+/**
+ * @brief Empty the word name arena for a recreated VM
+ *
+ * Repaints the backing store and re-initializes the V4Arena; names of the
+ * previous VM are gone afterwards.
+ *
+ * @return Name arena, or nullptr to let the VM use malloc
+ */
+V4Arena* vm_memory_reset_name_arena(VmMemoryLayout* layout);
+
+/**
+ * @brief Log the layout and per-region heap usage
+ */
+void vm_memory_report(const VmMemoryLayout& layout);
+
+/**
+ * @brief Get printable region name
+ */
+const char* mem_placement_name(MemPlacement placement);
+
+}  // namespace v4rtos
@@ -0,0 +1,219 @@
+/**
+ * @file ddt_bench.cpp
+ * @brief Device lookup: virtual provider + linear scan vs. constant DdtIndex
+ *
+ * Every device SYS call (LED-SET, ...) first resolves its (kind, role,
+ * index) to a descriptor. Compared here, for boards of 2 (NanoC6), 16 and
+ * 64 devices:
+ * - scan:  V4-std's default; DdtProvider::get_devices() through a virtual
+ *          call, then a linear search of the returned span
+ * - index: v4_ddt_lookup(); DdtIndex built by the compiler, one hash and
+ *          (without collisions) one compare
+ *
+ * Lookups cycle through every device of the board plus one absent device,
+ * so misses (a scan of the whole table) are included. Both must return
+ * the same descriptor for every key.
+ *
+ * Usage:
+ *   v4-bench-ddt [--lookups N]
+ *
+ * SPDX-License-Identifier: MIT OR Apache-2.0
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "ddt_index.hpp"
+
+using v4rtos::DdtIndex;
+
+/** v4dev_desc_t */
+struct DevDesc
+{
+  uint8_t kind;     ///< Device kind (LED, BUTTON, ...)
+  uint8_t role;     ///< Role (STATUS, USER, ...)
+  uint8_t index;    ///< Instance of the same kind and role
+  uint8_t flags;    ///< V4DEV_FLAG_*
+  uint32_t handle;  ///< Pin or peripheral number
+};
+
+/** Descriptor table of a simulated board */
+template <size_t N>
+struct Board
+{
+  DevDesc devices[N];  ///< Descriptors
+};
+
+// Devices of eight kinds in four roles, as on a board with Grove I2C,
+// ADC channels and RGB LEDs
+template <size_t N>
+static constexpr Board<N> make_board()
+{
+  Board<N> board = {};
+  for (size_t i = 0; i < N; i++)
+  {
+    board.devices[i].kind = (uint8_t)(1 + i % 8);
+    board.devices[i].role = (uint8_t)(1 + (i / 8) % 4);
+    board.devices[i].index = (uint8_t)(i / 32);
+    board.devices[i].handle = (uint32_t)i;
+  }
+  return board;
+}
+
+static constexpr Board<2> BOARD2 = make_board<2>();
+static constexpr Board<16> BOARD16 = make_board<16>();
+static constexpr Board<64> BOARD64 = make_board<64>();
+static constexpr auto INDEX2 = v4rtos::make_ddt_index(BOARD2.devices);
+static constexpr auto INDEX16 = v4rtos::make_ddt_index(BOARD16.devices);
+static constexpr auto INDEX64 = v4rtos::make_ddt_index(BOARD64.devices);
+static_assert(INDEX2.valid() && INDEX16.valid() && INDEX64.valid(), "duplicate device");
+
+/** v4std::span */
+struct DevSpan
+{
+  const DevDesc* ptr;  ///< First descriptor
+  size_t n;            ///< Number of descriptors
+};
+
+/** v4std::DdtProvider */
+class Provider
+{
+ public:
+  virtual ~Provider() = default;
+  virtual DevSpan get_devices() const = 0;
+};
+
+/** Board provider returning its static table */
+class BoardProvider : public Provider
+{
+ public:
+  BoardProvider(const DevDesc* devices, size_t n) : devices_(devices), n_(n) {}
+
+  DevSpan get_devices() const override
+  {
+    return DevSpan{devices_, n_};
+  }
+
+ private:
+  const DevDesc* devices_;  ///< Descriptor table
+  size_t n_;                ///< Number of descriptors
+};
+
+static const Provider* volatile s_provider = nullptr;
+static uint64_t s_compares = 0;
+
+// V4-std Ddt::find() without V4STD_DDT_LOOKUP
+__attribute__((noinline)) static const DevDesc* scan_find(uint8_t kind, uint8_t role,
+                                                          uint8_t index)
+{
+  DevSpan devices = s_provider->get_devices();
+  for (size_t i = 0; i < devices.n; i++)
+  {
+    s_compares++;
+    const DevDesc& d = devices.ptr[i];
+    if (d.kind == kind && d.role == role && d.index == index)
+    {
+      return &d;
+    }
+  }
+  return nullptr;
+}
+
+/** Lookup method under test */
+typedef const DevDesc* (*FindFn)(uint8_t kind, uint8_t role, uint8_t index);
+
+/** Result of one board and method */
+struct Result
+{
+  double ns_per_lookup;  ///< Wall time per lookup
+  uint64_t checksum;     ///< Sum of the found handles (+1 each)
+};
+
+template <size_t N>
+static Result run(FindFn find, const Board<N>& board, uint32_t lookups)
+{
+  // Every device, then one the board does not have
+  DevDesc keys[N + 1];
+  memcpy(keys, board.devices, sizeof(board.devices));
+  keys[N] = DevDesc{0xEE, 0xEE, 0xEE, 0, 0};
+
+  uint64_t checksum = 0;
+  size_t k = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t n = 0; n < lookups; n++)
+  {
+    const DevDesc* d = find(keys[k].kind, keys[k].role, keys[k].index);
+    checksum += d != nullptr ? d->handle + 1 : 0;
+    k = k == N ? 0 : k + 1;
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  double ns =
+      (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+  return Result{ns / lookups, checksum};
+}
+
+template <size_t N, const DdtIndex<DevDesc, N>& INDEX>
+__attribute__((noinline)) static const DevDesc* index_find(uint8_t kind, uint8_t role,
+                                                           uint8_t index)
+{
+  return INDEX.find(kind, role, index);
+}
+
+template <size_t N, const DdtIndex<DevDesc, N>& INDEX>
+static bool bench_board(const Board<N>& board, uint32_t lookups)
+{
+  BoardProvider provider(board.devices, N);
+  s_provider = &provider;
+  s_compares = 0;
+  Result scan = run(scan_find, board, lookups);
+  double compares = (double)s_compares / lookups;
+  Result index = run(index_find<N, INDEX>, board, lookups);
+
+  printf("%7u %-6s %10.2f %12.1f %10s\n", (unsigned)N, "scan", scan.ns_per_lookup,
+         compares, "-");
+  printf("%7u %-6s %10.2f %12s %10u %7.2fx\n", (unsigned)N, "index", index.ns_per_lookup,
+         "-", (unsigned)INDEX.max_probe(),
+         index.ns_per_lookup > 0 ? scan.ns_per_lookup / index.ns_per_lookup : 0.0);
+
+  if (scan.checksum != index.checksum)
+  {
+    fprintf(stderr, "%u devices: scan and index found different devices\n", (unsigned)N);
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char** argv)
+{
+  long lookups = 10000000;
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--lookups") == 0 && i + 1 < argc)
+    {
+      lookups = atol(argv[++i]);
+    }
+    else
+    {
+      fprintf(stderr, "Usage: %s [--lookups N]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (lookups <= 0 || lookups > 1000000000)
+  {
+    fprintf(stderr, "Invalid --lookups\n");
+    return 2;
+  }
+
+  printf("%ld lookups per run (every device, then one absent)\n\n", lookups);
+  printf("%7s %-6s %10s %12s %10s %8s\n", "devices", "method", "ns/lookup",
+         "compares/op", "max probe", "speedup");
+  bool same = bench_board<2, INDEX2>(BOARD2, (uint32_t)lookups);
+  same = bench_board<16, INDEX16>(BOARD16, (uint32_t)lookups) && same;
+  same = bench_board<64, INDEX64>(BOARD64, (uint32_t)lookups) && same;
+  return same ? 0 : 1;
+}
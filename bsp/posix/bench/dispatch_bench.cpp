@@ -0,0 +1,160 @@
+/**
+ * @file dispatch_bench.cpp
+ * @brief VM dispatch benchmark (switch vs. computed goto, -Os vs. -O2)
+ *
+ * Runs bytecode shaped like the tools/examples programs through a
+ * minimal V4-style interpreter built four ways:
+ *
+ * - switch dispatch, -Os (the runtime's default build)
+ * - computed-goto (direct-threaded) dispatch, -Os
+ * - switch dispatch, -O2
+ * - computed-goto dispatch, -O2 (CONFIG_V4_VM_DISPATCH_THREADED +
+ *   CONFIG_V4_VM_CORE_O2)
+ *
+ * Delays are left out so the loops measure interpreter overhead only.
+ *
+ * Usage:
+ *   v4-bench-dispatch [--iterations N] [--runs N]
+ *
+ * SPDX-License-Identifier: MIT OR Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <time.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "dispatch_bench_programs.hpp"
+#include "dispatch_bench_vm.hpp"
+
+using namespace v4bench;
+
+// ==============================================================================
+// Timing
+// ==============================================================================
+
+static double now_seconds(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/** One interpreter build */
+struct Variant
+{
+  const char* name;  ///< Report label
+  RunFn run;         ///< Entry point
+};
+
+/**
+ * @brief Best-of-N wall time for one workload on one variant
+ */
+static double time_run(const Variant& v, const Workload& w, int runs, BenchVm* vm,
+                       int* status)
+{
+  double best = 0;
+  for (int r = 0; r < runs; r++)
+  {
+    vm->sys_calls = 0;
+    vm->sys_checksum = 0;
+    double t0 = now_seconds();
+    *status = v.run(vm, w.code.data(), w.entry);
+    double dt = now_seconds() - t0;
+    if (r == 0 || dt < best)
+    {
+      best = dt;
+    }
+  }
+  return best;
+}
+
+int main(int argc, char** argv)
+{
+  int32_t iterations = 200000;
+  int runs = 5;
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+    {
+      iterations = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc)
+    {
+      runs = atoi(argv[++i]);
+    }
+    else
+    {
+      fprintf(stderr, "Usage: %s [--iterations N] [--runs N]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (iterations <= 0 || runs <= 0)
+  {
+    fprintf(stderr, "Invalid --iterations/--runs\n");
+    return 2;
+  }
+
+  const Variant variants[] = {
+      {"switch -Os", run_switch_os},
+      {"threaded -Os", run_threaded_os},
+      {"switch -O2", run_switch_o2},
+      {"threaded -O2", run_threaded_o2},
+  };
+  const Workload workloads[] = {make_blink(iterations), make_hello(iterations / 4),
+                                make_fib(iterations / 4), make_branchy(iterations * 8)};
+
+  static BenchVm vm;
+  int failures = 0;
+
+  printf("VM dispatch: best of %d runs, times in ms\n", runs);
+  printf("%-8s", "");
+  for (const Variant& v : variants)
+  {
+    printf(" %14s", v.name);
+  }
+  printf(" %10s\n", "speedup");
+
+  for (const Workload& w : workloads)
+  {
+    double base = 0;
+    double best = 0;
+    uint64_t ref_calls = 0;
+    uint64_t ref_checksum = 0;
+    int32_t ref_depth = 0;
+
+    printf("%-8s", w.name);
+    for (size_t i = 0; i < sizeof(variants) / sizeof(variants[0]); i++)
+    {
+      int status = 0;
+      double t = time_run(variants[i], w, runs, &vm, &status);
+      printf(" %14.2f", t * 1e3);
+
+      // Every variant must compute the same result
+      if (i == 0)
+      {
+        base = t;
+        ref_calls = vm.sys_calls;
+        ref_checksum = vm.sys_checksum;
+        ref_depth = vm.depth;
+      }
+      else if (vm.sys_calls != ref_calls || vm.sys_checksum != ref_checksum ||
+               vm.depth != ref_depth)
+      {
+        fprintf(stderr, "\nMISMATCH: %s on %s\n", w.name, variants[i].name);
+        failures++;
+      }
+      if (status != BENCH_OK)
+      {
+        fprintf(stderr, "\nERROR %d: %s on %s\n", status, w.name, variants[i].name);
+        failures++;
+      }
+      best = i == 0 || t < best ? t : best;
+    }
+    printf(" %9.2fx   %s\n", best > 0 ? base / best : 0.0, w.source);
+  }
+
+  return failures == 0 ? 0 : 1;
+}
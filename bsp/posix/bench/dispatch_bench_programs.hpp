@@ -0,0 +1,317 @@
+/**
+ * @file dispatch_bench_programs.hpp
+ * @brief Bytecode assembler and workloads for the bench VM
+ *
+ * Programs are shaped like tools/examples (blink.fth, hello.fth,
+ * multitask.fth) and shared by the dispatch and peephole benchmarks.
+ *
+ * SPDX-License-Identifier: MIT OR Apache-2.0
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "dispatch_bench_vm.hpp"
+
+namespace v4bench
+{
+
+// ==============================================================================
+// Bytecode assembler
+// ==============================================================================
+
+/**
+ * @brief Tiny assembler with forward-patched branches
+ */
+class Assembler
+{
+ public:
+  size_t here() const
+  {
+    return code_.size();
+  }
+
+  void op(Op o)
+  {
+    code_.push_back(o);
+  }
+
+  void lit(int32_t v)
+  {
+    op_i32(OP_LIT, v);
+  }
+
+  /** Opcode with an inline int32 (LIT, LIT_ADD, DELAY_LIT) */
+  void op_i32(Op o, int32_t v)
+  {
+    op(o);
+    for (int i = 0; i < 4; i++)
+    {
+      code_.push_back(static_cast<uint8_t>(static_cast<uint32_t>(v) >> (8 * i)));
+    }
+  }
+
+  void sys(uint8_t id)
+  {
+    op(OP_SYS);
+    code_.push_back(id);
+  }
+
+  void call(size_t target)
+  {
+    op(OP_CALL);
+    u16(static_cast<uint16_t>(target));
+  }
+
+  /** Branch back to @p target (JMP, JZ or LOOP) */
+  void branch(Op o, size_t target)
+  {
+    op(o);
+    u16(static_cast<uint16_t>(target - (here() + 2)));
+  }
+
+  /** Forward branch; returns the operand offset for patch() */
+  size_t branch_forward(Op o)
+  {
+    op(o);
+    u16(0);
+    return here() - 2;
+  }
+
+  void patch(size_t at)
+  {
+    uint16_t off = static_cast<uint16_t>(here() - (at + 2));
+    code_[at] = static_cast<uint8_t>(off);
+    code_[at + 1] = static_cast<uint8_t>(off >> 8);
+  }
+
+  const std::vector<uint8_t>& code() const
+  {
+    return code_;
+  }
+
+ private:
+  void u16(uint16_t v)
+  {
+    code_.push_back(static_cast<uint8_t>(v));
+    code_.push_back(static_cast<uint8_t>(v >> 8));
+  }
+
+  std::vector<uint8_t> code_;
+};
+
+// ==============================================================================
+// Workloads
+// ==============================================================================
+
+constexpr uint8_t SYS_TASK_DELAY = 1;   // ( ms -- )
+constexpr uint8_t SYS_GPIO_WRITE = 21;  // ( pin value -- )
+constexpr uint8_t SYS_UART_WRITE = 30;  // ( char -- ), stands in for EMIT
+
+/** One compiled workload */
+struct Workload
+{
+  const char* name;           ///< Short name
+  const char* source;         ///< Forth equivalent (for the report)
+  std::vector<uint8_t> code;  ///< Bytecode
+  size_t entry;               ///< Entry point
+};
+
+/**
+ * blink.fth: LED-ON / LED-OFF words called from a counted loop
+ *
+ *   : LED-ON  7 1 GPIO-WRITE ;  : LED-OFF  7 0 GPIO-WRITE ;
+ *   : BLINK  ( n -- ) 0 DO LED-ON LED-OFF LOOP ;
+ */
+inline Workload make_blink(int32_t n)
+{
+  Assembler a;
+  size_t led_on = a.here();
+  a.lit(7);
+  a.lit(1);
+  a.sys(SYS_GPIO_WRITE);
+  a.op(OP_RET);
+  size_t led_off = a.here();
+  a.lit(7);
+  a.lit(0);
+  a.sys(SYS_GPIO_WRITE);
+  a.op(OP_RET);
+
+  size_t entry = a.here();
+  a.lit(n);
+  a.lit(0);
+  a.op(OP_DO);
+  size_t body = a.here();
+  a.call(led_on);
+  a.call(led_off);
+  a.branch(OP_LOOP, body);
+  a.op(OP_HALT);
+  return {"blink", ": BLINK 0 DO LED-ON LED-OFF LOOP ;", a.code(), entry};
+}
+
+/**
+ * hello.fth: string output, one EMIT per character
+ *
+ *   : HELLO  ." Hello from V4 RTOS!" CR ;
+ *   : HELLOS ( n -- ) 0 DO HELLO LOOP ;
+ */
+inline Workload make_hello(int32_t n)
+{
+  static const char MSG[] = "Hello from V4 RTOS!\n";
+
+  Assembler a;
+  size_t hello = a.here();
+  for (const char* c = MSG; *c != '\0'; c++)
+  {
+    a.lit(*c);
+    a.sys(SYS_UART_WRITE);
+  }
+  a.op(OP_RET);
+
+  size_t entry = a.here();
+  a.lit(n);
+  a.lit(0);
+  a.op(OP_DO);
+  size_t body = a.here();
+  a.call(hello);
+  a.branch(OP_LOOP, body);
+  a.op(OP_HALT);
+  return {"hello", ": HELLOS 0 DO HELLO LOOP ;", a.code(), entry};
+}
+
+/**
+ * Arithmetic kernel: iterative Fibonacci inside a counted loop
+ *
+ *   : FIB ( n -- f ) 0 1 ROT 0 DO OVER + SWAP LOOP DROP ;
+ *   : FIBS ( n -- ) 0 DO 30 FIB DROP LOOP ;
+ */
+inline Workload make_fib(int32_t n)
+{
+  Assembler a;
+  size_t fib = a.here();
+  a.lit(0);
+  a.lit(1);
+  a.op(OP_ROT);
+  a.lit(0);
+  a.op(OP_DO);
+  size_t inner = a.here();
+  a.op(OP_OVER);
+  a.op(OP_ADD);
+  a.op(OP_SWAP);
+  a.branch(OP_LOOP, inner);
+  a.op(OP_DROP);
+  a.op(OP_RET);
+
+  size_t entry = a.here();
+  a.lit(n);
+  a.lit(0);
+  a.op(OP_DO);
+  size_t body = a.here();
+  a.lit(30);
+  a.call(fib);
+  a.op(OP_DROP);
+  a.branch(OP_LOOP, body);
+  a.op(OP_HALT);
+  return {"fib", ": FIBS 0 DO 30 FIB DROP LOOP ;", a.code(), entry};
+}
+
+/**
+ * multitask.fth task body: countdown with a conditional branch
+ *
+ *   : TICK ( n -- ) BEGIN DUP 1 AND IF 7 1 GPIO-WRITE THEN 1 - DUP 0< UNTIL DROP ;
+ */
+inline Workload make_branchy(int32_t n)
+{
+  Assembler a;
+  size_t entry = a.here();
+  a.lit(n);
+  size_t top = a.here();
+  a.op(OP_DUP);
+  a.lit(1);
+  a.op(OP_AND);
+  size_t skip = a.branch_forward(OP_JZ);
+  a.lit(7);
+  a.lit(1);
+  a.sys(SYS_GPIO_WRITE);
+  a.patch(skip);
+  a.lit(1);
+  a.op(OP_SUB);
+  a.op(OP_DUP);
+  a.lit(0);
+  a.op(OP_LT);
+  a.branch(OP_JZ, top);
+  a.op(OP_DROP);
+  a.op(OP_HALT);
+  return {"branchy", ": TICK BEGIN .. IF .. THEN 1 - DUP 0< UNTIL ;", a.code(), entry};
+}
+
+/**
+ * multitask.fth TASK1, bounded: string output, a delay and a countdown
+ *
+ *   : TASK1 ( n -- )
+ *     BEGIN ." [Task 1] Running..." CR 1000 DELAY 1 - DUP 0< UNTIL DROP ;
+ */
+inline Workload make_task1(int32_t n)
+{
+  static const char MSG[] = "[Task 1] Running...\n";
+
+  Assembler a;
+  size_t entry = a.here();
+  a.lit(n);
+  size_t top = a.here();
+  for (const char* c = MSG; *c != '\0'; c++)
+  {
+    a.lit(*c);
+    a.sys(SYS_UART_WRITE);
+  }
+  a.lit(1000);
+  a.sys(SYS_TASK_DELAY);
+  a.lit(1);
+  a.op(OP_SUB);
+  a.op(OP_DUP);
+  a.lit(0);
+  a.op(OP_LT);
+  a.branch(OP_JZ, top);
+  a.op(OP_DROP);
+  a.op(OP_HALT);
+  return {"task1", ": TASK1 BEGIN .\" ..\" CR 1000 DELAY 1 - DUP 0< UNTIL ;", a.code(),
+          entry};
+}
+
+/**
+ * Accumulator loop with an increment and a DUP IF
+ *
+ *   : ACC ( n -- x ) 0 SWAP 0 DO 3 + DUP 7 AND DUP IF + ELSE DROP THEN LOOP ;
+ */
+inline Workload make_acc(int32_t n)
+{
+  Assembler a;
+  size_t entry = a.here();
+  a.lit(n);
+  a.lit(0);
+  a.op(OP_SWAP);
+  a.lit(0);
+  a.op(OP_DO);
+  size_t body = a.here();
+  a.lit(3);
+  a.op(OP_ADD);
+  a.op(OP_DUP);
+  a.lit(7);
+  a.op(OP_AND);
+  a.op(OP_DUP);
+  size_t to_else = a.branch_forward(OP_JZ);
+  a.op(OP_ADD);
+  size_t to_then = a.branch_forward(OP_JMP);
+  a.patch(to_else);
+  a.op(OP_DROP);
+  a.patch(to_then);
+  a.branch(OP_LOOP, body);
+  a.op(OP_HALT);
+  return {"acc", ": ACC 0 DO 3 + DUP 7 AND DUP IF + ELSE DROP THEN LOOP ;", a.code(),
+          entry};
+}
+
+}  // namespace v4bench
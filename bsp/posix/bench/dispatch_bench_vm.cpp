@@ -0,0 +1,153 @@
+/**
+ * @file dispatch_bench_vm.cpp
+ * @brief Switch and computed-goto interpreters for the dispatch benchmark
+ *
+ * Compiled three times by CMake (-Os, -O2 and a dispatch-counting -O2
+ * copy); BENCH_SUFFIX selects the function names of each copy.
+ *
+ * SPDX-License-Identifier: MIT OR Apache-2.0
+ */
+
+#include <cstring>
+
+#include "dispatch_bench_vm.hpp"
+
+#ifndef BENCH_SUFFIX
+#error "BENCH_SUFFIX must be defined (os, o2 or count)"
+#endif
+
+#define BENCH_CAT2(a, b) a##_##b
+#define BENCH_CAT(a, b) BENCH_CAT2(a, b)
+#define BENCH_NAME(name) BENCH_CAT(name, BENCH_SUFFIX)
+
+#ifdef BENCH_COUNT_DISPATCH
+#define BENCH_COUNT() vm->dispatches++
+#else
+#define BENCH_COUNT() (void)0
+#endif
+
+namespace v4bench
+{
+
+namespace
+{
+
+inline int32_t read_i32(const uint8_t* p)
+{
+  uint32_t v;
+  memcpy(&v, p, 4);
+  return static_cast<int32_t>(v);
+}
+
+inline int16_t read_i16(const uint8_t* p)
+{
+  return static_cast<int16_t>(p[0] | (p[1] << 8));
+}
+
+inline int32_t wrap(uint32_t v)
+{
+  return static_cast<int32_t>(v);
+}
+
+inline uint16_t read_u16(const uint8_t* p)
+{
+  return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+// SYS 21 (GPIO-WRITE) takes ( pin value ), everything else one cell
+inline int sys_argc(uint8_t id)
+{
+  return id == 21 ? 2 : 1;
+}
+
+// Out of line, like a real SYS handler table entry
+__attribute__((noinline)) void sys_call(BenchVm* vm, uint8_t id, const int32_t* args,
+                                        int argc)
+{
+  uint64_t mix = id;
+  for (int i = 0; i < argc; i++)
+  {
+    mix = mix * 31 + static_cast<uint32_t>(args[i]);
+  }
+  vm->sys_calls++;
+  vm->sys_checksum += mix;
+}
+
+}  // namespace
+
+#define PUSH_CHECK(n)          \
+  if (sp + (n) > vm->ds + 256) \
+  {                            \
+    return BENCH_ERR_OVERFLOW; \
+  }
+#define POP_CHECK(n)            \
+  if (sp - vm->ds < (n))        \
+  {                             \
+    return BENCH_ERR_UNDERFLOW; \
+  }
+#define RPUSH_CHECK(n)         \
+  if (rp + (n) > vm->rs + 64)  \
+  {                            \
+    return BENCH_ERR_OVERFLOW; \
+  }
+#define RPOP_CHECK(n)           \
+  if (rp - vm->rs < (n))        \
+  {                             \
+    return BENCH_ERR_UNDERFLOW; \
+  }
+
+// Shared by run_switch and resume_switch (static: the copies differ per build)
+__attribute__((always_inline)) static inline int switch_loop(
+    BenchVm* vm, const uint8_t* code, const uint8_t* ip, int32_t* sp, int32_t* rp)
+{
+#define OP(name) case OP_##name:
+#define NEXT continue
+  for (;;)
+  {
+    BENCH_COUNT();
+    switch (*ip++)
+    {
+#include "dispatch_bench_ops.inc"
+      default:
+        return BENCH_ERR_UNDERFLOW;
+    }
+  }
+#undef OP
+#undef NEXT
+}
+
+int BENCH_NAME(run_switch)(BenchVm* vm, const uint8_t* code, size_t entry)
+{
+  return switch_loop(vm, code, code + entry, vm->ds, vm->rs);
+}
+
+int BENCH_NAME(resume_switch)(BenchVm* vm, const uint8_t* code, size_t ip)
+{
+  return switch_loop(vm, code, code + ip, vm->ds + vm->depth, vm->rs + vm->rdepth);
+}
+
+int BENCH_NAME(run_threaded)(BenchVm* vm, const uint8_t* code, size_t entry)
+{
+  // One label per opcode, in enum order; bytecode is trusted (no range check)
+#define BENCH_OP_LABEL(name) &&L_##name,
+  static const void* const labels[OP_COUNT] = {BENCH_OPS(BENCH_OP_LABEL)};
+#undef BENCH_OP_LABEL
+
+  const uint8_t* ip = code + entry;
+  int32_t* sp = vm->ds;
+  int32_t* rp = vm->rs;
+
+#define OP(name) L_##name:
+#define NEXT             \
+  do                     \
+  {                      \
+    BENCH_COUNT();       \
+    goto* labels[*ip++]; \
+  } while (0)
+  NEXT;
+#include "dispatch_bench_ops.inc"
+#undef OP
+#undef NEXT
+}
+
+}  // namespace v4bench
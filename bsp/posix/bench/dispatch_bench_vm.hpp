@@ -0,0 +1,101 @@
+/**
+ * @file dispatch_bench_vm.hpp
+ * @brief Minimal stack VM for the dispatch benchmark
+ *
+ * A reduced V4-style bytecode (1-byte opcodes, inline little-endian
+ * operands, data and return stacks with bounds checks) interpreted two
+ * ways: a switch loop and direct threading through computed goto. The
+ * interpreter source is compiled once per optimization level, so each
+ * level provides its own pair of run functions. A third copy counts
+ * dispatched opcodes for the peephole benchmark.
+ *
+ * The last four opcodes are superinstructions produced by the peephole
+ * pass (bytecode_peephole); hand-written code does not use them.
+ *
+ * SPDX-License-Identifier: MIT OR Apache-2.0
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace v4bench
+{
+
+// Opcode list: X(name)
+#define BENCH_OPS(X) \
+  X(HALT)            \
+  X(LIT)             \
+  X(DUP)             \
+  X(DROP)            \
+  X(SWAP)            \
+  X(OVER)            \
+  X(ROT)             \
+  X(ADD)             \
+  X(SUB)             \
+  X(MUL)             \
+  X(AND)             \
+  X(LT)              \
+  X(TOR)             \
+  X(FROMR)           \
+  X(JMP)             \
+  X(JZ)              \
+  X(CALL)            \
+  X(RET)             \
+  X(DO)              \
+  X(LOOP)            \
+  X(SYS)             \
+  X(LIT_ADD)         \
+  X(DUP_JZ)          \
+  X(DELAY_LIT)       \
+  X(DEC_JNN)
+
+/** Bytecode opcodes */
+enum Op : uint8_t
+{
+#define BENCH_OP_ENUM(name) OP_##name,
+  BENCH_OPS(BENCH_OP_ENUM)
+#undef BENCH_OP_ENUM
+      OP_COUNT
+};
+
+/** Interpreter result codes */
+enum : int
+{
+  BENCH_OK = 0,
+  BENCH_ERR_OVERFLOW = -1,
+  BENCH_ERR_UNDERFLOW = -2
+};
+
+/** VM state */
+struct BenchVm
+{
+  int32_t ds[256];        ///< Data stack
+  int32_t rs[64];         ///< Return stack (return addresses, loop indices)
+  int32_t depth;          ///< Data stack depth after run
+  int32_t rdepth;         ///< Return stack depth after run
+  uint64_t sys_calls;     ///< SYS instructions executed
+  uint64_t sys_checksum;  ///< Mix of SYS arguments (keeps work observable)
+  uint64_t dispatches;    ///< Opcodes dispatched (counting build only)
+};
+
+/** Interpreter entry point: run @p code from @p entry until HALT */
+using RunFn = int (*)(BenchVm* vm, const uint8_t* code, size_t entry);
+
+int run_switch_os(BenchVm* vm, const uint8_t* code, size_t entry);
+int run_threaded_os(BenchVm* vm, const uint8_t* code, size_t entry);
+int run_switch_o2(BenchVm* vm, const uint8_t* code, size_t entry);
+int run_threaded_o2(BenchVm* vm, const uint8_t* code, size_t entry);
+int run_switch_count(BenchVm* vm, const uint8_t* code, size_t entry);
+int run_threaded_count(BenchVm* vm, const uint8_t* code, size_t entry);
+
+/**
+ * Continue at @p ip with the stacks left in @p vm (depth, rdepth), e.g.
+ * after native code bailed out (switch dispatch; jit benchmark)
+ */
+int resume_switch_os(BenchVm* vm, const uint8_t* code, size_t ip);
+int resume_switch_o2(BenchVm* vm, const uint8_t* code, size_t ip);
+int resume_switch_count(BenchVm* vm, const uint8_t* code, size_t ip);
+
+}  // namespace v4bench
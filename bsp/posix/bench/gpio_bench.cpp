@@ -0,0 +1,371 @@
+/**
+ * @file gpio_bench.cpp
+ * @brief Bit-banged GPIO from Forth: per-pin LED words vs. fast path vs. port writes
+ *
+ * Every pin update goes through a SYS-handler-shaped call (arguments on a
+ * small data stack, handler through a function pointer table) into one of:
+ * - driver: the former Esp32LedHal::set_led(); virtual call, active-low
+ *           branch, a gpio_set_level()-style checked driver call and a
+ *           debug log level test per pin
+ * - fast:   Esp32LedHal / PosixLedHal now; one set or clear store per pin
+ * - port:   GPIO-PORT-WRITE; every pin of the update in one call (GpioPort)
+ *
+ * Patterns, one update each:
+ * - square: one edge of a square wave on one pin
+ * - spi:    one byte of SPI mode 0, MSB first (data, clock up, clock down)
+ * - bus8:   one byte on an 8-bit parallel bus plus a strobe pulse
+ *
+ * The registers are PosixGpioRegs, which count set/clear stores and level
+ * changes; all paths must leave the same levels after the same number of
+ * level changes. Host stores are atomic read-modify-writes, dearer than a
+ * device store, while a host SYS call is only an indirect call; on a
+ * device the SYS call count is what bounds the rate, each call being a
+ * trip through the interpreter.
+ *
+ * Usage:
+ *   v4-bench-gpio [--updates N]
+ *
+ * SPDX-License-Identifier: MIT OR Apache-2.0
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "gpio_port.hpp"
+#include "posix_gpio_regs.hpp"
+
+using v4rtos::GpioPort;
+using v4rtos::PosixGpioRegs;
+
+static constexpr uint32_t LED_PIN = 7;
+static constexpr uint32_t MOSI_PIN = 18;
+static constexpr uint32_t CLK_PIN = 19;
+static constexpr uint32_t STROBE_PIN = 8;
+static constexpr uint32_t BUS_MASK = 0xFFu << 20;  ///< Data lines GPIO20-27
+static constexpr uint32_t BUS_SHIFT = 20;
+
+/** Data stack of the simulated SYS calls */
+struct Stack
+{
+  int32_t cells[8];  ///< Cells
+  int sp;            ///< Depth
+
+  void push(int32_t v)
+  {
+    cells[sp++] = v;
+  }
+
+  int32_t pop()
+  {
+    return cells[--sp];
+  }
+};
+
+typedef int (*SysFn)(Stack* ds);
+
+// ==============================================================================
+// LED HALs
+// ==============================================================================
+
+/** v4std::LedHal */
+class LedHal
+{
+ public:
+  virtual ~LedHal() = default;
+  virtual bool set_led(uint32_t handle, bool state, bool active_low) = 0;
+};
+
+static PosixGpioRegs s_regs;
+static volatile int s_log_level = 3;  ///< ESP_LOG_INFO: debug logs skipped
+
+// gpio_set_level(): pin check, then the HAL store
+__attribute__((noinline)) static int driver_set_level(uint32_t gpio, uint32_t level)
+{
+  if (gpio >= PosixGpioRegs::PIN_COUNT)
+  {
+    return -1;
+  }
+  if (level != 0)
+  {
+    s_regs.set(1u << gpio);
+  }
+  else
+  {
+    s_regs.clear(1u << gpio);
+  }
+  return 0;
+}
+
+/** Former Esp32LedHal */
+class DriverLedHal : public LedHal
+{
+ public:
+  bool set_led(uint32_t handle, bool state, bool active_low) override
+  {
+    uint32_t level = state ? 1 : 0;
+    if (active_low)
+    {
+      level = !level;
+    }
+    if (driver_set_level(handle, level) != 0)
+    {
+      return false;
+    }
+    if (s_log_level >= 4)
+    {
+      printf("LED GPIO%u set to %s\n", (unsigned)handle, level ? "HIGH" : "LOW");
+    }
+    return true;
+  }
+};
+
+/** Esp32LedHal / PosixLedHal fast path */
+class FastLedHal : public LedHal
+{
+ public:
+  bool set_led(uint32_t handle, bool state, bool active_low) override
+  {
+    if (handle >= PosixGpioRegs::PIN_COUNT)
+    {
+      return false;
+    }
+    uint32_t bit = 1u << handle;
+    if (state != active_low)
+    {
+      s_regs.set(bit);
+    }
+    else
+    {
+      s_regs.clear(bit);
+    }
+    return true;
+  }
+};
+
+static DriverLedHal s_driver_hal;
+static FastLedHal s_fast_hal;
+static LedHal* s_hal = nullptr;
+static GpioPort<PosixGpioRegs> s_port(s_regs, (1u << LED_PIN) | (1u << MOSI_PIN) |
+                                                  (1u << CLK_PIN) | (1u << STROBE_PIN) |
+                                                  BUS_MASK);
+
+// ==============================================================================
+// SYS handlers
+// ==============================================================================
+
+// LED-SET ( state handle -- )
+static int sys_led_set(Stack* ds)
+{
+  uint32_t handle = (uint32_t)ds->pop();
+  bool state = ds->pop() != 0;
+  return s_hal->set_led(handle, state, false) ? 0 : -1;
+}
+
+// GPIO-PORT-WRITE ( values mask -- result )
+static int sys_port_write(Stack* ds)
+{
+  uint32_t mask = (uint32_t)ds->pop();
+  uint32_t values = (uint32_t)ds->pop();
+  ds->push(s_port.write(mask, values));
+  return 0;
+}
+
+static SysFn volatile s_sys[] = {sys_led_set, sys_port_write};
+static uint64_t s_calls = 0;
+
+static void pin(Stack* ds, uint32_t gpio, bool level)
+{
+  ds->push(level ? 1 : 0);
+  ds->push((int32_t)gpio);
+  s_sys[0](ds);
+  s_calls++;
+}
+
+static void port(Stack* ds, uint32_t mask, uint32_t values)
+{
+  ds->push((int32_t)values);
+  ds->push((int32_t)mask);
+  s_sys[1](ds);
+  ds->pop();  // result
+  s_calls++;
+}
+
+// ==============================================================================
+// Patterns
+// ==============================================================================
+
+static void square(Stack* ds, bool batched, uint32_t n)
+{
+  bool level = (n & 1) != 0;
+  if (batched)
+  {
+    port(ds, 1u << LED_PIN, level ? 1u << LED_PIN : 0);
+  }
+  else
+  {
+    pin(ds, LED_PIN, level);
+  }
+}
+
+static void spi(Stack* ds, bool batched, uint32_t n)
+{
+  uint8_t byte = (uint8_t)(n * 0x9Du);
+  for (int bit = 7; bit >= 0; bit--)
+  {
+    bool data = ((byte >> bit) & 1) != 0;
+    if (batched)
+    {
+      // Data and the previous falling edge together, then the rising edge
+      port(ds, (1u << MOSI_PIN) | (1u << CLK_PIN), data ? 1u << MOSI_PIN : 0);
+      port(ds, 1u << CLK_PIN, 1u << CLK_PIN);
+    }
+    else
+    {
+      pin(ds, MOSI_PIN, data);
+      pin(ds, CLK_PIN, true);
+      pin(ds, CLK_PIN, false);
+    }
+  }
+  if (batched)
+  {
+    port(ds, 1u << CLK_PIN, 0);
+  }
+}
+
+static void bus8(Stack* ds, bool batched, uint32_t n)
+{
+  uint8_t byte = (uint8_t)(n * 0x9Du);
+  if (batched)
+  {
+    port(ds, BUS_MASK, (uint32_t)byte << BUS_SHIFT);
+    port(ds, 1u << STROBE_PIN, 1u << STROBE_PIN);
+    port(ds, 1u << STROBE_PIN, 0);
+  }
+  else
+  {
+    for (uint32_t bit = 0; bit < 8; bit++)
+    {
+      pin(ds, BUS_SHIFT + bit, ((byte >> bit) & 1) != 0);
+    }
+    pin(ds, STROBE_PIN, true);
+    pin(ds, STROBE_PIN, false);
+  }
+}
+
+/** Bit-banged pattern */
+struct Pattern
+{
+  const char* name;                                     ///< Label
+  void (*update)(Stack* ds, bool batched, uint32_t n);  ///< One update
+};
+
+/** HAL path */
+struct Path
+{
+  const char* name;  ///< Label
+  LedHal* hal;       ///< LED HAL (per-pin paths)
+  bool batched;      ///< GPIO-PORT-WRITE
+};
+
+/** Result of one pattern on one path */
+struct Result
+{
+  double ns_per_update;  ///< Wall time per update
+  double calls;          ///< SYS calls per update
+  double writes;         ///< Register stores per update
+  uint32_t levels;       ///< Pin levels at the end
+  uint64_t changes;      ///< Level changes
+};
+
+static Result run(const Pattern& pattern, const Path& path, uint32_t updates)
+{
+  // Fresh registers: every path starts from all pins low
+  s_regs.clear(0xFFFFFFFFu);
+  uint64_t writes0 = s_regs.write_count();
+  uint64_t changes0 = s_regs.toggle_count();
+  s_calls = 0;
+  s_hal = path.hal;
+
+  Stack ds = {};
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t n = 0; n < updates; n++)
+  {
+    pattern.update(&ds, path.batched, n);
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  Result r;
+  double ns =
+      (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+  r.ns_per_update = ns / updates;
+  r.calls = (double)s_calls / updates;
+  r.writes = (double)(s_regs.write_count() - writes0) / updates;
+  r.levels = s_regs.out();
+  r.changes = s_regs.toggle_count() - changes0;
+  return r;
+}
+
+int main(int argc, char** argv)
+{
+  long updates = 1000000;
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--updates") == 0 && i + 1 < argc)
+    {
+      updates = atol(argv[++i]);
+    }
+    else
+    {
+      fprintf(stderr, "Usage: %s [--updates N]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (updates <= 0 || updates > 100000000)
+  {
+    fprintf(stderr, "Invalid --updates\n");
+    return 2;
+  }
+
+  static const Pattern patterns[] = {
+      {"square", square},
+      {"spi", spi},
+      {"bus8", bus8},
+  };
+  static const Path paths[] = {
+      {"driver", &s_driver_hal, false},
+      {"fast", &s_fast_hal, false},
+      {"port", nullptr, true},
+  };
+  static constexpr size_t PATHS = sizeof(paths) / sizeof(paths[0]);
+
+  printf("%ld updates per run\n\n", updates);
+  printf("%-7s %-7s %10s %10s %10s %12s %8s\n", "pattern", "path", "SYS/upd",
+         "stores/upd", "ns/upd", "updates/s", "speedup");
+  bool same = true;
+  for (const Pattern& pattern : patterns)
+  {
+    Result results[PATHS];
+    for (size_t p = 0; p < PATHS; p++)
+    {
+      results[p] = run(pattern, paths[p], (uint32_t)updates);
+      const Result& r = results[p];
+      printf("%-7s %-7s %10.1f %10.1f %10.1f %12.0f %7.2fx\n", pattern.name,
+             paths[p].name, r.calls, r.writes, r.ns_per_update,
+             r.ns_per_update > 0 ? 1e9 / r.ns_per_update : 0.0,
+             r.ns_per_update > 0 ? results[0].ns_per_update / r.ns_per_update : 0.0);
+      if (r.levels != results[0].levels || r.changes != results[0].changes)
+      {
+        fprintf(stderr,
+                "%s/%s: levels 0x%08x after %llu changes, driver 0x%08x after %llu\n",
+                pattern.name, paths[p].name, (unsigned)r.levels,
+                (unsigned long long)r.changes, (unsigned)results[0].levels,
+                (unsigned long long)results[0].changes);
+        same = false;
+      }
+    }
+  }
+  return same ? 0 : 1;
+}
@@ -0,0 +1,633 @@
+/**
+ * @file image_transfer_bench.cpp
+ * @brief End-to-end bytecode image upload: plain vs. LZ4-compressed
+ *
+ * Runs a device-side link loop (frame scanner, runtime commands, an
+ * ImageStore on a RAM stand-in for NOR flash) against a socketpair and
+ * uploads program-shaped bytecode images the way scripts/v4image.py does:
+ * CAPS, ERASE, INFO, WRITE (or WRITE_LZ4) chunks, COMMIT, each waiting for
+ * its response. Reports bytes on the wire, frames, end-to-end time and
+ * device busy time, unthrottled and at a USB Serial/JTAG-like link rate.
+ *
+ * The decoded slot is compared with the original image after each run.
+ * --verify instead checks the rollback guarantees of ImageStore: while an
+ * image is on trial, updates cannot touch the previous one, so a panic or
+ * a reset still returns to it.
+ *
+ * Usage:
+ *   v4-bench-image-transfer [--kbps N] [--verify]
+ *
+ * SPDX-License-Identifier: MIT OR Apache-2.0
+ */
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "dispatch_bench_programs.hpp"
+#include "image_store.hpp"
+#include "link_frame_scanner.hpp"
+#include "link_runtime_commands.hpp"
+#include "posix_rx.hpp"
+#include "v4link_wire.hpp"
+
+using namespace v4rtos;
+using namespace v4bench;
+
+static constexpr size_t PARTITION_SIZE = 128 * 1024;  ///< Two 64 KB slots
+static constexpr size_t SECTOR_SIZE = 4096;           ///< Erase granularity
+static constexpr size_t CHUNK = 256;                  ///< Payload bytes per WRITE
+
+// ==============================================================================
+// Helpers
+// ==============================================================================
+
+static double now_seconds(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void write_all(int fd, const uint8_t* data, size_t len)
+{
+  while (len > 0)
+  {
+    ssize_t n = write(fd, data, len);
+    if (n > 0)
+    {
+      data += n;
+      len -= (size_t)n;
+    }
+    else if (n < 0 && errno != EINTR)
+    {
+      return;
+    }
+  }
+}
+
+static bool read_all(int fd, uint8_t* data, size_t len)
+{
+  while (len > 0)
+  {
+    ssize_t n = read(fd, data, len);
+    if (n <= 0)
+    {
+      return false;
+    }
+    data += n;
+    len -= (size_t)n;
+  }
+  return true;
+}
+
+static void put_u32(std::vector<uint8_t>& v, uint32_t x)
+{
+  for (int i = 0; i < 4; i++)
+  {
+    v.push_back(static_cast<uint8_t>(x >> (8 * i)));
+  }
+}
+
+/**
+ * @brief Program-shaped bytecode of about @p size bytes
+ *
+ * The bench workloads (blink.fth, hello.fth, ... shapes) with varying
+ * constants, as a larger application defines many similar words.
+ */
+static std::vector<uint8_t> make_image(size_t size)
+{
+  std::vector<uint8_t> image;
+  for (int32_t i = 0; image.size() < size; i++)
+  {
+    Workload w;
+    switch (i % 6)
+    {
+      case 0:
+        w = make_blink(100 + i);
+        break;
+      case 1:
+        w = make_hello(10 + i);
+        break;
+      case 2:
+        w = make_fib(1000 + 7 * i);
+        break;
+      case 3:
+        w = make_branchy(50 + i);
+        break;
+      case 4:
+        w = make_task1(i);
+        break;
+      default:
+        w = make_acc(300 + 3 * i);
+        break;
+    }
+    image.insert(image.end(), w.code.begin(), w.code.end());
+  }
+  image.resize(size);
+  return image;
+}
+
+// ==============================================================================
+// LZ4 Block Compressor (host side)
+// ==============================================================================
+
+static void put_length(std::vector<uint8_t>& out, size_t len)
+{
+  for (len -= 15; len >= 255; len -= 255)
+  {
+    out.push_back(255);
+  }
+  out.push_back(static_cast<uint8_t>(len));
+}
+
+static void put_sequence(std::vector<uint8_t>& out, const uint8_t* lit, size_t lit_len,
+                         size_t offset, size_t match_len)
+{
+  size_t ml = match_len - 4;
+  out.push_back(static_cast<uint8_t>(((lit_len < 15 ? lit_len : 15) << 4) |
+                                     (match_len == 0 ? 0 : (ml < 15 ? ml : 15))));
+  if (lit_len >= 15)
+  {
+    put_length(out, lit_len);
+  }
+  out.insert(out.end(), lit, lit + lit_len);
+  if (match_len == 0)
+  {
+    return;  // Last sequence: literals only
+  }
+  out.push_back(static_cast<uint8_t>(offset));
+  out.push_back(static_cast<uint8_t>(offset >> 8));
+  if (ml >= 15)
+  {
+    put_length(out, ml);
+  }
+}
+
+/**
+ * @brief Greedy LZ4 block compressor (same output as scripts/v4image.py)
+ *
+ * Single-entry hash table over 4-byte sequences; honours the format's end
+ * rules (last match starts 12 bytes before the end, last 5 bytes literal).
+ */
+static std::vector<uint8_t> lz4_compress(const std::vector<uint8_t>& in)
+{
+  std::vector<uint8_t> out;
+  std::vector<int32_t> table(4096, -1);
+  const size_t n = in.size();
+  const size_t match_limit = n > 12 ? n - 12 : 0;
+  size_t anchor = 0;
+  size_t i = 0;
+
+  while (i < match_limit)
+  {
+    uint32_t v;
+    memcpy(&v, &in[i], 4);
+    uint32_t h = (v * 2654435761u) >> 20;
+    int32_t ref = table[h];
+    table[h] = (int32_t)i;
+    if (ref < 0 || i - (size_t)ref > 65535 || memcmp(&in[(size_t)ref], &in[i], 4) != 0)
+    {
+      i++;
+      continue;
+    }
+    size_t len = 4;
+    while (i + len < n - 5 && in[(size_t)ref + len] == in[i + len])
+    {
+      len++;
+    }
+    put_sequence(out, in.data() + anchor, i - anchor, i - (size_t)ref, len);
+    i += len;
+    anchor = i;
+  }
+  put_sequence(out, in.data() + anchor, n - anchor, 0, 0);
+  return out;
+}
+
+// ==============================================================================
+// Device Side
+// ==============================================================================
+
+/**
+ * @brief Device-side link loop with an image partition in RAM
+ *
+ * Erase and write follow NOR rules as in the POSIX image_partition.
+ */
+class Device
+{
+ public:
+  explicit Device(int fd)
+      : fd_(fd),
+        flash_mem_(PARTITION_SIZE, 0xFF),
+        scanner_(512, on_frame, this),
+        cmds_(512)
+  {
+    ImageFlash flash = {flash_mem_.data(), flash_mem_.size(), SECTOR_SIZE,
+                        flash_erase,       flash_write,       this};
+    store_ = new ImageStore(flash, clock_ms, 10000);
+    store_->boot();
+    cmds_.add(link_wire::CMD_IMAGE, ImageStore::handle_command, store_);
+    cmds_.add_caps(link_wire::CAP_IMAGE_LZ4);
+  }
+
+  ~Device()
+  {
+    delete store_;
+  }
+
+  void run()
+  {
+    bool eof = false;
+    uint8_t buffer[512];
+    auto on_chunk = [this](const uint8_t* data, size_t len) { scanner_.feed(data, len); };
+    while (!eof)
+    {
+      if (posix_rx_wait(fd_, -1) == RxWait::READABLE)
+      {
+        posix_rx_drain(fd_, buffer, sizeof(buffer), on_chunk, &eof);
+      }
+    }
+  }
+
+  /** Code of the slot the last upload went to */
+  const uint8_t* slot_code(uint8_t slot) const
+  {
+    return flash_mem_.data() + slot * (PARTITION_SIZE / 2) + sizeof(ImageStore::Header);
+  }
+
+  double busy_s = 0.0;  ///< Time spent in runtime command handlers
+
+ private:
+  static uint32_t clock_ms(void)
+  {
+    return (uint32_t)(now_seconds() * 1000.0);
+  }
+
+  static bool flash_erase(void* user, size_t offset, size_t len)
+  {
+    memset(static_cast<Device*>(user)->flash_mem_.data() + offset, 0xFF, len);
+    return true;
+  }
+
+  static bool flash_write(void* user, size_t offset, const uint8_t* data, size_t len)
+  {
+    uint8_t* dst = static_cast<Device*>(user)->flash_mem_.data() + offset;
+    for (size_t i = 0; i < len; i++)
+    {
+      dst[i] &= data[i];
+    }
+    return memcmp(dst, data, len) == 0;
+  }
+
+  static void on_frame(void* user, const LinkFrameView& frame)
+  {
+    auto* self = static_cast<Device*>(user);
+    if (!link_wire::is_runtime_cmd(frame.cmd))
+    {
+      return;
+    }
+    double t0 = now_seconds();
+    size_t len = 0;
+    const uint8_t* resp = self->cmds_.handle(frame, &len);
+    self->busy_s += now_seconds() - t0;
+    write_all(self->fd_, resp, len);
+  }
+
+  int fd_;
+  std::vector<uint8_t> flash_mem_;
+  LinkFrameScanner scanner_;
+  LinkRuntimeCommands cmds_;
+  ImageStore* store_ = nullptr;
+};
+
+// ==============================================================================
+// Host Side
+// ==============================================================================
+
+/**
+ * @brief Request/response host link with an optional rate limit
+ */
+class Host
+{
+ public:
+  Host(int fd, double bytes_per_s) : fd_(fd), rate_(bytes_per_s) {}
+
+  /** Send one request and wait for its response; false unless STATUS_OK */
+  bool request(uint8_t cmd, const std::vector<uint8_t>& payload,
+               std::vector<uint8_t>* resp = nullptr)
+  {
+    std::vector<uint8_t> frame(payload.size() + link_wire::OVERHEAD);
+    size_t n = link_wire::encode_frame(cmd, payload.data(), payload.size(), frame.data());
+    pace(n);
+    write_all(fd_, frame.data(), n);
+    wire_bytes += n;
+    frames++;
+
+    uint8_t header[link_wire::HEADER_SIZE];
+    if (!read_all(fd_, header, sizeof(header)))
+    {
+      return false;
+    }
+    size_t len = header[1] | ((size_t)header[2] << 8);
+    std::vector<uint8_t> rest(len + link_wire::CRC_SIZE);
+    if (!read_all(fd_, rest.data(), rest.size()))
+    {
+      return false;
+    }
+    if (resp != nullptr)
+    {
+      resp->assign(rest.begin(), rest.begin() + (long)len);
+    }
+    return header[3] == link_wire::STATUS_OK;
+  }
+
+  size_t wire_bytes = 0;  ///< Request bytes sent
+  size_t frames = 0;      ///< Requests sent
+
+ private:
+  /** Sleep so the request stream stays within the link rate */
+  void pace(size_t bytes)
+  {
+    if (rate_ <= 0.0)
+    {
+      return;
+    }
+    double now = now_seconds();
+    if (next_ < now)
+    {
+      next_ = now;
+    }
+    double wait = next_ - now;
+    if (wait > 0.0)
+    {
+      usleep((useconds_t)(wait * 1e6));
+    }
+    next_ += (double)bytes / rate_;
+  }
+
+  int fd_;
+  double rate_;
+  double next_ = 0.0;
+};
+
+struct Result
+{
+  double seconds;     ///< End-to-end upload time
+  double device_s;    ///< Device time in command handlers
+  size_t wire_bytes;  ///< Request bytes on the link
+  size_t frames;      ///< Requests
+};
+
+static Result transfer(const std::vector<uint8_t>& image, bool compress, double rate)
+{
+  int sv[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0)
+  {
+    perror("socketpair");
+    exit(1);
+  }
+  Device device(sv[1]);
+  std::thread device_thread([&device]() { device.run(); });
+  Host host(sv[0], rate);
+
+  double t0 = now_seconds();
+
+  // Negotiate: fall back to plain WRITEs unless the runtime decodes LZ4
+  std::vector<uint8_t> resp;
+  if (compress && (!host.request(link_wire::CMD_CAPS, {}, &resp) || resp.size() < 4 ||
+                   (resp[0] & link_wire::CAP_IMAGE_LZ4) == 0))
+  {
+    compress = false;
+  }
+
+  bool ok = host.request(link_wire::CMD_IMAGE, {ImageStore::OP_ERASE});
+  ok = ok && host.request(link_wire::CMD_IMAGE, {ImageStore::OP_INFO}, &resp);
+  uint8_t slot = resp.size() > 1 ? resp[1] : 0;
+  uint32_t seq = 0;
+  for (size_t i = 0; i < 4 && resp.size() > 5; i++)
+  {
+    seq |= (uint32_t)resp[2 + i] << (8 * i);
+  }
+
+  const std::vector<uint8_t> data = compress ? lz4_compress(image) : image;
+  for (size_t off = 0; ok && off < data.size(); off += CHUNK)
+  {
+    size_t n = data.size() - off < CHUNK ? data.size() - off : CHUNK;
+    std::vector<uint8_t> payload;
+    if (compress)
+    {
+      payload.push_back(ImageStore::OP_WRITE_LZ4);
+    }
+    else
+    {
+      payload.push_back(ImageStore::OP_WRITE);
+      put_u32(payload, (uint32_t)off);
+    }
+    payload.insert(payload.end(), data.data() + off, data.data() + off + n);
+    ok = host.request(link_wire::CMD_IMAGE, payload);
+  }
+
+  uint16_t flags = ImageStore::FLAG_AUTOSTART;
+  std::vector<uint8_t> commit = {ImageStore::OP_COMMIT};
+  put_u32(commit, (uint32_t)image.size());
+  put_u32(commit, ImageStore::image_crc(image.data(), image.size(), flags, seq));
+  commit.push_back((uint8_t)flags);
+  commit.push_back((uint8_t)(flags >> 8));
+  ok = ok && host.request(link_wire::CMD_IMAGE, commit);
+
+  double seconds = now_seconds() - t0;
+  close(sv[0]);
+  device_thread.join();
+  close(sv[1]);
+
+  if (!ok || memcmp(device.slot_code(slot), image.data(), image.size()) != 0)
+  {
+    fprintf(stderr, "upload of %zu bytes (%s) failed or differs\n", image.size(),
+            compress ? "lz4" : "plain");
+    exit(1);
+  }
+  return {seconds, device.busy_s, host.wire_bytes, host.frames};
+}
+
+// ==============================================================================
+// Rollback Verification
+// ==============================================================================
+
+static uint32_t s_verify_ms = 0;  ///< Trial clock of the verification store
+
+/** RAM stand-in for NOR flash with a manual clock */
+struct VerifyFlash
+{
+  std::vector<uint8_t> mem = std::vector<uint8_t>(PARTITION_SIZE, 0xFF);
+
+  static bool erase(void* user, size_t offset, size_t len)
+  {
+    memset(static_cast<VerifyFlash*>(user)->mem.data() + offset, 0xFF, len);
+    return true;
+  }
+
+  static bool write(void* user, size_t offset, const uint8_t* data, size_t len)
+  {
+    uint8_t* dst = static_cast<VerifyFlash*>(user)->mem.data() + offset;
+    for (size_t i = 0; i < len; i++)
+    {
+      dst[i] &= data[i];
+    }
+    return memcmp(dst, data, len) == 0;
+  }
+
+  static uint32_t clock_ms(void)
+  {
+    return s_verify_ms;
+  }
+
+  ImageFlash flash()
+  {
+    return {mem.data(), mem.size(), SECTOR_SIZE, erase, write, this};
+  }
+};
+
+static int s_checks = 0;
+static int s_failures = 0;
+
+static void check(bool ok, const char* what)
+{
+  s_checks++;
+  if (!ok)
+  {
+    s_failures++;
+    fprintf(stderr, "image verify: %s\n", what);
+  }
+}
+
+/** Erase, write and commit @p image; false if any step fails */
+static bool store_upload(ImageStore* store, const std::vector<uint8_t>& image)
+{
+  // next_seq() after the erase, as the host reads it from INFO
+  if (!store->erase() || !store->write(0, image.data(), image.size()))
+  {
+    return false;
+  }
+  uint16_t flags = ImageStore::FLAG_AUTOSTART;
+  uint32_t crc = ImageStore::image_crc(image.data(), image.size(), flags,
+                                       store->next_seq());
+  return store->commit(image.size(), crc, flags);
+}
+
+/** true if @p store runs @p image */
+static bool store_runs(const ImageStore& store, const std::vector<uint8_t>& image)
+{
+  const ImageStore::Header* h = store.active_header();
+  return h != nullptr && h->size == image.size() &&
+         memcmp(store.active_code(), image.data(), image.size()) == 0;
+}
+
+static int run_verify(void)
+{
+  static constexpr uint32_t TRIAL_MS = 1000;
+  const std::vector<uint8_t> first = make_image(4 * 1024);
+  const std::vector<uint8_t> second = make_image(6 * 1024);
+
+  VerifyFlash flash;
+  s_verify_ms = 0;
+  ImageStore store(flash.flash(), VerifyFlash::clock_ms, TRIAL_MS);
+  store.boot();
+
+  // A confirmed first image
+  check(store_upload(&store, first) && store.activate(), "first upload failed");
+  s_verify_ms += TRIAL_MS;
+  store.service();
+  check(!store.on_trial() && store_runs(store, first), "first image not confirmed");
+
+  // Second image on trial: no update op may reach the first one
+  check(store_upload(&store, second) && store.activate(), "second upload failed");
+  check(store.on_trial(), "second image not on trial");
+  check(!store.erase(), "ERASE accepted during the trial");
+  check(!store.write(0, second.data(), 16), "WRITE accepted during the trial");
+  check(!store.write_lz4(second.data(), 16), "WRITE_LZ4 accepted during the trial");
+  check(!store.commit(second.size(), 0, 0), "COMMIT accepted during the trial");
+
+  // Panic within the window: back to the first image
+  s_verify_ms += TRIAL_MS / 2;
+  check(store.fault() && store_runs(store, first), "no rollback after a panic");
+
+  // Again, now with a reset before the window ends
+  check(store_upload(&store, second) && store.activate(), "third upload failed");
+  check(!store.erase(), "ERASE accepted during the second trial");
+  ImageStore rebooted(flash.flash(), VerifyFlash::clock_ms, TRIAL_MS);
+  check(rebooted.boot() && store_runs(rebooted, first), "no rollback after a reset");
+  check(rebooted.rollbacks() == 1, "reset rollback not counted");
+
+  // Once the window has passed, updates work again without an INFO
+  check(store_upload(&rebooted, second) && rebooted.activate(), "fourth upload failed");
+  s_verify_ms += TRIAL_MS;
+  check(rebooted.erase(), "ERASE refused after the trial");
+
+  printf("image verify: %d checks, %d failures\n", s_checks, s_failures);
+  return s_failures == 0 ? 0 : 1;
+}
+
+// ==============================================================================
+// Main
+// ==============================================================================
+
+int main(int argc, char** argv)
+{
+  double kbps = 400.0;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--kbps") == 0 && i + 1 < argc)
+    {
+      kbps = atof(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--verify") == 0)
+    {
+      return run_verify();
+    }
+    else
+    {
+      fprintf(stderr, "Usage: %s [--kbps N] [--verify]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (kbps <= 0.0)
+  {
+    fprintf(stderr, "Invalid --kbps\n");
+    return 2;
+  }
+
+  // The device side may still answer after the host has closed
+  signal(SIGPIPE, SIG_IGN);
+
+  printf("Image upload: %zu-byte chunks, socketpair transport, responses awaited\n",
+         CHUNK);
+  printf("%8s %6s %10s %7s %7s %12s %12s %12s\n", "image", "mode", "wire", "ratio",
+         "frames", "unthrottled", "device", "@ KB/s");
+  const size_t sizes[] = {4 * 1024, 16 * 1024, 60 * 1024};
+  for (size_t size : sizes)
+  {
+    std::vector<uint8_t> image = make_image(size);
+    for (bool compress : {false, true})
+    {
+      Result fast = transfer(image, compress, 0.0);
+      Result slow = transfer(image, compress, kbps * 1024.0);
+      printf("%8zu %6s %10zu %6.2fx %7zu %9.2f ms %9.2f ms %9.1f ms\n", size,
+             compress ? "lz4" : "plain", fast.wire_bytes,
+             (double)image.size() / (double)fast.wire_bytes, fast.frames,
+             fast.seconds * 1e3, fast.device_s * 1e3, slow.seconds * 1e3);
+    }
+  }
+  printf("(@ KB/s: request stream paced to %.0f KB/s)\n", kbps);
+  return 0;
+}
@@ -0,0 +1,541 @@
+/**
+ * @file jit_bench.cpp
+ * @brief Template JIT: native vs. interpreted words on an RV32 simulator
+ *
+ * Compiles bench VM words with Rv32Jit through a JitCache (as vm_jit does
+ * on the ESP32-C6) and runs the machine code on Rv32Sim. Each word is
+ * called the way the engine would: the return address is pushed, the
+ * native code runs, and on JIT_EXIT the interpreter resumes at exit_ip
+ * with the stacks the native code left behind (JIT_DONE: the interpreter
+ * executes the RET). The result must match running the same call purely
+ * interpreted: status, final data stack and the SYS call trace.
+ *
+ * The default mode reports bytecode dispatches of the interpreted call
+ * against instructions retired by the native code plus the dispatches
+ * left to the interpreter. --verify sweeps argument values, stack bound
+ * violations and words the JIT only partly covers, and checks results.
+ *
+ * Usage:
+ *   v4-bench-jit [--iterations N] [--threshold N] [--verify]
+ *
+ * SPDX-License-Identifier: MIT OR Apache-2.0
+ */
+
+#include <stdlib.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "dispatch_bench_programs.hpp"
+#include "dispatch_bench_vm.hpp"
+#include "rv32_jit.hpp"
+#include "rv32_sim.hpp"
+#include "vm_jit.hpp"
+
+using namespace v4bench;
+using v4rtos::JIT_DONE;
+using v4rtos::JIT_EXIT;
+using v4rtos::JitCache;
+using v4rtos::JitIsa;
+using v4rtos::JitOp;
+using v4rtos::JitOpInfo;
+using v4rtos::Rv32Jit;
+
+// ==============================================================================
+// Bench VM instruction set
+// ==============================================================================
+
+static JitOpInfo g_ops[256];
+
+static JitIsa make_isa(void)
+{
+  for (JitOpInfo& op : g_ops)
+  {
+    op = JitOpInfo{JitOp::UNSUPPORTED, 0};
+  }
+  g_ops[OP_LIT] = {JitOp::LIT, 4};
+  g_ops[OP_DUP] = {JitOp::DUP, 0};
+  g_ops[OP_DROP] = {JitOp::DROP, 0};
+  g_ops[OP_SWAP] = {JitOp::SWAP, 0};
+  g_ops[OP_OVER] = {JitOp::OVER, 0};
+  g_ops[OP_ROT] = {JitOp::ROT, 0};
+  g_ops[OP_ADD] = {JitOp::ADD, 0};
+  g_ops[OP_SUB] = {JitOp::SUB, 0};
+  g_ops[OP_MUL] = {JitOp::MUL, 0};
+  g_ops[OP_AND] = {JitOp::AND, 0};
+  g_ops[OP_LT] = {JitOp::LT, 0};
+  g_ops[OP_TOR] = {JitOp::TOR, 0};
+  g_ops[OP_FROMR] = {JitOp::FROMR, 0};
+  g_ops[OP_JMP] = {JitOp::JMP, 2};
+  g_ops[OP_JZ] = {JitOp::JZ, 2};
+  g_ops[OP_DO] = {JitOp::DO, 0};
+  g_ops[OP_LOOP] = {JitOp::LOOP, 2};
+  g_ops[OP_RET] = {JitOp::RET, 0};
+  g_ops[OP_LIT_ADD] = {JitOp::LIT_ADD, 4};
+  g_ops[OP_DUP_JZ] = {JitOp::DUP_JZ, 2};
+  g_ops[OP_DEC_JNN] = {JitOp::DEC_JNN, 2};
+  // Interpreted: CALL, SYS, HALT, DELAY_LIT (operand sizes still matter)
+  g_ops[OP_CALL] = {JitOp::UNSUPPORTED, 2};
+  g_ops[OP_SYS] = {JitOp::UNSUPPORTED, 1};
+  g_ops[OP_DELAY_LIT] = {JitOp::UNSUPPORTED, 4};
+  return JitIsa{g_ops};
+}
+
+// ==============================================================================
+// Words
+// ==============================================================================
+
+/** One word and the caller that invokes it */
+struct Word
+{
+  const char* name;           ///< Short name
+  const char* source;         ///< Forth equivalent (for the report)
+  std::vector<uint8_t> code;  ///< Word, then the caller
+  size_t entry;               ///< Word entry
+};
+
+/** Append "args.. CALL word HALT" and return its entry */
+static size_t add_caller(Assembler* a, size_t word, const std::vector<int32_t>& args)
+{
+  size_t caller = a->here();
+  for (int32_t v : args)
+  {
+    a->lit(v);
+  }
+  a->call(word);
+  a->op(OP_HALT);
+  return caller;
+}
+
+/** : FIB ( n -- f ) 0 1 ROT 0 DO OVER + SWAP LOOP DROP ; */
+static void asm_fib(Assembler* a)
+{
+  a->lit(0);
+  a->lit(1);
+  a->op(OP_ROT);
+  a->lit(0);
+  a->op(OP_DO);
+  size_t inner = a->here();
+  a->op(OP_OVER);
+  a->op(OP_ADD);
+  a->op(OP_SWAP);
+  a->branch(OP_LOOP, inner);
+  a->op(OP_DROP);
+  a->op(OP_RET);
+}
+
+/** : ACC ( n -- x ) 0 SWAP 0 DO 3 + DUP 7 AND DUP IF + ELSE DROP THEN LOOP ; */
+static void asm_acc(Assembler* a)
+{
+  a->lit(0);
+  a->op(OP_SWAP);
+  a->lit(0);
+  a->op(OP_DO);
+  size_t body = a->here();
+  a->lit(3);
+  a->op(OP_ADD);
+  a->op(OP_DUP);
+  a->lit(7);
+  a->op(OP_AND);
+  a->op(OP_DUP);
+  size_t to_else = a->branch_forward(OP_JZ);
+  a->op(OP_ADD);
+  size_t to_then = a->branch_forward(OP_JMP);
+  a->patch(to_else);
+  a->op(OP_DROP);
+  a->patch(to_then);
+  a->branch(OP_LOOP, body);
+  a->op(OP_RET);
+}
+
+/** : POLY ( x -- y ) DUP >R DUP * R> 3 * + 1 + ; */
+static void asm_poly(Assembler* a)
+{
+  a->op(OP_DUP);
+  a->op(OP_TOR);
+  a->op(OP_DUP);
+  a->op(OP_MUL);
+  a->op(OP_FROMR);
+  a->lit(3);
+  a->op(OP_MUL);
+  a->op(OP_ADD);
+  a->lit(1);
+  a->op(OP_ADD);
+  a->op(OP_RET);
+}
+
+/**
+ * Peephole output: LIT_ADD, DUP_JZ and DEC_JNN
+ *
+ *   : ODDS ( n -- c ) 0 SWAP BEGIN DUP 1 AND IF SWAP 1 + SWAP THEN
+ *     1 - DUP 0< UNTIL DROP ;
+ */
+static void asm_odds(Assembler* a)
+{
+  a->lit(0);
+  a->op(OP_SWAP);
+  size_t top = a->here();
+  a->op(OP_DUP);
+  a->lit(1);
+  a->op(OP_AND);
+  size_t to_even = a->branch_forward(OP_DUP_JZ);
+  a->op(OP_DROP);
+  a->op(OP_SWAP);
+  a->op_i32(OP_LIT_ADD, 1);
+  a->op(OP_SWAP);
+  size_t to_next = a->branch_forward(OP_JMP);
+  a->patch(to_even);
+  a->op(OP_DROP);
+  a->patch(to_next);
+  a->branch(OP_DEC_JNN, top);
+  a->op(OP_DROP);
+  a->op(OP_RET);
+}
+
+/** : TICK ( n -- ) BEGIN DUP 1 AND IF 7 1 GPIO-WRITE THEN 1 - DUP 0< UNTIL DROP ; */
+static void asm_tick(Assembler* a)
+{
+  size_t top = a->here();
+  a->op(OP_DUP);
+  a->lit(1);
+  a->op(OP_AND);
+  size_t skip = a->branch_forward(OP_JZ);
+  a->lit(7);
+  a->lit(1);
+  a->sys(SYS_GPIO_WRITE);
+  a->patch(skip);
+  a->lit(1);
+  a->op(OP_SUB);
+  a->op(OP_DUP);
+  a->lit(0);
+  a->op(OP_LT);
+  a->branch(OP_JZ, top);
+  a->op(OP_DROP);
+  a->op(OP_RET);
+}
+
+/** : DUP3 ( a -- a a a a ) DUP DUP DUP ; (data stack overflow) */
+static void asm_dup3(Assembler* a)
+{
+  a->op(OP_DUP);
+  a->op(OP_DUP);
+  a->op(OP_DUP);
+  a->op(OP_RET);
+}
+
+/** : RDROP R> DROP ; (pops its own return address: underflow at RET) */
+static void asm_rdrop(Assembler* a)
+{
+  a->op(OP_FROMR);
+  a->op(OP_DROP);
+  a->op(OP_RET);
+}
+
+struct WordDef
+{
+  const char* name;
+  const char* source;
+  void (*assemble)(Assembler* a);
+};
+
+static const WordDef WORDS[] = {
+    {"fib", ": FIB 0 1 ROT 0 DO OVER + SWAP LOOP DROP ;", asm_fib},
+    {"acc", ": ACC 0 SWAP 0 DO 3 + DUP 7 AND DUP IF + ELSE DROP THEN LOOP ;", asm_acc},
+    {"poly", ": POLY DUP >R DUP * R> 3 * + 1 + ;", asm_poly},
+    {"odds", ": ODDS .. DUP_JZ .. LIT_ADD .. DEC_JNN DROP ;", asm_odds},
+    {"tick", ": TICK BEGIN .. IF .. GPIO-WRITE THEN .. UNTIL DROP ;", asm_tick},
+    {"dup3", ": DUP3 DUP DUP DUP ;", asm_dup3},
+    {"rdrop", ": RDROP R> DROP ;", asm_rdrop},
+};
+
+// ==============================================================================
+// Native calls
+// ==============================================================================
+
+// Simulated memory (ESP32-C6 HP SRAM addresses)
+constexpr uint32_t SIM_BASE = 0x40800000u;
+constexpr size_t SIM_SIZE = 64 * 1024;
+constexpr uint32_t EXEC_ADDR = SIM_BASE;           // 32 KB executable buffer
+constexpr size_t EXEC_WORDS = 32 * 1024 / 4;
+constexpr uint32_t FRAME_ADDR = SIM_BASE + 0x8000;  // JitFrame
+constexpr uint32_t DS_ADDR = SIM_BASE + 0x8100;     // 256 cells
+constexpr uint32_t RS_ADDR = SIM_BASE + 0x8500;     // 64 cells
+constexpr uint64_t MAX_STEPS = 1ull << 30;
+
+/** Result of one call */
+struct Outcome
+{
+  int status;                  ///< Interpreter result
+  uint64_t sys_calls;          ///< SYS calls made
+  uint64_t sys_checksum;       ///< SYS argument mix
+  uint64_t dispatches;         ///< Opcodes dispatched (counting build)
+  uint64_t native_steps;       ///< Instructions retired by native code
+  bool native;                 ///< Native code ran
+  bool done;                   ///< Native code returned JIT_DONE
+  std::vector<int32_t> stack;  ///< Final data stack
+};
+
+static Outcome finish(BenchVm* vm, int status)
+{
+  Outcome o = {};
+  o.status = status;
+  o.sys_calls = vm->sys_calls;
+  o.sys_checksum = vm->sys_checksum;
+  o.dispatches = vm->dispatches;
+  o.stack.assign(vm->ds, vm->ds + (status == BENCH_OK ? vm->depth : 0));
+  return o;
+}
+
+/** Plain interpreted call */
+static Outcome run_interpreted(const std::vector<uint8_t>& code, size_t caller)
+{
+  static BenchVm vm;
+  vm.sys_calls = 0;
+  vm.sys_checksum = 0;
+  vm.dispatches = 0;
+  return finish(&vm, run_switch_count(&vm, code.data(), caller));
+}
+
+/**
+ * Call the word at @p entry like a JIT-enabled engine: ask the cache, run
+ * native code if there is any, let the interpreter finish
+ */
+static Outcome run_call(JitCache* cache, Rv32Sim* sim, const std::vector<uint8_t>& code,
+                        size_t entry, size_t caller, const std::vector<int32_t>& args)
+{
+  const uint32_t* fn = cache->lookup(code.data(), code.size(), entry);
+  if (fn == nullptr)
+  {
+    return run_interpreted(code, caller);
+  }
+
+  // State at the CALL: arguments on the data stack, return address pushed
+  const uint32_t* exec = reinterpret_cast<const uint32_t*>(sim->host(EXEC_ADDR));
+  uint32_t ret_ip = static_cast<uint32_t>(caller + args.size() * 5 + 3);
+  for (size_t i = 0; i < args.size(); i++)
+  {
+    sim->store32(DS_ADDR + static_cast<uint32_t>(i) * 4, static_cast<uint32_t>(args[i]));
+  }
+  sim->store32(RS_ADDR, ret_ip);
+  sim->store32(FRAME_ADDR + 0, DS_ADDR + static_cast<uint32_t>(args.size()) * 4);
+  sim->store32(FRAME_ADDR + 4, DS_ADDR);
+  sim->store32(FRAME_ADDR + 8, DS_ADDR + 256 * 4);
+  sim->store32(FRAME_ADDR + 12, RS_ADDR + 4);
+  sim->store32(FRAME_ADDR + 16, RS_ADDR);
+  sim->store32(FRAME_ADDR + 20, RS_ADDR + 64 * 4);
+  sim->store32(FRAME_ADDR + 24, 0);
+
+  uint32_t pc = EXEC_ADDR + static_cast<uint32_t>(fn - exec) * 4;
+  Rv32Sim::Result r = sim->call(pc, FRAME_ADDR, MAX_STEPS);
+  if (r != Rv32Sim::SIM_RETURNED)
+  {
+    fprintf(stderr, "native code %s at 0x%08x\n",
+            r == Rv32Sim::SIM_FAULT ? "faulted" : "timed out", sim->fault_pc());
+    Outcome o = {};
+    o.status = 1;
+    return o;
+  }
+
+  // Hand the stacks to the interpreter
+  static BenchVm vm;
+  uint32_t sp = sim->load32(FRAME_ADDR + 0);
+  uint32_t rp = sim->load32(FRAME_ADDR + 12);
+  vm.depth = static_cast<int32_t>((sp - DS_ADDR) / 4);
+  vm.rdepth = static_cast<int32_t>((rp - RS_ADDR) / 4);
+  memcpy(vm.ds, sim->host(DS_ADDR), sizeof(vm.ds));
+  memcpy(vm.rs, sim->host(RS_ADDR), sizeof(vm.rs));
+  vm.sys_calls = 0;
+  vm.sys_checksum = 0;
+  vm.dispatches = 0;
+
+  uint32_t result = sim->reg(10);
+  size_t ip = result == JIT_EXIT ? sim->load32(FRAME_ADDR + 24) : ret_ip;
+  if (result == JIT_DONE)
+  {
+    vm.rdepth--;  // RET
+  }
+  Outcome o = finish(&vm, resume_switch_count(&vm, code.data(), ip));
+  o.native_steps = sim->steps();
+  o.native = true;
+  o.done = result == JIT_DONE;
+  return o;
+}
+
+static bool same(const Outcome& a, const Outcome& b)
+{
+  return a.status == b.status && a.sys_calls == b.sys_calls &&
+         a.sys_checksum == b.sys_checksum && a.stack == b.stack;
+}
+
+/** Word plus caller assembled for one argument list */
+static Word build(const WordDef& def, const std::vector<int32_t>& args, size_t* caller)
+{
+  Assembler a;
+  def.assemble(&a);
+  *caller = add_caller(&a, 0, args);
+  return Word{def.name, def.source, a.code(), 0};
+}
+
+// ==============================================================================
+// Modes
+// ==============================================================================
+
+/** Arguments tried per word in --verify */
+static std::vector<std::vector<int32_t>> verify_args(const char* name)
+{
+  if (strcmp(name, "dup3") == 0)
+  {
+    // 252 fits, 253 overflows on the last DUP, 256 on the first
+    std::vector<std::vector<int32_t>> sets;
+    for (size_t n : {1, 252, 253, 254, 256})
+    {
+      sets.push_back(std::vector<int32_t>(n, 5));
+    }
+    return sets;
+  }
+  if (strcmp(name, "rdrop") == 0)
+  {
+    return {{}, {1}};
+  }
+  // Also no argument at all: stack underflow on the first pop
+  return {{}, {0}, {1}, {2}, {3}, {7}, {30}, {64}, {-1}, {1000}, {46341}, {INT32_MIN}};
+}
+
+static int run_verify(Rv32Jit* jit, Rv32Sim* sim)
+{
+  int cases = 0;
+  int failures = 0;
+  for (const WordDef& def : WORDS)
+  {
+    for (const std::vector<int32_t>& args : verify_args(def.name))
+    {
+      // Loop words with huge counts are left to the benchmark
+      if (!args.empty() && (args[0] > 100000 || args[0] < -1) &&
+          strcmp(def.name, "poly") != 0)
+      {
+        continue;
+      }
+      size_t caller = 0;
+      Word w = build(def, args, &caller);
+      JitCache cache(jit, reinterpret_cast<uint32_t*>(sim->host(EXEC_ADDR)), EXEC_WORDS,
+                     1, nullptr);
+      Outcome ref = run_interpreted(w.code, caller);
+      Outcome got = run_call(&cache, sim, w.code, w.entry, caller, args);
+      cases++;
+      if (!got.native || !same(ref, got))
+      {
+        failures++;
+        printf("MISMATCH %-6s args=%zu (first %d): status %d/%d depth %zu/%zu "
+               "sys %llu/%llu\n",
+               def.name, args.size(), args.empty() ? 0 : args[0], ref.status, got.status,
+               ref.stack.size(), got.stack.size(), (unsigned long long)ref.sys_calls,
+               (unsigned long long)got.sys_calls);
+      }
+    }
+  }
+  printf("jit verify: %d cases, %d mismatches\n", cases, failures);
+  return failures == 0 ? 0 : 1;
+}
+
+static int run_bench(Rv32Jit* jit, Rv32Sim* sim, int32_t iterations, uint32_t threshold)
+{
+  static const char* const BENCH_WORDS[] = {"fib", "acc", "poly", "odds", "tick"};
+
+  JitCache cache(jit, reinterpret_cast<uint32_t*>(sim->host(EXEC_ADDR)), EXEC_WORDS,
+                 threshold, nullptr);
+  // Cached words are keyed by code address: keep every word alive
+  std::vector<Word> words;
+  words.reserve(sizeof(BENCH_WORDS) / sizeof(BENCH_WORDS[0]));
+  int failures = 0;
+  printf("Template JIT: interpreted dispatches vs. native RV32 instructions\n");
+  printf("(each word called %u times through the JIT cache; last call shown)\n",
+         threshold + 1);
+  printf("%-6s %9s %12s %12s %10s %9s %8s\n", "", "bytes", "dispatches", "native insn",
+         "interp", "insn/op", "result");
+
+  for (const char* name : BENCH_WORDS)
+  {
+    const WordDef* def = nullptr;
+    for (const WordDef& d : WORDS)
+    {
+      def = strcmp(d.name, name) == 0 ? &d : def;
+    }
+    std::vector<int32_t> args = {strcmp(name, "poly") == 0 ? 12345 : iterations};
+    size_t caller = 0;
+    words.push_back(build(*def, args, &caller));
+    const Word& w = words.back();
+
+    size_t native_before = cache.stats().exec_used;
+    Outcome ref = run_interpreted(w.code, caller);
+    Outcome got = {};
+    for (uint32_t i = 0; i <= threshold; i++)
+    {
+      got = run_call(&cache, sim, w.code, w.entry, caller, args);
+    }
+    if (!same(ref, got))
+    {
+      failures++;
+      printf("%-6s MISMATCH\n", name);
+      continue;
+    }
+
+    // The caller's LITs, CALL and HALT are not part of the word
+    uint64_t word_ops = ref.dispatches - args.size() - 2;
+    uint64_t left = got.dispatches > 0 ? got.dispatches - 1 : 0;
+    size_t native_bytes = cache.stats().exec_used - native_before;
+    printf("%-6s %3zu->%-5zu %12llu %12llu %10llu %9.2f %8s\n", name, caller,
+           native_bytes, (unsigned long long)word_ops,
+           (unsigned long long)got.native_steps, (unsigned long long)left,
+           word_ops > 0 ? (double)got.native_steps / (double)word_ops : 0.0,
+           got.done ? "done" : "exit");
+  }
+
+  const JitCache::Stats& s = cache.stats();
+  printf("cache: lookups=%u compiled=%u native_runs=%u failed=%u exec_used=%zu bytes\n",
+         s.lookups, s.compiled, s.native_runs, s.failed, s.exec_used);
+  return failures == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv)
+{
+  int32_t iterations = 100000;
+  int32_t threshold = 2;
+  bool verify_only = false;
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+    {
+      iterations = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc)
+    {
+      threshold = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--verify") == 0)
+    {
+      verify_only = true;
+    }
+    else
+    {
+      fprintf(stderr, "Usage: %s [--iterations N] [--threshold N] [--verify]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (iterations <= 0 || threshold <= 0)
+  {
+    fprintf(stderr, "Invalid --iterations/--threshold\n");
+    return 2;
+  }
+
+  static const JitIsa isa = make_isa();
+  Rv32Jit jit(isa);
+  static Rv32Sim sim(SIM_BASE, SIM_SIZE);
+
+  if (verify_only)
+  {
+    return run_verify(&jit, &sim);
+  }
+  return run_bench(&jit, &sim, iterations, static_cast<uint32_t>(threshold));
+}
@@ -0,0 +1,266 @@
+/**
+ * @file link_ingest_bench.cpp
+ * @brief V4-link ingestion benchmark (per-byte vs. bulk)
+ *
+ * Measures how many bytes per second the runtime can push through the
+ * V4-link framing layer for a bytecode-upload-like stream:
+ *
+ * - per-byte: one out-of-line call and state-machine step per byte,
+ *   payload copied into a 512-byte frame buffer (the former poll() path)
+ * - bulk: LinkFrameScanner fed whole read chunks, frames handed out in place
+ *
+ * Usage:
+ *   v4-bench-link-ingest [--mb N] [--chunk N] [--payload N]
+ *
+ * SPDX-License-Identifier: MIT OR Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <time.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "link_frame_scanner.hpp"
+#include "v4link_wire.hpp"
+
+using namespace v4rtos;
+
+// ==============================================================================
+// Reference per-byte decoder
+// ==============================================================================
+
+/**
+ * @brief Byte-at-a-time frame decoder
+ *
+ * Same structure as a classic V4-link receive state machine: every byte
+ * is fed through an out-of-line call, the payload is copied into a fixed
+ * buffer and the CRC is updated bit by bit.
+ */
+class PerByteDecoder
+{
+ public:
+  uint64_t frames = 0;
+  uint64_t payload_bytes = 0;
+
+  __attribute__((noinline)) void feed_byte(uint8_t b)
+  {
+    switch (state_)
+    {
+      case State::WAIT_STX:
+        if (b == link_wire::STX)
+        {
+          crc_ = 0;
+          state_ = State::LEN_L;
+        }
+        break;
+      case State::LEN_L:
+        len_ = b;
+        crc_ = crc_step(crc_, b);
+        state_ = State::LEN_H;
+        break;
+      case State::LEN_H:
+        len_ |= static_cast<size_t>(b) << 8;
+        crc_ = crc_step(crc_, b);
+        state_ = len_ > sizeof(buf_) ? State::WAIT_STX : State::CMD;
+        break;
+      case State::CMD:
+        crc_ = crc_step(crc_, b);
+        pos_ = 0;
+        state_ = len_ > 0 ? State::DATA : State::CRC;
+        break;
+      case State::DATA:
+        buf_[pos_++] = b;
+        crc_ = crc_step(crc_, b);
+        if (pos_ == len_)
+        {
+          state_ = State::CRC;
+        }
+        break;
+      case State::CRC:
+        if (b == crc_)
+        {
+          frames++;
+          payload_bytes += len_;
+        }
+        state_ = State::WAIT_STX;
+        break;
+    }
+  }
+
+ private:
+  enum class State
+  {
+    WAIT_STX,
+    LEN_L,
+    LEN_H,
+    CMD,
+    DATA,
+    CRC
+  };
+
+  static uint8_t crc_step(uint8_t crc, uint8_t b)
+  {
+    crc ^= b;
+    for (int i = 0; i < 8; i++)
+    {
+      crc = (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ 0x07)
+                         : static_cast<uint8_t>(crc << 1);
+    }
+    return crc;
+  }
+
+  State state_ = State::WAIT_STX;
+  size_t len_ = 0;
+  size_t pos_ = 0;
+  uint8_t crc_ = 0;
+  uint8_t buf_[512];
+};
+
+// ==============================================================================
+// Bulk path sink
+// ==============================================================================
+
+struct BulkSink
+{
+  uint64_t frames = 0;
+  uint64_t payload_bytes = 0;
+};
+
+static void bulk_on_frame(void* user, const LinkFrameView& frame)
+{
+  auto* sink = static_cast<BulkSink*>(user);
+  if (frame.crc_ok)
+  {
+    sink->frames++;
+    sink->payload_bytes += frame.len;
+  }
+}
+
+// ==============================================================================
+// Helpers
+// ==============================================================================
+
+static double now_seconds(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Build an upload-like stream of EXEC frames
+ *
+ * Payload sizes are pseudo-random up to @p max_payload, contents mimic
+ * bytecode (small opcodes with occasional 32-bit literals).
+ */
+static std::vector<uint8_t> build_stream(size_t total_bytes, size_t max_payload)
+{
+  std::vector<uint8_t> stream;
+  stream.reserve(total_bytes + max_payload + link_wire::OVERHEAD);
+  std::vector<uint8_t> payload(max_payload);
+  uint32_t seed = 0x1234567u;
+
+  while (stream.size() < total_bytes)
+  {
+    seed = seed * 1103515245u + 12345u;
+    size_t len = max_payload / 2 + (seed >> 8) % (max_payload / 2 + 1);
+    for (size_t i = 0; i < len; i++)
+    {
+      seed = seed * 1103515245u + 12345u;
+      payload[i] = static_cast<uint8_t>((seed >> 16) & 0x3F);
+    }
+    size_t pos = stream.size();
+    stream.resize(pos + len + link_wire::OVERHEAD);
+    link_wire::encode_frame(link_wire::CMD_EXEC, payload.data(), len, &stream[pos]);
+  }
+  return stream;
+}
+
+static void report(const char* name, double seconds, size_t bytes, uint64_t frames)
+{
+  double mbps = (double)bytes / seconds / (1024.0 * 1024.0);
+  printf("%-10s %10.3f s %12.1f MB/s %12llu frames\n", name, seconds, mbps,
+         (unsigned long long)frames);
+}
+
+// ==============================================================================
+// Main
+// ==============================================================================
+
+int main(int argc, char** argv)
+{
+  size_t total_mb = 64;
+  size_t chunk = 512;
+  size_t max_payload = 508;
+
+  for (int i = 1; i + 1 < argc; i += 2)
+  {
+    if (strcmp(argv[i], "--mb") == 0)
+    {
+      total_mb = strtoul(argv[i + 1], nullptr, 0);
+    }
+    else if (strcmp(argv[i], "--chunk") == 0)
+    {
+      chunk = strtoul(argv[i + 1], nullptr, 0);
+    }
+    else if (strcmp(argv[i], "--payload") == 0)
+    {
+      max_payload = strtoul(argv[i + 1], nullptr, 0);
+    }
+    else
+    {
+      fprintf(stderr, "Usage: %s [--mb N] [--chunk N] [--payload N]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (chunk == 0 || max_payload < 2 || max_payload > 512)
+  {
+    fprintf(stderr, "Invalid --chunk/--payload\n");
+    return 2;
+  }
+
+  std::vector<uint8_t> stream = build_stream(total_mb * 1024 * 1024, max_payload);
+  printf("V4-link ingest: %zu bytes, read chunk %zu, payload <= %zu\n", stream.size(),
+         chunk, max_payload);
+
+  // Before: per-byte feed
+  PerByteDecoder decoder;
+  double t0 = now_seconds();
+  for (size_t off = 0; off < stream.size(); off += chunk)
+  {
+    size_t n = stream.size() - off < chunk ? stream.size() - off : chunk;
+    for (size_t i = 0; i < n; i++)
+    {
+      decoder.feed_byte(stream[off + i]);
+    }
+  }
+  double per_byte_s = now_seconds() - t0;
+
+  // After: bulk scanner
+  BulkSink sink;
+  LinkFrameScanner scanner(512, bulk_on_frame, &sink);
+  t0 = now_seconds();
+  for (size_t off = 0; off < stream.size(); off += chunk)
+  {
+    size_t n = stream.size() - off < chunk ? stream.size() - off : chunk;
+    scanner.feed(&stream[off], n);
+  }
+  double bulk_s = now_seconds() - t0;
+
+  report("per-byte", per_byte_s, stream.size(), decoder.frames);
+  report("bulk", bulk_s, stream.size(), sink.frames);
+  printf("speedup    %10.2fx (staged %llu of %llu frames)\n", per_byte_s / bulk_s,
+         (unsigned long long)scanner.stats().staged_frames,
+         (unsigned long long)sink.frames);
+
+  if (decoder.frames != sink.frames || decoder.payload_bytes != sink.payload_bytes)
+  {
+    fprintf(stderr, "MISMATCH: per-byte %llu frames, bulk %llu frames\n",
+            (unsigned long long)decoder.frames, (unsigned long long)sink.frames);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,332 @@
+/**
+ * @file link_latency_bench.cpp
+ * @brief V4-link latency/throughput harness (polling vs. event-driven)
+ *
+ * Runs a device-side link loop against a socketpair standing in for
+ * USB Serial/JTAG and measures, for each receive strategy:
+ *
+ * - command round-trip latency (PING -> response)
+ * - upload throughput (EXEC stream followed by a PING barrier)
+ * - idle wakeups per second
+ * - upload throughput while the host never reads responses (stalled host)
+ *
+ * Strategies:
+ * - poll:  128-byte non-blocking read, then sleep 1 ms (former app_main loop)
+ * - event: block until readable, drain with 512-byte reads (link task)
+ *
+ * Responses go through the runtime's TxRing, so a stalled host costs
+ * dropped responses instead of a blocked device.
+ *
+ * Usage:
+ *   v4-bench-link-latency [--pings N] [--mb N]
+ *
+ * SPDX-License-Identifier: MIT OR Apache-2.0
+ */
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "link_frame_scanner.hpp"
+#include "posix_rx.hpp"
+#include "tx_ring.hpp"
+#include "v4link_wire.hpp"
+
+using namespace v4rtos;
+
+// ==============================================================================
+// Helpers
+// ==============================================================================
+
+static double now_seconds(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void write_all(int fd, const uint8_t* data, size_t len)
+{
+  while (len > 0)
+  {
+    ssize_t n = write(fd, data, len);
+    if (n > 0)
+    {
+      data += n;
+      len -= (size_t)n;
+    }
+    else if (n < 0 && errno != EINTR)
+    {
+      return;
+    }
+  }
+}
+
+// ==============================================================================
+// Device Side
+// ==============================================================================
+
+enum class RxMode
+{
+  POLL,
+  EVENT
+};
+
+/**
+ * @brief Device-side link loop under test
+ *
+ * Replies STATUS_OK to every PING so the host can time round trips and
+ * use a PING as a barrier after an upload. Replies are queued in a TxRing
+ * and flushed once per receive batch, as in PosixLinkPort.
+ */
+class Device
+{
+ public:
+  Device(int fd, RxMode mode)
+      : fd_(fd), mode_(mode), scanner_(512, on_frame, this), tx_(2048, tx_sink, &fd_, 20)
+  {
+    fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL, 0) | O_NONBLOCK);
+  }
+
+  void run()
+  {
+    bool eof = false;
+    auto on_chunk = [this](const uint8_t* data, size_t len) { scanner_.feed(data, len); };
+
+    while (!eof)
+    {
+      wakeups.fetch_add(1, std::memory_order_relaxed);
+      if (mode_ == RxMode::POLL)
+      {
+        uint8_t buffer[128];
+        ssize_t len = read(fd_, buffer, sizeof(buffer));
+        if (len > 0)
+        {
+          on_chunk(buffer, (size_t)len);
+        }
+        else if (len == 0)
+        {
+          eof = true;
+        }
+        usleep(1000);
+      }
+      else
+      {
+        uint8_t buffer[512];
+        if (posix_rx_wait(fd_, -1) == RxWait::READABLE)
+        {
+          posix_rx_drain(fd_, buffer, sizeof(buffer), on_chunk, &eof);
+        }
+      }
+      tx_.flush(0);
+    }
+  }
+
+  const TxRing::Stats& tx_stats() const
+  {
+    return tx_.stats();
+  }
+
+  std::atomic<uint64_t> wakeups{0};
+  std::atomic<uint64_t> exec_bytes{0};
+
+ private:
+  static void on_frame(void* user, const LinkFrameView& frame)
+  {
+    auto* self = static_cast<Device*>(user);
+    if (!frame.crc_ok)
+    {
+      return;
+    }
+    if (frame.cmd == link_wire::CMD_PING)
+    {
+      uint8_t resp[link_wire::OVERHEAD];
+      size_t n = link_wire::encode_frame(link_wire::STATUS_OK, nullptr, 0, resp);
+      self->tx_.write(resp, n);
+    }
+    else
+    {
+      self->exec_bytes.fetch_add(frame.len, std::memory_order_relaxed);
+    }
+  }
+
+  static size_t tx_sink(void* user, const uint8_t* data, size_t len, uint32_t timeout_ms)
+  {
+    int fd = *static_cast<int*>(user);
+    ssize_t n = write(fd, data, len);
+    if (n < 0 && errno == EAGAIN && timeout_ms > 0)
+    {
+      struct pollfd pfd = {fd, POLLOUT, 0};
+      ::poll(&pfd, 1, (int)timeout_ms);
+      n = write(fd, data, len);
+    }
+    return n > 0 ? (size_t)n : 0;
+  }
+
+  int fd_;
+  RxMode mode_;
+  LinkFrameScanner scanner_;
+  TxRing tx_;
+};
+
+// ==============================================================================
+// Host Side
+// ==============================================================================
+
+/** Send a PING and block until the response frame is read */
+static double ping(int fd)
+{
+  uint8_t frame[link_wire::OVERHEAD];
+  size_t n = link_wire::encode_frame(link_wire::CMD_PING, nullptr, 0, frame);
+  double t0 = now_seconds();
+  write_all(fd, frame, n);
+
+  uint8_t resp[link_wire::OVERHEAD];
+  size_t got = 0;
+  while (got < sizeof(resp))
+  {
+    ssize_t r = read(fd, resp + got, sizeof(resp) - got);
+    if (r <= 0)
+    {
+      return -1.0;
+    }
+    got += (size_t)r;
+  }
+  return now_seconds() - t0;
+}
+
+static void run_mode(RxMode mode, int pings, size_t upload_mb)
+{
+  int sv[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0)
+  {
+    perror("socketpair");
+    exit(1);
+  }
+
+  Device device(sv[1], mode);
+  std::thread device_thread([&device]() { device.run(); });
+  int host = sv[0];
+
+  const size_t frame_size = 508 + link_wire::OVERHEAD;
+
+  // 1. Round-trip latency
+  std::vector<double> rtt;
+  rtt.reserve((size_t)pings);
+  for (int i = 0; i < pings; i++)
+  {
+    rtt.push_back(ping(host));
+  }
+  std::sort(rtt.begin(), rtt.end());
+
+  // 2. Upload throughput: EXEC stream, then a PING barrier
+  std::vector<uint8_t> stream;
+  std::vector<uint8_t> payload(508, 0x11);
+  while (stream.size() < upload_mb * 1024 * 1024)
+  {
+    size_t pos = stream.size();
+    stream.resize(pos + payload.size() + link_wire::OVERHEAD);
+    link_wire::encode_frame(link_wire::CMD_EXEC, payload.data(), payload.size(),
+                            &stream[pos]);
+  }
+  double t0 = now_seconds();
+  write_all(host, stream.data(), stream.size());
+  ping(host);
+  double upload_s = now_seconds() - t0;
+
+  // 3. Idle wakeups
+  uint64_t w0 = device.wakeups.load();
+  usleep(1000 * 1000);
+  uint64_t idle_wakeups = device.wakeups.load() - w0;
+
+  // 4. Stalled host: flood PINGs without reading a single response, then
+  //    upload again and wait for the device to have consumed everything
+  std::vector<uint8_t> pings_stream;
+  for (int i = 0; i < 100000; i++)
+  {
+    uint8_t frame[link_wire::OVERHEAD];
+    link_wire::encode_frame(link_wire::CMD_PING, nullptr, 0, frame);
+    pings_stream.insert(pings_stream.end(), frame, frame + sizeof(frame));
+  }
+  uint64_t expected = device.exec_bytes.load() + (stream.size() / frame_size) * 508;
+  t0 = now_seconds();
+  write_all(host, pings_stream.data(), pings_stream.size());
+  write_all(host, stream.data(), stream.size());
+  while (device.exec_bytes.load() < expected)
+  {
+    usleep(100);
+  }
+  double stalled_s = now_seconds() - t0;
+
+  close(host);
+  device_thread.join();
+  close(sv[1]);
+  const TxRing::Stats& tx = device.tx_stats();
+
+  auto pct = [&rtt](double p) { return rtt[(size_t)(p * (double)(rtt.size() - 1))]; };
+  printf("%-6s rtt p50 %8.1f us  p99 %8.1f us  max %8.1f us | upload %8.2f MB/s | "
+         "idle %5llu wakeups/s\n",
+         mode == RxMode::POLL ? "poll" : "event", pct(0.50) * 1e6, pct(0.99) * 1e6,
+         rtt.back() * 1e6, (double)stream.size() / upload_s / (1024.0 * 1024.0),
+         (unsigned long long)idle_wakeups);
+  printf("%-6s stalled host: upload %8.2f MB/s | tx %llu flushed, %llu dropped "
+         "(%llu responses)\n",
+         "",
+         (double)(stream.size() + pings_stream.size()) / stalled_s / (1024.0 * 1024.0),
+         (unsigned long long)tx.flushed_bytes, (unsigned long long)tx.dropped_bytes,
+         (unsigned long long)tx.dropped_writes);
+}
+
+// ==============================================================================
+// Main
+// ==============================================================================
+
+int main(int argc, char** argv)
+{
+  int pings = 500;
+  size_t upload_mb = 4;
+
+  for (int i = 1; i + 1 < argc; i += 2)
+  {
+    if (strcmp(argv[i], "--pings") == 0)
+    {
+      pings = atoi(argv[i + 1]);
+    }
+    else if (strcmp(argv[i], "--mb") == 0)
+    {
+      upload_mb = strtoul(argv[i + 1], nullptr, 0);
+    }
+    else
+    {
+      fprintf(stderr, "Usage: %s [--pings N] [--mb N]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (pings <= 0)
+  {
+    fprintf(stderr, "Invalid --pings\n");
+    return 2;
+  }
+
+  // The device side may still flush responses after the host has closed
+  signal(SIGPIPE, SIG_IGN);
+
+  printf("V4-link latency: %d pings, %zu MB upload, socketpair transport\n", pings,
+         upload_mb);
+  run_mode(RxMode::POLL, pings, upload_mb);
+  run_mode(RxMode::EVENT, pings, upload_mb);
+  return 0;
+}
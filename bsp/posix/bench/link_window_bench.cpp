@@ -0,0 +1,542 @@
+/**
+ * @file link_window_bench.cpp
+ * @brief Windowed (pipelined) vs. stop-and-wait uploads over a simulated link
+ *
+ * Uploads a bytecode image into an ImageStore slot (RAM stand-in for NOR
+ * flash) through the device-side runtime path (frame scanner, runtime
+ * commands, LinkWindow) over a simulated link with a line rate, a one-way
+ * latency, a fixed device time per frame and random frame loss in both
+ * directions. Time is simulated with discrete events, so the results are
+ * exact and repeatable for a given --seed.
+ *
+ * Stop-and-wait is the plain protocol: one IMAGE WRITE, then its response
+ * (resent after a timeout if either got lost). Windowed runs wrap the same
+ * WRITEs in CMD_WINDOW DATA frames and keep up to the negotiated window in
+ * flight, resending the frames the SACK bitmaps show missing, or the
+ * oldest one after a timeout. Every run ends with COMMIT, whose CRC check
+ * and a comparison of the slot prove each WRITE landed exactly once.
+ *
+ * Usage:
+ *   v4-bench-link-window [--kbps N] [--latency-us N] [--device-us N]
+ *                        [--loss P] [--window-kb N] [--seed N]
+ *
+ * SPDX-License-Identifier: MIT OR Apache-2.0
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "image_store.hpp"
+#include "link_frame_scanner.hpp"
+#include "link_runtime_commands.hpp"
+#include "link_window.hpp"
+#include "v4link_wire.hpp"
+
+using namespace v4rtos;
+
+static constexpr size_t PARTITION_SIZE = 128 * 1024;  ///< Two 64 KB slots
+static constexpr size_t SECTOR_SIZE = 4096;           ///< Erase granularity
+static constexpr size_t BUFFER_SIZE = 512;            ///< Device V4-link buffer
+static constexpr size_t CHUNK = 256;                  ///< Code bytes per WRITE
+static constexpr size_t IMAGE_SIZE = 60 * 1024;       ///< Uploaded image
+
+/** Simulated link parameters */
+struct Config
+{
+  double rate = 400.0 * 1024.0;  ///< Line rate per direction (bytes/s)
+  double latency_us = 500.0;     ///< One-way latency
+  double device_us = 100.0;      ///< Device time per frame (handler, flash)
+  double loss = 0.0;             ///< Probability that a frame is lost
+  size_t window_kb = 4;          ///< Device reorder buffer (CONFIG_V4_LINK_WINDOW_KB)
+  unsigned seed = 1;             ///< Loss pattern
+};
+
+static double s_now_us = 0.0;  ///< Simulated time
+
+// ==============================================================================
+// Simulated Link
+// ==============================================================================
+
+/**
+ * @brief One direction of the link: frames serialize at the line rate,
+ *        then arrive after the latency
+ */
+class Wire
+{
+ public:
+  Wire(double rate, double latency_us) : rate_(rate), latency_us_(latency_us) {}
+
+  /** Arrival time of a frame of @p bytes handed over at @p t */
+  double send(double t, size_t bytes)
+  {
+    double start = t > free_us_ ? t : free_us_;
+    free_us_ = start + (double)bytes * 1e6 / rate_;
+    return free_us_ + latency_us_;
+  }
+
+ private:
+  double rate_;           ///< Bytes per second
+  double latency_us_;     ///< Propagation delay
+  double free_us_ = 0.0;  ///< Time the line is free again
+};
+
+/** Frame in flight */
+struct Event
+{
+  double t;                    ///< Arrival time
+  uint64_t order;              ///< Tie-break: send order
+  bool to_device;              ///< Direction
+  std::vector<uint8_t> frame;  ///< Encoded frame
+};
+
+struct Later
+{
+  bool operator()(const Event& a, const Event& b) const
+  {
+    return a.t != b.t ? a.t > b.t : a.order > b.order;
+  }
+};
+
+using EventQueue = std::priority_queue<Event, std::vector<Event>, Later>;
+
+/**
+ * @brief Host, link and device in one discrete-event simulation
+ */
+class Sim
+{
+ public:
+  explicit Sim(const Config& cfg)
+      : cfg_(cfg),
+        down_(cfg.rate, cfg.latency_us),
+        up_(cfg.rate, cfg.latency_us),
+        rng_(cfg.seed),
+        flash_mem_(PARTITION_SIZE, 0xFF),
+        scanner_(BUFFER_SIZE, on_frame, this),
+        cmds_(BUFFER_SIZE),
+        window_(&cmds_, BUFFER_SIZE, cfg.window_kb * 1024)
+  {
+    s_now_us = 0.0;
+    ImageFlash flash = {flash_mem_.data(), flash_mem_.size(), SECTOR_SIZE,
+                        flash_erase,       flash_write,       this};
+    store_ = new ImageStore(flash, clock_ms, 10000);
+    store_->boot();
+    cmds_.add(link_wire::CMD_IMAGE, ImageStore::handle_command, store_);
+    cmds_.add(link_wire::CMD_WINDOW, LinkWindow::handle_command, &window_);
+  }
+
+  ~Sim()
+  {
+    delete store_;
+  }
+
+  /** Send a request frame now (it may get lost) */
+  void host_send(uint8_t cmd, const std::vector<uint8_t>& payload)
+  {
+    std::vector<uint8_t> frame(payload.size() + link_wire::OVERHEAD);
+    link_wire::encode_frame(cmd, payload.data(), payload.size(), frame.data());
+    frames_sent++;
+    double t = down_.send(s_now_us, frame.size());
+    if (!lost())
+    {
+      events_.push(Event{t, order_++, true, std::move(frame)});
+    }
+  }
+
+  /**
+   * @brief Advance time until a response reaches the host
+   * @return false if none arrived before @p deadline_us (time is then
+   *         the deadline)
+   */
+  bool host_receive(double deadline_us, uint8_t* status, std::vector<uint8_t>* data)
+  {
+    while (!events_.empty() && events_.top().t <= deadline_us)
+    {
+      Event ev = events_.top();
+      events_.pop();
+      s_now_us = ev.t;
+      if (ev.to_device)
+      {
+        scanner_.feed(ev.frame.data(), ev.frame.size());
+        continue;
+      }
+      *status = ev.frame[3];
+      data->assign(ev.frame.begin() + link_wire::HEADER_SIZE, ev.frame.end() - 1);
+      return true;
+    }
+    s_now_us = deadline_us;
+    return false;
+  }
+
+  /** Retransmission timeout with @p window frames in flight */
+  double rto_us(size_t window) const
+  {
+    double frame_us = (double)(BUFFER_SIZE + link_wire::OVERHEAD) * 1e6 / cfg_.rate;
+    double queued_us = (double)(window + 1) * (frame_us + cfg_.device_us);
+    return 2.0 * (2.0 * cfg_.latency_us + queued_us) + 1000.0;
+  }
+
+  /** Code of an image slot */
+  const uint8_t* slot_code(uint8_t slot) const
+  {
+    return flash_mem_.data() + slot * (PARTITION_SIZE / 2) + sizeof(ImageStore::Header);
+  }
+
+  size_t frames_sent = 0;  ///< Request frames put on the wire
+  size_t resent = 0;       ///< Of those, retransmissions
+  size_t timeouts = 0;     ///< Retransmission timeouts
+
+ private:
+  bool lost()
+  {
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    return cfg_.loss > 0.0 && uniform(rng_) < cfg_.loss;
+  }
+
+  static uint32_t clock_ms(void)
+  {
+    return (uint32_t)(s_now_us / 1000.0);
+  }
+
+  static bool flash_erase(void* user, size_t offset, size_t len)
+  {
+    memset(static_cast<Sim*>(user)->flash_mem_.data() + offset, 0xFF, len);
+    return true;
+  }
+
+  static bool flash_write(void* user, size_t offset, const uint8_t* data, size_t len)
+  {
+    uint8_t* dst = static_cast<Sim*>(user)->flash_mem_.data() + offset;
+    for (size_t i = 0; i < len; i++)
+    {
+      dst[i] &= data[i];
+    }
+    return memcmp(dst, data, len) == 0;
+  }
+
+  // Device: handle the frame once the previous one is done, reply after device_us
+  static void on_frame(void* user, const LinkFrameView& frame)
+  {
+    auto* self = static_cast<Sim*>(user);
+    if (!link_wire::is_runtime_cmd(frame.cmd))
+    {
+      return;
+    }
+    size_t len = 0;
+    const uint8_t* resp = self->cmds_.handle(frame, &len);
+
+    double start = s_now_us > self->device_free_us_ ? s_now_us : self->device_free_us_;
+    self->device_free_us_ = start + self->cfg_.device_us;
+    double t = self->up_.send(self->device_free_us_, len);
+    if (!self->lost())
+    {
+      std::vector<uint8_t> reply(resp, resp + len);
+      self->events_.push(Event{t, self->order_++, false, std::move(reply)});
+    }
+  }
+
+  Config cfg_;                      ///< Link parameters
+  Wire down_;                       ///< Host to device
+  Wire up_;                         ///< Device to host
+  std::mt19937 rng_;                ///< Loss pattern
+  EventQueue events_;               ///< Frames in flight
+  uint64_t order_ = 0;              ///< Event tie-break
+  double device_free_us_ = 0.0;     ///< Device busy until
+  std::vector<uint8_t> flash_mem_;  ///< Image partition
+  LinkFrameScanner scanner_;        ///< Device RX
+  LinkRuntimeCommands cmds_;        ///< Device commands
+  LinkWindow window_;               ///< CMD_WINDOW
+  ImageStore* store_ = nullptr;     ///< CMD_IMAGE
+};
+
+// ==============================================================================
+// Host Side
+// ==============================================================================
+
+/** Stop-and-wait request, resent until answered */
+static bool request(Sim& sim, uint8_t cmd, const std::vector<uint8_t>& payload,
+                    std::vector<uint8_t>* resp, bool resend = false)
+{
+  for (int tries = 0; tries < 100; tries++)
+  {
+    sim.host_send(cmd, payload);
+    if (resend)
+    {
+      sim.resent++;
+    }
+    uint8_t status = 0;
+    if (sim.host_receive(s_now_us + sim.rto_us(1), &status, resp))
+    {
+      return status == link_wire::STATUS_OK;
+    }
+    sim.timeouts++;
+    resend = true;
+  }
+  return false;
+}
+
+/** IMAGE WRITE payload of chunk @p i */
+static std::vector<uint8_t> write_payload(const std::vector<uint8_t>& image, size_t i)
+{
+  size_t off = i * CHUNK;
+  size_t n = image.size() - off < CHUNK ? image.size() - off : CHUNK;
+  std::vector<uint8_t> p = {ImageStore::OP_WRITE};
+  for (int b = 0; b < 4; b++)
+  {
+    p.push_back((uint8_t)(off >> (8 * b)));
+  }
+  p.insert(p.end(), image.data() + off, image.data() + off + n);
+  return p;
+}
+
+/** WRITEs wrapped in CMD_WINDOW, SACK-driven retransmission */
+static bool upload_windowed(Sim& sim, const std::vector<uint8_t>& image, uint8_t want,
+                            uint8_t* window)
+{
+  std::vector<uint8_t> resp;
+  if (!request(sim, link_wire::CMD_WINDOW, {LinkWindow::OP_OPEN, want}, &resp) ||
+      resp.size() < 3)
+  {
+    return false;
+  }
+  *window = resp[0];
+
+  const size_t n = (image.size() + CHUNK - 1) / CHUNK;
+  const double rto = sim.rto_us(*window);
+  std::vector<uint64_t> order(n, 0);  // Send order of each frame's last copy
+  std::vector<bool> held(n, false);   // Reported in a SACK bitmap
+  uint64_t sent = 0;
+  size_t base = 0;  // Oldest unacknowledged frame
+  size_t next = 0;  // Next new frame
+  double deadline = 0.0;
+
+  auto transmit = [&](size_t s)
+  {
+    std::vector<uint8_t> p = {LinkWindow::OP_DATA, (uint8_t)s, (uint8_t)(s >> 8),
+                              link_wire::CMD_IMAGE};
+    std::vector<uint8_t> w = write_payload(image, s);
+    p.insert(p.end(), w.begin(), w.end());
+    sim.host_send(link_wire::CMD_WINDOW, p);
+    order[s] = ++sent;
+  };
+
+  while (base < n)
+  {
+    if (next == base)
+    {
+      deadline = s_now_us + rto;
+    }
+    while (next < n && next < base + *window)
+    {
+      transmit(next++);
+    }
+
+    uint8_t status = 0;
+    if (!sim.host_receive(deadline, &status, &resp))
+    {
+      transmit(base);
+      sim.resent++;
+      sim.timeouts++;
+      deadline = s_now_us + rto;
+      continue;
+    }
+    if (status != link_wire::STATUS_OK || resp.size() < 9)
+    {
+      continue;
+    }
+    if (resp[6] != link_wire::STATUS_OK)
+    {
+      return false;  // A wrapped WRITE failed
+    }
+
+    // Cumulative part: the device ran everything before ack
+    uint16_t ack = (uint16_t)(resp[0] | (resp[1] << 8));
+    int16_t progress = (int16_t)(uint16_t)(ack - (uint16_t)base);
+    if (progress > 0)
+    {
+      base += (size_t)progress;
+      deadline = s_now_us + rto;
+    }
+
+    // Selective part: a frame sent before one that arrived is lost
+    uint32_t sack = (uint32_t)resp[2] | ((uint32_t)resp[3] << 8) |
+                    ((uint32_t)resp[4] << 16) | ((uint32_t)resp[5] << 24);
+    size_t highest = base;
+    for (size_t i = 0; i < 31 && base + 1 + i < n; i++)
+    {
+      if (sack & (1u << i))
+      {
+        held[base + 1 + i] = true;
+        highest = base + 1 + i;
+      }
+    }
+    for (size_t s = base; s < highest; s++)
+    {
+      if (!held[s] && order[s] < order[highest])
+      {
+        transmit(s);
+        sim.resent++;
+      }
+    }
+  }
+  return true;
+}
+
+/** Result of one upload */
+struct Result
+{
+  uint8_t window;   ///< Negotiated window (0: stop-and-wait)
+  double ms;        ///< Simulated time, ERASE to COMMIT
+  size_t frames;    ///< Request frames sent
+  size_t resent;    ///< Retransmissions
+  size_t timeouts;  ///< Retransmission timeouts
+};
+
+/** ERASE, INFO, WRITEs (plain or windowed), COMMIT; verifies the slot */
+static Result upload(const Config& cfg, const std::vector<uint8_t>& image, uint8_t want)
+{
+  Sim sim(cfg);
+  std::vector<uint8_t> resp;
+  Result r = {0, 0.0, 0, 0, 0};
+
+  bool ok = request(sim, link_wire::CMD_IMAGE, {ImageStore::OP_ERASE}, &resp);
+  ok = ok && request(sim, link_wire::CMD_IMAGE, {ImageStore::OP_INFO}, &resp) &&
+       resp.size() >= 6;
+  uint8_t slot = ok ? resp[1] : 0;
+  uint32_t seq = 0;
+  for (size_t i = 0; ok && i < 4; i++)
+  {
+    seq |= (uint32_t)resp[2 + i] << (8 * i);
+  }
+
+  if (want == 0)
+  {
+    for (size_t i = 0; ok && i * CHUNK < image.size(); i++)
+    {
+      ok = request(sim, link_wire::CMD_IMAGE, write_payload(image, i), &resp);
+    }
+  }
+  else
+  {
+    ok = ok && upload_windowed(sim, image, want, &r.window);
+  }
+
+  uint16_t flags = ImageStore::FLAG_AUTOSTART;
+  uint32_t crc = ImageStore::image_crc(image.data(), image.size(), flags, seq);
+  std::vector<uint8_t> commit = {ImageStore::OP_COMMIT};
+  for (uint32_t v : {(uint32_t)image.size(), crc})
+  {
+    for (int b = 0; b < 4; b++)
+    {
+      commit.push_back((uint8_t)(v >> (8 * b)));
+    }
+  }
+  commit.push_back((uint8_t)flags);
+  commit.push_back((uint8_t)(flags >> 8));
+  ok = ok && request(sim, link_wire::CMD_IMAGE, commit, &resp);
+
+  if (!ok || memcmp(sim.slot_code(slot), image.data(), image.size()) != 0)
+  {
+    fprintf(stderr, "upload (window %u, loss %.3f) failed or differs\n", (unsigned)want,
+            cfg.loss);
+    exit(1);
+  }
+  r.ms = s_now_us / 1000.0;
+  r.frames = sim.frames_sent;
+  r.resent = sim.resent;
+  r.timeouts = sim.timeouts;
+  return r;
+}
+
+// ==============================================================================
+// Main
+// ==============================================================================
+
+int main(int argc, char** argv)
+{
+  Config cfg;
+  double loss = -1.0;
+
+  for (int i = 1; i + 1 < argc; i += 2)
+  {
+    const char* arg = argv[i];
+    double v = atof(argv[i + 1]);
+    if (strcmp(arg, "--kbps") == 0 && v > 0.0)
+    {
+      cfg.rate = v * 1024.0;
+    }
+    else if (strcmp(arg, "--latency-us") == 0 && v >= 0.0)
+    {
+      cfg.latency_us = v;
+    }
+    else if (strcmp(arg, "--device-us") == 0 && v >= 0.0)
+    {
+      cfg.device_us = v;
+    }
+    else if (strcmp(arg, "--loss") == 0 && v >= 0.0 && v < 0.5)
+    {
+      loss = v;
+    }
+    else if (strcmp(arg, "--window-kb") == 0 && v >= 1.0)
+    {
+      cfg.window_kb = (size_t)v;
+    }
+    else if (strcmp(arg, "--seed") == 0)
+    {
+      cfg.seed = (unsigned)v;
+    }
+    else
+    {
+      fprintf(stderr,
+              "Usage: %s [--kbps N] [--latency-us N] [--device-us N] [--loss P]\n"
+              "          [--window-kb N] [--seed N]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+
+  std::mt19937 gen(7);
+  std::vector<uint8_t> image(IMAGE_SIZE);
+  for (uint8_t& b : image)
+  {
+    b = (uint8_t)gen();
+  }
+
+  printf("Image upload: %zu bytes in %zu-byte WRITEs over a simulated link\n", IMAGE_SIZE,
+         CHUNK);
+  printf("%.0f KB/s each way, %.0f us latency, %.0f us device time per frame, "
+         "%zu KB reorder buffer\n",
+         cfg.rate / 1024.0, cfg.latency_us, cfg.device_us, cfg.window_kb);
+  printf("%6s %-14s %6s %10s %9s %6s %7s %7s %8s\n", "loss", "mode", "window", "time",
+         "KB/s", "line", "frames", "resent", "timeouts");
+
+  std::vector<double> losses = {0.0, 0.01};
+  if (loss >= 0.0)
+  {
+    losses = {loss};
+  }
+  for (double p : losses)
+  {
+    cfg.loss = p;
+    for (uint8_t want : {0, 1, 2, 4, 8, 16, 32})
+    {
+      Result r = upload(cfg, image, want);
+      if (want > 1 && r.window < want)
+      {
+        break;  // Capped by the reorder buffer
+      }
+      double kbs = (double)IMAGE_SIZE / 1024.0 / (r.ms / 1000.0);
+      printf("%5.1f%% %-14s %6s %7.1f ms %9.1f %5.0f%% %7zu %7zu %8zu\n", p * 100.0,
+             want == 0 ? "stop-and-wait" : "windowed",
+             want == 0 ? "-" : std::to_string(r.window).c_str(), r.ms, kbs,
+             kbs * 1024.0 / cfg.rate * 100.0, r.frames, r.resent, r.timeouts);
+    }
+  }
+  printf("(line: code bytes per second against the raw line rate)\n");
+  return 0;
+}
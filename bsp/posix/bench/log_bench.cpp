@@ -0,0 +1,335 @@
+/**
+ * @file log_bench.cpp
+ * @brief Deferred-format log: cost and wire size per message vs. a log line
+ *
+ * Part 1 logs one runtime message ("VM %u faulted (error %d), restarting")
+ * through each path, single producer:
+ * - log:      an ESP_LOGW-style formatted line ("W (ms) tag: ...") written
+ *             to /dev/null; on a device the UART adds ~90 us per line
+ * - off:      V4_DLOG() with no log installed (before dlog_install())
+ * - filtered: V4_DLOG() above the level set with OP_LEVEL
+ * - deferred: V4_DLOG() into a DeferredLog ring
+ * Bytes per message count what leaves the device: the console line, or
+ * the CMD_LOG READ replies including their V4-link framing. Format bytes
+ * are the tag and format strings the log line keeps in flash.
+ *
+ * Part 2 runs 1, 2 and 4 producer threads on one log while a consumer
+ * drains it through DeferredLog::handle_command() like the link task and
+ * decodes the replies. The run fails if a record has the wrong ID or
+ * arguments, arrives out of order for its producer, or if received +
+ * dropped differs from the messages logged.
+ *
+ * Usage:
+ *   v4-bench-log [--messages N]
+ *
+ * SPDX-License-Identifier: MIT OR Apache-2.0
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <thread>
+#include <vector>
+
+#include "deferred_log.hpp"
+#include "link_runtime_commands.hpp"
+#include "v4link_wire.hpp"
+
+using v4rtos::DeferredLog;
+using v4rtos::LinkFrameView;
+using v4rtos::LinkReply;
+
+static constexpr char TAG[] = "V4Link";
+static constexpr char FMT[] = "VM %u faulted (error %d), restarting";
+static constexpr uint32_t MSG_ID = v4rtos::dlog_id(TAG, FMT);
+
+static constexpr size_t RING_RECORDS = 4096;
+static constexpr size_t BATCH = RING_RECORDS / 2;  ///< Messages between drains (part 1)
+static constexpr size_t REPLY_PAYLOAD = 512;       ///< READ reply capacity
+static constexpr size_t FRAME_OVERHEAD = 5;        ///< STX, length, status, CRC
+
+static uint32_t clock_ms(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)((uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u);
+}
+
+static double seconds(std::chrono::steady_clock::duration d)
+{
+  return std::chrono::duration<double>(d).count();
+}
+
+static uint32_t get_u32(const uint8_t* p)
+{
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+         ((uint32_t)p[3] << 24);
+}
+
+/**
+ * @brief Send one CMD_LOG READ and walk the reply like scripts/v4log.py
+ * @param on_record Called with (id, nargs, args) per record
+ * @return Reply bytes on the wire
+ */
+template <class F>
+static size_t read_once(DeferredLog* log, bool* more, uint32_t* dropped, F on_record)
+{
+  static uint8_t request[1] = {DeferredLog::OP_READ};
+  static uint8_t buf[REPLY_PAYLOAD];
+  LinkFrameView frame = {v4rtos::link_wire::CMD_LOG, request, 1, nullptr, 0, true};
+  LinkReply reply = {v4rtos::link_wire::STATUS_OK, buf, 0, sizeof(buf)};
+  DeferredLog::handle_command(log, frame, &reply);
+
+  *more = buf[0] != 0;
+  *dropped = get_u32(buf + 1);
+  size_t off = 5;
+  while (off + 10 <= reply.len)
+  {
+    uint32_t id = get_u32(buf + off + 4);
+    uint8_t nargs = buf[off + 9];
+    uint32_t args[v4rtos::LogRecord::MAX_ARGS];
+    for (uint8_t i = 0; i < nargs; i++)
+    {
+      args[i] = get_u32(buf + off + 10 + 4 * i);
+    }
+    on_record(id, nargs, args);
+    off += 10 + 4 * (size_t)nargs;
+  }
+  return reply.len + FRAME_OVERHEAD;
+}
+
+/** Drain everything; returns the wire bytes */
+static size_t drain(DeferredLog* log)
+{
+  size_t bytes = 0;
+  bool more = true;
+  uint32_t dropped;
+  while (more || log->ring().pending() > 0)
+  {
+    bytes += read_once(log, &more, &dropped, [](uint32_t, uint8_t, const uint32_t*) {});
+  }
+  return bytes;
+}
+
+// ==============================================================================
+// Part 1: cost per message
+// ==============================================================================
+
+static FILE* s_null = nullptr;
+static size_t s_line_bytes = 0;
+
+// ESP_LOGW(TAG, FMT, ...) without the UART
+__attribute__((noinline)) static void log_line(unsigned vm, int err)
+{
+  char line[96];
+  int len = snprintf(line, sizeof(line),
+                     "W (%u) %s: VM %u faulted (error %d), restarting\n",
+                     (unsigned)clock_ms(), TAG, vm, err);
+  fwrite(line, 1, (size_t)len, s_null);
+  s_line_bytes += (size_t)len;
+}
+
+enum class Path
+{
+  LOG,
+  OFF,
+  FILTERED,
+  DEFERRED
+};
+
+/** Result of one path */
+struct PathCost
+{
+  double ns_per_msg;     ///< Time per log call
+  double bytes_per_msg;  ///< Bytes leaving the device per message
+};
+
+static PathCost time_path(Path path, DeferredLog* log, uint32_t messages)
+{
+  v4rtos::dlog_install(path == Path::LOG || path == Path::OFF ? nullptr : log);
+  log->set_level(path == Path::FILTERED ? v4rtos::LOG_ERROR : v4rtos::LOG_DEBUG);
+  s_line_bytes = 0;
+
+  std::chrono::steady_clock::duration total{};
+  size_t wire = 0;
+  for (uint32_t done = 0; done < messages;)
+  {
+    uint32_t n = messages - done < BATCH ? messages - done : (uint32_t)BATCH;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < n; i++)
+    {
+      if (path == Path::LOG)
+      {
+        log_line((done + i) & 7, -(int)((done + i) & 15));
+      }
+      else
+      {
+        V4_DLOG(v4rtos::LOG_WARN, TAG, "VM %u faulted (error %d), restarting",
+                (unsigned)((done + i) & 7), -(int)((done + i) & 15));
+      }
+    }
+    total += std::chrono::steady_clock::now() - start;
+    if (path == Path::DEFERRED)
+    {
+      wire += drain(log);  // Link task drain, not timed
+    }
+    done += n;
+  }
+  v4rtos::dlog_install(nullptr);
+  log->set_level(v4rtos::LOG_DEBUG);
+
+  PathCost c;
+  c.ns_per_msg = seconds(total) * 1e9 / messages;
+  c.bytes_per_msg = (double)(path == Path::LOG ? s_line_bytes : wire) / messages;
+  return c;
+}
+
+// ==============================================================================
+// Part 2: producers and a concurrent CMD_LOG consumer
+// ==============================================================================
+
+/** Outcome of one contention run */
+struct Contention
+{
+  double ns_per_msg;  ///< Wall time per logged message
+  uint64_t received;  ///< Records decoded
+  uint64_t dropped;   ///< Records the full ring refused
+  bool valid;         ///< IDs and arguments intact, order kept, nothing lost
+};
+
+static Contention run_contention(unsigned producers, uint32_t messages)
+{
+  DeferredLog log(clock_ms, RING_RECORDS, v4rtos::LOG_DEBUG);
+  v4rtos::dlog_install(&log);
+  std::atomic<unsigned> running{producers};
+  std::atomic<bool> go{false};
+
+  std::vector<uint32_t> next(producers, 0);  // Next expected sequence per producer
+  uint64_t received = 0;
+  uint32_t dropped = 0;
+  bool valid = true;
+
+  auto consume = [&](uint32_t id, uint8_t nargs, const uint32_t* args) {
+    if (id != MSG_ID || nargs != 2 || args[0] >= producers ||
+        (uint32_t)-(int32_t)args[1] < next[args[0]])
+    {
+      valid = false;
+      return;
+    }
+    next[args[0]] = (uint32_t)-(int32_t)args[1] + 1;  // Gaps are drops
+    received++;
+  };
+
+  std::vector<std::thread> threads;
+  for (unsigned p = 0; p < producers; p++)
+  {
+    threads.emplace_back([&, p]() {
+      while (!go.load(std::memory_order_acquire))
+      {
+      }
+      for (uint32_t seq = 0; seq < messages; seq++)
+      {
+        V4_DLOG(v4rtos::LOG_WARN, TAG, "VM %u faulted (error %d), restarting", p,
+                -(int)seq);
+      }
+      running.fetch_sub(1, std::memory_order_release);
+    });
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  go.store(true, std::memory_order_release);
+  bool more;
+  while (running.load(std::memory_order_acquire) > 0)
+  {
+    read_once(&log, &more, &dropped, consume);
+  }
+  auto end = std::chrono::steady_clock::now();
+  for (std::thread& t : threads)
+  {
+    t.join();
+  }
+  do
+  {
+    read_once(&log, &more, &dropped, consume);
+  } while (more);
+  v4rtos::dlog_install(nullptr);
+
+  Contention c;
+  c.ns_per_msg = seconds(end - start) * 1e9 / ((double)messages * producers);
+  c.received = received;
+  c.dropped = dropped;
+  c.valid = valid && log.ring().pending() == 0 &&
+            received + c.dropped == (uint64_t)messages * producers;
+  return c;
+}
+
+int main(int argc, char** argv)
+{
+  long messages = 2000000;
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--messages") == 0 && i + 1 < argc)
+    {
+      messages = atol(argv[++i]);
+    }
+    else
+    {
+      fprintf(stderr, "Usage: %s [--messages N]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (messages <= 0 || messages > 0x7FFFFFFF)
+  {
+    fprintf(stderr, "Invalid --messages (1..2147483647)\n");
+    return 2;
+  }
+  s_null = fopen("/dev/null", "w");
+  if (s_null == nullptr)
+  {
+    perror("/dev/null");
+    return 1;
+  }
+
+  printf("%ld messages per run, %u-record ring, %u-byte READ replies\n", messages,
+         (unsigned)RING_RECORDS, (unsigned)REPLY_PAYLOAD);
+  printf("format bytes in flash: log %u, deferred 0 (ID 0x%08X)\n\n",
+         (unsigned)(sizeof(TAG) + sizeof(FMT)), (unsigned)MSG_ID);
+  printf("%-9s %10s %10s %10s\n", "path", "ns/msg", "vs. log", "bytes/msg");
+  DeferredLog log(clock_ms, RING_RECORDS, v4rtos::LOG_DEBUG);
+  static const struct
+  {
+    const char* name;
+    Path path;
+  } paths[] = {
+      {"log", Path::LOG},
+      {"off", Path::OFF},
+      {"filtered", Path::FILTERED},
+      {"deferred", Path::DEFERRED},
+  };
+  double log_ns = 0;
+  for (const auto& p : paths)
+  {
+    PathCost c = time_path(p.path, &log, (uint32_t)messages);
+    log_ns = p.path == Path::LOG ? c.ns_per_msg : log_ns;
+    printf("%-9s %10.1f %9.1fx %10.1f\n", p.name, c.ns_per_msg,
+           c.ns_per_msg > 0 ? log_ns / c.ns_per_msg : 0.0, c.bytes_per_msg);
+  }
+  fclose(s_null);
+
+  printf("\n%-9s %10s %12s %10s %6s\n", "producers", "ns/msg", "received", "dropped",
+         "check");
+  bool valid = true;
+  for (unsigned producers : {1u, 2u, 4u})
+  {
+    Contention c = run_contention(producers, (uint32_t)messages);
+    printf("%-9u %10.1f %12llu %10llu %6s\n", producers, c.ns_per_msg,
+           (unsigned long long)c.received, (unsigned long long)c.dropped,
+           c.valid ? "ok" : "FAIL");
+    valid = valid && c.valid;
+  }
+  return valid ? 0 : 1;
+}
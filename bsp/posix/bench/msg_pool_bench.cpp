@@ -0,0 +1,386 @@
+/**
+ * @file msg_pool_bench.cpp
+ * @brief Producer/consumer messaging: copying shared queue vs. MsgPool
+ *
+ * Runs 1..4 producer/consumer thread pairs. Each producer sends a stream
+ * of sequence-numbered messages to its own consumer, which checks every
+ * payload.
+ *
+ * Strategies:
+ * - copy:   the V4-engine model; one 16-slot queue for all tasks, the
+ *           message copied in by SEND and out by RECV, SEND failing when
+ *           the queue is full (the producer yields and retries)
+ * - pooled: MsgPool; the producer fills a pooled block in place, only
+ *           its address moves through the consumer's own queue, and a
+ *           full queue or empty pool blocks instead of failing
+ *
+ * MsgPool runs with the same std::mutex/std::condition_variable Sync as
+ * the POSIX runtime (msg_sys.cpp).
+ *
+ * Usage:
+ *   v4-bench-msg-pool [--messages N] [--size N]
+ *
+ * SPDX-License-Identifier: MIT OR Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <time.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "msg_pool.hpp"
+
+using v4rtos::MsgPool;
+
+static constexpr size_t MAX_PAIRS = 4;
+static constexpr size_t MAX_SIZE = 1024;
+
+// ==============================================================================
+// Helpers
+// ==============================================================================
+
+static double now_seconds(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Payload: sequence number, then bytes derived from it
+static void fill_payload(uint8_t* buf, size_t size, uint32_t seq)
+{
+  memcpy(buf, &seq, sizeof(seq));
+  for (size_t i = sizeof(seq); i < size; i++)
+  {
+    buf[i] = (uint8_t)(seq + i);
+  }
+}
+
+static bool check_payload(const uint8_t* buf, size_t size, uint32_t seq)
+{
+  uint32_t got;
+  memcpy(&got, buf, sizeof(got));
+  if (got != seq)
+  {
+    return false;
+  }
+  for (size_t i = sizeof(seq); i < size; i++)
+  {
+    if (buf[i] != (uint8_t)(seq + i))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/** Result of one run */
+struct RunStats
+{
+  double seconds;     ///< Wall time
+  uint64_t messages;  ///< Messages received
+  uint64_t wrong;     ///< Payloads that failed the check
+  uint64_t retries;   ///< SEND/RECV attempts that found the queue full/empty
+  uint64_t copied;    ///< Payload bytes copied by the queue
+};
+
+// ==============================================================================
+// Copying shared queue (V4-engine model)
+// ==============================================================================
+
+/** One 16-slot queue shared by all tasks, copy in and copy out */
+class CopyQueue
+{
+ public:
+  static constexpr size_t DEPTH = 16;
+
+  bool send(uint8_t task, const uint8_t* data, size_t len)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (size_ == DEPTH)
+    {
+      return false;  // V4_ERR_QUEUE_FULL
+    }
+    Slot& slot = slots_[size_++];
+    slot.task = task;
+    slot.len = len;
+    memcpy(slot.data, data, len);
+    copied_ += len;
+    return true;
+  }
+
+  // Oldest message for @p task, or -1 (the queue is scanned under the lock)
+  int recv(uint8_t task, uint8_t* buf)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < size_; i++)
+    {
+      if (slots_[i].task != task)
+      {
+        continue;
+      }
+      int len = (int)slots_[i].len;
+      memcpy(buf, slots_[i].data, slots_[i].len);
+      copied_ += slots_[i].len;
+      for (size_t j = i + 1; j < size_; j++)
+      {
+        slots_[j - 1] = slots_[j];
+      }
+      size_--;
+      return len;
+    }
+    return -1;
+  }
+
+  uint64_t copied() const
+  {
+    return copied_;
+  }
+
+ private:
+  struct Slot
+  {
+    uint8_t task;
+    size_t len;
+    uint8_t data[MAX_SIZE];
+  };
+
+  std::mutex mutex_;
+  Slot slots_[DEPTH];
+  size_t size_ = 0;
+  uint64_t copied_ = 0;
+};
+
+static RunStats run_copy(size_t pairs, uint32_t messages, size_t size)
+{
+  CopyQueue* queue = new CopyQueue();
+  std::vector<uint64_t> wrong(pairs, 0);
+  std::vector<uint64_t> retries(pairs * 2, 0);
+  std::vector<std::thread> threads;
+
+  double start = now_seconds();
+  for (size_t p = 0; p < pairs; p++)
+  {
+    threads.emplace_back([&, p]() {
+      uint8_t buf[MAX_SIZE];
+      for (uint32_t seq = 0; seq < messages; seq++)
+      {
+        fill_payload(buf, size, seq);
+        while (!queue->send((uint8_t)p, buf, size))
+        {
+          retries[p * 2]++;
+          std::this_thread::yield();
+        }
+      }
+    });
+    threads.emplace_back([&, p]() {
+      uint8_t buf[MAX_SIZE];
+      for (uint32_t seq = 0; seq < messages; seq++)
+      {
+        int len;
+        while ((len = queue->recv((uint8_t)p, buf)) < 0)
+        {
+          retries[p * 2 + 1]++;
+          std::this_thread::yield();
+        }
+        if ((size_t)len != size || !check_payload(buf, size, seq))
+        {
+          wrong[p]++;
+        }
+      }
+    });
+  }
+  for (std::thread& t : threads)
+  {
+    t.join();
+  }
+
+  RunStats stats = {now_seconds() - start, (uint64_t)pairs * messages, 0, 0,
+                    queue->copied()};
+  for (size_t p = 0; p < pairs; p++)
+  {
+    stats.wrong += wrong[p];
+    stats.retries += retries[p * 2] + retries[p * 2 + 1];
+  }
+  delete queue;
+  return stats;
+}
+
+// ==============================================================================
+// MsgPool
+// ==============================================================================
+
+/** Sync of the POSIX runtime */
+struct HostSync
+{
+  std::mutex mutex;
+  std::condition_variable cv[MsgPool::CHANNELS];
+};
+
+static void sync_lock(void* user)
+{
+  static_cast<HostSync*>(user)->mutex.lock();
+}
+
+static void sync_unlock(void* user)
+{
+  static_cast<HostSync*>(user)->mutex.unlock();
+}
+
+static void sync_wait(void* user, uint8_t channel, uint32_t timeout_ms)
+{
+  HostSync* sync = static_cast<HostSync*>(user);
+  std::unique_lock<std::mutex> lock(sync->mutex, std::adopt_lock);
+  if (timeout_ms == MsgPool::WAIT_FOREVER)
+  {
+    sync->cv[channel].wait(lock);
+  }
+  else
+  {
+    sync->cv[channel].wait_for(lock, std::chrono::milliseconds(timeout_ms));
+  }
+  lock.release();
+}
+
+static void sync_wake(void* user, uint8_t channel)
+{
+  static_cast<HostSync*>(user)->cv[channel].notify_all();
+}
+
+static uint32_t sync_now_ms(void* user)
+{
+  (void)user;  // Unused
+  return (uint32_t)(now_seconds() * 1000.0);
+}
+
+static RunStats run_pooled(size_t pairs, uint32_t messages, size_t size)
+{
+  HostSync host;
+  MsgPool::Sync sync = {sync_lock, sync_unlock, sync_wait, sync_wake, sync_now_ms, &host};
+  MsgPool* msgs = new MsgPool(sync);
+
+  // Block addresses are offsets into memory shared by all threads, as VM
+  // addresses are for Forth tasks
+  std::vector<uint8_t> arena(MsgPool::MAX_BLOCKS * size);
+  msgs->setup(0, (uint32_t)size, MsgPool::MAX_BLOCKS);
+
+  std::vector<uint64_t> wrong(pairs, 0);
+  std::vector<std::thread> threads;
+
+  double start = now_seconds();
+  for (size_t p = 0; p < pairs; p++)
+  {
+    threads.emplace_back([&, p]() {
+      for (uint32_t seq = 0; seq < messages; seq++)
+      {
+        uint32_t addr;
+        if (msgs->alloc(&addr, MsgPool::WAIT_FOREVER) != MsgPool::OK)
+        {
+          return;
+        }
+        fill_payload(&arena[addr], size, seq);
+        msgs->send((uint8_t)p, addr, (uint32_t)size, MsgPool::WAIT_FOREVER);
+      }
+    });
+    threads.emplace_back([&, p]() {
+      for (uint32_t seq = 0; seq < messages; seq++)
+      {
+        MsgPool::Message msg;
+        if (msgs->recv((uint8_t)p, &msg, MsgPool::WAIT_FOREVER) != MsgPool::OK)
+        {
+          return;
+        }
+        if (msg.len != size || !check_payload(&arena[msg.addr], size, seq))
+        {
+          wrong[p]++;
+        }
+        msgs->release(msg.addr);
+      }
+    });
+  }
+  for (std::thread& t : threads)
+  {
+    t.join();
+  }
+
+  MsgPool::Stats pool = msgs->stats();
+  RunStats stats = {now_seconds() - start, pool.received, 0,
+                    (uint64_t)pool.alloc_waits + pool.send_waits, 0};
+  for (size_t p = 0; p < pairs; p++)
+  {
+    stats.wrong += wrong[p];
+  }
+  delete msgs;
+  return stats;
+}
+
+// ==============================================================================
+// Main
+// ==============================================================================
+
+static void print_row(const char* name, size_t pairs, const RunStats& stats)
+{
+  double rate = stats.seconds > 0 ? (double)stats.messages / stats.seconds : 0.0;
+  printf("%-7s %5u %12.0f %10.2f %12llu %14llu %6llu\n", name, (unsigned)pairs, rate,
+         rate > 0 ? 1e6 / rate : 0.0, (unsigned long long)stats.retries,
+         (unsigned long long)stats.copied, (unsigned long long)stats.wrong);
+}
+
+int main(int argc, char** argv)
+{
+  long messages = 200000;
+  long size = 64;
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--messages") == 0 && i + 1 < argc)
+    {
+      messages = atol(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+    {
+      size = atol(argv[++i]);
+    }
+    else
+    {
+      fprintf(stderr, "Usage: %s [--messages N] [--size N]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (messages <= 0 || size < (long)sizeof(uint32_t) || size > (long)MAX_SIZE)
+  {
+    fprintf(stderr, "Invalid --messages/--size (size 4..%u)\n", (unsigned)MAX_SIZE);
+    return 2;
+  }
+
+  printf("%ld messages of %ld bytes per pair, %u-slot shared queue vs. %u blocks + "
+         "%u-deep queues\n\n",
+         messages, size, (unsigned)CopyQueue::DEPTH, (unsigned)MsgPool::MAX_BLOCKS,
+         (unsigned)MsgPool::QUEUE_DEPTH);
+  printf("%-7s %5s %12s %10s %12s %14s %6s\n", "queue", "pairs", "msgs/s", "us/msg",
+         "retry/wait", "bytes copied", "wrong");
+
+  uint64_t wrong = 0;
+  for (size_t pairs = 1; pairs <= MAX_PAIRS; pairs *= 2)
+  {
+    RunStats copy = run_copy(pairs, (uint32_t)messages, (size_t)size);
+    RunStats pooled = run_pooled(pairs, (uint32_t)messages, (size_t)size);
+    print_row("copy", pairs, copy);
+    print_row("pooled", pairs, pooled);
+    wrong += copy.wrong + pooled.wrong;
+    if (pooled.messages != (uint64_t)pairs * (uint64_t)messages)
+    {
+      fprintf(stderr, "pooled: %llu of %llu messages received\n",
+              (unsigned long long)pooled.messages,
+              (unsigned long long)pairs * (unsigned long long)messages);
+      return 1;
+    }
+  }
+  return wrong == 0 ? 0 : 1;
+}
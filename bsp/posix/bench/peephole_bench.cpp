@@ -0,0 +1,323 @@
+/**
+ * @file peephole_bench.cpp
+ * @brief Peephole/superinstruction pass: dispatch count, speed and verification
+ *
+ * Runs each workload as written and after BytecodePeephole has fused
+ *
+ * - LIT n +                  -> LIT_ADD n
+ * - DUP IF (DUP JZ)          -> DUP_JZ
+ * - LIT ms SYS 1 (delay)     -> DELAY_LIT ms
+ * - LIT 1 - DUP LIT 0 < JZ   -> DEC_JNN (countdown loop)
+ *
+ * and compares the two runs: status, final data stack and the SYS call
+ * trace must match. The default mode reports dispatched opcodes (counting
+ * build) and best-of-N time (threaded -O2 build); --verify instead
+ * sweeps small and boundary iteration counts through every interpreter
+ * build and only checks results.
+ *
+ * Usage:
+ *   v4-bench-peephole [--iterations N] [--runs N] [--verify]
+ *
+ * SPDX-License-Identifier: MIT OR Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <time.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "bytecode_peephole.hpp"
+#include "dispatch_bench_programs.hpp"
+#include "dispatch_bench_vm.hpp"
+
+using namespace v4bench;
+using v4rtos::BytecodePeephole;
+using v4rtos::PeepholeBranch;
+using v4rtos::PeepholeIsa;
+using v4rtos::PeepholeOp;
+using v4rtos::PeepholeRule;
+
+// ==============================================================================
+// Bench VM instruction set
+// ==============================================================================
+
+/** Fusion rules, longest first */
+static const PeepholeRule RULES[] = {
+    {"dec-jnn",
+     {{OP_LIT, true, 1},
+      {OP_SUB, false, 0},
+      {OP_DUP, false, 0},
+      {OP_LIT, true, 0},
+      {OP_LT, false, 0},
+      {OP_JZ, false, 0}},
+     6,
+     OP_DEC_JNN,
+     5},
+    {"delay-lit",
+     {{OP_LIT, false, 0}, {OP_SYS, true, SYS_TASK_DELAY}},
+     2,
+     OP_DELAY_LIT,
+     0},
+    {"lit-add", {{OP_LIT, false, 0}, {OP_ADD, false, 0}}, 2, OP_LIT_ADD, 0},
+    {"dup-jz", {{OP_DUP, false, 0}, {OP_JZ, false, 0}}, 2, OP_DUP_JZ, 1},
+};
+
+static PeepholeOp g_ops[256];
+
+static PeepholeIsa make_isa(void)
+{
+  for (PeepholeOp& op : g_ops)
+  {
+    op = PeepholeOp{0, PeepholeBranch::NONE};
+  }
+  g_ops[OP_LIT] = {4, PeepholeBranch::NONE};
+  g_ops[OP_LIT_ADD] = {4, PeepholeBranch::NONE};
+  g_ops[OP_DELAY_LIT] = {4, PeepholeBranch::NONE};
+  g_ops[OP_SYS] = {1, PeepholeBranch::NONE};
+  g_ops[OP_CALL] = {2, PeepholeBranch::ABS16};
+  for (Op op : {OP_JMP, OP_JZ, OP_LOOP, OP_DUP_JZ, OP_DEC_JNN})
+  {
+    g_ops[op] = {2, PeepholeBranch::REL16};
+  }
+  return PeepholeIsa{g_ops, RULES, sizeof(RULES) / sizeof(RULES[0])};
+}
+
+// ==============================================================================
+// Side-by-side runs
+// ==============================================================================
+
+/** Workload before and after the pass */
+struct Pair
+{
+  Workload original;          ///< As assembled
+  std::vector<uint8_t> code;  ///< Optimized bytecode
+  size_t entry;               ///< Optimized entry point
+};
+
+static Pair optimize(BytecodePeephole* pass, const Workload& w)
+{
+  Pair p = {w, w.code, 0};
+  p.code.resize(pass->run(p.code.data(), p.code.size()));
+  p.entry = pass->remap(w.entry);
+  return p;
+}
+
+/** Result of one run */
+struct Outcome
+{
+  int status;                  ///< Interpreter result
+  int32_t depth;               ///< Final data stack depth
+  uint64_t sys_calls;          ///< SYS calls made
+  uint64_t sys_checksum;       ///< SYS argument mix
+  uint64_t dispatches;         ///< Opcodes dispatched (counting build)
+  std::vector<int32_t> stack;  ///< Final data stack
+};
+
+static Outcome run_once(RunFn run, const uint8_t* code, size_t entry)
+{
+  static BenchVm vm;
+  vm.depth = 0;
+  vm.sys_calls = 0;
+  vm.sys_checksum = 0;
+  vm.dispatches = 0;
+  Outcome o;
+  o.status = run(&vm, code, entry);
+  o.depth = vm.depth;
+  o.sys_calls = vm.sys_calls;
+  o.sys_checksum = vm.sys_checksum;
+  o.dispatches = vm.dispatches;
+  o.stack.assign(vm.ds, vm.ds + (o.status == BENCH_OK ? vm.depth : 0));
+  return o;
+}
+
+static bool same_result(const Outcome& a, const Outcome& b)
+{
+  return a.status == b.status && a.depth == b.depth && a.sys_calls == b.sys_calls &&
+         a.sys_checksum == b.sys_checksum && a.stack == b.stack;
+}
+
+static void print_outcome(const char* label, const Outcome& o)
+{
+  fprintf(stderr, "  %-9s status %d, %llu SYS (sum %016llx), stack [", label, o.status,
+          (unsigned long long)o.sys_calls, (unsigned long long)o.sys_checksum);
+  for (size_t i = 0; i < o.stack.size(); i++)
+  {
+    fprintf(stderr, "%s%d", i == 0 ? "" : " ", o.stack[i]);
+  }
+  fprintf(stderr, "]\n");
+}
+
+/**
+ * @brief Run original and optimized code on @p run and compare
+ */
+static bool verify(const char* build, RunFn run, const Pair& p, int32_t n)
+{
+  Outcome a = run_once(run, p.original.code.data(), p.original.entry);
+  Outcome b = run_once(run, p.code.data(), p.entry);
+  if (same_result(a, b))
+  {
+    return true;
+  }
+  fprintf(stderr, "MISMATCH: %s (n=%d) on %s\n", p.original.name, n, build);
+  print_outcome("original", a);
+  print_outcome("optimized", b);
+  return false;
+}
+
+// ==============================================================================
+// Modes
+// ==============================================================================
+
+/** Workload generator and its iteration scale for timing runs */
+struct Maker
+{
+  Workload (*make)(int32_t n);  ///< Generator
+  int32_t mul;                  ///< Iterations = base * mul / div
+  int32_t div;                  ///< Iteration divisor
+};
+
+static const Maker MAKERS[] = {
+    {make_blink, 1, 1}, {make_hello, 1, 4},   {make_fib, 1, 4},
+    {make_branchy, 8, 1}, {make_task1, 1, 4}, {make_acc, 4, 1},
+};
+
+/** Interpreter builds */
+struct Build
+{
+  const char* name;  ///< Report label
+  RunFn run;         ///< Entry point
+};
+
+static const Build BUILDS[] = {
+    {"switch -Os", run_switch_os},   {"threaded -Os", run_threaded_os},
+    {"switch -O2", run_switch_o2},   {"threaded -O2", run_threaded_o2},
+    {"counting", run_switch_count},  {"counting thr.", run_threaded_count},
+};
+
+static int run_verify(BytecodePeephole* pass)
+{
+  static const int32_t COUNTS[] = {0, 1, 2, 3, 7, 64, 1000};
+  int cases = 0;
+  int failures = 0;
+  for (const Maker& m : MAKERS)
+  {
+    for (int32_t n : COUNTS)
+    {
+      Pair p = optimize(pass, m.make(n));
+      for (const Build& b : BUILDS)
+      {
+        cases++;
+        failures += verify(b.name, b.run, p, n) ? 0 : 1;
+      }
+    }
+  }
+  printf("peephole verify: %d cases, %d mismatches\n", cases, failures);
+  return failures == 0 ? 0 : 1;
+}
+
+static double now_seconds(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static double best_time(RunFn run, const uint8_t* code, size_t entry, int runs)
+{
+  static BenchVm vm;
+  double best = 0;
+  for (int r = 0; r < runs; r++)
+  {
+    double t0 = now_seconds();
+    run(&vm, code, entry);
+    double dt = now_seconds() - t0;
+    best = r == 0 || dt < best ? dt : best;
+  }
+  return best;
+}
+
+static int run_bench(BytecodePeephole* pass, int32_t iterations, int runs)
+{
+  int failures = 0;
+  printf("Peephole pass: dispatches (counting build), best of %d runs (threaded -O2)\n",
+         runs);
+  printf("%-8s %11s %6s %14s %14s %7s %10s %10s %8s\n", "", "bytes", "fused",
+         "dispatches", "optimized", "saved", "ms", "opt ms", "speedup");
+
+  for (const Maker& m : MAKERS)
+  {
+    int32_t n = iterations * m.mul / m.div;
+    uint64_t fused_before = pass->stats().fused;
+    Pair p = optimize(pass, m.make(n));
+    uint64_t fused = pass->stats().fused - fused_before;
+
+    if (!verify("counting", run_switch_count, p, n))
+    {
+      failures++;
+      continue;
+    }
+    Outcome a = run_once(run_switch_count, p.original.code.data(), p.original.entry);
+    Outcome b = run_once(run_switch_count, p.code.data(), p.entry);
+
+    double t0 =
+        best_time(run_threaded_o2, p.original.code.data(), p.original.entry, runs);
+    double t1 = best_time(run_threaded_o2, p.code.data(), p.entry, runs);
+    double saved = a.dispatches > 0 ? 100.0 * (double)(a.dispatches - b.dispatches) /
+                                          (double)a.dispatches
+                                    : 0.0;
+
+    printf("%-8s %5zu->%-5zu %6llu %14llu %14llu %6.1f%% %10.2f %10.2f %7.2fx\n",
+           p.original.name, p.original.code.size(), p.code.size(),
+           (unsigned long long)fused, (unsigned long long)a.dispatches,
+           (unsigned long long)b.dispatches, saved, t0 * 1e3, t1 * 1e3,
+           t1 > 0 ? t0 / t1 : 0.0);
+  }
+
+  printf("rules:");
+  for (size_t r = 0; r < sizeof(RULES) / sizeof(RULES[0]); r++)
+  {
+    printf(" %s=%llu", RULES[r].name, (unsigned long long)pass->rule_hits(r));
+  }
+  printf("\n");
+  return failures == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv)
+{
+  int32_t iterations = 200000;
+  int runs = 5;
+  bool verify_only = false;
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+    {
+      iterations = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc)
+    {
+      runs = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--verify") == 0)
+    {
+      verify_only = true;
+    }
+    else
+    {
+      fprintf(stderr, "Usage: %s [--iterations N] [--runs N] [--verify]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (iterations <= 0 || runs <= 0)
+  {
+    fprintf(stderr, "Invalid --iterations/--runs\n");
+    return 2;
+  }
+
+  static const PeepholeIsa isa = make_isa();
+  BytecodePeephole pass(isa, 4096);
+
+  return verify_only ? run_verify(&pass) : run_bench(&pass, iterations, runs);
+}
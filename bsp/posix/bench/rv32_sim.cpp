@@ -0,0 +1,320 @@
+/**
+ * @file rv32_sim.cpp
+ * @brief Minimal RV32IM simulator implementation
+ *
+ * SPDX-License-Identifier: MIT OR Apache-2.0
+ */
+
+#include "rv32_sim.hpp"
+
+#include <cstring>
+
+namespace v4bench
+{
+
+namespace
+{
+
+// Return address that ends call(); never a valid instruction address
+constexpr uint32_t RETURN_SENTINEL = 0xFFFFFFF0u;
+
+inline int32_t sext(uint32_t v, int bits)
+{
+  return static_cast<int32_t>(v << (32 - bits)) >> (32 - bits);
+}
+
+// DIV/REM corner cases as defined by the M extension
+inline uint32_t div_signed(uint32_t a, uint32_t b)
+{
+  if (b == 0)
+  {
+    return 0xFFFFFFFFu;
+  }
+  if (a == 0x80000000u && b == 0xFFFFFFFFu)
+  {
+    return a;
+  }
+  return static_cast<uint32_t>(static_cast<int32_t>(a) / static_cast<int32_t>(b));
+}
+
+inline uint32_t rem_signed(uint32_t a, uint32_t b)
+{
+  if (b == 0)
+  {
+    return a;
+  }
+  if (a == 0x80000000u && b == 0xFFFFFFFFu)
+  {
+    return 0;
+  }
+  return static_cast<uint32_t>(static_cast<int32_t>(a) % static_cast<int32_t>(b));
+}
+
+}  // namespace
+
+Rv32Sim::Rv32Sim(uint32_t base, size_t size) : base_(base), mem_(size, 0) {}
+
+uint32_t Rv32Sim::load32(uint32_t addr) const
+{
+  uint32_t v;
+  memcpy(&v, mem_.data() + (addr - base_), 4);
+  return v;
+}
+
+void Rv32Sim::store32(uint32_t addr, uint32_t value)
+{
+  memcpy(mem_.data() + (addr - base_), &value, 4);
+}
+
+Rv32Sim::Result Rv32Sim::call(uint32_t pc, uint32_t arg, uint64_t max_steps)
+{
+  memset(x_, 0, sizeof(x_));
+  x_[1] = RETURN_SENTINEL;
+  x_[2] = base_ + static_cast<uint32_t>(mem_.size());  // Stack at the top
+  x_[10] = arg;
+  pc_ = pc;
+  steps_ = 0;
+
+  while (pc_ != RETURN_SENTINEL)
+  {
+    if (steps_ >= max_steps)
+    {
+      return SIM_TIMEOUT;
+    }
+    if (!step())
+    {
+      fault_pc_ = pc_;
+      return SIM_FAULT;
+    }
+    steps_++;
+  }
+  return SIM_RETURNED;
+}
+
+bool Rv32Sim::step()
+{
+  if (!in_range(pc_, 4) || (pc_ & 3) != 0)
+  {
+    return false;
+  }
+  uint32_t insn = load32(pc_);
+  uint32_t opc = insn & 0x7F;
+  uint32_t rd = (insn >> 7) & 0x1F;
+  uint32_t f3 = (insn >> 12) & 0x7;
+  uint32_t rs1 = (insn >> 15) & 0x1F;
+  uint32_t rs2 = (insn >> 20) & 0x1F;
+  uint32_t f7 = insn >> 25;
+  uint32_t a = x_[rs1];
+  uint32_t b = x_[rs2];
+  int32_t imm_i = sext(insn >> 20, 12);
+  int32_t imm_s = sext(((insn >> 25) << 5) | ((insn >> 7) & 0x1F), 12);
+  uint32_t shamt = rs2;
+  uint32_t next = pc_ + 4;
+  uint32_t result = 0;
+  bool write = true;
+
+  switch (opc)
+  {
+    case 0x37:  // LUI
+      result = insn & 0xFFFFF000u;
+      break;
+    case 0x17:  // AUIPC
+      result = pc_ + (insn & 0xFFFFF000u);
+      break;
+    case 0x6F:  // JAL
+    {
+      uint32_t imm = (((insn >> 31) & 1) << 20) | (((insn >> 12) & 0xFF) << 12) |
+                     (((insn >> 20) & 1) << 11) | (((insn >> 21) & 0x3FF) << 1);
+      result = next;
+      next = pc_ + static_cast<uint32_t>(sext(imm, 21));
+      break;
+    }
+    case 0x67:  // JALR
+      if (f3 != 0)
+      {
+        return false;
+      }
+      result = next;
+      next = (a + static_cast<uint32_t>(imm_i)) & ~1u;
+      break;
+    case 0x63:  // BRANCH
+    {
+      uint32_t imm = (((insn >> 31) & 1) << 12) | (((insn >> 7) & 1) << 11) |
+                     (((insn >> 25) & 0x3F) << 5) | (((insn >> 8) & 0xF) << 1);
+      bool taken;
+      switch (f3)
+      {
+        case 0:
+          taken = a == b;
+          break;
+        case 1:
+          taken = a != b;
+          break;
+        case 4:
+          taken = static_cast<int32_t>(a) < static_cast<int32_t>(b);
+          break;
+        case 5:
+          taken = static_cast<int32_t>(a) >= static_cast<int32_t>(b);
+          break;
+        case 6:
+          taken = a < b;
+          break;
+        case 7:
+          taken = a >= b;
+          break;
+        default:
+          return false;
+      }
+      if (taken)
+      {
+        next = pc_ + static_cast<uint32_t>(sext(imm, 13));
+      }
+      write = false;
+      break;
+    }
+    case 0x03:  // LOAD
+    {
+      uint32_t addr = a + static_cast<uint32_t>(imm_i);
+      uint32_t size = 1u << (f3 & 3);
+      if ((f3 & 3) == 3 || f3 > 5 || !in_range(addr, size))
+      {
+        return false;
+      }
+      uint32_t v = 0;
+      memcpy(&v, mem_.data() + (addr - base_), size);
+      if (f3 == 0)
+      {
+        v = static_cast<uint32_t>(sext(v, 8));
+      }
+      else if (f3 == 1)
+      {
+        v = static_cast<uint32_t>(sext(v, 16));
+      }
+      result = v;
+      break;
+    }
+    case 0x23:  // STORE
+    {
+      uint32_t addr = a + static_cast<uint32_t>(imm_s);
+      uint32_t size = 1u << f3;
+      if (f3 > 2 || !in_range(addr, size))
+      {
+        return false;
+      }
+      memcpy(mem_.data() + (addr - base_), &b, size);
+      write = false;
+      break;
+    }
+    case 0x13:  // OP-IMM
+    {
+      switch (f3)
+      {
+        case 0:
+          result = a + static_cast<uint32_t>(imm_i);
+          break;
+        case 1:
+          result = a << shamt;
+          break;
+        case 2:
+          result = static_cast<int32_t>(a) < imm_i ? 1 : 0;
+          break;
+        case 3:
+          result = a < static_cast<uint32_t>(imm_i) ? 1 : 0;
+          break;
+        case 4:
+          result = a ^ static_cast<uint32_t>(imm_i);
+          break;
+        case 5:
+          result = (f7 & 0x20) ? static_cast<uint32_t>(static_cast<int32_t>(a) >> shamt)
+                               : a >> shamt;
+          break;
+        case 6:
+          result = a | static_cast<uint32_t>(imm_i);
+          break;
+        default:
+          result = a & static_cast<uint32_t>(imm_i);
+          break;
+      }
+      break;
+    }
+    case 0x33:  // OP
+      if (f7 == 0x01)
+      {
+        // M extension
+        int64_t sa = static_cast<int32_t>(a);
+        int64_t sb = static_cast<int32_t>(b);
+        switch (f3)
+        {
+          case 0:
+            result = a * b;
+            break;
+          case 1:
+            result = static_cast<uint32_t>((sa * sb) >> 32);
+            break;
+          case 2:
+            result = static_cast<uint32_t>((sa * static_cast<int64_t>(b)) >> 32);
+            break;
+          case 3:
+            result = static_cast<uint32_t>((static_cast<uint64_t>(a) * b) >> 32);
+            break;
+          case 4:
+            result = div_signed(a, b);
+            break;
+          case 5:
+            result = b == 0 ? 0xFFFFFFFFu : a / b;
+            break;
+          case 6:
+            result = rem_signed(a, b);
+            break;
+          default:
+            result = b == 0 ? a : a % b;
+            break;
+        }
+        break;
+      }
+      switch (f3)
+      {
+        case 0:
+          result = (f7 & 0x20) ? a - b : a + b;
+          break;
+        case 1:
+          result = a << (b & 31);
+          break;
+        case 2:
+          result = static_cast<int32_t>(a) < static_cast<int32_t>(b) ? 1 : 0;
+          break;
+        case 3:
+          result = a < b ? 1 : 0;
+          break;
+        case 4:
+          result = a ^ b;
+          break;
+        case 5:
+          shamt = b & 31;
+          result = (f7 & 0x20) ? static_cast<uint32_t>(static_cast<int32_t>(a) >> shamt)
+                               : a >> shamt;
+          break;
+        case 6:
+          result = a | b;
+          break;
+        default:
+          result = a & b;
+          break;
+      }
+      break;
+    case 0x0F:  // FENCE, FENCE.I
+      write = false;
+      break;
+    default:
+      return false;
+  }
+
+  if (write && rd != 0)
+  {
+    x_[rd] = result;
+  }
+  pc_ = next;
+  return true;
+}
+
+}  // namespace v4bench
@@ -0,0 +1,96 @@
+/**
+ * @file rv32_sim.hpp
+ * @brief Minimal RV32IM simulator for testing JIT output on the host
+ *
+ * Executes machine code from a flat little-endian memory image. Covers
+ * RV32I (except CSR/system instructions) and the M extension, which is
+ * everything the template JIT emits plus some margin. Calls run until the
+ * callee returns to a sentinel address, an illegal instruction or bad
+ * memory access faults, or a step limit is hit.
+ *
+ * SPDX-License-Identifier: MIT OR Apache-2.0
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace v4bench
+{
+
+/**
+ * @brief RV32IM hart with private memory
+ */
+class Rv32Sim
+{
+ public:
+  /** Run results */
+  enum Result
+  {
+    SIM_RETURNED,  ///< Callee returned to the sentinel
+    SIM_FAULT,     ///< Illegal instruction or access outside memory
+    SIM_TIMEOUT    ///< Step limit reached
+  };
+
+  /**
+   * @brief Construct simulator
+   * @param base Address of the first memory byte
+   * @param size Memory size (bytes)
+   */
+  Rv32Sim(uint32_t base, size_t size);
+
+  /** Host pointer for a target address (no bounds check) */
+  uint8_t* host(uint32_t addr)
+  {
+    return mem_.data() + (addr - base_);
+  }
+
+  uint32_t load32(uint32_t addr) const;
+  void store32(uint32_t addr, uint32_t value);
+
+  /**
+   * @brief Call the function at @p pc with a0 = @p arg
+   *
+   * @param pc Function address
+   * @param arg First argument
+   * @param max_steps Instruction limit
+   * @return Run result; a0 afterwards is available from reg(10)
+   */
+  Result call(uint32_t pc, uint32_t arg, uint64_t max_steps);
+
+  /** Register value */
+  uint32_t reg(int r) const
+  {
+    return x_[r];
+  }
+
+  /** Instructions retired by the last call() */
+  uint64_t steps() const
+  {
+    return steps_;
+  }
+
+  /** Address of the faulting instruction (SIM_FAULT) */
+  uint32_t fault_pc() const
+  {
+    return fault_pc_;
+  }
+
+ private:
+  bool in_range(uint32_t addr, uint32_t bytes) const
+  {
+    return addr >= base_ && addr - base_ <= mem_.size() - bytes;
+  }
+  bool step();
+
+  uint32_t base_;             ///< Address of mem_[0]
+  std::vector<uint8_t> mem_;  ///< Memory image
+  uint32_t x_[32] = {};       ///< Integer registers
+  uint32_t pc_ = 0;           ///< Program counter
+  uint64_t steps_ = 0;        ///< Instructions retired
+  uint32_t fault_pc_ = 0;     ///< Last fault address
+};
+
+}  // namespace v4bench
@@ -0,0 +1,349 @@
+/**
+ * @file sched_bench.cpp
+ * @brief Wakeup latency and priority inversion: round-robin vs. TaskScheduler
+ *
+ * Simulates a typical V4 application on one CPU with discrete time steps,
+ * TaskScheduler choosing the task to run exactly as V4-engine does through
+ * the v4_sched_* hooks:
+ * - control: 1 kHz-class loop (priority 0) that touches a shared bus under
+ *   a mutex for a moment every period
+ * - sensor:  periodic sampling (priority 2)
+ * - compute: periodic CPU-heavy burst (priority 4)
+ * - logger:  background task (priority 6) writing to the shared bus in
+ *   long mutex-protected chunks
+ *
+ * Policies:
+ * - rr:      the former engine scheduler; every task at one priority,
+ *            10 ms slices in turn
+ * - prio:    fixed priorities, plain mutex (no inheritance), so compute
+ *            can hold off the logger while control waits for the bus
+ * - prio+pi: fixed priorities with priority inheritance
+ *
+ * For every task: wakeup latency (release until first run), response time
+ * (release until the job is done) and missed deadlines (response longer
+ * than the period). The last table lists the per-priority wakeup latency
+ * TaskScheduler itself recorded, the figures CMD_SCHED reads on a device.
+ *
+ * Usage:
+ *   v4-bench-sched [--seconds N] [--hold-us N] [--slices "0 5 10"]
+ *
+ * SPDX-License-Identifier: MIT OR Apache-2.0
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "task_sched.hpp"
+
+using v4rtos::TaskScheduler;
+
+static constexpr uint32_t STEP_US = 10;  ///< Scheduler tick of the simulation
+static constexpr uint8_t BUS_MUTEX = 0;  ///< Mutex shared by control and logger
+static constexpr uint8_t RR_PRIORITY = 7;
+
+static uint32_t s_now_us = 0;  ///< Simulated time
+
+static uint32_t sim_clock_us(void)
+{
+  return s_now_us;
+}
+
+/** Task of the simulated application */
+struct TaskDef
+{
+  const char* name;    ///< Label
+  uint8_t priority;    ///< Priority under prio / prio+pi
+  uint32_t period_us;  ///< Release period (0: background, always runnable)
+  uint32_t work_us;    ///< CPU time per job
+  uint32_t lock_at;    ///< CPU time into the job at which the bus is locked
+  uint32_t hold_us;    ///< CPU time with the bus locked (0: no bus access)
+};
+
+static TaskDef s_tasks[] = {
+    {"control", 0, 2000, 200, 50, 100},
+    {"sensor", 2, 10000, 1500, 0, 0},
+    {"compute", 4, 50000, 20000, 0, 0},
+    {"logger", 6, 0, 3000, 500, 1000},
+};
+static constexpr uint8_t TASKS = sizeof(s_tasks) / sizeof(s_tasks[0]);
+
+/** Per-task state and results of one run */
+struct TaskRun
+{
+  bool idle;               ///< Waiting for its next release
+  bool started;            ///< Ran since its release
+  bool holding;            ///< Owns (or was handed) the bus mutex
+  uint32_t release_us;     ///< Release of the current job
+  uint32_t next_us;        ///< Next periodic release
+  uint32_t progress_us;    ///< CPU time of the current job
+  uint32_t jobs;           ///< Completed jobs
+  uint32_t misses;         ///< Jobs that outlived their period
+  uint32_t wake_max_us;    ///< Worst wakeup latency
+  uint64_t wake_total_us;  ///< Sum of wakeup latencies
+  uint32_t resp_max_us;    ///< Worst response time
+  uint64_t resp_total_us;  ///< Sum of response times
+};
+
+/** Scheduling policy */
+struct Policy
+{
+  const char* name;  ///< Label
+  bool priorities;   ///< Fixed priorities (else all at RR_PRIORITY)
+  bool inheritance;  ///< Priority inheritance
+};
+
+// Lock/unlock the bus when the job reaches those points; false if blocked
+static bool job_events(TaskScheduler* sched, uint8_t id, TaskRun* run)
+{
+  const TaskDef& def = s_tasks[id];
+  if (def.hold_us == 0)
+  {
+    return true;
+  }
+  if (!run->holding && run->progress_us == def.lock_at)
+  {
+    run->holding = true;
+    if (sched->lock(BUS_MUTEX, id) == TaskScheduler::BLOCKED)
+    {
+      return false;  // Owns the bus once it runs again
+    }
+  }
+  if (run->holding && run->progress_us == def.lock_at + def.hold_us)
+  {
+    sched->unlock(BUS_MUTEX, id);
+    run->holding = false;
+  }
+  return true;
+}
+
+// CPU time until the job's next lock, unlock or completion
+static uint32_t to_next_event(uint8_t id, const TaskRun& run)
+{
+  const TaskDef& def = s_tasks[id];
+  uint32_t target = def.work_us;
+  if (def.hold_us > 0 && !run.holding && run.progress_us < def.lock_at)
+  {
+    target = def.lock_at;
+  }
+  else if (def.hold_us > 0 && run.holding)
+  {
+    target = def.lock_at + def.hold_us;
+  }
+  return target - run.progress_us;
+}
+
+static void run_policy(const Policy& policy, uint32_t seconds, const uint16_t* slices,
+                       TaskRun* runs, TaskScheduler::Latency* latency)
+{
+  s_now_us = 0;
+  TaskScheduler sched(sim_clock_us);
+  sched.set_inheritance(policy.inheritance);
+  for (uint8_t p = 0; p < TaskScheduler::PRIORITIES; p++)
+  {
+    sched.set_slice(p, policy.priorities ? slices[p] : TaskScheduler::DEFAULT_SLICE_MS);
+  }
+
+  memset(runs, 0, sizeof(TaskRun) * TASKS);
+  for (uint8_t id = 0; id < TASKS; id++)
+  {
+    sched.create(id, policy.priorities ? s_tasks[id].priority : RR_PRIORITY);
+    runs[id].next_us = s_tasks[id].period_us;
+  }
+
+  uint32_t end_us = seconds * 1000000u;
+  uint8_t current = TaskScheduler::NO_TASK;
+  while (s_now_us < end_us)
+  {
+    // Periodic releases; a job still running at its next release overruns
+    uint32_t next_release = end_us;
+    for (uint8_t id = 0; id < TASKS; id++)
+    {
+      TaskRun& run = runs[id];
+      if (s_tasks[id].period_us == 0)
+      {
+        continue;
+      }
+      if (run.next_us <= s_now_us && run.idle)
+      {
+        run.idle = false;
+        run.started = false;
+        run.release_us = run.next_us;
+        run.progress_us = 0;
+        sched.ready(id);
+      }
+      while (run.next_us <= s_now_us)
+      {
+        run.next_us += s_tasks[id].period_us;
+      }
+      if (run.next_us < next_release)
+      {
+        next_release = run.next_us;
+      }
+    }
+
+    if (sched.preempt())
+    {
+      current = sched.pick(nullptr);
+    }
+    if (current == TaskScheduler::NO_TASK)
+    {
+      s_now_us = next_release;
+      continue;
+    }
+
+    TaskRun& run = runs[current];
+    if (!run.started)
+    {
+      uint32_t wake = s_now_us - run.release_us;
+      run.started = true;
+      run.wake_total_us += wake;
+      if (wake > run.wake_max_us)
+      {
+        run.wake_max_us = wake;
+      }
+    }
+    if (!job_events(&sched, current, &run))
+    {
+      continue;
+    }
+
+    uint32_t dt = to_next_event(current, run);
+    dt = dt < STEP_US ? dt : STEP_US;
+    if (next_release - s_now_us < dt)
+    {
+      dt = next_release - s_now_us;
+    }
+    s_now_us += dt;
+    run.progress_us += dt;
+
+    if (!job_events(&sched, current, &run) || run.progress_us < s_tasks[current].work_us)
+    {
+      continue;
+    }
+
+    // Job done
+    uint32_t response = s_now_us - run.release_us;
+    run.jobs++;
+    run.resp_total_us += response;
+    if (response > run.resp_max_us)
+    {
+      run.resp_max_us = response;
+    }
+    if (s_tasks[current].period_us > 0)
+    {
+      if (response > s_tasks[current].period_us)
+      {
+        run.misses++;
+      }
+      run.idle = true;
+      sched.block(current);
+    }
+    else
+    {
+      run.release_us = s_now_us;  // Background: next chunk right away
+      run.progress_us = 0;
+    }
+  }
+
+  for (uint8_t p = 0; p < TaskScheduler::PRIORITIES; p++)
+  {
+    latency[p] = sched.latency(p);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  long seconds = 10;
+  const char* slice_text = "0 5 10";
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc)
+    {
+      seconds = atol(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--hold-us") == 0 && i + 1 < argc)
+    {
+      s_tasks[TASKS - 1].hold_us = (uint32_t)atol(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--slices") == 0 && i + 1 < argc)
+    {
+      slice_text = argv[++i];
+    }
+    else
+    {
+      fprintf(stderr, "Usage: %s [--seconds N] [--hold-us N] [--slices \"0 5 10\"]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+
+  TaskDef& logger = s_tasks[TASKS - 1];
+  uint16_t slices[TaskScheduler::PRIORITIES];
+  if (seconds <= 0 || seconds > 3600 ||
+      logger.lock_at + logger.hold_us > logger.work_us ||
+      !TaskScheduler::parse_slices(slice_text, slices))
+  {
+    fprintf(stderr, "Invalid --seconds/--hold-us/--slices (hold at most %u us)\n",
+            (unsigned)(logger.work_us - logger.lock_at));
+    return 2;
+  }
+
+  static const Policy policies[] = {
+      {"rr", false, false},
+      {"prio", true, false},
+      {"prio+pi", true, true},
+  };
+  static constexpr size_t POLICIES = sizeof(policies) / sizeof(policies[0]);
+  TaskRun runs[POLICIES][TASKS];
+  TaskScheduler::Latency latency[POLICIES][TaskScheduler::PRIORITIES];
+
+  printf("%ld s simulated, %u us steps, logger holds the bus %u us, slices \"%s\" ms\n\n",
+         seconds, (unsigned)STEP_US, (unsigned)logger.hold_us, slice_text);
+  printf("%-8s %-8s %4s %10s %10s %10s %10s %7s %7s\n", "policy", "task", "prio",
+         "wake max", "wake avg", "resp max", "resp avg", "jobs", "misses");
+  for (size_t p = 0; p < POLICIES; p++)
+  {
+    run_policy(policies[p], (uint32_t)seconds, slices, runs[p], latency[p]);
+    for (uint8_t id = 0; id < TASKS; id++)
+    {
+      const TaskRun& run = runs[p][id];
+      uint32_t jobs = run.jobs > 0 ? run.jobs : 1;
+      printf("%-8s %-8s %4u ", policies[p].name, s_tasks[id].name,
+             (unsigned)(policies[p].priorities ? s_tasks[id].priority : RR_PRIORITY));
+      if (s_tasks[id].period_us > 0)
+      {
+        printf("%10u %10u ", (unsigned)run.wake_max_us,
+               (unsigned)(run.wake_total_us / jobs));
+      }
+      else
+      {
+        printf("%10s %10s ", "-", "-");  // Background: never waits for a release
+      }
+      printf("%10u %10u %7u %7u\n", (unsigned)run.resp_max_us,
+             (unsigned)(run.resp_total_us / jobs), (unsigned)run.jobs,
+             (unsigned)run.misses);
+    }
+  }
+
+  printf("\nTaskScheduler wakeup latency per priority (CMD_SCHED counters), us\n");
+  printf("%-8s %4s %10s %10s %10s\n", "policy", "prio", "wakeups", "max", "avg");
+  for (size_t p = 0; p < POLICIES; p++)
+  {
+    for (uint8_t prio = 0; prio < TaskScheduler::PRIORITIES; prio++)
+    {
+      const TaskScheduler::Latency& l = latency[p][prio];
+      if (l.wakeups == 0)
+      {
+        continue;
+      }
+      printf("%-8s %4u %10u %10u %10u\n", policies[p].name, (unsigned)prio,
+             (unsigned)l.wakeups, (unsigned)l.max_us, (unsigned)(l.total_us / l.wakeups));
+    }
+  }
+
+  // Inheritance must bound the control loop by the logger's critical section
+  const TaskRun& control = runs[POLICIES - 1][0];
+  return control.misses == 0 ? 0 : 1;
+}
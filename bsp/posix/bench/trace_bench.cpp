@@ -0,0 +1,259 @@
+/**
+ * @file trace_bench.cpp
+ * @brief Event trace: cost per event vs. a log line, and lock-free ring checks
+ *
+ * Part 1 times one event through each diagnostics path, single producer:
+ * - log:      an ESP_LOGI-style formatted line ("I (ms) tag: ...") written
+ *             to /dev/null; on a device the UART adds ~90 us per line
+ * - off:      trace_event() with no trace installed (V4_TRACE builds
+ *             before trace_install())
+ * - masked:   trace_event() for an event type disabled with OP_ENABLE
+ * - trace:    trace_event() into a TraceBuffer ring
+ *
+ * Part 2 runs 1, 2 and 4 producer threads on one ring (tasks and ISRs
+ * sharing a core's ring) while a consumer drains it like the link task.
+ * Every record carries its producer and sequence number; the run fails
+ * if a record is corrupted, arrives out of order for its producer, or if
+ * received + dropped differs from the events emitted.
+ *
+ * Usage:
+ *   v4-bench-trace [--events N]
+ *
+ * SPDX-License-Identifier: MIT OR Apache-2.0
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <thread>
+#include <vector>
+
+#include "trace_buffer.hpp"
+
+using v4rtos::TraceBuffer;
+using v4rtos::TraceRecord;
+using v4rtos::TraceRing;
+
+static constexpr size_t RING_RECORDS = 4096;
+static constexpr size_t BATCH = RING_RECORDS / 2;  ///< Events between drains (part 1)
+
+static uint32_t clock_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+}
+
+static double seconds(std::chrono::steady_clock::duration d)
+{
+  return std::chrono::duration<double>(d).count();
+}
+
+static void drain(TraceRing& ring)
+{
+  TraceRecord rec;
+  while (ring.pop(&rec))
+  {
+  }
+}
+
+// ==============================================================================
+// Part 1: cost per event
+// ==============================================================================
+
+static FILE* s_null = nullptr;
+
+// ESP_LOGI(TAG, "SYS %u enter (task %u)", ...) without the UART
+__attribute__((noinline)) static void log_event(uint8_t task, uint16_t id)
+{
+  char line[96];
+  int len = snprintf(line, sizeof(line), "I (%u) v4-runtime: SYS %u enter (task %u)\n",
+                     (unsigned)(clock_ns() / 1000000u), (unsigned)id, (unsigned)task);
+  fwrite(line, 1, (size_t)len, s_null);
+}
+
+enum class Path
+{
+  LOG,
+  OFF,
+  MASKED,
+  TRACE
+};
+
+static double time_path(Path path, TraceBuffer* trace, uint32_t events)
+{
+  v4rtos::trace_install(path == Path::LOG || path == Path::OFF ? nullptr : trace);
+  trace->set_enabled(path == Path::MASKED ? 0 : TraceBuffer::ALL_EVENTS);
+
+  std::chrono::steady_clock::duration total{};
+  for (uint32_t done = 0; done < events;)
+  {
+    uint32_t n = events - done < BATCH ? events - done : (uint32_t)BATCH;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < n; i++)
+    {
+      if (path == Path::LOG)
+      {
+        log_event(1, (uint16_t)(done + i));
+      }
+      else
+      {
+        v4rtos::trace_event(v4rtos::TRACE_SYS_ENTER, 1, (uint16_t)(done + i), 0);
+      }
+    }
+    total += std::chrono::steady_clock::now() - start;
+    drain(trace->ring(0));  // Link task drain, not timed
+    done += n;
+  }
+  v4rtos::trace_install(nullptr);
+  trace->set_enabled(TraceBuffer::ALL_EVENTS);
+  return seconds(total) * 1e9 / events;
+}
+
+// ==============================================================================
+// Part 2: producers and a concurrent consumer on one ring
+// ==============================================================================
+
+/** Outcome of one contention run */
+struct Contention
+{
+  double ns_per_event;  ///< Wall time per emitted event
+  uint64_t received;    ///< Records drained
+  uint64_t dropped;     ///< Records the full ring refused
+  bool valid;           ///< No corruption, order kept, nothing lost
+};
+
+static Contention run_contention(unsigned producers, uint32_t events)
+{
+  TraceBuffer trace(clock_ns, 1000, nullptr, 1, RING_RECORDS);
+  TraceRing& ring = trace.ring(0);
+  std::atomic<unsigned> running{producers};
+  std::atomic<bool> go{false};
+
+  std::vector<uint32_t> next(producers, 0);  // Next expected sequence per producer
+  uint64_t received = 0;
+  bool valid = true;
+
+  auto consume = [&](const TraceRecord& rec) {
+    unsigned p = rec.task;
+    uint32_t seq = rec.arg & 0xFFFFFFu;
+    if (p >= producers || rec.type != v4rtos::TRACE_MSG_SEND ||
+        rec.arg >> 24 != p || rec.arg16 != (uint16_t)seq || seq < next[p])
+    {
+      valid = false;
+      return;
+    }
+    next[p] = seq + 1;  // Gaps are drops
+    received++;
+  };
+
+  std::vector<std::thread> threads;
+  for (unsigned p = 0; p < producers; p++)
+  {
+    threads.emplace_back([&, p]() {
+      while (!go.load(std::memory_order_acquire))
+      {
+      }
+      for (uint32_t seq = 0; seq < events; seq++)
+      {
+        trace.emit(v4rtos::TRACE_MSG_SEND, (uint8_t)p, (uint16_t)seq, (p << 24) | seq);
+      }
+      running.fetch_sub(1, std::memory_order_release);
+    });
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  go.store(true, std::memory_order_release);
+  TraceRecord rec;
+  while (running.load(std::memory_order_acquire) > 0)
+  {
+    while (ring.pop(&rec))
+    {
+      consume(rec);
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+  for (std::thread& t : threads)
+  {
+    t.join();
+  }
+  while (ring.pop(&rec))
+  {
+    consume(rec);
+  }
+
+  Contention c;
+  c.ns_per_event = seconds(end - start) * 1e9 / ((double)events * producers);
+  c.received = received;
+  c.dropped = ring.dropped();
+  c.valid = valid && ring.pending() == 0 &&
+            received + c.dropped == (uint64_t)events * producers;
+  return c;
+}
+
+int main(int argc, char** argv)
+{
+  long events = 2000000;
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--events") == 0 && i + 1 < argc)
+    {
+      events = atol(argv[++i]);
+    }
+    else
+    {
+      fprintf(stderr, "Usage: %s [--events N]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (events <= 0 || events > 0xFFFFFF)
+  {
+    fprintf(stderr, "Invalid --events (1..16777215)\n");
+    return 2;
+  }
+  s_null = fopen("/dev/null", "w");
+  if (s_null == nullptr)
+  {
+    perror("/dev/null");
+    return 1;
+  }
+
+  printf("%ld events per run, %u-record ring\n\n", events, (unsigned)RING_RECORDS);
+  printf("%-8s %10s %10s\n", "path", "ns/event", "vs. log");
+  TraceBuffer trace(clock_ns, 1000, nullptr, 1, RING_RECORDS);
+  static const struct
+  {
+    const char* name;
+    Path path;
+  } paths[] = {
+      {"log", Path::LOG},
+      {"off", Path::OFF},
+      {"masked", Path::MASKED},
+      {"trace", Path::TRACE},
+  };
+  double log_ns = 0;
+  for (const auto& p : paths)
+  {
+    double ns = time_path(p.path, &trace, (uint32_t)events);
+    log_ns = p.path == Path::LOG ? ns : log_ns;
+    printf("%-8s %10.1f %9.1fx\n", p.name, ns, ns > 0 ? log_ns / ns : 0.0);
+  }
+  fclose(s_null);
+
+  printf("\n%-9s %10s %12s %10s %6s\n", "producers", "ns/event", "received", "dropped",
+         "check");
+  bool valid = true;
+  for (unsigned producers : {1u, 2u, 4u})
+  {
+    Contention c = run_contention(producers, (uint32_t)events);
+    printf("%-9u %10.1f %12llu %10llu %6s\n", producers, c.ns_per_event,
+           (unsigned long long)c.received, (unsigned long long)c.dropped,
+           c.valid ? "ok" : "FAIL");
+    valid = valid && c.valid;
+  }
+  return valid ? 0 : 1;
+}
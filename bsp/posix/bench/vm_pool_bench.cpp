@@ -0,0 +1,286 @@
+/**
+ * @file vm_pool_bench.cpp
+ * @brief VM pool stress test: throughput scaling and fault isolation
+ *
+ * Runs 1..VmPool::MAX_VMS bench VMs from one VmPool, one host thread per
+ * VM (the runtime's link task is the only executor on target, so
+ * threads here stand in for independent devices sharing the pool code).
+ * Each thread runs the acc workload in its own arena slice and checks
+ * the result against a reference run.
+ *
+ * A second pass repeats the largest pool while VM 0 keeps running a
+ * program that underflows its data stack. Its thread reports the fault
+ * through VmPool::panic_hook() and restarts the VM, exactly as the link
+ * port does before routing the next frame; the other VMs must keep
+ * their throughput and results.
+ *
+ * Usage:
+ *   v4-bench-vm-pool [--ms N] [--iterations N]
+ *
+ * SPDX-License-Identifier: MIT OR Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <time.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "dispatch_bench_programs.hpp"
+#include "dispatch_bench_vm.hpp"
+#include "vm_pool.hpp"
+
+using namespace v4bench;
+using v4rtos::VmPool;
+
+static constexpr size_t CACHE_LINE = 64;
+
+// ==============================================================================
+// Helpers
+// ==============================================================================
+
+static double now_seconds(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Bench VMs live at the start of their slice, like vm_create() on target
+static void* create_vm(void* user, uint8_t id, uint8_t* mem, size_t size)
+{
+  (void)user;  // Unused
+  (void)id;    // Unused
+  if (size < sizeof(BenchVm))
+  {
+    return nullptr;
+  }
+  return new (mem) BenchVm();
+}
+
+static void destroy_vm(void* user, void* vm)
+{
+  (void)user;  // Unused
+  static_cast<BenchVm*>(vm)->~BenchVm();
+}
+
+// ==============================================================================
+// Workers
+// ==============================================================================
+
+/** Per-thread result */
+struct WorkerStats
+{
+  uint64_t runs;      ///< Completed workload runs
+  uint64_t wrong;     ///< Runs with a wrong result
+  uint64_t faults;    ///< Injected faults (faulting VM only)
+  uint64_t restarts;  ///< Restarts after a fault
+};
+
+/** Shared worker setup */
+struct WorkerCtx
+{
+  VmPool* pool;
+  const Workload* work;
+  const std::vector<uint8_t>* crash;  ///< Underflowing program
+  int32_t expect;                     ///< Reference result of @p work
+  bool inject;                        ///< VM 0 runs @p crash between runs
+  std::atomic<bool> go{false};
+  std::atomic<bool> stop{false};
+};
+
+static void worker(WorkerCtx* ctx, uint8_t id, WorkerStats* out)
+{
+  WorkerStats s = {0, 0, 0, 0};
+  while (!ctx->go.load(std::memory_order_acquire))
+  {
+    std::this_thread::yield();
+  }
+  while (!ctx->stop.load(std::memory_order_relaxed))
+  {
+    // Same order as the link port: restart a faulted VM, then route to it
+    if (ctx->pool->info(id).state == VmPool::State::FAULTED && ctx->pool->restart(id))
+    {
+      s.restarts++;
+    }
+    BenchVm* vm = static_cast<BenchVm*>(ctx->pool->vm(id));
+    if (vm == nullptr)
+    {
+      break;
+    }
+
+    if (ctx->inject && id == 0)
+    {
+      int err = run_switch_o2(vm, ctx->crash->data(), 0);
+      if (err != BENCH_OK)
+      {
+        VmPool::panic_hook(ctx->pool->fault_context(id), err);
+        s.faults++;
+      }
+      continue;
+    }
+
+    int err = run_switch_o2(vm, ctx->work->code.data(), ctx->work->entry);
+    if (err != BENCH_OK || vm->depth != 1 || vm->ds[0] != ctx->expect)
+    {
+      s.wrong++;
+    }
+    s.runs++;
+  }
+  *out = s;
+}
+
+/**
+ * @brief Run @p count VMs for @p ms milliseconds
+ * @return Per-VM stats
+ */
+static std::vector<WorkerStats> run_pool(size_t count, const Workload& work,
+                                         const std::vector<uint8_t>& crash,
+                                         int32_t expect, bool inject, int ms,
+                                         double* elapsed)
+{
+  // Whole cache lines per slice, so neighbouring VMs do not share one
+  size_t slice = (sizeof(BenchVm) + CACHE_LINE - 1) & ~(CACHE_LINE - 1);
+  std::vector<uint8_t> buf(slice * count + CACHE_LINE);
+  uint8_t* arena = buf.data() + (CACHE_LINE - (uintptr_t)buf.data() % CACHE_LINE);
+  VmPool pool(arena, slice * count, count, create_vm, destroy_vm, nullptr);
+  pool.start();
+
+  WorkerCtx ctx;
+  ctx.pool = &pool;
+  ctx.work = &work;
+  ctx.crash = &crash;
+  ctx.expect = expect;
+  ctx.inject = inject;
+
+  std::vector<WorkerStats> stats(count);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < count; i++)
+  {
+    threads.emplace_back(worker, &ctx, static_cast<uint8_t>(i), &stats[i]);
+  }
+
+  double start = now_seconds();
+  ctx.go.store(true, std::memory_order_release);
+  struct timespec wait = {ms / 1000, (long)(ms % 1000) * 1000000L};
+  nanosleep(&wait, nullptr);
+  ctx.stop.store(true);
+  for (std::thread& t : threads)
+  {
+    t.join();
+  }
+  *elapsed = now_seconds() - start;
+
+  // The pool's own accounting must agree with what the threads saw
+  for (size_t i = 0; i < count; i++)
+  {
+    const VmPool::Info& info = pool.info(static_cast<uint8_t>(i));
+    if (info.faults != static_cast<uint16_t>(stats[i].faults) ||
+        info.restarts != static_cast<uint16_t>(stats[i].restarts))
+    {
+      stats[i].wrong++;
+    }
+  }
+  return stats;
+}
+
+// ==============================================================================
+// Main
+// ==============================================================================
+
+int main(int argc, char** argv)
+{
+  int ms = 300;
+  int32_t iterations = 2000;
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--ms") == 0 && i + 1 < argc)
+    {
+      ms = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+    {
+      iterations = atoi(argv[++i]);
+    }
+    else
+    {
+      fprintf(stderr, "Usage: %s [--ms N] [--iterations N]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (ms <= 0 || iterations <= 0)
+  {
+    fprintf(stderr, "Invalid --ms/--iterations\n");
+    return 2;
+  }
+
+  Workload work = make_acc(iterations);
+  Assembler bad;
+  bad.op(OP_DROP);  // Data stack underflow on an empty stack
+  bad.op(OP_HALT);
+  std::vector<uint8_t> crash = bad.code();
+
+  BenchVm ref;
+  if (run_switch_o2(&ref, work.code.data(), work.entry) != BENCH_OK || ref.depth != 1)
+  {
+    fprintf(stderr, "Reference run failed\n");
+    return 1;
+  }
+  int32_t expect = ref.ds[0];
+
+  unsigned cpus = std::thread::hardware_concurrency();
+  printf("VM pool: %s x %d per run, %d ms per point, %u host CPUs\n", work.name,
+         iterations, ms, cpus);
+  printf("%-5s %14s %9s %8s\n", "VMs", "runs/s", "speedup", "wrong");
+
+  uint64_t wrong = 0;
+  double base = 0.0;
+  for (size_t n = 1; n <= VmPool::MAX_VMS; n++)
+  {
+    double elapsed = 0.0;
+    std::vector<WorkerStats> stats =
+        run_pool(n, work, crash, expect, false, ms, &elapsed);
+    uint64_t runs = 0;
+    uint64_t bad_runs = 0;
+    for (const WorkerStats& s : stats)
+    {
+      runs += s.runs;
+      bad_runs += s.wrong;
+    }
+    double rate = (double)runs / elapsed;
+    if (n == 1)
+    {
+      base = rate;
+    }
+    printf("%-5zu %14.0f %8.2fx %8llu\n", n, rate, rate / base,
+           (unsigned long long)bad_runs);
+    wrong += bad_runs;
+  }
+
+  // Fault isolation: VM 0 panics continuously, the others must not notice
+  double elapsed = 0.0;
+  std::vector<WorkerStats> stats =
+      run_pool(VmPool::MAX_VMS, work, crash, expect, true, ms, &elapsed);
+  printf("\nFault isolation (%zu VMs, VM 0 underflows every run):\n", VmPool::MAX_VMS);
+  printf("%-5s %14s %9s %9s %8s\n", "VM", "runs/s", "faults", "restarts", "wrong");
+  for (size_t i = 0; i < stats.size(); i++)
+  {
+    const WorkerStats& s = stats[i];
+    printf("%-5zu %14.0f %9llu %9llu %8llu\n", i, (double)s.runs / elapsed,
+           (unsigned long long)s.faults, (unsigned long long)s.restarts,
+           (unsigned long long)s.wrong);
+    wrong += s.wrong;
+  }
+
+  if (wrong != 0)
+  {
+    fprintf(stderr, "FAILED: %llu wrong results\n", (unsigned long long)wrong);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,62 @@
+/**
+ * @file board.h
+ * @brief Host (POSIX) Board Configuration
+ *
+ * Virtual board used by the POSIX runtime. Pin numbers mirror the
+ * M5Stack NanoC6 so that bytecode written for the device runs unchanged.
+ *
+ * SPDX-License-Identifier: MIT OR Apache-2.0
+ */
+
+#ifndef BOARD_HOST_H
+#define BOARD_HOST_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  /* ========================================================================
+   * Board Identification
+   * ======================================================================== */
+
+#define BOARD_NAME "Host (POSIX)"
+#define BOARD_VARIANT "HOST"
+#define BOARD_MCU "POSIX"
+#define BOARD_VENDOR "V4-project"
+
+/* ========================================================================
+ * GPIO Pin Definitions (virtual)
+ * ======================================================================== */
+
+/** Simple LED (virtual GPIO7, active high) */
+#define LED_PIN 7
+#define LED_ACTIVE_HIGH 1
+
+/** Button (virtual GPIO9, active low) */
+#define BUTTON_PIN 9
+#define BUTTON_ACTIVE_LOW 1
+
+/** Number of virtual GPIO pins */
+#define HOST_GPIO_COUNT 32
+
+  /* ========================================================================
+   * Board Features
+   * ======================================================================== */
+
+#define HAS_RGB_LED 0
+#define HAS_BUTTON 1
+#define HAS_BATTERY 0
+#define HAS_GROVE 0
+#define HAS_LCD 0
+#define HAS_IMU 0
+#define HAS_WIFI 0
+#define HAS_BLE 0
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BOARD_HOST_H */
@@ -0,0 +1,56 @@
+/**
+ * @file host_ddt_provider.cpp
+ * @brief DDT Provider for the Host (POSIX) board
+ *
+ * SPDX-License-Identifier: MIT OR Apache-2.0
+ */
+
+#include "host_ddt_provider.hpp"
+
+#include "ddt_index.hpp"
+
+extern "C"
+{
+#include "board.h"
+}
+
+namespace v4rtos
+{
+
+// Device descriptor table of the virtual host board (board_devices.def)
+static constexpr v4dev_desc_t DEVICES[] = {
+#define V4_DEVICE(kind_, role_, index_, flags_, handle_) \
+  {                                                       \
+      .kind = (kind_),                                    \
+      .role = (role_),                                    \
+      .index = (index_),                                  \
+      .flags = (flags_),                                  \
+      .handle = (handle_),                                \
+  },
+#include "board_devices.def"
+};
+
+static constexpr auto INDEX = make_ddt_index(DEVICES);
+static_assert(INDEX.valid(), "board_devices.def: (kind, role, index) listed twice");
+
+v4std::span<const v4dev_desc_t> HostDdtProvider::get_devices() const
+{
+  return v4std::span<const v4dev_desc_t>{DEVICES, INDEX.size()};
+}
+
+const v4dev_desc_t* HostDdtProvider::find(uint8_t kind, uint8_t role, uint8_t index)
+{
+  return INDEX.find(kind, role, index);
+}
+
+size_t HostDdtProvider::count()
+{
+  return INDEX.size();
+}
+
+}  // namespace v4rtos
+
+extern "C" const v4dev_desc_t* v4_ddt_lookup(uint8_t kind, uint8_t role, uint8_t index)
+{
+  return v4rtos::INDEX.find(kind, role, index);
+}
@@ -0,0 +1,65 @@
+/**
+ * @file host_ddt_provider.hpp
+ * @brief DDT Provider for the Host (POSIX) board
+ *
+ * Device descriptor table for the virtual host board.
+ * Mirrors the NanoC6 layout so device lookups behave identically.
+ *
+ * SPDX-License-Identifier: MIT OR Apache-2.0
+ */
+
+#ifndef HOST_DDT_PROVIDER_HPP
+#define HOST_DDT_PROVIDER_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include "v4std/ddt.hpp"
+#include "v4std/ddt_types.h"
+
+extern "C"
+{
+  /**
+   * @brief V4-std hook: device by (kind, role, index)
+   *
+   * V4-std built with V4STD_DDT_LOOKUP resolves devices through this
+   * instead of scanning DdtProvider::get_devices(). Defined by the board.
+   *
+   * @return Descriptor, or nullptr if the board has no such device
+   */
+  const v4dev_desc_t* v4_ddt_lookup(uint8_t kind, uint8_t role, uint8_t index);
+}
+
+namespace v4rtos
+{
+
+/**
+ * @brief DDT Provider for the Host (POSIX) board
+ *
+ * Provides device descriptors for:
+ * - STATUS LED (virtual GPIO7, active-high)
+ * - USER BUTTON (virtual GPIO9, active-low)
+ */
+class HostDdtProvider : public v4std::DdtProvider
+{
+ public:
+  v4std::span<const v4dev_desc_t> get_devices() const override;
+
+  /**
+   * @brief Find a device through the constant DdtIndex
+   *
+   * No virtual call and no scan over the table.
+   *
+   * @return Descriptor, or nullptr if the board has no such device
+   */
+  static const v4dev_desc_t* find(uint8_t kind, uint8_t role, uint8_t index);
+
+  /**
+   * @brief Number of devices (board_devices.def)
+   */
+  static size_t count();
+};
+
+}  // namespace v4rtos
+
+#endif  // HOST_DDT_PROVIDER_HPP
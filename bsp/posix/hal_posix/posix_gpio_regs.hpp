@@ -0,0 +1,92 @@
+/**
+ * @file posix_gpio_regs.hpp
+ * @brief Virtual GPIO set/clear registers for POSIX hosts
+ *
+ * Stands in for the ESP32 GPIO_OUT_W1TS/W1TC registers (Esp32GpioRegs):
+ * one level bitmap for 32 virtual pins, with every register store and
+ * every resulting level change counted, so host runs and benchmarks see
+ * how many writes a pin pattern costs on hardware.
+ *
+ * SPDX-License-Identifier: MIT OR Apache-2.0
+ */
+
+#ifndef POSIX_GPIO_REGS_HPP
+#define POSIX_GPIO_REGS_HPP
+
+#include <atomic>
+#include <cstdint>
+
+namespace v4rtos
+{
+
+/**
+ * @brief Virtual GPIO0-31 set/clear registers (GpioPort register block)
+ *
+ * Outputs read back as inputs (pads wired to their latch).
+ */
+class PosixGpioRegs
+{
+ public:
+  static constexpr uint32_t PIN_COUNT = 32;  ///< Number of virtual GPIO pins
+
+  /** W1TS store */
+  void set(uint32_t mask)
+  {
+    uint32_t prev = levels_.fetch_or(mask, std::memory_order_relaxed);
+    count(mask & ~prev);
+  }
+
+  /** W1TC store */
+  void clear(uint32_t mask)
+  {
+    uint32_t prev = levels_.fetch_and(~mask, std::memory_order_relaxed);
+    count(mask & prev);
+  }
+
+  uint32_t out() const
+  {
+    return levels_.load(std::memory_order_relaxed);
+  }
+
+  uint32_t in() const
+  {
+    return levels_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Get number of register stores since start
+   * @return Set and clear stores
+   */
+  uint64_t write_count() const
+  {
+    return writes_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Get number of physical level changes since start
+   * @return Toggle count across all pins
+   */
+  uint64_t toggle_count() const
+  {
+    return toggles_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  void count(uint32_t changed)
+  {
+    writes_.fetch_add(1, std::memory_order_relaxed);
+    if (changed != 0)
+    {
+      toggles_.fetch_add((uint64_t)__builtin_popcount(changed),
+                         std::memory_order_relaxed);
+    }
+  }
+
+  std::atomic<uint32_t> levels_{0};   ///< Physical level bitmap (bit n = GPIOn)
+  std::atomic<uint64_t> writes_{0};   ///< Register store counter
+  std::atomic<uint64_t> toggles_{0};  ///< Level change counter
+};
+
+}  // namespace v4rtos
+
+#endif  // POSIX_GPIO_REGS_HPP
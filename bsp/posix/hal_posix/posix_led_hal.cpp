@@ -0,0 +1,52 @@
+/**
+ * @file posix_led_hal.cpp
+ * @brief LED HAL implementation for POSIX hosts
+ *
+ * SPDX-License-Identifier: MIT OR Apache-2.0
+ */
+
+#include "posix_led_hal.hpp"
+
+#include "posix_log.h"
+
+static const char* TAG = "posix_led_hal";
+
+namespace v4rtos
+{
+
+bool PosixLedHal::set_led(uint32_t handle, bool state, bool active_low)
+{
+  if (handle >= PIN_COUNT)
+  {
+    POSIX_LOGE(TAG, "Invalid virtual GPIO%u", (unsigned)handle);
+    return false;
+  }
+
+  // Apply active-low logic; one W1TS or W1TC store
+  uint32_t bit = 1u << handle;
+  if (state != active_low)
+  {
+    regs_.set(bit);
+  }
+  else
+  {
+    regs_.clear(bit);
+  }
+  return true;
+}
+
+bool PosixLedHal::get_led(uint32_t handle, bool active_low)
+{
+  if (handle >= PIN_COUNT)
+  {
+    POSIX_LOGE(TAG, "Invalid virtual GPIO%u", (unsigned)handle);
+    return false;
+  }
+
+  bool level = (regs_.out() & (1u << handle)) != 0;
+
+  // Apply active-low logic when reading
+  return level != active_low;
+}
+
+}  // namespace v4rtos
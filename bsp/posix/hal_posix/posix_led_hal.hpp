@@ -0,0 +1,57 @@
+/**
+ * @file posix_led_hal.hpp
+ * @brief LED HAL implementation for POSIX hosts
+ *
+ * SPDX-License-Identifier: MIT OR Apache-2.0
+ */
+
+#ifndef POSIX_LED_HAL_HPP
+#define POSIX_LED_HAL_HPP
+
+#include <cstdint>
+
+#include "posix_gpio_regs.hpp"
+#include "v4std/sys_led.hpp"
+
+namespace v4rtos
+{
+
+/**
+ * @brief LED HAL implementation backed by virtual GPIO registers
+ *
+ * Keeps one level per virtual pin so bytecode can toggle and read back
+ * LEDs exactly as on hardware: like Esp32LedHal, every set_led() is one
+ * set or clear store, without logging.
+ */
+class PosixLedHal : public v4std::LedHal
+{
+ public:
+  static constexpr uint32_t PIN_COUNT = PosixGpioRegs::PIN_COUNT;  ///< Virtual pins
+
+  bool set_led(uint32_t handle, bool state, bool active_low) override;
+  bool get_led(uint32_t handle, bool active_low) override;
+
+  /**
+   * @brief Get number of physical level changes since start
+   * @return Toggle count across all pins
+   */
+  uint64_t toggle_count() const
+  {
+    return regs_.toggle_count();
+  }
+
+  /**
+   * @brief Virtual GPIO registers (shared with the GPIO port words)
+   */
+  PosixGpioRegs& regs()
+  {
+    return regs_;
+  }
+
+ private:
+  PosixGpioRegs regs_;  ///< Virtual GPIO0-31
+};
+
+}  // namespace v4rtos
+
+#endif  // POSIX_LED_HAL_HPP
@@ -0,0 +1,90 @@
+// GPIO port words for the POSIX runtime
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#include "gpio_sys.hpp"
+
+#include "gpio_port.hpp"
+#include "posix_gpio_regs.hpp"
+#include "posix_log.h"
+#include "sys_table.hpp"
+#include "v4/vm_api.h"
+#include "v4std/sys_handlers.hpp"
+
+static const char* TAG = "GpioPort";
+
+namespace v4rtos
+{
+
+using PosixGpioPort = GpioPort<PosixGpioRegs>;
+
+static PosixGpioRegs* s_regs = nullptr;
+static PosixGpioPort* s_port = nullptr;
+
+// ==============================================================================
+// SYS handlers
+// ==============================================================================
+
+// GPIO-PORT-WRITE ( values mask -- result )
+v4_err sys_gpio_port_write(Vm* vm)
+{
+  uint32_t mask = (uint32_t)vm_ds_pop(vm);
+  uint32_t values = (uint32_t)vm_ds_pop(vm);
+
+  PosixGpioPort::Status status = PosixGpioPort::ERR_INVALID;
+  if (s_port != nullptr)
+  {
+    status = s_port->write(mask, values);
+  }
+  vm_ds_push(vm, status);
+  return 0;
+}
+
+// GPIO-PORT-TOGGLE ( mask -- result )
+v4_err sys_gpio_port_toggle(Vm* vm)
+{
+  uint32_t mask = (uint32_t)vm_ds_pop(vm);
+
+  PosixGpioPort::Status status = PosixGpioPort::ERR_INVALID;
+  if (s_port != nullptr)
+  {
+    status = s_port->toggle(mask);
+  }
+  vm_ds_push(vm, status);
+  return 0;
+}
+
+// GPIO-PORT-READ ( -- levels )
+v4_err sys_gpio_port_read(Vm* vm)
+{
+  vm_ds_push(vm, s_port != nullptr ? (v4_i32)s_port->read() : 0);
+  return 0;
+}
+
+void gpio_sys_init(PosixGpioRegs* regs, uint32_t allowed)
+{
+  s_regs = regs;
+  s_port = new PosixGpioPort(*regs, allowed);
+
+#ifndef V4_SYS_TABLE
+  // V4_SYS_TABLE builds find these in the constant table (sys_table.hpp)
+  v4std::register_sys_handler(SYS_GPIO_PORT_WRITE, sys_gpio_port_write);
+  v4std::register_sys_handler(SYS_GPIO_PORT_TOGGLE, sys_gpio_port_toggle);
+  v4std::register_sys_handler(SYS_GPIO_PORT_READ, sys_gpio_port_read);
+#endif
+
+  POSIX_LOGI(TAG, "GPIO port words on virtual pins 0x%08x", (unsigned)allowed);
+}
+
+void gpio_sys_report(void)
+{
+  if (s_regs == nullptr)
+  {
+    return;
+  }
+  POSIX_LOGI(TAG, "GPIO: %llu register writes, %llu level changes",
+             (unsigned long long)s_regs->write_count(),
+             (unsigned long long)s_regs->toggle_count());
+}
+
+}  // namespace v4rtos
@@ -0,0 +1,31 @@
+// GPIO port words for the POSIX runtime
+//
+// Registers GPIO-PORT-WRITE, GPIO-PORT-TOGGLE and GPIO-PORT-READ
+// (SYS_GPIO_PORT_WRITE .. SYS_GPIO_PORT_READ) on the virtual GPIO
+// registers of the LED HAL, which count every set/clear store.
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include <cstdint>
+
+namespace v4rtos
+{
+
+class PosixGpioRegs;
+
+/**
+ * @brief Register the SYS handlers
+ *
+ * @param regs    Virtual GPIO registers (PosixLedHal::regs())
+ * @param allowed Pins the words may drive (V4_GPIO_PORT_MASK)
+ */
+void gpio_sys_init(PosixGpioRegs* regs, uint32_t allowed);
+
+/**
+ * @brief Log register stores and level changes
+ */
+void gpio_sys_report(void);
+
+}  // namespace v4rtos
@@ -0,0 +1,98 @@
+// Bytecode image partition implementation for POSIX hosts
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#include "image_partition.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+
+#include "posix_log.h"
+
+static const char* TAG = "ImagePart";
+
+#ifndef CONFIG_V4_IMAGE_PARTITION_KB
+#define CONFIG_V4_IMAGE_PARTITION_KB 128
+#endif
+
+#define IMAGE_PARTITION_SIZE (CONFIG_V4_IMAGE_PARTITION_KB * 1024)
+
+/** Erase granularity, same as the ESP32-C6 flash sector */
+#define IMAGE_SECTOR_SIZE 4096
+
+namespace v4rtos
+{
+
+static bool file_erase(void* user, size_t offset, size_t len)
+{
+  memset(static_cast<uint8_t*>(user) + offset, 0xFF, len);
+  return true;
+}
+
+// NOR programming: bits can only go from 1 to 0
+static bool file_write(void* user, size_t offset, const uint8_t* data, size_t len)
+{
+  uint8_t* dst = static_cast<uint8_t*>(user) + offset;
+  for (size_t i = 0; i < len; i++)
+  {
+    dst[i] &= data[i];
+  }
+  return memcmp(dst, data, len) == 0;
+}
+
+bool image_partition_open(ImageFlash* flash, const char* path)
+{
+  int fd = open(path, O_RDWR | O_CREAT, 0644);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0)
+  {
+    POSIX_LOGE(TAG, "Cannot open image file %s: %s", path, strerror(errno));
+    if (fd >= 0)
+    {
+      close(fd);
+    }
+    return false;
+  }
+
+  // Pad to the partition size with erased flash
+  uint8_t erased[IMAGE_SECTOR_SIZE];
+  memset(erased, 0xFF, sizeof(erased));
+  for (off_t pos = st.st_size; pos < IMAGE_PARTITION_SIZE;)
+  {
+    size_t n = IMAGE_PARTITION_SIZE - (size_t)pos;
+    n = n < sizeof(erased) ? n : sizeof(erased);
+    if (pwrite(fd, erased, n, pos) != (ssize_t)n)
+    {
+      POSIX_LOGE(TAG, "Cannot extend image file %s: %s", path, strerror(errno));
+      close(fd);
+      return false;
+    }
+    pos += (off_t)n;
+  }
+
+  void* map =
+      mmap(nullptr, IMAGE_PARTITION_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);  // The mapping stays valid
+  if (map == MAP_FAILED)
+  {
+    POSIX_LOGE(TAG, "Cannot map image file %s: %s", path, strerror(errno));
+    return false;
+  }
+
+  flash->map = static_cast<const uint8_t*>(map);
+  flash->size = IMAGE_PARTITION_SIZE;
+  flash->erase_size = IMAGE_SECTOR_SIZE;
+  flash->erase = file_erase;
+  flash->write = file_write;
+  flash->user = map;
+  POSIX_LOGI(TAG, "Image partition: %u KB in %s, mapped @ %p",
+             (unsigned)CONFIG_V4_IMAGE_PARTITION_KB, path, map);
+  return true;
+}
+
+}  // namespace v4rtos
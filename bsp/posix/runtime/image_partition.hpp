@@ -0,0 +1,34 @@
+// Bytecode image partition for POSIX hosts
+//
+// Stands in for the ESP32-C6 "v4image" flash partition with a shared
+// mapping of a file (--image-file). Erase and write follow NOR flash rules
+// (erase fills with 0xFF, a write can only clear bits), so an upload that
+// forgets to erase fails here as it would on the device. Images built by
+// scripts/v4image.py can be used as the file directly.
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include "image_store.hpp"
+
+#ifndef CONFIG_V4_IMAGE_TRIAL_S
+#define CONFIG_V4_IMAGE_TRIAL_S 10  ///< Trial window of a new image (seconds)
+#endif
+
+namespace v4rtos
+{
+
+/**
+ * @brief Map an image file
+ *
+ * A missing or short file is created or extended to
+ * CONFIG_V4_IMAGE_PARTITION_KB with erased (0xFF) bytes.
+ *
+ * @param flash Region to fill
+ * @param path File backing the partition
+ * @return false if the file cannot be opened or mapped
+ */
+bool image_partition_open(ImageFlash* flash, const char* path);
+
+}  // namespace v4rtos
@@ -0,0 +1,948 @@
+/**
+ * @file main.cpp
+ * @brief V4 RTOS Runtime for POSIX hosts
+ *
+ * Runs the same initialization sequence and V4-link loop as the
+ * ESP32-C6 runtime, with a pty or an inherited fd (e.g. one end of a
+ * socketpair) standing in for USB Serial/JTAG and an optional loopback
+ * TCP port standing in for a second transport. Intended for soak and
+ * throughput testing on CI machines.
+ *
+ * Usage:
+ *   v4-runtime-posix [--pty | --fd N] [--tcp PORT] [--poll-us N] [--iterations N]
+ *                    [--vms N] [--panic-policy NAME] [--crash-file PATH]
+ *                    [--image-file PATH] [-v]
+ *
+ * SPDX-License-Identifier: MIT OR Apache-2.0
+ */
+
+#include <fcntl.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+// Board definitions
+extern "C"
+{
+#include "host/board.h"
+}
+
+// V4 kernel APIs
+#include "v4/task.h"
+#include "v4/vm_api.h"
+
+// V4-hal APIs
+#include "v4/hal.h"
+
+// V4-link port and transports
+#include "posix_link_port.hpp"
+#include "posix_link_transport.hpp"
+
+// V4 panic handler and crash log (--panic-policy, --crash-file)
+#include "crash_log.hpp"
+#include "panic_handler.hpp"
+
+// VM memory layout (CMake: V4_VM_ARENA_SIZE_KB, V4_NAME_ARENA_SIZE_KB)
+#include "vm_memory.hpp"
+
+// Memory high-water marks (CMD_MEM_STATS, MEM-WATERMARK)
+#include "mem_stats.hpp"
+
+// VM pool (--vms N)
+#include "vm_pool.hpp"
+
+// Pooled zero-copy messages (MSG-POOL .. MSG-FREE)
+#include "msg_sys.hpp"
+
+// GPIO port words (GPIO-PORT-WRITE .. GPIO-PORT-READ)
+#include "gpio_sys.hpp"
+
+// Bytecode image partition (--image-file)
+#include "image_partition.hpp"
+#include "image_store.hpp"
+
+// Peephole pass (CMake: V4_VM_PEEPHOLE)
+#ifdef V4_PEEPHOLE
+#include "bytecode_peephole.hpp"
+#endif
+
+// Priority scheduling (CMake: V4_SCHED_PRIORITY)
+#ifdef V4_SCHED_PRIORITY
+#include "sched_sys.hpp"
+#endif
+
+// VM profiler (CMake: V4_PROFILE)
+#ifdef V4_PROFILE
+#include "vm_profiler.hpp"
+#endif
+
+// Event trace (CMake: V4_TRACE)
+#ifdef V4_TRACE
+#include "trace_buffer.hpp"
+#endif
+
+// Logging
+#include "posix_log.h"
+
+// V4-std integration (host-level)
+#include "../hal_posix/posix_led_hal.hpp"
+// V4-std integration (board-level)
+#include "../boards/host/host_ddt_provider.hpp"
+#include "v4std/ddt.hpp"
+#include "v4std/sys_led.hpp"
+
+static const char* TAG = "v4-runtime";
+
+int posix_log_level = POSIX_LOG_INFO;
+
+// ==============================================================================
+// VM Memory Configuration
+// ==============================================================================
+
+/**
+ * @brief V4 VM memory layout
+ *
+ * Defaults match the ESP32-C6 runtime so that programs which fit on the
+ * device fit here, and vice versa.
+ */
+static v4rtos::VmMemoryLayout g_vm_memory;
+
+/** Global VM instance */
+static struct Vm* g_vm = nullptr;
+
+/** Primary V4-link transport (pty or --fd) */
+static v4rtos::PosixFdTransport* g_link_fd = nullptr;
+
+/** Global V4-link port instance (primary transport, main thread) */
+static v4rtos::PosixLinkPort* g_link = nullptr;
+
+/** Loopback TCP transport (--tcp) */
+static v4rtos::PosixTcpTransport* g_tcp = nullptr;
+
+/** V4-link port on g_tcp, served by its own thread */
+static v4rtos::PosixLinkPort* g_link_tcp = nullptr;
+
+/** Serializes frames of both ports; they share the VMs and handlers */
+static std::mutex g_link_lock;
+
+/** Global VM pool (--vms N; g_vm is VM 0) */
+static v4rtos::VmPool* g_pool = nullptr;
+
+/** Crash log storage without --crash-file (lost at exit) */
+static v4rtos::CrashLog::Storage g_crash_storage;
+
+/** Global crash log (read with the V4-link CRASH_LOG command) */
+static v4rtos::CrashLog* g_crash_log = nullptr;
+
+/** Mapped image file (--image-file) */
+static v4rtos::ImageFlash g_image_flash;
+
+/** Global bytecode image store (nullptr: no --image-file) */
+static v4rtos::ImageStore* g_image = nullptr;
+
+/** VM 0 (re)creation runs the active image once V4-std is up */
+static bool g_image_live = false;
+
+/** Global DDT provider (virtual host board) */
+static v4rtos::HostDdtProvider g_ddt_provider;
+
+/** Global LED HAL (virtual GPIO) */
+static v4rtos::PosixLedHal g_led_hal;
+
+#ifdef V4_PROFILE
+static uint32_t profile_clock_us(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)((uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u);
+}
+
+/** Global VM profiler (read with the V4-link PROFILE command) */
+static v4rtos::VmProfiler g_profiler(profile_clock_us, V4_PROFILE_SAMPLE_PERIOD);
+#endif
+
+#ifdef V4_TRACE
+// No portable cycle counter of known rate: nanosecond timestamps
+static constexpr uint32_t TRACE_TICKS_PER_US = 1000;
+
+static uint32_t trace_clock(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+}
+
+/** Global event trace (drained with the V4-link TRACE command) */
+static v4rtos::TraceBuffer* g_trace = nullptr;
+#endif
+
+#ifdef V4_PEEPHOLE
+/** Global peephole pass (EXEC payload filter) */
+static v4rtos::BytecodePeephole* g_peephole = nullptr;
+#endif
+
+/** Set by SIGINT/SIGTERM to leave the main loop */
+static volatile sig_atomic_t g_stop = 0;
+
+// ==============================================================================
+// Command Line Options
+// ==============================================================================
+
+/** Runtime options */
+struct RuntimeOptions
+{
+  int link_fd = -1;                  ///< Inherited link fd (-1: open a pty)
+  long tcp_port = -1;                ///< Loopback TCP port (-1: none, 0: any)
+  long poll_us = -1;                 ///< Sleep between polls (-1: event-driven)
+  long long iterations = 0;          ///< Loop iterations before exit (0: forever)
+  size_t vms = 1;                    ///< Independent VMs in the VmPool
+  int panic_policy = -1;             ///< PanicPolicy (-1: halt for one VM, else reset-vm)
+  const char* crash_file = nullptr;  ///< Crash log file (nullptr: in memory)
+  const char* image_file = nullptr;  ///< Image partition file (nullptr: none)
+};
+
+static void print_usage(const char* argv0)
+{
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "  --pty            Open a pseudo-terminal for V4-link (default)\n"
+          "  --fd N           Use inherited fd N for V4-link (e.g. socketpair)\n"
+          "  --tcp PORT       Also serve V4-link on 127.0.0.1:PORT (0: any free port)\n"
+          "  --poll-us N      Poll every N microseconds instead of waiting for data\n"
+          "  --iterations N   Exit after N polls/wakeups (default: run forever)\n"
+          "  --vms N          Run N independent VMs (1-4, select with VM_SELECT)\n"
+          "  --panic-policy P halt, reset-vm, restart-task or reboot (default:\n"
+          "                   halt with one VM, reset-vm with several)\n"
+          "  --crash-file F   Keep the crash log in file F across runs\n"
+          "  --image-file F   Flash image partition stand-in; its image runs at boot\n"
+          "  -v, --verbose    Enable debug logging\n",
+          argv0);
+}
+
+static bool parse_options(int argc, char** argv, RuntimeOptions* opts)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    const char* arg = argv[i];
+    bool has_value = i + 1 < argc;
+
+    if (strcmp(arg, "--pty") == 0)
+    {
+      opts->link_fd = -1;
+    }
+    else if (strcmp(arg, "--fd") == 0 && has_value)
+    {
+      opts->link_fd = atoi(argv[++i]);
+    }
+    else if (strcmp(arg, "--tcp") == 0 && has_value)
+    {
+      opts->tcp_port = atol(argv[++i]);
+      if (opts->tcp_port < 0 || opts->tcp_port > 65535)
+      {
+        print_usage(argv[0]);
+        return false;
+      }
+    }
+    else if (strcmp(arg, "--poll-us") == 0 && has_value)
+    {
+      opts->poll_us = atol(argv[++i]);
+    }
+    else if (strcmp(arg, "--iterations") == 0 && has_value)
+    {
+      opts->iterations = atoll(argv[++i]);
+    }
+    else if (strcmp(arg, "--vms") == 0 && has_value)
+    {
+      long vms = atol(argv[++i]);
+      if (vms < 1 || vms > (long)v4rtos::VmPool::MAX_VMS)
+      {
+        print_usage(argv[0]);
+        return false;
+      }
+      opts->vms = (size_t)vms;
+    }
+    else if (strcmp(arg, "--panic-policy") == 0 && has_value)
+    {
+      const char* name = argv[++i];
+      opts->panic_policy = -1;
+      for (uint8_t p = 0; p < v4rtos::PANIC_POLICY_COUNT; p++)
+      {
+        if (strcmp(name, v4rtos::panic_policy_name((v4rtos::PanicPolicy)p)) == 0)
+        {
+          opts->panic_policy = p;
+        }
+      }
+      if (opts->panic_policy < 0)
+      {
+        print_usage(argv[0]);
+        return false;
+      }
+    }
+    else if (strcmp(arg, "--crash-file") == 0 && has_value)
+    {
+      opts->crash_file = argv[++i];
+    }
+    else if (strcmp(arg, "--image-file") == 0 && has_value)
+    {
+      opts->image_file = argv[++i];
+    }
+    else if (strcmp(arg, "-v") == 0 || strcmp(arg, "--verbose") == 0)
+    {
+      posix_log_level = POSIX_LOG_DEBUG;
+    }
+    else
+    {
+      print_usage(argv[0]);
+      return false;
+    }
+  }
+  return true;
+}
+
+static void handle_signal(int sig)
+{
+  (void)sig;
+  g_stop = 1;
+}
+
+static double now_seconds(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Map the crash log storage
+ *
+ * With --crash-file the storage is a shared mapping of that file, so a
+ * panic recorded just before exit() is on disk for the next run (the
+ * host counterpart of RTC no-init RAM). Falls back to process memory.
+ */
+static v4rtos::CrashLog::Storage* crash_storage(const char* path)
+{
+  if (path == nullptr)
+  {
+    return &g_crash_storage;
+  }
+  size_t size = sizeof(v4rtos::CrashLog::Storage);
+  int fd = open(path, O_RDWR | O_CREAT, 0644);
+  if (fd < 0 || ftruncate(fd, (off_t)size) != 0)
+  {
+    POSIX_LOGW(TAG, "Cannot open crash file %s, keeping the log in memory", path);
+    if (fd >= 0)
+    {
+      close(fd);
+    }
+    return &g_crash_storage;
+  }
+  void* map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);  // The mapping stays valid
+  if (map == MAP_FAILED)
+  {
+    POSIX_LOGW(TAG, "Cannot map crash file %s, keeping the log in memory", path);
+    return &g_crash_storage;
+  }
+  return static_cast<v4rtos::CrashLog::Storage*>(map);
+}
+
+// ==============================================================================
+// V4 VM Initialization
+// ==============================================================================
+
+/**
+ * @brief Run the active bytecode image on VM 0
+ *
+ * Same as on the ESP32-C6: the image runs straight from the mapping.
+ * Images without FLAG_AUTOSTART only stay stored.
+ *
+ * @return false if an image on trial failed and was rolled back
+ */
+static bool image_start(struct Vm* vm)
+{
+  const v4rtos::ImageStore::Header* h = g_image->active_header();
+  if (h == nullptr || (h->flags & v4rtos::ImageStore::FLAG_AUTOSTART) == 0)
+  {
+    return true;
+  }
+  uint8_t slot = g_image->active();
+  uint32_t rollbacks = g_image->rollbacks();
+  double start = now_seconds();
+  v4_err err = vm_exec_raw(vm, g_image->active_code(), (int)h->size);
+  if (err != 0)
+  {
+    POSIX_LOGE(TAG, "Bytecode image (slot %u) failed: %d", (unsigned)slot, err);
+    // A RESET_VM panic has rolled back in pool_panic_hook already
+    return g_image->rollbacks() == rollbacks && !g_image->fault();
+  }
+  POSIX_LOGI(TAG, "Bytecode image (slot %u) started in place (%.0f us)",
+             (unsigned)g_image->active(), (now_seconds() - start) * 1e6);
+  return true;
+}
+
+/**
+ * @brief Panic hook of the pool VMs
+ *
+ * A VM 0 panic while the image is on trial revokes it; the VM restart
+ * that follows runs the previous image.
+ */
+static void pool_panic_hook(void* context, int32_t error)
+{
+  if (g_image != nullptr && context == g_pool->fault_context(0) && g_image->fault())
+  {
+    POSIX_LOGW(TAG, "Bytecode image on trial panicked, rolled back to slot %u",
+               (unsigned)g_image->active());
+  }
+  v4rtos::VmPool::panic_hook(context, error);
+}
+
+/** Destroy a pool VM */
+static void pool_destroy_vm(void* user, void* vm)
+{
+  (void)user;  // Unused
+#ifdef V4_SCHED_PRIORITY
+  v4rtos::sched_sys_detach(static_cast<struct Vm*>(vm));
+#endif
+  vm_destroy(static_cast<struct Vm*>(vm));
+}
+
+/**
+ * @brief Create one pool VM in its arena slice
+ *
+ * Each pool VM gets its own scheduler and a panic handler that applies
+ * the panic policy to this VM only.
+ */
+static void* pool_create_vm(void* user, uint8_t id, uint8_t* mem, size_t size)
+{
+  (void)user;  // Unused
+  VmConfig config = {
+      .mem = mem,
+      .mem_size = (uint32_t)size,
+      .mmio = nullptr,
+      .mmio_count = 0,
+      // A single VM owns the name arena (emptied on every restart); pool
+      // VMs do not share it and malloc names
+      .arena = g_pool->count() == 1 ? v4rtos::vm_memory_reset_name_arena(&g_vm_memory)
+                                    : nullptr};
+  struct Vm* vm = vm_create(&config);
+  if (vm == nullptr)
+  {
+    POSIX_LOGE(TAG, "Failed to create VM %u", (unsigned)id);
+    return nullptr;
+  }
+  panic_handler_init_isolated(vm, id, pool_panic_hook, g_pool->fault_context(id));
+#ifdef V4_SCHED_PRIORITY
+  // Before the task system creates the first task
+  v4rtos::sched_sys_attach(vm, id);
+#endif
+  v4_err err = vm_task_init(vm, 10);
+  if (err != 0)
+  {
+    POSIX_LOGE(TAG, "Failed to initialize task system of VM %u: %d", (unsigned)id, err);
+    pool_destroy_vm(user, vm);
+    return nullptr;
+  }
+
+  // VM 0 runs the stored image; one that fails on trial was rolled back,
+  // so rebuild the VM around the previous image
+  if (id == 0 && g_image_live && !image_start(vm))
+  {
+    pool_destroy_vm(user, vm);
+    return pool_create_vm(user, id, mem, size);
+  }
+  return vm;
+}
+
+/**
+ * @brief Initialize V4 VM and task system
+ *
+ * Allocates the configured VM memory layout, attaches the crash log and
+ * creates a pool of @p opts.vms VM instances, each with a preemptive task
+ * scheduler (10ms time slice, or fixed priorities with per-priority slices
+ * in V4_SCHED_PRIORITY builds).
+ *
+ * @param opts Runtime options (VM count, panic policy, crash file)
+ * @return 0 on success, negative error code on failure
+ */
+static int v4_init(const RuntimeOptions& opts)
+{
+  // Allocate VM and name arenas
+  if (v4rtos::vm_memory_init(&g_vm_memory) != 0)
+  {
+    return -1;
+  }
+
+#ifdef V4_TRACE
+  // Like the profiler, before any scheduler so its first switch is recorded;
+  // host threads are not pinned, so one ring serves them all
+  g_trace = new v4rtos::TraceBuffer(trace_clock, TRACE_TICKS_PER_US, nullptr, 1,
+                                    V4_TRACE_RECORDS);
+  v4rtos::trace_install(g_trace);
+  POSIX_LOGI(TAG, "Event trace enabled (%u records, %u ticks/us)",
+             (unsigned)g_trace->ring(0).capacity(), (unsigned)TRACE_TICKS_PER_US);
+#endif
+
+#ifdef V4_PROFILE
+  // Start profiling before any scheduler so its first switch is counted
+  v4rtos::vm_profiler_install(&g_profiler);
+  POSIX_LOGI(TAG, "VM profiler enabled (PC sample every %u opcodes)",
+             (unsigned)V4_PROFILE_SAMPLE_PERIOD);
+#endif
+
+#ifdef V4_SCHED_PRIORITY
+  // Fixed priorities and per-priority slices instead of one 10ms slice
+  v4rtos::sched_sys_init(V4_SCHED_SLICES_MS);
+#endif
+
+  // Crash log from earlier runs when --crash-file is given
+  v4rtos::PanicPolicy policy = opts.panic_policy >= 0
+                                   ? (v4rtos::PanicPolicy)opts.panic_policy
+                                   : (opts.vms > 1 ? v4rtos::PanicPolicy::RESET_VM
+                                                   : v4rtos::PanicPolicy::HALT);
+  g_crash_log = new v4rtos::CrashLog(crash_storage(opts.crash_file), policy);
+  panic_handler_set_crash_log(g_crash_log);
+  POSIX_LOGI(TAG, "Crash log: boot %u, %u panic(s) recorded%s, policy %s",
+             (unsigned)g_crash_log->boots(), (unsigned)g_crash_log->panics(),
+             g_crash_log->restored() ? "" : " (new log)",
+             v4rtos::panic_policy_name(g_crash_log->policy()));
+
+  // Independent VMs, one per arena slice; a single VM is a pool of one so
+  // that it can be recreated after a panic
+  g_pool = new v4rtos::VmPool(g_vm_memory.vm_arena, g_vm_memory.vm_arena_size, opts.vms,
+                              pool_create_vm, pool_destroy_vm, nullptr);
+  if (g_pool->start() != g_pool->count())
+  {
+    POSIX_LOGE(TAG, "Failed to start VM pool");
+    return -1;
+  }
+  g_vm = static_cast<struct Vm*>(g_pool->vm(0));
+  if (g_pool->count() == 1)
+  {
+    POSIX_LOGI(TAG, "V4 VM created (arena: %u KB)",
+               (unsigned)(g_vm_memory.vm_arena_size / 1024));
+  }
+  else
+  {
+    POSIX_LOGI(TAG, "V4 VM pool created (%u VMs, %u KB each)", (unsigned)g_pool->count(),
+               (unsigned)(g_pool->slice_size() / 1024));
+  }
+  v4rtos::vm_memory_report(g_vm_memory);
+  POSIX_LOGI(TAG, "V4 task scheduler initialized (10ms time slice)");
+
+  return 0;
+}
+
+// ==============================================================================
+// V4-std Initialization
+// ==============================================================================
+
+/**
+ * @brief Initialize V4-std system
+ *
+ * Initializes:
+ * - DDT (Device Descriptor Table)
+ * - LED HAL
+ * - SYS call handlers
+ *
+ * @return 0 on success, negative error code on failure
+ */
+static int v4std_init(void)
+{
+  // Set DDT provider
+  v4std::Ddt::set_provider(&g_ddt_provider);
+  POSIX_LOGI(TAG, "DDT provider registered (%u devices)",
+             (unsigned)v4rtos::HostDdtProvider::count());
+
+  // Set LED HAL
+  v4std::set_led_hal(&g_led_hal);
+  POSIX_LOGI(TAG, "LED HAL registered");
+
+  // Register LED SYS handlers
+  v4std::register_led_sys_handlers();
+  POSIX_LOGI(TAG, "LED SYS handlers registered");
+
+  // GPIO port words on the LED HAL's virtual registers
+  v4rtos::gpio_sys_init(&g_led_hal.regs(), CONFIG_V4_GPIO_PORT_MASK);
+
+  POSIX_LOGI(TAG, "V4-std initialized");
+  return 0;
+}
+
+// ==============================================================================
+// Bytecode Image
+// ==============================================================================
+
+/** Millisecond clock of the image trial window */
+static uint32_t image_clock_ms(void)
+{
+  return (uint32_t)(now_seconds() * 1000.0);
+}
+
+/** Start a freshly activated image: VM 0 is rebuilt around it */
+static bool image_switch(void* user)
+{
+  (void)user;  // Unused
+  return g_pool->restart(0) && g_image->on_trial();
+}
+
+/**
+ * @brief Map the image file and run the active image
+ *
+ * Same as the ESP32-C6 autostart: an image left on trial by the last run
+ * is rolled back first.
+ *
+ * @param path Image file (--image-file)
+ */
+static void image_autostart(const char* path)
+{
+  if (!v4rtos::image_partition_open(&g_image_flash, path))
+  {
+    return;
+  }
+  g_image = new v4rtos::ImageStore(g_image_flash, image_clock_ms,
+                                   CONFIG_V4_IMAGE_TRIAL_S * 1000);
+  g_image->set_switch(image_switch, nullptr);
+  bool found = g_image->boot();
+  if (g_image->rollbacks() > 0)
+  {
+    POSIX_LOGW(TAG, "Bytecode image was not confirmed before exit, rolled back");
+  }
+  g_image_live = true;
+  if (!found)
+  {
+    POSIX_LOGI(TAG, "No bytecode image stored");
+    return;
+  }
+  const v4rtos::ImageStore::Header* h = g_image->active_header();
+  POSIX_LOGI(TAG, "Bytecode image: slot %u, %u bytes, CRC 0x%08X%s",
+             (unsigned)g_image->active(), (unsigned)h->size, (unsigned)h->crc,
+             g_image->on_trial() ? " (on trial)" : "");
+
+  if (!image_start(g_vm))
+  {
+    g_pool->restart(0);
+    g_vm = static_cast<struct Vm*>(g_pool->vm(0));
+  }
+}
+
+// ==============================================================================
+// V4-link Ports
+// ==============================================================================
+
+static void link_lock(void* user)
+{
+  static_cast<std::mutex*>(user)->lock();
+}
+
+static void link_unlock(void* user)
+{
+  static_cast<std::mutex*>(user)->unlock();
+}
+
+/**
+ * @brief Create a V4-link port on @p transport
+ *
+ * Every port answers the same runtime commands and routes core frames to
+ * the same VM pool; each keeps its own VM_SELECT channel and window.
+ */
+static v4rtos::PosixLinkPort* link_port_create(v4rtos::LinkTransport* transport)
+{
+  auto* port = new v4rtos::PosixLinkPort(g_vm, transport, 512);
+  port->attach_pool(g_pool);
+  port->add_runtime_command(v4rtos::link_wire::CMD_CRASH_LOG,
+                            v4rtos::CrashLog::handle_command, g_crash_log);
+  if (g_image != nullptr)
+  {
+    port->add_runtime_command(v4rtos::link_wire::CMD_IMAGE,
+                              v4rtos::ImageStore::handle_command, g_image);
+    port->add_caps(v4rtos::link_wire::CAP_IMAGE_LZ4);
+  }
+  // Let hosts keep several frames in flight (image uploads)
+  port->enable_window(CONFIG_V4_LINK_WINDOW_KB * 1024);
+#ifdef V4_PROFILE
+  port->add_runtime_command(v4rtos::link_wire::CMD_PROFILE,
+                            v4rtos::VmProfiler::handle_command, &g_profiler);
+#endif
+#ifdef V4_TRACE
+  port->add_runtime_command(v4rtos::link_wire::CMD_TRACE,
+                            v4rtos::TraceBuffer::handle_command, g_trace);
+#endif
+#ifdef V4_SCHED_PRIORITY
+  port->add_runtime_command(v4rtos::link_wire::CMD_SCHED,
+                            v4rtos::sched_sys_handle_command, nullptr);
+#endif
+#ifdef V4_PEEPHOLE
+  if (g_peephole != nullptr)
+  {
+    port->set_exec_filter(v4rtos::BytecodePeephole::filter, g_peephole);
+  }
+#endif
+  return port;
+}
+
+/**
+ * @brief Serve the TCP port until shutdown (second V4-link task)
+ *
+ * Wakes up every STOP_POLL_MS while idle to notice g_stop; signals are
+ * blocked on this thread so that they interrupt the main loop.
+ */
+static void tcp_link_thread(void)
+{
+  static constexpr uint32_t STOP_POLL_MS = 200;
+  while (!g_stop)
+  {
+    g_link_tcp->service(STOP_POLL_MS);
+  }
+}
+
+// ==============================================================================
+// Main Entry Point
+// ==============================================================================
+
+/**
+ * @brief Main entry point
+ *
+ * Initialization sequence (same order as app_main on ESP32-C6):
+ * 1. HAL initialization (V4-hal)
+ * 2. V4 VM creation and task system initialization
+ * 3. V4-std initialization, then the bytecode image (--image-file)
+ * 4. V4-link protocol initialization (pty or inherited fd, optional TCP)
+ * 5. Link loop: wait for data and drain it (or poll with --poll-us)
+ */
+int main(int argc, char** argv)
+{
+  RuntimeOptions opts;
+  if (!parse_options(argc, argv, &opts))
+  {
+    return 2;
+  }
+
+  signal(SIGINT, handle_signal);
+  signal(SIGTERM, handle_signal);
+  signal(SIGPIPE, SIG_IGN);
+
+  POSIX_LOGI(TAG, "=== V4 RTOS Runtime ===");
+  POSIX_LOGI(TAG, "Version: 1.0.0-dev");
+  POSIX_LOGI(TAG, "Board: %s", BOARD_NAME);
+
+  // Step 1: Initialize HAL
+  POSIX_LOGI(TAG, "[1/4] Initializing HAL...");
+  int hal_status = hal_init();
+  if (hal_status != 0)
+  {
+    POSIX_LOGE(TAG, "HAL initialization failed: %d", hal_status);
+    return 1;
+  }
+  POSIX_LOGI(TAG, "HAL initialized");
+
+  // Step 2: Initialize V4 VM and task system
+  POSIX_LOGI(TAG, "[2/4] Initializing V4 VM and task system...");
+  if (v4_init(opts) != 0)
+  {
+    POSIX_LOGE(TAG, "V4 initialization failed");
+    return 1;
+  }
+
+  // Step 3: Initialize V4-std
+  POSIX_LOGI(TAG, "[3/4] Initializing V4-std...");
+  if (v4std_init() != 0)
+  {
+    POSIX_LOGE(TAG, "V4-std initialization failed");
+    return 1;
+  }
+  // SYS words an autostarted image may call at top level
+  v4rtos::mem_stats_init(g_vm, &g_vm_memory);
+  v4rtos::mem_stats_track_pool(g_pool);
+  v4rtos::msg_sys_init(g_pool);
+  if (opts.image_file != nullptr)
+  {
+    image_autostart(opts.image_file);
+  }
+
+  // Step 4: Initialize V4-link protocol
+  POSIX_LOGI(TAG, "[4/4] Initializing V4-link protocol...");
+#ifdef V4_PEEPHOLE
+  // Fuse superinstructions into EXEC payloads before V4-link stores them
+  if (v4_peephole_isa() != nullptr)
+  {
+    g_peephole = new v4rtos::BytecodePeephole(*v4_peephole_isa(), 512);
+    POSIX_LOGI(TAG, "Peephole pass enabled (%u rules)",
+               (unsigned)v4_peephole_isa()->rule_count);
+  }
+#endif
+  int link_fd = opts.link_fd;
+  if (link_fd < 0)
+  {
+    char slave_name[64];
+    link_fd = v4rtos::PosixFdTransport::open_pty(slave_name, sizeof(slave_name));
+    if (link_fd < 0)
+    {
+      POSIX_LOGE(TAG, "V4-link initialization failed");
+      return 1;
+    }
+    POSIX_LOGI(TAG, "V4-link pty: %s", slave_name);
+    // Machine-readable line for harnesses driving the runtime
+    printf("V4LINK_PTY=%s\n", slave_name);
+    fflush(stdout);
+  }
+  g_link_fd = new v4rtos::PosixFdTransport(link_fd);
+  if (!g_link_fd->ok())
+  {
+    POSIX_LOGE(TAG, "V4-link initialization failed");
+    return 1;
+  }
+  g_link = link_port_create(g_link_fd);
+  v4rtos::mem_stats_attach_link(g_link);
+  if (g_image != nullptr)
+  {
+    // One port is enough to end the trial window on time
+    g_link->set_timer_hook(v4rtos::ImageStore::timer_hook, g_image);
+  }
+
+  std::thread tcp_thread;
+  if (opts.tcp_port >= 0)
+  {
+    g_tcp = new v4rtos::PosixTcpTransport((uint16_t)opts.tcp_port);
+    if (!g_tcp->ok())
+    {
+      POSIX_LOGE(TAG, "V4-link TCP transport failed");
+      return 1;
+    }
+    // Machine-readable line for harnesses driving the runtime
+    printf("V4LINK_TCP=%u\n", (unsigned)g_tcp->port());
+    fflush(stdout);
+    g_link_tcp = link_port_create(g_tcp);
+    g_link->set_frame_lock(link_lock, link_unlock, &g_link_lock);
+    g_link_tcp->set_frame_lock(link_lock, link_unlock, &g_link_lock);
+
+    // The thread inherits a mask with SIGINT/SIGTERM blocked
+    sigset_t stop_signals, old_mask;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stop_signals, &old_mask);
+    tcp_thread = std::thread(tcp_link_thread);
+    pthread_sigmask(SIG_SETMASK, &old_mask, nullptr);
+  }
+
+  // All systems ready
+  POSIX_LOGI(TAG, "=== V4 RTOS Runtime Ready ===");
+  POSIX_LOGI(TAG, "Waiting for bytecode via V4-link protocol...");
+
+  // Link loop: event-driven by default (mirrors the device link task),
+  // fixed-interval polling with --poll-us for comparison
+  double start = now_seconds();
+  long long iterations = 0;
+  while (!g_stop && !g_link->closed())
+  {
+    if (opts.poll_us < 0)
+    {
+      if (!g_link->service(v4rtos::LinkTransport::WAIT_FOREVER))
+      {
+        continue;
+      }
+    }
+    else
+    {
+      g_link->poll();
+      if (opts.poll_us > 0)
+      {
+        usleep((useconds_t)opts.poll_us);
+      }
+    }
+    iterations++;
+    if (opts.iterations > 0 && iterations >= opts.iterations)
+    {
+      break;
+    }
+  }
+  double elapsed = now_seconds() - start;
+
+  // Stop the TCP port before anything it uses goes away
+  g_stop = 1;
+  if (tcp_thread.joinable())
+  {
+    tcp_thread.join();
+  }
+
+  // Soak-test summary
+  POSIX_LOGI(TAG, "Loop: %lld wakeups in %.3f s (%.0f /s)", iterations, elapsed,
+             elapsed > 0 ? (double)iterations / elapsed : 0.0);
+  POSIX_LOGI(TAG, "Link: %llu bytes received (%.0f B/s)",
+             (unsigned long long)g_link->bytes_received(),
+             elapsed > 0 ? (double)g_link->bytes_received() / elapsed : 0.0);
+  const v4rtos::TxRing::Stats& tx = g_link->tx_stats();
+  POSIX_LOGI(TAG, "TX: %llu queued, %llu flushed, %llu dropped (%llu responses)",
+             (unsigned long long)tx.queued_bytes, (unsigned long long)tx.flushed_bytes,
+             (unsigned long long)tx.dropped_bytes, (unsigned long long)tx.dropped_writes);
+  if (g_link_tcp != nullptr)
+  {
+    POSIX_LOGI(TAG, "TCP: %u hosts, %llu bytes received, %llu flushed, %llu dropped",
+               (unsigned)g_tcp->connections(),
+               (unsigned long long)g_link_tcp->bytes_received(),
+               (unsigned long long)g_link_tcp->tx_stats().flushed_bytes,
+               (unsigned long long)g_link_tcp->tx_stats().dropped_bytes);
+  }
+  POSIX_LOGI(TAG, "LED: %llu toggles", (unsigned long long)g_led_hal.toggle_count());
+  v4rtos::mem_stats_report();
+  v4rtos::msg_sys_report();
+  v4rtos::gpio_sys_report();
+#ifdef V4_SCHED_PRIORITY
+  v4rtos::sched_sys_report();
+#endif
+  for (size_t id = 0; id < g_pool->count(); id++)
+  {
+    const v4rtos::VmPool::Info& info = g_pool->info((uint8_t)id);
+    POSIX_LOGI(TAG, "VM %u: %u faults, %u restarts (last error %d)", (unsigned)id,
+               (unsigned)info.faults, (unsigned)info.restarts, (int)info.last_error);
+  }
+#ifdef V4_TRACE
+  POSIX_LOGI(TAG, "Trace: %u records pending, %u dropped",
+             (unsigned)g_trace->ring(0).pending(), (unsigned)g_trace->dropped());
+#endif
+#ifdef V4_PROFILE
+  for (size_t id = 0; id < v4rtos::VmProfiler::MAX_TASKS; id++)
+  {
+    const v4rtos::VmProfiler::TaskStats& t = g_profiler.task(id);
+    if (t.switches > 0)
+    {
+      POSIX_LOGI(TAG, "Task %u: %u us, %u switches, %u preemptions", (unsigned)id,
+                 (unsigned)t.run_us, (unsigned)t.switches, (unsigned)t.preemptions);
+    }
+  }
+#endif
+
+#ifdef V4_PEEPHOLE
+  if (g_peephole != nullptr)
+  {
+    const v4rtos::BytecodePeephole::Stats& pp = g_peephole->stats();
+    POSIX_LOGI(TAG, "Peephole: %llu payloads, %llu fused, %llu bytes saved, %llu "
+               "rejected",
+               (unsigned long long)pp.runs, (unsigned long long)pp.fused,
+               (unsigned long long)pp.bytes_saved, (unsigned long long)pp.rejected);
+  }
+#endif
+
+  delete g_link_tcp;
+  delete g_tcp;
+  delete g_link;
+  delete g_link_fd;
+#ifdef V4_PEEPHOLE
+  delete g_peephole;
+#endif
+  delete g_pool;  // Destroys every pool VM, including g_vm
+  delete g_crash_log;
+  delete g_image;
+#ifdef V4_TRACE
+  v4rtos::trace_install(nullptr);
+  delete g_trace;
+#endif
+  return 0;
+}
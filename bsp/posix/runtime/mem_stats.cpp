@@ -0,0 +1,161 @@
+// Memory high-water marks for the POSIX runtime
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#include "mem_stats.hpp"
+
+#include "link_runtime_commands.hpp"
+#include "posix_link_port.hpp"
+#include "posix_log.h"
+#include "sys_table.hpp"
+#include "v4/vm_api.h"
+#include "v4std/sys_handlers.hpp"
+#include "vm_memory.hpp"
+#include "vm_pool.hpp"
+
+static const char* TAG = "MemStats";
+
+namespace v4rtos
+{
+
+static Vm* s_vm = nullptr;
+static const VmMemoryLayout* s_layout = nullptr;
+static PosixLinkPort* s_link = nullptr;
+static MemWatermarks s_marks;
+static const VmPool* s_pool = nullptr;
+
+// Data stack depth is only observable between frames
+static void sample_data_stack(void* user)
+{
+  (void)user;  // Unused
+  if (s_pool == nullptr)
+  {
+    if (s_vm != nullptr)
+    {
+      s_marks.update(MemRegion::DATA_STACK, (size_t)vm_ds_depth_public(s_vm),
+                     V4_DS_CAPACITY);
+    }
+    return;
+  }
+  // Pool VMs come and go on restart; only sample the running ones
+  for (size_t i = 0; i < s_pool->count(); i++)
+  {
+    Vm* vm = static_cast<Vm*>(s_pool->vm(static_cast<uint8_t>(i)));
+    if (vm != nullptr)
+    {
+      s_marks.update(MemRegion::DATA_STACK, (size_t)vm_ds_depth_public(vm),
+                     V4_DS_CAPACITY);
+    }
+  }
+}
+
+const MemWatermarks& mem_stats_sample(void)
+{
+  if (s_pool != nullptr)
+  {
+    // Report the fullest slice against one slice's capacity
+    for (size_t i = 0; i < s_pool->count(); i++)
+    {
+      s_marks.update(MemRegion::VM_ARENA,
+                     mem_painted_high_water(s_pool->slice(static_cast<uint8_t>(i)),
+                                            s_pool->slice_size()),
+                     s_pool->slice_size());
+    }
+  }
+  else if (s_layout != nullptr)
+  {
+    s_marks.update(MemRegion::VM_ARENA,
+                   mem_painted_high_water(s_layout->vm_arena, s_layout->vm_arena_size),
+                   s_layout->vm_arena_size);
+  }
+  if (s_layout != nullptr && s_layout->name_buf != nullptr)
+  {
+    s_marks.update(MemRegion::NAME_ARENA,
+                   mem_painted_high_water(s_layout->name_buf, s_layout->name_buf_size),
+                   s_layout->name_buf_size);
+  }
+
+  sample_data_stack(nullptr);
+
+  if (s_link != nullptr)
+  {
+    const LinkFrameScanner::Stats& rx = s_link->scanner_stats();
+    s_marks.update(MemRegion::LINK_RX_CHUNK, s_link->rx_high_water(),
+                   PosixLinkPort::rx_chunk_size());
+    s_marks.update(MemRegion::LINK_PAYLOAD, rx.payload_high_water,
+                   s_link->buffer_capacity());
+    s_marks.update(MemRegion::LINK_STAGE, rx.stage_high_water,
+                   s_link->buffer_capacity() + link_wire::OVERHEAD);
+    s_marks.update(MemRegion::LINK_TX_RING, s_link->tx_stats().high_water,
+                   s_link->tx_capacity());
+  }
+
+  return s_marks;
+}
+
+// CMD_MEM_STATS: no request payload, one record per tracked region
+static void handle_mem_stats(void* user, const LinkFrameView& frame, LinkReply* reply)
+{
+  (void)user;   // Unused
+  (void)frame;  // Unused
+  mem_stats_sample().encode(reply);
+}
+
+// MEM-WATERMARK ( region -- used capacity )
+v4_err sys_mem_watermark(Vm* vm)
+{
+  v4_i32 region = vm_ds_pop(vm);
+  MemWatermarks::Entry entry = {0, 0};
+  if (region >= 0 && region < (v4_i32)MemRegion::COUNT)
+  {
+    entry = mem_stats_sample().get((MemRegion)region);
+  }
+  vm_ds_push(vm, (v4_i32)entry.used);
+  vm_ds_push(vm, (v4_i32)entry.capacity);
+  return 0;
+}
+
+void mem_stats_init(Vm* vm, const VmMemoryLayout* layout)
+{
+  s_vm = vm;
+  s_layout = layout;
+#ifndef V4_SYS_TABLE
+  // V4_SYS_TABLE builds find it in the constant table (sys_table.hpp)
+  v4std::register_sys_handler(SYS_MEM_WATERMARK, sys_mem_watermark);
+#endif
+}
+
+void mem_stats_attach_link(PosixLinkPort* link)
+{
+  s_link = link;
+
+  link->set_frame_hook(sample_data_stack, nullptr);
+  link->add_runtime_command(link_wire::CMD_MEM_STATS, handle_mem_stats, nullptr);
+
+  POSIX_LOGI(TAG, "Memory watermarks enabled (link cmd 0x%02X, SYS %u)",
+             link_wire::CMD_MEM_STATS, (unsigned)SYS_MEM_WATERMARK);
+}
+
+void mem_stats_track_pool(const VmPool* pool)
+{
+  s_pool = pool;
+}
+
+void mem_stats_report(void)
+{
+  const MemWatermarks& marks = mem_stats_sample();
+  POSIX_LOGI(TAG, "Memory high-water marks:");
+  for (size_t i = 0; i < (size_t)MemRegion::COUNT; i++)
+  {
+    const MemWatermarks::Entry& e = marks.get((MemRegion)i);
+    if (e.capacity == 0)
+    {
+      continue;
+    }
+    POSIX_LOGI(TAG, "  %-16s %7u / %7u (%u%%)", mem_region_name((MemRegion)i),
+               (unsigned)e.used, (unsigned)e.capacity,
+               (unsigned)((uint64_t)e.used * 100 / e.capacity));
+  }
+}
+
+}  // namespace v4rtos
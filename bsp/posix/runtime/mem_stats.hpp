@@ -0,0 +1,62 @@
+// Memory high-water marks for the POSIX runtime
+//
+// Collects watermarks for the VM arenas, the VM data stack and the V4-link
+// buffers, and serves them over V4-link (CMD_MEM_STATS) and to Forth code
+// (SYS_MEM_WATERMARK). Host threads have no measurable stack watermark,
+// so the task stack regions are not reported.
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include "mem_watermark.hpp"
+
+extern "C"
+{
+  typedef struct Vm Vm;
+}
+
+namespace v4rtos
+{
+
+class PosixLinkPort;
+class VmPool;
+struct VmMemoryLayout;
+
+/**
+ * @brief Start tracking and register the SYS handler
+ *
+ * Call before any bytecode runs (image autostart included), so that
+ * MEM-WATERMARK is available to it.
+ *
+ * @param vm VM whose data stack depth is sampled after each frame
+ * @param layout Painted arenas (vm_memory_init())
+ */
+void mem_stats_init(Vm* vm, const VmMemoryLayout* layout);
+
+/**
+ * @brief Track a link port's buffers and register the link command
+ *
+ * @param link Link port
+ */
+void mem_stats_attach_link(PosixLinkPort* link);
+
+/**
+ * @brief Sample the VMs of a pool instead of the single VM
+ *
+ * DATA_STACK then covers every running pool VM and VM_ARENA reports the
+ * fullest slice against the slice size.
+ */
+void mem_stats_track_pool(const VmPool* pool);
+
+/**
+ * @brief Sample all regions and return the high-water marks
+ */
+const MemWatermarks& mem_stats_sample(void);
+
+/**
+ * @brief Log all high-water marks
+ */
+void mem_stats_report(void);
+
+}  // namespace v4rtos
@@ -0,0 +1,33 @@
+// Pooled message words for the POSIX runtime
+//
+// Gives every pool VM a MsgPool and registers the MSG-* SYS handlers
+// (SYS_MSG_POOL .. SYS_MSG_FREE). V4 tasks share the VM's thread, so the
+// words never block: a full queue or an empty pool fails with ERR_TIMEOUT.
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include "msg_pool.hpp"
+
+namespace v4rtos
+{
+
+class VmPool;
+
+/**
+ * @brief Create one MsgPool per VM and register the SYS handlers
+ *
+ * The pools stay empty until Forth code hands them memory with MSG-POOL;
+ * a restarted VM has to do so again.
+ *
+ * @param pool VM pool
+ */
+void msg_sys_init(const VmPool* pool);
+
+/**
+ * @brief Log message counters of every VM that set up a pool
+ */
+void msg_sys_report(void);
+
+}  // namespace v4rtos
@@ -0,0 +1,223 @@
+/**
+ * @file panic_handler.cpp
+ * @brief V4 VM panic handler implementation for the POSIX runtime
+ *
+ * SPDX-License-Identifier: MIT OR Apache-2.0
+ */
+
+#include "panic_handler.hpp"
+
+#include <stdlib.h>
+#include <time.h>
+
+#include <cinttypes>
+
+// V4 VM API
+#include "crash_log.hpp"
+#include "mem_watermark.hpp"  // VM stack capacities
+#include "posix_log.h"
+#include "trace_buffer.hpp"
+#include "v4/panic.h"  // For PanicInfo struct and vm_set_panic_handler
+#include "v4/vm_api.h"
+#include "vm_pool.hpp"
+
+#ifdef V4_TASK_RESTART
+// Provided by V4-engine built with V4_TASK_RESTART: restart @p task_id from
+// its entry word with empty stacks once the panic handler returns
+extern "C" v4_err vm_task_restart(struct Vm* vm, uint8_t task_id);
+#endif
+
+using v4rtos::CrashLog;
+using v4rtos::PanicPolicy;
+
+static const char* TAG = "v4-panic";
+
+/** Pool VM registered with panic_handler_init_isolated() */
+struct IsolatedVm
+{
+  struct Vm* vm;                               ///< VM instance
+  uint8_t id;                                  ///< Pool index
+  void (*on_fault)(void* user, int32_t code);  ///< Marks the VM faulted
+  void* user;                                  ///< @p on_fault context
+};
+
+static IsolatedVm s_isolated[v4rtos::VmPool::MAX_VMS];
+
+/** Crash log and policy (panic_handler_set_crash_log()) */
+static CrashLog* s_crash_log = nullptr;
+
+/** Process start, for crash log uptimes */
+static struct timespec s_start;
+
+static uint32_t uptime_ms(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint32_t)((now.tv_sec - s_start.tv_sec) * 1000 +
+                    (now.tv_nsec - s_start.tv_nsec) / 1000000);
+}
+
+/** Mark the panic in the event trace, ahead of the slow log output */
+static void trace_panic(const IsolatedVm* iso, const V4PanicInfo* info)
+{
+  v4rtos::trace_event(v4rtos::TRACE_PANIC,
+                      info != nullptr ? info->task_id : V4_TRACE_NO_TASK,
+                      iso != nullptr ? iso->id : CrashLog::NO_VM,
+                      info != nullptr ? (uint32_t)info->error_code : 0);
+}
+
+/**
+ * @brief Pick the configured policy where it can work
+ *
+ * RESTART_TASK needs V4-engine with V4_TASK_RESTART (the restart is
+ * requested here) and RESET_VM a pool VM to recreate; otherwise the next
+ * weaker recovery is used.
+ */
+static PanicPolicy choose_action(const IsolatedVm* iso, const V4PanicInfo* info)
+{
+  PanicPolicy action =
+      s_crash_log != nullptr ? s_crash_log->policy() : PanicPolicy::HALT;
+#ifdef V4_TASK_RESTART
+  if (action == PanicPolicy::RESTART_TASK &&
+      (iso == nullptr || info == nullptr ||
+       vm_task_restart(iso->vm, info->task_id) != 0))
+  {
+    action = PanicPolicy::RESET_VM;
+  }
+#else
+  (void)info;  // Unused
+  if (action == PanicPolicy::RESTART_TASK)
+  {
+    action = PanicPolicy::RESET_VM;
+  }
+#endif
+  if (action == PanicPolicy::RESET_VM && iso == nullptr)
+  {
+    action = PanicPolicy::HALT;
+  }
+  return action;
+}
+
+/** Store the panic in the crash log before acting on it */
+static void record_panic(const IsolatedVm* iso, const V4PanicInfo* info,
+                         PanicPolicy action)
+{
+  if (s_crash_log == nullptr)
+  {
+    return;
+  }
+  CrashLog::Entry e = {};
+  e.uptime_ms = uptime_ms();
+  e.vm_id = iso != nullptr ? iso->id : CrashLog::NO_VM;
+  e.action = (uint8_t)action;
+  if (info != nullptr)
+  {
+    e.error = info->error_code;
+    e.pc = info->pc;
+    e.task_id = info->task_id;
+    e.ds_depth = (int16_t)info->ds_depth;
+    e.rs_depth = (int16_t)info->rs_depth;
+    if (info->has_stack_data && info->ds_depth > 0)
+    {
+      e.stack_count = (uint8_t)(info->ds_depth < (int)CrashLog::STACK_CELLS
+                                    ? info->ds_depth
+                                    : (int)CrashLog::STACK_CELLS);
+      for (size_t i = 0; i < e.stack_count; i++)
+      {
+        e.stack[i] = info->stack[i];
+      }
+    }
+  }
+  s_crash_log->record(e);
+}
+
+/**
+ * @brief Panic handler callback
+ *
+ * Called by VM when a fatal error occurs.
+ * Logs error details, stores them in the crash log and applies the panic
+ * policy. HALT and REBOOT terminate the process (a supervisor restarts
+ * it); RESET_VM and RESTART_TASK return so only the VM or task stops.
+ */
+static void handle_panic(void* user_data, const V4PanicInfo* info)
+{
+  IsolatedVm* iso = static_cast<IsolatedVm*>(user_data);
+  trace_panic(iso, info);
+  if (!info)
+  {
+    POSIX_LOGE(TAG, "!!! VM PANIC (NULL panic info) !!!");
+  }
+  else
+  {
+    POSIX_LOGE(TAG, "!!! V4 VM PANIC - FATAL ERROR !!!");
+    POSIX_LOGE(TAG, "Error Code:    %" PRId32, info->error_code);
+    POSIX_LOGE(TAG, "PC:            0x%08X", (unsigned int)info->pc);
+    POSIX_LOGE(TAG, "Task:          %u", (unsigned)info->task_id);
+    POSIX_LOGE(TAG, "Stack Depth:   %d / %u", info->ds_depth,
+               (unsigned)v4rtos::V4_DS_CAPACITY);
+    POSIX_LOGE(TAG, "Return Depth:  %d / %u", info->rs_depth,
+               (unsigned)v4rtos::V4_RS_CAPACITY);
+
+    if (info->has_stack_data && info->ds_depth > 0)
+    {
+      int count = info->ds_depth < 4 ? info->ds_depth : 4;
+      for (int i = 0; i < count; i++)
+      {
+        POSIX_LOGE(TAG, "  [%d]: 0x%08X (%d)", i, (unsigned int)info->stack[i],
+                   (int)info->stack[i]);
+      }
+    }
+  }
+
+  PanicPolicy action = choose_action(iso, info);
+  record_panic(iso, info, action);
+  POSIX_LOGE(TAG, "Panic policy: %s", v4rtos::panic_policy_name(action));
+
+  switch (action)
+  {
+    case PanicPolicy::RESET_VM:
+      // Stop only this VM; it is recreated before its next frame
+      iso->on_fault(iso->user, info != nullptr ? info->error_code : 0);
+      return;
+    case PanicPolicy::RESTART_TASK:
+      // V4-engine restarts the task; the VM and its other tasks keep running
+      return;
+    case PanicPolicy::HALT:
+    case PanicPolicy::REBOOT:
+      break;
+  }
+  exit(V4_PANIC_EXIT_STATUS);
+}
+
+extern "C" void panic_handler_init(struct Vm* vm)
+{
+  if (!vm)
+  {
+    POSIX_LOGE(TAG, "Cannot initialize panic handler: NULL VM");
+    return;
+  }
+
+  if (s_start.tv_sec == 0 && s_start.tv_nsec == 0)
+  {
+    clock_gettime(CLOCK_MONOTONIC, &s_start);
+  }
+  vm_set_panic_handler(vm, handle_panic, nullptr);
+  POSIX_LOGI(TAG, "Panic handler registered");
+}
+
+extern "C" void panic_handler_init_isolated(struct Vm* vm, uint8_t id,
+                                            void (*on_fault)(void* user, int32_t code),
+                                            void* user)
+{
+  panic_handler_init(vm);
+  if (vm != nullptr && id < v4rtos::VmPool::MAX_VMS)
+  {
+    s_isolated[id] = IsolatedVm{vm, id, on_fault, user};
+    vm_set_panic_handler(vm, handle_panic, &s_isolated[id]);
+  }
+}
+
+void panic_handler_set_crash_log(CrashLog* log)
+{
+  s_crash_log = log;
+}
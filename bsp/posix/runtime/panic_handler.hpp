@@ -0,0 +1,71 @@
+/**
+ * @file panic_handler.hpp
+ * @brief V4 VM panic handler for the POSIX runtime
+ *
+ * Provides panic handler integration for V4 VM:
+ * - Logs panic information via POSIX_LOGE
+ * - Terminates the process with a distinct exit status
+ *
+ * SPDX-License-Identifier: MIT OR Apache-2.0
+ */
+
+#pragma once
+
+/** Exit status used when the VM panics (EX_SOFTWARE) */
+#define V4_PANIC_EXIT_STATUS 70
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  /**
+   * @brief Initialize V4 panic handler for the POSIX runtime
+   *
+   * Registers a panic handler that logs the panic information, stores
+   * it in the crash log if one is set, and exits with
+   * V4_PANIC_EXIT_STATUS, so soak tests fail loudly where the device
+   * would halt.
+   *
+   * Must be called after vm_create() and before any VM execution.
+   *
+   * @param vm VM instance
+   */
+  void panic_handler_init(struct Vm* vm);
+
+  /**
+   * @brief Initialize the panic handler for one VM of a VM pool
+   *
+   * Same report as panic_handler_init(), plus the crash log and panic
+   * policy (panic_handler_set_crash_log()). With RESET_VM the handler
+   * calls @p on_fault and returns instead of exiting, so only this
+   * VM stops (see VmPool::panic_hook()).
+   *
+   * @param vm VM instance
+   * @param id Pool index (recorded in the crash log)
+   * @param on_fault Called with @p user and the V4 error code
+   * @param user Identifies the VM to @p on_fault
+   */
+  void panic_handler_init_isolated(struct Vm* vm, uint8_t id,
+                                   void (*on_fault)(void* user, int32_t code),
+                                   void* user);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#ifdef __cplusplus
+namespace v4rtos
+{
+class CrashLog;
+}
+
+/**
+ * @brief Record every panic in @p log and apply its panic policy
+ *
+ * Without a crash log every panic exits the process.
+ */
+void panic_handler_set_crash_log(v4rtos::CrashLog* log);
+#endif
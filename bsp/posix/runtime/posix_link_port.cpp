@@ -0,0 +1,317 @@
+// V4-link port implementation for POSIX hosts
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#include "posix_link_port.hpp"
+
+#include "posix_log.h"
+#include "trace_buffer.hpp"
+#include "v4/vm_api.h"
+#include "v4link/link.hpp"
+
+static const char* TAG = "V4Link";
+
+namespace v4rtos
+{
+
+// Trace an outgoing frame: [STX][LEN_L][LEN_H][status]...
+static void trace_tx(const uint8_t* data, size_t len)
+{
+  trace_event(TRACE_LINK_TX, V4_TRACE_NO_TASK, len > 3 ? data[3] : 0, (uint32_t)len);
+}
+
+// Static write callback for V4-link: queue the response, never block
+static void link_write_callback(void* user, const uint8_t* data, size_t len)
+{
+  trace_tx(data, len);
+  static_cast<TxRing*>(user)->write(data, len);
+}
+
+PosixLinkPort::PosixLinkPort(Vm* vm, LinkTransport* transport, size_t buffer_size)
+    : transport_(transport),
+      link_(nullptr),
+      scanner_(buffer_size, on_frame, this),
+      tx_(TX_RING_SIZE, LinkTransport::tx_sink, transport, TX_MAX_WAIT_MS),
+      runtime_cmds_(buffer_size),
+      buffer_size_(buffer_size)
+{
+  POSIX_LOGI(TAG, "Initializing V4-link on %s (buffer: %zu bytes)", transport->name(),
+             buffer_size);
+
+  // Create V4-link instance with write callback
+  link_ = std::make_unique<v4::link::Link>(vm, link_write_callback, &tx_, buffer_size);
+
+  POSIX_LOGI(TAG, "V4-link initialized");
+}
+
+PosixLinkPort::~PosixLinkPort()
+{
+  // Last chance for queued responses, bounded like any other write
+  tx_.flush(TX_MAX_WAIT_MS);
+}
+
+bool PosixLinkPort::receive(uint32_t timeout_ms)
+{
+  uint8_t buffer[RX_CHUNK];
+  int len = transport_->read(buffer, sizeof(buffer), timeout_ms);
+  if (len > 0)
+  {
+    rx_bytes_ += (uint64_t)len;
+    feed(buffer, (size_t)len);
+    return true;
+  }
+  if (len < 0)
+  {
+    POSIX_LOGI(TAG, "Link closed by peer");
+    closed_ = true;
+  }
+  return false;
+}
+
+void PosixLinkPort::poll()
+{
+  if (!link_ || closed_)
+  {
+    return;
+  }
+
+  if (timer_hook_ != nullptr)
+  {
+    lock();
+    timer_hook_(timer_hook_user_);
+    unlock();
+  }
+
+  // Read available data from the transport (non-blocking)
+  receive(0);
+
+  // One coalesced flush per poll
+  flush_tx();
+}
+
+bool PosixLinkPort::service(uint32_t timeout_ms)
+{
+  if (!link_ || closed_)
+  {
+    return false;
+  }
+
+  // While responses are still queued, wake up periodically to retry them
+  if (tx_.pending() > 0 && timeout_ms > TX_RETRY_MS)
+  {
+    timeout_ms = TX_RETRY_MS;
+  }
+  if (timer_hook_ != nullptr)
+  {
+    lock();
+    uint32_t due_ms = timer_hook_(timer_hook_user_);
+    unlock();
+    if (due_ms < timeout_ms)
+    {
+      timeout_ms = due_ms;
+    }
+  }
+
+  // Sleep until the first chunk, then drain everything buffered behind it
+  bool received = receive(timeout_ms);
+  if (received)
+  {
+    while (receive(0))
+    {
+    }
+  }
+
+  // Responses produced by this batch go out in one flush
+  flush_tx();
+  return received || closed_;
+}
+
+void PosixLinkPort::feed(const uint8_t* data, size_t len)
+{
+  if (!link_)
+  {
+    return;
+  }
+
+  if (len > rx_high_water_)
+  {
+    rx_high_water_ = len;
+  }
+  scanner_.feed(data, len);
+}
+
+void PosixLinkPort::flush_tx()
+{
+  tx_.flush(0);
+}
+
+void PosixLinkPort::lock()
+{
+  if (lock_ != nullptr)
+  {
+    lock_(lock_user_);
+  }
+}
+
+void PosixLinkPort::unlock()
+{
+  if (unlock_ != nullptr)
+  {
+    unlock_(lock_user_);
+  }
+}
+
+void PosixLinkPort::on_frame(void* user, const LinkFrameView& frame)
+{
+  auto* self = static_cast<PosixLinkPort*>(user);
+  self->lock();
+  self->handle_frame(frame);
+  self->unlock();
+}
+
+void PosixLinkPort::handle_frame(const LinkFrameView& frame)
+{
+  // Trace drains stay out of the trace they read
+  bool traced = frame.cmd != link_wire::CMD_TRACE;
+  if (traced)
+  {
+    trace_event(TRACE_LINK_RX, V4_TRACE_NO_TASK, frame.cmd, (uint32_t)frame.len);
+  }
+
+  // Runtime commands are answered here, straight into the TX ring
+  if (link_wire::is_runtime_cmd(frame.cmd))
+  {
+    size_t len = 0;
+    const uint8_t* resp = runtime_cmds_.handle(frame, &len);
+    if (traced)
+    {
+      trace_tx(resp, len);
+    }
+    tx_.write(resp, len);
+    return;
+  }
+
+  // Core commands: V4-link only exposes byte-wise input, so replay the
+  // already delimited frame (including bad-CRC frames, which it NAKs).
+  // EXEC payloads go through the exec filter (peephole pass) first
+  v4::link::Link* link = route();
+  if (link == nullptr)
+  {
+    uint8_t nak[link_wire::OVERHEAD];
+    size_t len = link_wire::encode_frame(link_wire::STATUS_ERROR, nullptr, 0, nak);
+    trace_tx(nak, len);
+    tx_.write(nak, len);
+    return;
+  }
+  size_t raw_len = 0;
+  const uint8_t* raw = runtime_cmds_.filter_exec(frame, &raw_len);
+  for (size_t i = 0; i < raw_len; ++i)
+  {
+    link->feed_byte(raw[i]);
+  }
+
+  if (frame_hook_ != nullptr)
+  {
+    frame_hook_(frame_hook_user_);
+  }
+}
+
+void PosixLinkPort::attach_pool(VmPool* pool)
+{
+  pool_ = pool;
+  channel_ = 0;
+  runtime_cmds_.add(link_wire::CMD_VM_SELECT, handle_select, this);
+  runtime_cmds_.add(link_wire::CMD_VM_CTRL, VmPool::handle_command, pool);
+  POSIX_LOGI(TAG, "VM pool attached (%u VMs, link cmds 0x%02X/0x%02X)",
+           (unsigned)pool->count(), link_wire::CMD_VM_SELECT, link_wire::CMD_VM_CTRL);
+}
+
+bool PosixLinkPort::enable_window(size_t budget)
+{
+  if (window_)
+  {
+    return false;
+  }
+  window_ = std::make_unique<LinkWindow>(&runtime_cmds_, buffer_size_, budget);
+  if (window_->capacity() == 0)
+  {
+    window_.reset();
+    return false;
+  }
+  runtime_cmds_.add(link_wire::CMD_WINDOW, LinkWindow::handle_command, window_.get());
+  runtime_cmds_.add_caps(link_wire::CAP_LINK_WINDOW);
+  POSIX_LOGI(TAG, "Windowed transfers enabled (%u frames, link cmd 0x%02X)",
+             (unsigned)window_->capacity(), link_wire::CMD_WINDOW);
+  return true;
+}
+
+// CMD_VM_SELECT: [id u8] -> [id u8][state u8]
+void PosixLinkPort::handle_select(void* user, const LinkFrameView& frame,
+                                  LinkReply* reply)
+{
+  auto* self = static_cast<PosixLinkPort*>(user);
+  if (self->pool_ == nullptr || frame.len < 1 || frame.payload[0] >= self->pool_->count())
+  {
+    reply->status = link_wire::STATUS_ERROR;
+    return;
+  }
+  self->channel_ = frame.payload[0];
+  reply->put_u8(self->channel_);
+  reply->put_u8(static_cast<uint8_t>(self->pool_->info(self->channel_).state));
+}
+
+v4::link::Link* PosixLinkPort::route()
+{
+  if (pool_ == nullptr)
+  {
+    return link_.get();
+  }
+
+  // A faulted VM gets a fresh instance before it sees more code
+  const VmPool::Info& info = pool_->info(channel_);
+  if (info.state == VmPool::State::FAULTED)
+  {
+    POSIX_LOGW(TAG, "VM %u faulted (error %d), restarting", (unsigned)channel_,
+             (int)info.last_error);
+    pool_->restart(channel_);
+  }
+  Vm* vm = static_cast<Vm*>(pool_->vm(channel_));
+  if (vm == nullptr)
+  {
+    return nullptr;
+  }
+
+  // Rebind when the VM behind the channel was recreated
+  Channel& ch = channels_[channel_];
+  if (!ch.link || ch.generation != info.generation)
+  {
+    ch.link = std::make_unique<v4::link::Link>(vm, link_write_callback, &tx_,
+                                               buffer_size_);
+    ch.generation = info.generation;
+  }
+  return ch.link.get();
+}
+
+void PosixLinkPort::reset()
+{
+  for (Channel& ch : channels_)
+  {
+    if (ch.link)
+    {
+      ch.link->reset();
+    }
+  }
+  if (link_)
+  {
+    link_->reset();
+    scanner_.reset();
+    POSIX_LOGI(TAG, "V4-link reset");
+  }
+}
+
+size_t PosixLinkPort::buffer_capacity() const
+{
+  return link_ ? link_->buffer_capacity() : 0;
+}
+
+}  // namespace v4rtos
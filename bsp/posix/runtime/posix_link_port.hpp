@@ -0,0 +1,340 @@
+// V4-link port for POSIX hosts
+//
+// Runs the device link loop over a LinkTransport (pty, socketpair, pipe,
+// TCP) so the full runtime loop can run on Linux
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "link_frame_scanner.hpp"
+#include "link_runtime_commands.hpp"
+#include "link_transport.hpp"
+#include "link_window.hpp"
+#include "tx_ring.hpp"
+#include "vm_pool.hpp"
+
+#ifndef CONFIG_V4_LINK_WINDOW_KB
+#define CONFIG_V4_LINK_WINDOW_KB 4  ///< Reorder buffer for windowed transfers (KB)
+#endif
+
+// Forward declarations
+extern "C"
+{
+  typedef struct Vm Vm;
+}
+
+namespace v4
+{
+namespace link
+{
+class Link;
+}
+}  // namespace v4
+
+namespace v4rtos
+{
+
+/**
+ * @brief V4-link port for POSIX hosts
+ *
+ * Wraps V4-link protocol implementation on top of a LinkTransport.
+ * Responses are queued in a TxRing and flushed once per receive batch,
+ * so a peer that stops reading cannot stall bytecode ingestion.
+ *
+ * Several ports, one per transport and thread, may serve the same VMs;
+ * they must then share a frame lock (set_frame_lock()).
+ */
+class PosixLinkPort
+{
+ public:
+  /**
+   * @brief Construct V4-link port
+   * @param vm V4 VM instance
+   * @param transport Byte transport (not owned; must outlive the port)
+   * @param buffer_size V4-link receive buffer size (default: 512 bytes)
+   */
+  PosixLinkPort(Vm* vm, LinkTransport* transport, size_t buffer_size = 512);
+
+  /**
+   * @brief Destructor
+   */
+  ~PosixLinkPort();
+
+  /**
+   * @brief Poll for incoming data (non-blocking)
+   *
+   * Reads from the transport and feeds the chunk to feed().
+   * Should be called regularly from main loop.
+   */
+  void poll();
+
+  /**
+   * @brief Wait for data, then feed everything the transport has buffered
+   *
+   * Event-driven counterpart of the device link task: the caller sleeps
+   * in the transport instead of waking up every millisecond. While
+   * responses are queued the wait is capped at TX_RETRY_MS, and the timer
+   * hook caps it further. Responses of the batch go out in one flush.
+   *
+   * @param timeout_ms Timeout in milliseconds (LinkTransport::WAIT_FOREVER:
+   *                   until data, close or a signal)
+   * @return true if data arrived or the peer closed, false on timeout or
+   *         signal
+   */
+  bool service(uint32_t timeout_ms);
+
+  /**
+   * @brief Feed a chunk of received bytes
+   *
+   * Frame boundaries are found in bulk by LinkFrameScanner. Frames that
+   * lie entirely inside @p data are dispatched in place; only frames
+   * split across chunks are staged.
+   *
+   * @param data Received bytes
+   * @param len Number of bytes
+   */
+  void feed(const uint8_t* data, size_t len);
+
+  /**
+   * @brief Register a handler for a runtime command (0x40..0x7F)
+   *
+   * Runtime commands are answered by the port itself; all other commands
+   * go to V4-link.
+   *
+   * @return false if @p cmd is out of range or already taken
+   */
+  bool add_runtime_command(uint8_t cmd, RuntimeCmdHandler handler, void* user)
+  {
+    return runtime_cmds_.add(cmd, handler, user);
+  }
+
+  /**
+   * @brief Advertise capability bits (link_wire::CAP_*) in CMD_CAPS
+   */
+  void add_caps(uint32_t caps)
+  {
+    runtime_cmds_.add_caps(caps);
+  }
+
+  /**
+   * @brief Set a filter applied to EXEC payloads before V4-link sees them
+   */
+  void set_exec_filter(ExecFilter filter, void* user)
+  {
+    runtime_cmds_.set_exec_filter(filter, user);
+  }
+
+  /**
+   * @brief Set a callback run after each core frame has been handled by V4-link
+   */
+  void set_frame_hook(void (*hook)(void* user), void* user)
+  {
+    frame_hook_ = hook;
+    frame_hook_user_ = user;
+  }
+
+  /**
+   * @brief Set a callback run on every poll() and service()
+   *
+   * The hook returns the milliseconds until it needs to run again
+   * (UINT32_MAX: only on traffic); service() caps its timeout to that
+   * instead of adding a periodic tick.
+   */
+  void set_timer_hook(uint32_t (*hook)(void* user), void* user)
+  {
+    timer_hook_ = hook;
+    timer_hook_user_ = user;
+  }
+
+  /**
+   * @brief Serialize frame handling with other ports
+   *
+   * Runtime commands, core frames and the timer hook run between
+   * @p lock and @p unlock, so ports on other threads can share the VMs
+   * and command handlers. Not needed with a single port.
+   */
+  void set_frame_lock(void (*lock)(void* user), void (*unlock)(void* user), void* user)
+  {
+    lock_ = lock;
+    unlock_ = unlock;
+    lock_user_ = user;
+  }
+
+  /**
+   * @brief Serve the VMs of @p pool on separate channels
+   *
+   * Registers CMD_VM_SELECT (answered by the port) and CMD_VM_CTRL
+   * (VmPool::handle_command()). Core frames go to the selected VM,
+   * channel 0 until the host selects another, each through its own
+   * V4-link instance. A faulted VM is restarted before its next frame.
+   */
+  void attach_pool(VmPool* pool);
+
+  /**
+   * @brief Serve windowed transfers (CMD_WINDOW, LinkWindow)
+   *
+   * The window is @p budget / buffer_capacity() frames; CMD_CAPS then
+   * advertises CAP_LINK_WINDOW.
+   *
+   * @param budget Reorder buffer size (bytes)
+   * @return false if the budget holds no frame or a window exists
+   */
+  bool enable_window(size_t budget);
+
+  /**
+   * @brief Get the windowed transfer state (nullptr: not enabled)
+   */
+  const LinkWindow* window() const
+  {
+    return window_.get();
+  }
+
+  /**
+   * @brief Get the pool VM core frames currently go to
+   */
+  uint8_t channel() const
+  {
+    return channel_;
+  }
+
+  /**
+   * @brief Get largest single transport read (bytes)
+   */
+  size_t rx_high_water() const
+  {
+    return rx_high_water_;
+  }
+
+  /**
+   * @brief Get transport read buffer size (bytes)
+   */
+  static constexpr size_t rx_chunk_size()
+  {
+    return RX_CHUNK;
+  }
+
+  /**
+   * @brief Get TX ring capacity (bytes)
+   */
+  size_t tx_capacity() const
+  {
+    return tx_.capacity();
+  }
+
+  /**
+   * @brief Push queued responses to the transport (non-blocking)
+   *
+   * Called by poll() and service(); callers using feed() directly must
+   * call it themselves.
+   */
+  void flush_tx();
+
+  /**
+   * @brief Get number of response bytes waiting to be sent
+   */
+  size_t tx_pending() const
+  {
+    return tx_.pending();
+  }
+
+  /**
+   * @brief Get TX ring counters (queued, flushed, dropped)
+   */
+  const TxRing::Stats& tx_stats() const
+  {
+    return tx_.stats();
+  }
+
+  /**
+   * @brief Reset V4-link state
+   */
+  void reset();
+
+  /**
+   * @brief Get V4-link buffer capacity
+   * @return Buffer capacity in bytes
+   */
+  size_t buffer_capacity() const;
+
+  /**
+   * @brief Check whether the peer closed the connection
+   * @return true once the transport reported the link gone for good
+   */
+  bool closed() const
+  {
+    return closed_;
+  }
+
+  /**
+   * @brief Get total number of bytes received
+   * @return Bytes fed to V4-link since construction
+   */
+  uint64_t bytes_received() const
+  {
+    return rx_bytes_;
+  }
+
+  /**
+   * @brief Get frame scanner counters
+   */
+  const LinkFrameScanner::Stats& scanner_stats() const
+  {
+    return scanner_.stats();
+  }
+
+  /**
+   * @brief Get the transport the port reads from and writes to
+   */
+  LinkTransport* transport() const
+  {
+    return transport_;
+  }
+
+ private:
+  /** V4-link instance of one pool VM */
+  struct Channel
+  {
+    std::unique_ptr<v4::link::Link> link;  ///< Link bound to the VM
+    uint32_t generation = 0;               ///< VmPool generation it was built for
+  };
+
+  static void on_frame(void* user, const LinkFrameView& frame);
+  void handle_frame(const LinkFrameView& frame);
+  static void handle_select(void* user, const LinkFrameView& frame, LinkReply* reply);
+  v4::link::Link* route();
+  bool receive(uint32_t timeout_ms);
+  void lock();
+  void unlock();
+
+  LinkTransport* transport_;                      ///< Byte transport
+  bool closed_ = false;                           ///< Peer closed the link
+  uint64_t rx_bytes_ = 0;                         ///< Received byte counter
+  std::unique_ptr<v4::link::Link> link_;          ///< V4-link instance
+  LinkFrameScanner scanner_;                      ///< Bulk frame scanner
+  TxRing tx_;                                     ///< Outbound response ring
+  LinkRuntimeCommands runtime_cmds_;              ///< Runtime command handlers
+  void (*frame_hook_)(void*) = nullptr;           ///< Post-frame callback
+  void* frame_hook_user_ = nullptr;               ///< Post-frame callback user
+  uint32_t (*timer_hook_)(void*) = nullptr;       ///< Per-wait callback
+  void* timer_hook_user_ = nullptr;               ///< Per-wait callback user
+  void (*lock_)(void*) = nullptr;                 ///< Frame lock (shared VMs)
+  void (*unlock_)(void*) = nullptr;               ///< Frame unlock
+  void* lock_user_ = nullptr;                     ///< Frame lock user
+  size_t rx_high_water_ = 0;                      ///< Largest single read
+  size_t buffer_size_;                            ///< V4-link buffer size
+  VmPool* pool_ = nullptr;                        ///< VM pool (nullptr: single VM)
+  uint8_t channel_ = 0;                           ///< Selected pool VM
+  Channel channels_[VmPool::MAX_VMS];             ///< Per-VM links (pool mode)
+  std::unique_ptr<LinkWindow> window_;            ///< Windowed transfers
+  static constexpr size_t RX_CHUNK = 512;         ///< Bytes read per poll
+  static constexpr size_t TX_RING_SIZE = 2048;    ///< Outbound ring size
+  static constexpr uint32_t TX_MAX_WAIT_MS = 20;  ///< Longest wait before a drop
+  static constexpr uint32_t TX_RETRY_MS = 10;     ///< Retry period with TX pending
+};
+
+}  // namespace v4rtos
@@ -0,0 +1,294 @@
+// V4-link transports for POSIX hosts
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#include "posix_link_transport.hpp"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+
+#include "posix_log.h"
+#include "posix_rx.hpp"
+
+static const char* TAG = "V4Link";
+
+namespace v4rtos
+{
+
+static bool set_nonblocking(int fd)
+{
+  int flags = fcntl(fd, F_GETFL, 0);
+  return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+static int to_poll_ms(uint32_t timeout_ms)
+{
+  return timeout_ms == LinkTransport::WAIT_FOREVER ? -1 : (int)timeout_ms;
+}
+
+// Wait for data (unless timeout_ms is 0), then one non-blocking read
+static int fd_read(int fd, uint8_t* buf, size_t cap, uint32_t timeout_ms)
+{
+  if (timeout_ms > 0)
+  {
+    RxWait ret = posix_rx_wait(fd, to_poll_ms(timeout_ms));
+    if (ret == RxWait::ERROR)
+    {
+      POSIX_LOGE(TAG, "poll() on link fd failed: %s", strerror(errno));
+      return -1;
+    }
+    if (ret != RxWait::READABLE)
+    {
+      return 0;
+    }
+  }
+
+  ssize_t len = ::read(fd, buf, cap);
+  if (len > 0)
+  {
+    return (int)len;
+  }
+  // EIO: pty master whose slave is not (or no longer) open; keep waiting
+  if (len < 0 &&
+      (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR || errno == EIO))
+  {
+    return 0;
+  }
+  return -1;  // EOF on socket/pipe or a fatal error
+}
+
+// Non-blocking write, waiting at most timeout_ms for room
+static size_t fd_write(int fd, const uint8_t* data, size_t len, uint32_t timeout_ms)
+{
+  size_t total = 0;
+  bool waited = false;
+
+  while (total < len)
+  {
+    ssize_t written = ::write(fd, data + total, len - total);
+    if (written > 0)
+    {
+      total += (size_t)written;
+      continue;
+    }
+    if (written < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && timeout_ms > 0 &&
+        !waited)
+    {
+      struct pollfd pfd = {fd, POLLOUT, 0};
+      ::poll(&pfd, 1, (int)timeout_ms);
+      waited = true;
+      continue;
+    }
+    if (written < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+    {
+      POSIX_LOGD(TAG, "Failed to write to link fd: %s", strerror(errno));
+    }
+    break;
+  }
+  return total;
+}
+
+// ==============================================================================
+// File descriptor
+// ==============================================================================
+
+PosixFdTransport::PosixFdTransport(int fd) : fd_(fd), ok_(false)
+{
+  snprintf(name_, sizeof(name_), "fd%d", fd);
+
+  // Non-blocking I/O, matching usb_serial_jtag_read_bytes(..., 0)
+  if (!set_nonblocking(fd_))
+  {
+    POSIX_LOGE(TAG, "Failed to set O_NONBLOCK on fd %d: %s", fd_, strerror(errno));
+    return;
+  }
+  ok_ = true;
+}
+
+PosixFdTransport::~PosixFdTransport()
+{
+  close(fd_);
+}
+
+int PosixFdTransport::read(uint8_t* buf, size_t cap, uint32_t timeout_ms)
+{
+  if (!ok_)
+  {
+    return -1;
+  }
+  return fd_read(fd_, buf, cap, timeout_ms);
+}
+
+size_t PosixFdTransport::write(const uint8_t* data, size_t len, uint32_t timeout_ms)
+{
+  return ok_ ? fd_write(fd_, data, len, timeout_ms) : 0;
+}
+
+int PosixFdTransport::open_pty(char* slave_name, size_t slave_name_size)
+{
+  int fd = posix_openpt(O_RDWR | O_NOCTTY);
+  if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0)
+  {
+    POSIX_LOGE(TAG, "Failed to open pty: %s", strerror(errno));
+    if (fd >= 0)
+    {
+      close(fd);
+    }
+    return -1;
+  }
+
+  // Raw mode: V4-link frames are binary
+  struct termios tio;
+  if (tcgetattr(fd, &tio) == 0)
+  {
+    cfmakeraw(&tio);
+    tcsetattr(fd, TCSANOW, &tio);
+  }
+
+  const char* name = ptsname(fd);
+  snprintf(slave_name, slave_name_size, "%s", name ? name : "?");
+
+  // Keep one slave handle open for the lifetime of the process so the
+  // master never reports hang-up between host tool connections
+  if (name != nullptr && open(name, O_RDWR | O_NOCTTY) < 0)
+  {
+    POSIX_LOGW(TAG, "Failed to hold pty slave open: %s", strerror(errno));
+  }
+  return fd;
+}
+
+// ==============================================================================
+// TCP (loopback)
+// ==============================================================================
+
+PosixTcpTransport::PosixTcpTransport(uint16_t port)
+{
+  snprintf(name_, sizeof(name_), "tcp:%u", (unsigned)port);
+
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0)
+  {
+    POSIX_LOGE(TAG, "Failed to create TCP socket: %s", strerror(errno));
+    return;
+  }
+  int one = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+  // Loopback only: V4-link has no authentication
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(port);
+  socklen_t addr_len = sizeof(addr);
+  if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 4) != 0 ||
+      getsockname(fd, (struct sockaddr*)&addr, &addr_len) != 0 || !set_nonblocking(fd))
+  {
+    POSIX_LOGE(TAG, "Failed to listen on TCP port %u: %s", (unsigned)port,
+               strerror(errno));
+    close(fd);
+    return;
+  }
+
+  listen_fd_ = fd;
+  port_ = ntohs(addr.sin_port);
+  snprintf(name_, sizeof(name_), "tcp:%u", (unsigned)port_);
+  POSIX_LOGI(TAG, "Listening on 127.0.0.1:%u", (unsigned)port_);
+}
+
+PosixTcpTransport::~PosixTcpTransport()
+{
+  drop_host();
+  if (listen_fd_ >= 0)
+  {
+    close(listen_fd_);
+  }
+}
+
+void PosixTcpTransport::accept_host()
+{
+  int fd = accept(listen_fd_, nullptr, nullptr);
+  if (fd < 0)
+  {
+    return;
+  }
+
+  // Responses are single small frames; do not hold them back for Nagle
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  if (!set_nonblocking(fd))
+  {
+    close(fd);
+    return;
+  }
+
+  client_fd_ = fd;
+  connections_++;
+  POSIX_LOGI(TAG, "Host connected on %s", name_);
+}
+
+void PosixTcpTransport::drop_host()
+{
+  if (client_fd_ >= 0)
+  {
+    close(client_fd_);
+    client_fd_ = -1;
+    POSIX_LOGI(TAG, "Host disconnected from %s", name_);
+  }
+}
+
+int PosixTcpTransport::read(uint8_t* buf, size_t cap, uint32_t timeout_ms)
+{
+  if (listen_fd_ < 0)
+  {
+    return -1;
+  }
+
+  if (client_fd_ < 0)
+  {
+    // Nothing to read before a host connects; the accept is the wakeup
+    if (timeout_ms > 0 &&
+        posix_rx_wait(listen_fd_, to_poll_ms(timeout_ms)) != RxWait::READABLE)
+    {
+      return 0;
+    }
+    accept_host();
+    if (client_fd_ < 0)
+    {
+      return 0;
+    }
+  }
+
+  int len = fd_read(client_fd_, buf, cap, timeout_ms);
+  if (len < 0)
+  {
+    drop_host();
+    return 0;
+  }
+  return len;
+}
+
+size_t PosixTcpTransport::write(const uint8_t* data, size_t len, uint32_t timeout_ms)
+{
+  if (client_fd_ < 0)
+  {
+    return len;  // Nobody to answer
+  }
+  return fd_write(client_fd_, data, len, timeout_ms);
+}
+
+}  // namespace v4rtos
@@ -0,0 +1,128 @@
+// V4-link transports for POSIX hosts (fd, pty, TCP)
+//
+// Stand in for USB Serial/JTAG and the UART so the full protocol stack
+// can run and be tested on Linux
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "link_transport.hpp"
+
+namespace v4rtos
+{
+
+/**
+ * @brief V4-link over a connected file descriptor (pty master, socket, pipe)
+ *
+ * The fd is switched to non-blocking mode and closed by the destructor.
+ */
+class PosixFdTransport : public LinkTransport
+{
+ public:
+  /**
+   * @brief Construct fd transport
+   * @param fd Connected file descriptor (ownership is taken)
+   */
+  explicit PosixFdTransport(int fd);
+  ~PosixFdTransport() override;
+
+  /**
+   * @brief Check whether the fd could be set up
+   */
+  bool ok() const
+  {
+    return ok_;
+  }
+
+  const char* name() const override
+  {
+    return name_;
+  }
+
+  int read(uint8_t* buf, size_t cap, uint32_t timeout_ms) override;
+  size_t write(const uint8_t* data, size_t len, uint32_t timeout_ms) override;
+
+  /**
+   * @brief Open a pseudo-terminal to act as the host side of the link
+   *
+   * The returned fd is the pty master. Host tools (v4flash, v4repl)
+   * connect to the slave path written to @p slave_name.
+   *
+   * @param slave_name Buffer receiving the slave device path
+   * @param slave_name_size Size of @p slave_name
+   * @return Master fd on success, -1 on failure
+   */
+  static int open_pty(char* slave_name, size_t slave_name_size);
+
+ private:
+  int fd_;         ///< Link file descriptor
+  bool ok_;        ///< O_NONBLOCK set
+  char name_[16];  ///< "fdN"
+};
+
+/**
+ * @brief V4-link over TCP on the loopback interface
+ *
+ * Listens on 127.0.0.1:port and serves one host at a time; further hosts
+ * wait in the listen backlog. When the host disconnects the transport
+ * goes back to listening, so it never reports the link as closed.
+ * Responses with no host connected are discarded.
+ */
+class PosixTcpTransport : public LinkTransport
+{
+ public:
+  /**
+   * @brief Construct TCP transport
+   * @param port TCP port (0: pick a free one, see port())
+   */
+  explicit PosixTcpTransport(uint16_t port);
+  ~PosixTcpTransport() override;
+
+  /**
+   * @brief Check whether the listening socket is up
+   */
+  bool ok() const
+  {
+    return listen_fd_ >= 0;
+  }
+
+  /**
+   * @brief Get the port listened on
+   */
+  uint16_t port() const
+  {
+    return port_;
+  }
+
+  /**
+   * @brief Get number of hosts accepted so far
+   */
+  uint32_t connections() const
+  {
+    return connections_;
+  }
+
+  const char* name() const override
+  {
+    return name_;
+  }
+
+  int read(uint8_t* buf, size_t cap, uint32_t timeout_ms) override;
+  size_t write(const uint8_t* data, size_t len, uint32_t timeout_ms) override;
+
+ private:
+  void accept_host();
+  void drop_host();
+
+  int listen_fd_ = -1;        ///< Listening socket
+  int client_fd_ = -1;        ///< Connected host (-1: none)
+  uint16_t port_ = 0;         ///< Bound port
+  uint32_t connections_ = 0;  ///< Hosts accepted
+  char name_[16];             ///< "tcp:PORT"
+};
+
+}  // namespace v4rtos
@@ -0,0 +1,57 @@
+/**
+ * @file posix_log.h
+ * @brief ESP_LOGx-style logging for the POSIX runtime
+ *
+ * Keeps log output in the same "L (ms) tag: message" shape as the
+ * ESP32-C6 runtime so host and device logs can be diffed directly.
+ *
+ * SPDX-License-Identifier: MIT OR Apache-2.0
+ */
+
+#ifndef POSIX_LOG_H
+#define POSIX_LOG_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  /** Log levels (same ordering as esp_log_level_t) */
+  enum
+  {
+    POSIX_LOG_NONE = 0,
+    POSIX_LOG_ERROR = 1,
+    POSIX_LOG_WARN = 2,
+    POSIX_LOG_INFO = 3,
+    POSIX_LOG_DEBUG = 4,
+  };
+
+  /** Current log level (default: POSIX_LOG_INFO) */
+  extern int posix_log_level;
+
+  /** Milliseconds since process start (shared with the task platform) */
+  uint32_t v4_task_platform_get_tick_ms(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define POSIX_LOG(level, letter, tag, fmt, ...)                                     \
+  do                                                                                \
+  {                                                                                 \
+    if (posix_log_level >= (level))                                                 \
+    {                                                                               \
+      fprintf(stderr, letter " (%u) %s: " fmt "\n",                                 \
+              (unsigned)v4_task_platform_get_tick_ms(), tag, ##__VA_ARGS__);        \
+    }                                                                               \
+  } while (0)
+
+#define POSIX_LOGE(tag, fmt, ...) POSIX_LOG(POSIX_LOG_ERROR, "E", tag, fmt, ##__VA_ARGS__)
+#define POSIX_LOGW(tag, fmt, ...) POSIX_LOG(POSIX_LOG_WARN, "W", tag, fmt, ##__VA_ARGS__)
+#define POSIX_LOGI(tag, fmt, ...) POSIX_LOG(POSIX_LOG_INFO, "I", tag, fmt, ##__VA_ARGS__)
+#define POSIX_LOGD(tag, fmt, ...) POSIX_LOG(POSIX_LOG_DEBUG, "D", tag, fmt, ##__VA_ARGS__)
+
+#endif /* POSIX_LOG_H */
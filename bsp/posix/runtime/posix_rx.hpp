@@ -0,0 +1,92 @@
+// Event-driven receive helpers for POSIX file descriptors
+//
+// posix_rx_wait() is what PosixFdTransport sleeps in; posix_rx_drain()
+// reads until the fd would block, like PosixLinkPort::service(). The host
+// link benchmarks use both so that the benchmarked receive loop is the
+// one the runtime actually uses.
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace v4rtos
+{
+
+/** Result of posix_rx_wait() */
+enum class RxWait
+{
+  READABLE,     ///< Data (or EOF) is available
+  TIMEOUT,      ///< Timeout expired
+  INTERRUPTED,  ///< Interrupted by a signal
+  ERROR         ///< poll() failed
+};
+
+/**
+ * @brief Block until @p fd is readable
+ *
+ * @param fd File descriptor
+ * @param timeout_ms Timeout in milliseconds (-1: wait forever)
+ * @return Wait result
+ */
+inline RxWait posix_rx_wait(int fd, int timeout_ms)
+{
+  struct pollfd pfd = {fd, POLLIN, 0};
+  int ret = ::poll(&pfd, 1, timeout_ms);
+  if (ret > 0)
+  {
+    return RxWait::READABLE;
+  }
+  if (ret == 0)
+  {
+    return RxWait::TIMEOUT;
+  }
+  return errno == EINTR ? RxWait::INTERRUPTED : RxWait::ERROR;
+}
+
+/**
+ * @brief Read everything currently buffered on a non-blocking fd
+ *
+ * Calls @p on_chunk(data, len) for each read until the fd would block.
+ *
+ * @param fd Non-blocking file descriptor
+ * @param buf Scratch buffer
+ * @param cap Scratch buffer size
+ * @param on_chunk Chunk callback
+ * @param eof Set to true on EOF or a fatal read error
+ * @return Number of bytes read
+ */
+template <typename ChunkFn>
+inline size_t posix_rx_drain(int fd, uint8_t* buf, size_t cap, ChunkFn&& on_chunk,
+                             bool* eof)
+{
+  size_t total = 0;
+  while (1)
+  {
+    ssize_t len = read(fd, buf, cap);
+    if (len > 0)
+    {
+      total += (size_t)len;
+      on_chunk(buf, (size_t)len);
+      continue;
+    }
+    if (len < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    // EIO: pty master whose slave is not (or no longer) open; keep waiting
+    if (len == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EIO))
+    {
+      *eof = true;
+    }
+    return total;
+  }
+}
+
+}  // namespace v4rtos
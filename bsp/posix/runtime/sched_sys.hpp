@@ -0,0 +1,51 @@
+// Task scheduling words for the POSIX runtime
+//
+// Gives every pool VM a TaskScheduler, routes the v4_sched_* hooks of
+// V4-engine (built with V4_SCHED_PRIORITY) to it and registers the
+// TASK-PRIORITY and MUTEX-* SYS handlers (SYS_TASK_PRIORITY ..
+// SYS_MUTEX_UNLOCK).
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#pragma once
+
+#include "task_sched.hpp"
+
+namespace v4rtos
+{
+
+/**
+ * @brief Register the SYS handlers and set the per-priority slices
+ *
+ * Call before the VM pool starts.
+ *
+ * @param slices Slice per priority in ms ("0 5 10 10 10 10 20 20")
+ * @return false if @p slices does not parse (every priority keeps 10 ms)
+ */
+bool sched_sys_init(const char* slices);
+
+/**
+ * @brief Give pool VM @p id a fresh scheduler (before vm_task_init())
+ *
+ * Replaces the scheduler of the VM previously created for @p id.
+ */
+void sched_sys_attach(Vm* vm, uint8_t id);
+
+/**
+ * @brief Drop the scheduler of a VM about to be destroyed
+ */
+void sched_sys_detach(Vm* vm);
+
+/**
+ * @brief CMD_SCHED handler: [op][vm-id] (VM 0 if omitted)
+ *
+ * RuntimeCmdHandler signature; @p user is unused.
+ */
+void sched_sys_handle_command(void* user, const LinkFrameView& frame, LinkReply* reply);
+
+/**
+ * @brief Log the wakeup latency of every priority that ran
+ */
+void sched_sys_report(void);
+
+}  // namespace v4rtos
@@ -0,0 +1,59 @@
+// V4 task platform implementation for POSIX hosts
+//
+// Provides std::mutex/clock_gettime based task system backend for V4 kernel
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#include <stdint.h>
+#include <time.h>
+
+#include <mutex>
+
+// Recursive mutex standing in for the FreeRTOS critical-section spinlock
+static std::recursive_mutex v4_task_critical_mutex;
+
+static uint64_t monotonic_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+extern "C"
+{
+  /**
+   * @brief Get current tick time in milliseconds
+   *
+   * Used by V4 task scheduler for time-slicing and sleep.
+   *
+   * @return Current time in milliseconds since process start
+   */
+  uint32_t v4_task_platform_get_tick_ms(void)
+  {
+    // Time base captured on first use (thread-safe static initialization)
+    static const uint64_t epoch_ns = monotonic_ns();
+    return (uint32_t)((monotonic_ns() - epoch_ns) / 1000000ull);
+  }
+
+  /**
+   * @brief Enter critical section
+   *
+   * Acquires a process-wide recursive mutex. Supports nesting.
+   * Each call must be paired with v4_task_platform_critical_exit().
+   */
+  void v4_task_platform_critical_enter(void)
+  {
+    v4_task_critical_mutex.lock();
+  }
+
+  /**
+   * @brief Exit critical section
+   *
+   * Releases the recursive mutex.
+   */
+  void v4_task_platform_critical_exit(void)
+  {
+    v4_task_critical_mutex.unlock();
+  }
+
+}  // extern "C"
@@ -0,0 +1,137 @@
+// VM memory layout implementation for POSIX hosts
+//
+// SPDX-License-Identifier: MIT OR Apache-2.0
+
+#include "vm_memory.hpp"
+
+#include <stdlib.h>
+
+#include "mem_watermark.hpp"
+#include "posix_log.h"
+
+static const char* TAG = "VmMemory";
+
+// ==============================================================================
+// Build Configuration
+// ==============================================================================
+
+#ifndef CONFIG_V4_VM_ARENA_SIZE_KB
+#define CONFIG_V4_VM_ARENA_SIZE_KB 16
+#endif
+#ifndef CONFIG_V4_NAME_ARENA_SIZE_KB
+#define CONFIG_V4_NAME_ARENA_SIZE_KB 4
+#endif
+
+#define VM_ARENA_SIZE (CONFIG_V4_VM_ARENA_SIZE_KB * 1024)
+#define NAME_ARENA_SIZE (CONFIG_V4_NAME_ARENA_SIZE_KB * 1024)
+
+#if defined(CONFIG_V4_VM_ARENA_PLACEMENT_HEAP)
+#define ARENA_PLACEMENT v4rtos::MemPlacement::HEAP
+#else
+#define ARENA_PLACEMENT v4rtos::MemPlacement::STATIC
+static uint8_t vm_arena_static[VM_ARENA_SIZE] __attribute__((aligned(4)));
+#if NAME_ARENA_SIZE > 0
+static uint8_t name_arena_static[NAME_ARENA_SIZE] __attribute__((aligned(4)));
+#endif
+#endif
+
+namespace v4rtos
+{
+
+static uint8_t* alloc_region(MemPlacement placement, uint8_t* static_buf, size_t size)
+{
+  if (placement == MemPlacement::STATIC)
+  {
+    return static_buf;
+  }
+  void* ptr = nullptr;
+  return posix_memalign(&ptr, 16, size) == 0 ? static_cast<uint8_t*>(ptr) : nullptr;
+}
+
+const char* mem_placement_name(MemPlacement placement)
+{
+  switch (placement)
+  {
+    case MemPlacement::STATIC:
+      return "static";
+    case MemPlacement::HEAP:
+      return "heap";
+  }
+  return "?";
+}
+
+int vm_memory_init(VmMemoryLayout* layout)
+{
+  uint8_t* vm_static = nullptr;
+  uint8_t* name_static = nullptr;
+#if !defined(CONFIG_V4_VM_ARENA_PLACEMENT_HEAP)
+  vm_static = vm_arena_static;
+#if NAME_ARENA_SIZE > 0
+  name_static = name_arena_static;
+#endif
+#endif
+
+  *layout = VmMemoryLayout{};
+
+  // VM arena
+  layout->vm_placement = ARENA_PLACEMENT;
+  layout->vm_arena_size = VM_ARENA_SIZE;
+  layout->vm_arena = alloc_region(layout->vm_placement, vm_static, VM_ARENA_SIZE);
+  if (layout->vm_arena == nullptr)
+  {
+    POSIX_LOGE(TAG, "Failed to allocate %d KB VM arena", VM_ARENA_SIZE / 1024);
+    return -1;
+  }
+  mem_paint(layout->vm_arena, layout->vm_arena_size);
+
+  // Word name arena (optional)
+  layout->name_placement = ARENA_PLACEMENT;
+  if (NAME_ARENA_SIZE > 0)
+  {
+    layout->name_buf_size = NAME_ARENA_SIZE;
+    layout->name_buf = alloc_region(layout->name_placement, name_static, NAME_ARENA_SIZE);
+    if (layout->name_buf == nullptr)
+    {
+      POSIX_LOGE(TAG, "Failed to allocate %d KB name arena", NAME_ARENA_SIZE / 1024);
+      return -1;
+    }
+    mem_paint(layout->name_buf, layout->name_buf_size);
+    v4_arena_init(&layout->name_arena, layout->name_buf, layout->name_buf_size);
+  }
+
+  return 0;
+}
+
+V4Arena* vm_memory_name_arena(VmMemoryLayout* layout)
+{
+  return layout->name_buf != nullptr ? &layout->name_arena : nullptr;
+}
+
+V4Arena* vm_memory_reset_name_arena(VmMemoryLayout* layout)
+{
+  if (layout->name_buf == nullptr)
+  {
+    return nullptr;
+  }
+  mem_paint(layout->name_buf, layout->name_buf_size);
+  v4_arena_init(&layout->name_arena, layout->name_buf, layout->name_buf_size);
+  return &layout->name_arena;
+}
+
+void vm_memory_report(const VmMemoryLayout& layout)
+{
+  POSIX_LOGI(TAG, "VM memory layout:");
+  POSIX_LOGI(TAG, "  VM arena:   %6u bytes  %-8s @ %p", (unsigned)layout.vm_arena_size,
+             mem_placement_name(layout.vm_placement), (void*)layout.vm_arena);
+  if (layout.name_buf != nullptr)
+  {
+    POSIX_LOGI(TAG, "  Name arena: %6zu bytes  %-8s @ %p", layout.name_buf_size,
+               mem_placement_name(layout.name_placement), (void*)layout.name_buf);
+  }
+  else
+  {
+    POSIX_LOGI(TAG, "  Name arena: none (word names use malloc)");
+  }
+}
+
+}  // namespace v4rtos
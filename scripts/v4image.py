@@ -0,0 +1,368 @@
+#!/usr/bin/env python3
+# Build and upload flash-persistent V4 bytecode images
+#
+# An image is compiled bytecode (e.g. v4-front output) behind a 32-byte
+# header the runtime validates with CRC-32 before it runs the code in place
+# from the image partition (ESP32-C6: "v4image" in partitions.csv, POSIX:
+# --image-file). The partition holds two slots: an upload goes to the slot
+# that is not running and is activated on trial, so a new image that
+# panics (or a reset) before the trial window ends rolls back to the old
+# one. Images are either built into a partition file or written to a
+# running runtime with the IMAGE runtime command (0x45):
+#
+#   scripts/v4image.py build program.bin -o image.bin   # partition file
+#   scripts/v4image.py upload -p /dev/ttyACM0 program.bin
+#   scripts/v4image.py info -p /dev/ttyACM0
+#   scripts/v4image.py erase -p /dev/ttyACM0            # update slot only
+#
+# A partition file can be flashed with "parttool.py write_partition
+# --partition-name v4image --input image.bin" or passed to the POSIX
+# runtime as --image-file; its image (slot A) is already confirmed. Images
+# run at boot unless built with --no-autostart. "upload --no-activate"
+# only commits the image; it then starts its trial at the next boot.
+#
+# Uploads are LZ4-compressed when the runtime advertises it (CAPS runtime
+# command, 0x46); the device decodes the stream straight into the flash
+# slot. --no-compress sends plain code. If the runtime serves windowed
+# transfers (WINDOW runtime command, 0x47), the WRITEs are pipelined: up to
+# the window the runtime negotiates is in flight, and only frames its
+# selective acknowledgements report missing are resent. --no-window waits
+# for each response instead.
+#
+# SPDX-License-Identifier: MIT OR Apache-2.0
+
+import argparse
+import os
+import select
+import struct
+import sys
+import termios
+import time
+import zlib
+
+STX = 0xA5
+CMD_IMAGE = 0x45
+CMD_CAPS = 0x46
+CMD_WINDOW = 0x47
+CAP_IMAGE_LZ4 = 0x0001
+CAP_LINK_WINDOW = 0x0002
+WINDOW_OPEN = 0
+WINDOW_DATA = 1
+RESEND_S = 0.2  # Resend the oldest unacknowledged frame after this long
+OP_INFO = 0
+OP_ERASE = 1
+OP_WRITE = 2
+OP_COMMIT = 3
+OP_ACTIVATE = 4
+OP_WRITE_LZ4 = 5
+MAGIC = 0x4D493456  # "V4IM"
+VERSION = 1
+FLAG_AUTOSTART = 0x0001
+HEADER_SIZE = 32
+PARTITION_SIZE = 128 * 1024  # partitions.csv, V4_IMAGE_PARTITION_KB
+SLOT_STATES = ["empty", "pending", "trial", "confirmed", "revoked"]
+CHUNK = 256  # Code bytes per WRITE (fits the 512-byte link buffer)
+
+
+def crc8(data):
+    crc = 0
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def encode_frame(cmd, payload):
+    body = bytes([len(payload) & 0xFF, len(payload) >> 8, cmd]) + payload
+    return bytes([STX]) + body + bytes([crc8(body)])
+
+
+def split_frames(data):
+    """Split a byte stream into (status, payload) tuples and bytes consumed."""
+    frames = []
+    i = 0
+    while i + 5 <= len(data):
+        if data[i] != STX:
+            i += 1
+            continue
+        length = data[i + 1] | (data[i + 2] << 8)
+        end = i + 5 + length
+        if end > len(data):
+            break
+        if crc8(data[i + 1:end - 1]) == data[end - 1]:
+            frames.append((data[i + 3], bytes(data[i + 4:end - 1])))
+        i = end
+    return frames, i
+
+
+def lz4_compress(data):
+    """Greedy LZ4 block compressor (LZ4_decompress_safe() compatible)."""
+
+    def sequence(lit, offset, match_len):
+        ml = match_len - 4
+        token = (min(len(lit), 15) << 4) | (min(ml, 15) if match_len else 0)
+        seq = bytearray([token]) + lengths(len(lit)) + lit
+        if match_len:
+            seq += struct.pack("<H", offset) + lengths(ml)
+        return seq
+
+    def lengths(n):
+        if n < 15:
+            return b""
+        n -= 15
+        return b"\xff" * (n // 255) + bytes([n % 255])
+
+    out = bytearray()
+    table = {}
+    n = len(data)
+    anchor = i = 0
+    while i < n - 12:  # The last match starts 12 bytes before the end
+        key = data[i:i + 4]
+        ref = table.get(key)
+        table[key] = i
+        if ref is None or i - ref > 65535:
+            i += 1
+            continue
+        length = 4
+        while i + length < n - 5 and data[ref + length] == data[i + length]:
+            length += 1
+        out += sequence(data[anchor:i], i - ref, length)
+        i += length
+        anchor = i
+    out += sequence(data[anchor:], 0, 0)
+    return bytes(out)
+
+
+def image_crc(code, flags, seq):
+    """CRC-32 over the header fields before the CRC, then the code."""
+    fields = struct.pack("<IHHII", MAGIC, VERSION, flags, len(code), seq)
+    return zlib.crc32(code, zlib.crc32(fields)) & 0xFFFFFFFF
+
+
+def build_image(code, flags):
+    """Slot A image, already tried and confirmed (revoked stays erased)."""
+    header = struct.pack("<IHHIIIIII", MAGIC, VERSION, flags, len(code), 0,
+                         image_crc(code, flags, 0), 0, 0, 0xFFFFFFFF)
+    return header + code
+
+
+class Link:
+    """Request/response V4-link connection over a tty or pty."""
+
+    def __init__(self, path, timeout):
+        self.fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+        attrs = termios.tcgetattr(self.fd)
+        attrs[0] = 0  # iflag
+        attrs[1] = 0  # oflag
+        attrs[2] = termios.CS8 | termios.CREAD | termios.CLOCAL
+        attrs[3] = 0  # lflag (raw)
+        termios.tcsetattr(self.fd, termios.TCSANOW, attrs)
+        termios.tcflush(self.fd, termios.TCIOFLUSH)
+        self.timeout = timeout
+        self.buf = bytearray()
+        self.frames = []
+
+    def send(self, cmd, payload):
+        os.write(self.fd, encode_frame(cmd, payload))
+
+    def receive(self, timeout):
+        """Next response as (status, data), None after timeout seconds."""
+        deadline = time.monotonic() + timeout
+        while not self.frames:
+            remaining = deadline - time.monotonic()
+            if remaining <= 0:
+                return None
+            ready, _, _ = select.select([self.fd], [], [], remaining)
+            if ready:
+                self.buf += os.read(self.fd, 4096)
+                frames, used = split_frames(self.buf)
+                del self.buf[:used]
+                self.frames += frames
+        return self.frames.pop(0)
+
+    def request(self, payload, what, cmd=CMD_IMAGE, check=True):
+        self.frames = []  # Late answers to an earlier transfer
+        self.send(cmd, payload)
+        response = self.receive(self.timeout)
+        if response is None:
+            sys.exit("v4image: no response (is there an image partition?)")
+        status, data = response
+        if status != 0 and not check:
+            return None
+        if status != 0:
+            sys.exit("v4image: %s failed (status 0x%02X)" % (what, status))
+        return data
+
+
+def read_info(link):
+    data = link.request(bytes([OP_INFO]), "INFO")
+    info = dict(zip(["active", "update", "next_seq", "trial_ms", "rollbacks",
+                     "capacity"], struct.unpack_from("<BBIIII", data, 0)))
+    info["slots"] = [struct.unpack_from("<BHIII", data, 18 + 15 * i) for i in range(2)]
+    return info
+
+
+def erase(link):
+    # The update slot holds the rollback image until the trial is over
+    trial_ms = read_info(link)["trial_ms"]
+    if trial_ms:
+        sys.exit("v4image: an image is on trial, retry in %.1f s" % (trial_ms / 1000))
+    link.request(bytes([OP_ERASE]), "ERASE")
+
+
+def print_info(link):
+    info = read_info(link)
+    for i, (state, flags, size, seq, crc) in enumerate(info["slots"]):
+        mark = "*" if i == info["active"] else " "
+        if state == 0:
+            print("%s slot %s: empty" % (mark, "AB"[i]))
+            continue
+        print("%s slot %s: %s, seq %d, %d bytes, CRC 0x%08X, %s" %
+              (mark, "AB"[i], SLOT_STATES[state], seq, size, crc,
+               "autostart" if flags & FLAG_AUTOSTART else "stored only"))
+    if info["trial_ms"]:
+        print("trial: %d ms left" % info["trial_ms"])
+    print("rollbacks: %d, capacity: %d bytes per slot" %
+          (info["rollbacks"], info["capacity"]))
+
+
+def read_caps(link):
+    """Ask the runtime (CAPS); runtimes without the command answer an error."""
+    caps = link.request(b"", "CAPS", cmd=CMD_CAPS, check=False)
+    return struct.unpack_from("<I", caps)[0] if caps and len(caps) >= 4 else 0
+
+
+def send_windowed(link, payloads):
+    """Pipeline IMAGE requests through WINDOW; returns the window used.
+
+    Keeps up to the negotiated window in flight. A frame sent before one
+    the runtime reports held (SACK) was lost and is resent; without any
+    acknowledgement for RESEND_S the oldest frame is resent.
+    """
+    window = link.request(bytes([WINDOW_OPEN, 0]), "WINDOW OPEN", cmd=CMD_WINDOW)[0]
+    n = len(payloads)
+    order = [0] * n  # Send order of each frame's last copy
+    held = [False] * n
+    sent = [0]
+    base = nxt = 0
+    progress_at = time.monotonic()
+
+    def transmit(s):
+        head = struct.pack("<BHB", WINDOW_DATA, s & 0xFFFF, CMD_IMAGE)
+        link.send(CMD_WINDOW, head + payloads[s])
+        sent[0] += 1
+        order[s] = sent[0]
+
+    while base < n:
+        while nxt < n and nxt < base + window:
+            transmit(nxt)
+            nxt += 1
+        response = link.receive(RESEND_S)
+        if response is None:
+            if time.monotonic() - progress_at > link.timeout:
+                sys.exit("v4image: no acknowledgement for frame %d" % base)
+            transmit(base)
+            continue
+        status, data = response
+        if status != 0 or len(data) < 9:
+            continue  # E.g. a CRC error report; the SACKs show what to resend
+        ack, sack, failed, fail_seq = struct.unpack_from("<HIBH", data)
+        if failed:
+            sys.exit("v4image: WRITE %d failed (status 0x%02X)" % (fail_seq, failed))
+        step = (ack - base) & 0xFFFF
+        if 0 < step < 0x8000:
+            base += step
+            progress_at = time.monotonic()
+        highest = base
+        for i in range(min(window - 1, n - base - 1)):
+            if sack >> i & 1:
+                held[base + 1 + i] = True
+                highest = base + 1 + i
+        for s in range(base, highest):
+            if not held[s] and order[s] < order[highest]:
+                transmit(s)
+    return window
+
+
+def upload(link, code, flags, activate, compress, pipeline):
+    erase(link)
+    seq = read_info(link)["next_seq"]
+    caps = read_caps(link)
+    if compress and caps & CAP_IMAGE_LZ4:
+        stream = lz4_compress(code)
+        payloads = [bytes([OP_WRITE_LZ4]) + stream[off:off + CHUNK]
+                    for off in range(0, len(stream), CHUNK)]
+        ratio = len(code) / max(len(stream), 1)
+        print("sending %d bytes (LZ4, %.1fx)" % (len(stream), ratio))
+    else:
+        payloads = [bytes([OP_WRITE]) + struct.pack("<I", off) + code[off:off + CHUNK]
+                    for off in range(0, len(code), CHUNK)]
+    if pipeline and caps & CAP_LINK_WINDOW:
+        window = send_windowed(link, payloads)
+        print("sent %d frames, window %d" % (len(payloads), window))
+    else:
+        for i, payload in enumerate(payloads):
+            link.request(payload, "WRITE %d" % i)
+    crc = image_crc(code, flags, seq)
+    link.request(bytes([OP_COMMIT]) + struct.pack("<IIH", len(code), crc, flags),
+                 "COMMIT")
+    print("uploaded %d bytes, seq %d, CRC 0x%08X" % (len(code), seq, crc))
+    if activate:
+        link.request(bytes([OP_ACTIVATE]), "ACTIVATE (rolled back)")
+
+
+def main():
+    ap = argparse.ArgumentParser(description="V4 bytecode image tool")
+    ap.add_argument("action", choices=["build", "upload", "info", "erase"])
+    ap.add_argument("bytecode", nargs="?", help="Compiled bytecode (build, upload)")
+    ap.add_argument("-p", "--port", help="Serial device or pty of the runtime")
+    ap.add_argument("-o", "--output", help="Partition file to write (build)")
+    ap.add_argument("--size", type=int, default=PARTITION_SIZE,
+                    help="Partition size in bytes (build)")
+    ap.add_argument("--no-autostart", action="store_true",
+                    help="Store the image without running it at boot")
+    ap.add_argument("--no-compress", action="store_true",
+                    help="Send plain code even if the runtime decodes LZ4 (upload)")
+    ap.add_argument("--no-window", action="store_true",
+                    help="Wait for each WRITE response instead of pipelining (upload)")
+    ap.add_argument("--no-activate", action="store_true",
+                    help="Commit only; the image starts at the next boot (upload)")
+    ap.add_argument("--timeout", type=float, default=2.0,
+                    help="Response timeout (s)")
+    args = ap.parse_args()
+
+    flags = 0 if args.no_autostart else FLAG_AUTOSTART
+    code = b""
+    if args.action in ("build", "upload"):
+        if not args.bytecode:
+            ap.error("%s needs a bytecode file" % args.action)
+        with open(args.bytecode, "rb") as f:
+            code = f.read()
+        if HEADER_SIZE + len(code) > args.size // 2:
+            sys.exit("v4image: %d bytes of code do not fit a %d-byte slot" %
+                     (len(code), args.size // 2))
+
+    if args.action == "build":
+        if not args.output:
+            ap.error("build needs -o")
+        image = build_image(code, flags)
+        with open(args.output, "wb") as f:
+            f.write(image + b"\xff" * (args.size - len(image)))
+        print("%s: %d bytes of code, CRC 0x%08X" %
+              (args.output, len(code), image_crc(code, flags, 0)))
+        return
+
+    if not args.port:
+        ap.error("%s needs -p" % args.action)
+    link = Link(args.port, args.timeout)
+    if args.action == "upload":
+        upload(link, code, flags, not args.no_activate, not args.no_compress,
+               not args.no_window)
+    elif args.action == "erase":
+        erase(link)
+    print_info(link)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,418 @@
+#!/usr/bin/env python3
+# Extract the deferred log message table and read the log over V4-link
+#
+# A runtime built with the deferred-format log (ESP32-C6:
+# CONFIG_V4_LOG_DEFERRED) records V4_LOGx calls as a 32-bit message ID and
+# the raw integer arguments (bsp/common/deferred_log.hpp). The ID is FNV-1a
+# over the tag, a NUL and the format string, so this script recomputes it
+# from the sources and formats the records on the host:
+#
+#   extract  Scan sources for V4_LOGE/W/I/D and V4_DLOG calls and write the
+#            message table (JSON); the ESP-IDF build runs this into
+#            build/v4log.json
+#   read     Drain the log via the LOG runtime command (0x4A) and print one
+#            ESP-IDF style line per record ("W (1234) V4Link: ...")
+#
+# Usage:
+#   scripts/v4log.py extract -o v4log.json bsp/esp32c6 bsp/common
+#   scripts/v4log.py read -p /dev/ttyACM0 --table build/v4log.json
+#   scripts/v4log.py read -p /dev/ttyACM0 --follow --level debug
+#
+# Without --table, read extracts the table from this checkout's bsp/ first,
+# which only matches a firmware built from the same sources.
+#
+# SPDX-License-Identifier: MIT OR Apache-2.0
+
+import argparse
+import json
+import os
+import re
+import select
+import struct
+import sys
+import termios
+import time
+
+STX = 0xA5
+CMD_LOG = 0x4A
+OP_INFO = 0
+OP_READ = 1
+OP_LEVEL = 2
+READ_HEADER = 5
+RECORD_HEADER = 10
+LEVELS = ["none", "error", "warn", "info", "debug"]
+LETTERS = "-EWID"
+SOURCE_EXTS = (".c", ".cpp", ".h", ".hpp")
+
+CALL_RE = re.compile(r"\b(?:V4_LOG([EWID])|V4_DLOG)\s*\(")
+TAG_RE = re.compile(r'\bconstexpr\s+char\s+(\w+)\s*\[\s*\]\s*=\s*"((?:[^"\\]|\\.)*)"')
+STRING_RE = re.compile(r'\s*"((?:[^"\\]|\\.)*)"')
+CONV_RE = re.compile(r"%([-+ #0]*)(\d*)(?:\.(\d*))?([hljzt]*)([diuxXoc%])")
+ESCAPES = {"n": 10, "t": 9, "r": 13, "a": 7, "b": 8, "f": 12, "v": 11,
+           "\\": 92, "'": 39, '"': 34, "?": 63}
+
+
+def crc8(data):
+    crc = 0
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def encode_frame(cmd, payload):
+    body = bytes([len(payload) & 0xFF, len(payload) >> 8, cmd]) + payload
+    return bytes([STX]) + body + bytes([crc8(body)])
+
+
+def split_frames(data):
+    """Split a byte stream into (status, payload) tuples."""
+    frames = []
+    i = 0
+    while i + 5 <= len(data):
+        if data[i] != STX:
+            i += 1
+            continue
+        length = data[i + 1] | (data[i + 2] << 8)
+        end = i + 5 + length
+        if end > len(data):
+            break
+        if crc8(data[i + 1:end - 1]) == data[end - 1]:
+            frames.append((data[i + 3], data[i + 4:end - 1]))
+        i = end
+    return frames
+
+
+class Link:
+    """Request/response V4-link connection over a tty or pty."""
+
+    def __init__(self, path, timeout):
+        self.fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+        attrs = termios.tcgetattr(self.fd)
+        attrs[0] = 0  # iflag
+        attrs[1] = 0  # oflag
+        attrs[2] = termios.CS8 | termios.CREAD | termios.CLOCAL
+        attrs[3] = 0  # lflag (raw)
+        termios.tcsetattr(self.fd, termios.TCSANOW, attrs)
+        termios.tcflush(self.fd, termios.TCIOFLUSH)
+        self.timeout = timeout
+
+    def request(self, payload):
+        os.write(self.fd, encode_frame(CMD_LOG, payload))
+        buf = bytearray()
+        deadline = time.monotonic() + self.timeout
+        while True:
+            remaining = deadline - time.monotonic()
+            if remaining <= 0:
+                sys.exit("v4log: no response "
+                         "(is the runtime built with V4_LOG_DEFERRED?)")
+            ready, _, _ = select.select([self.fd], [], [], remaining)
+            if ready:
+                buf += os.read(self.fd, 4096)
+            frames = split_frames(buf)
+            if frames:
+                status, data = frames[0]
+                if status != 0:
+                    sys.exit("v4log: device answered status 0x%02X" % status)
+                return data
+
+
+# ------------------------------------------------------------------------------
+# Message table
+# ------------------------------------------------------------------------------
+
+def message_id(tag, fmt):
+    """dlog_id(): FNV-1a over the tag, a NUL and the format."""
+    h = 2166136261
+    for b in tag + b"\0" + fmt:
+        h = ((h ^ b) * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def unescape(literal):
+    """Bytes of a C string literal body."""
+    out = bytearray()
+    i = 0
+    raw = literal.encode("utf-8")
+    while i < len(raw):
+        c = raw[i]
+        i += 1
+        if c != 0x5C:  # backslash
+            out.append(c)
+            continue
+        e = chr(raw[i])
+        i += 1
+        if e == "x":
+            j = i
+            while j < len(raw) and chr(raw[j]) in "0123456789abcdefABCDEF":
+                j += 1
+            out.append(int(raw[i:j], 16) & 0xFF)
+            i = j
+        elif e in "01234567":
+            j = i - 1
+            while j < len(raw) and j < i + 2 and chr(raw[j]) in "01234567":
+                j += 1
+            out.append(int(raw[i - 1:j], 8) & 0xFF)
+            i = j
+        else:
+            out.append(ESCAPES.get(e, ord(e)))
+    return bytes(out)
+
+
+def strip_comments(text):
+    """Blank out comments, keeping string literals and line numbers."""
+    out = []
+    i = 0
+    n = len(text)
+    while i < n:
+        c = text[i]
+        if c == '"' or c == "'":
+            j = i + 1
+            while j < n and text[j] != c and text[j] != "\n":
+                j += 2 if text[j] == "\\" else 1
+            out.append(text[i:j + 1])
+            i = j + 1
+        elif text.startswith("//", i):
+            j = text.find("\n", i)
+            i = n if j < 0 else j
+        elif text.startswith("/*", i):
+            j = text.find("*/", i + 2)
+            j = n if j < 0 else j + 2
+            out.append("\n" * text.count("\n", i, j))
+            i = j
+        else:
+            out.append(c)
+            i += 1
+    return "".join(out)
+
+
+def strip_directives(text):
+    """Blank out preprocessor lines (macro bodies call V4_DLOG with parameters)."""
+    lines = text.split("\n")
+    directive = False
+    for i, line in enumerate(lines):
+        if directive or line.lstrip().startswith("#"):
+            directive = line.endswith("\\")
+            lines[i] = ""
+    return "\n".join(lines)
+
+
+def read_literals(text, pos):
+    """Concatenated string literals at pos: (body, end) or (None, pos)."""
+    parts = []
+    m = STRING_RE.match(text, pos)
+    while m:
+        parts.append(m.group(1))
+        pos = m.end()
+        m = STRING_RE.match(text, pos)
+    return ("".join(parts), pos) if parts else (None, pos)
+
+
+def skip_argument(text, pos):
+    """Position of the comma ending the macro argument starting at pos."""
+    depth = 0
+    while pos < len(text):
+        c = text[pos]
+        if c in "([{":
+            depth += 1
+        elif c in ")]}":
+            if depth == 0:
+                return pos
+            depth -= 1
+        elif c == "," and depth == 0:
+            return pos
+        elif c == '"':
+            _, pos = read_literals(text, pos)
+            continue
+        pos += 1
+    return pos
+
+
+def scan_file(path, table, warn):
+    with open(path, encoding="utf-8", errors="replace") as f:
+        text = strip_directives(strip_comments(f.read()))
+    tags = {name: unescape(value) for name, value in TAG_RE.findall(text)}
+    for m in CALL_RE.finditer(text):
+        where = "%s:%d" % (path, text.count("\n", 0, m.start()) + 1)
+        pos = m.end()
+        letter = m.group(1)
+        if letter is None:
+            # V4_DLOG(level, tag, fmt, ...): level is any expression
+            pos = skip_argument(text, pos) + 1
+        tag, end = read_literals(text, pos)
+        if tag is not None:
+            tag = unescape(tag)
+        else:
+            name = re.match(r"\s*(\w+)\s*", text[pos:])
+            tag = tags.get(name.group(1)) if name else None
+            if tag is None:
+                warn("%s: tag is not a constexpr char array of this file, skipped"
+                     % where)
+                continue
+            end = pos + name.end()
+        if text[end:end + 1] != ",":
+            warn("%s: unexpected call syntax, skipped" % where)
+            continue
+        fmt, end = read_literals(text, end + 1)
+        if fmt is None or text[end:end + 1].strip() not in (",", ")"):
+            warn("%s: format is not a plain string literal, skipped" % where)
+            continue
+        fmt = unescape(fmt)
+        key = "0x%08x" % message_id(tag, fmt)
+        strings = (tag.decode("utf-8", "replace"), fmt.decode("utf-8", "replace"))
+        entry = table.get(key)
+        if entry is None:
+            table[key] = {"tag": strings[0], "format": strings[1],
+                          "level": letter or "?", "sites": [where]}
+        elif (entry["tag"], entry["format"]) != strings:
+            sys.exit("v4log: message ID %s collides: %s and %s (reword one message)"
+                     % (key, entry["sites"][0], where))
+        else:
+            entry["sites"].append(where)
+
+
+def extract(paths, warn):
+    table = {}
+    for root in paths:
+        if os.path.isfile(root):
+            scan_file(root, table, warn)
+            continue
+        for dirpath, dirnames, filenames in os.walk(root):
+            dirnames[:] = sorted(d for d in dirnames
+                                 if not d.startswith((".", "_", "build")))
+            for name in sorted(filenames):
+                if name.endswith(SOURCE_EXTS):
+                    scan_file(os.path.join(dirpath, name), table, warn)
+    return table
+
+
+# ------------------------------------------------------------------------------
+# Record formatting
+# ------------------------------------------------------------------------------
+
+def convert(flags, width, prec, length, conv, value):
+    """One C integer conversion of a 32-bit argument."""
+    bits = 8 if "hh" in length else 16 if "h" in length else 32
+    value &= (1 << bits) - 1
+    if conv == "c":
+        return ("%" + flags.replace("0", "") + width + "s") % chr(value & 0xFF)
+    if conv in "di" and value & (1 << (bits - 1)):
+        value -= 1 << bits
+    spec = "%" + flags + width + ("." + (prec or "0") if prec is not None else "")
+    if conv == "o" and "#" in flags:
+        # Python prints 0o17 where C prints 017
+        text = "%o" % value
+        text = text if value == 0 else "0" + text
+        return ("%" + ("-" if "-" in flags else "") + width + "s") % text
+    return (spec + {"u": "d", "i": "d"}.get(conv, conv)) % value
+
+
+def format_message(fmt, args):
+    it = iter(args)
+
+    def one(m):
+        flags, width, prec, length, conv = m.groups()
+        if conv == "%":
+            return "%"
+        try:
+            return convert(flags, width, prec, length, conv, next(it))
+        except StopIteration:
+            return "<missing>"
+
+    return CONV_RE.sub(one, fmt)
+
+
+def format_record(table, rec):
+    time_ms, mid, level, args = rec
+    letter = LETTERS[level] if level < len(LETTERS) else "?"
+    entry = table.get("0x%08x" % mid)
+    if entry is None:
+        return "%s (%u) <id 0x%08x>: %s" % (letter, time_ms, mid,
+                                             " ".join("0x%08x" % a for a in args))
+    return "%s (%u) %s: %s" % (letter, time_ms, entry["tag"],
+                                format_message(entry["format"], args))
+
+
+def decode_read(data):
+    more, dropped = struct.unpack_from("<BI", data, 0)
+    records = []
+    off = READ_HEADER
+    while off + RECORD_HEADER <= len(data):
+        time_ms, mid, level, nargs = struct.unpack_from("<IIBB", data, off)
+        off += RECORD_HEADER
+        args = struct.unpack_from("<%dI" % nargs, data, off)
+        off += 4 * nargs
+        records.append((time_ms, mid, level, args))
+    return more, dropped, records
+
+
+def read_log(link, table, follow, interval, out):
+    capacity, pending, dropped, level = struct.unpack_from("<HHIB", link.request(
+        bytes([OP_INFO])), 0)
+    print("v4log: %d records, %d pending, %d dropped, level %s"
+          % (capacity, pending, dropped, LEVELS[level] if level < len(LEVELS) else level),
+          file=sys.stderr)
+    while True:
+        more = 1
+        while more:
+            more, lost, records = decode_read(link.request(bytes([OP_READ])))
+            if lost != dropped:
+                print("v4log: %d messages dropped (ring full)"
+                      % ((lost - dropped) & 0xFFFFFFFF), file=sys.stderr)
+                dropped = lost
+            for rec in records:
+                print(format_record(table, rec), file=out)
+        out.flush()
+        if not follow:
+            return
+        time.sleep(interval)
+
+
+def main():
+    ap = argparse.ArgumentParser(description="V4 deferred-format log tool")
+    sub = ap.add_subparsers(dest="command", required=True)
+    ex = sub.add_parser("extract", help="Write the message table of the sources")
+    ex.add_argument("paths", nargs="+", help="Source files or directories")
+    ex.add_argument("-o", "--output", help="Table file (default stdout)")
+    rd = sub.add_parser("read", help="Read and format the device log")
+    rd.add_argument("-p", "--port", required=True, help="Serial device or pty")
+    rd.add_argument("--table", help="Message table from extract (default: scan bsp/)")
+    rd.add_argument("--follow", action="store_true", help="Keep reading until Ctrl-C")
+    rd.add_argument("--interval", type=float, default=0.2,
+                    help="Time between reads with --follow (s, default 0.2)")
+    rd.add_argument("--level", choices=LEVELS,
+                    help="Most verbose level the device records from now on")
+    rd.add_argument("--timeout", type=float, default=2.0, help="Response timeout (s)")
+    args = ap.parse_args()
+
+    def warn(msg):
+        print("v4log: " + msg, file=sys.stderr)
+
+    if args.command == "extract":
+        table = extract(args.paths, warn)
+        if args.output:
+            with open(args.output, "w") as f:
+                json.dump(table, f, indent=1, sort_keys=True)
+        else:
+            json.dump(table, sys.stdout, indent=1, sort_keys=True)
+        return
+
+    if args.table:
+        with open(args.table) as f:
+            table = json.load(f)
+    else:
+        bsp = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "bsp")
+        table = extract([os.path.normpath(bsp)], lambda msg: None)
+
+    link = Link(args.port, args.timeout)
+    if args.level:
+        link.request(bytes([OP_LEVEL, LEVELS.index(args.level)]))
+    try:
+        read_log(link, table, args.follow, args.interval, sys.stdout)
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
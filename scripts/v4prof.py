@@ -0,0 +1,237 @@
+#!/usr/bin/env python3
+# Read the V4 VM profiler over V4-link and write folded stacks
+#
+# Talks to a runtime built with the VM profiler (ESP32-C6: CONFIG_V4_PROFILE,
+# POSIX: -DV4_PROFILE=ON) via the PROFILE runtime command (0x41). The output
+# is in the "folded" format read by flamegraph.pl, speedscope and inferno:
+#
+#   task0;BLINK 412
+#   task1;0x00000134 97
+#
+# Usage:
+#   scripts/v4prof.py -p /dev/ttyACM0 --duration 10 > prof.folded
+#   scripts/v4prof.py -p /dev/ttyACM0 --save prof.bin    # raw snapshot
+#   scripts/v4prof.py --load prof.bin --symbols words.map > prof.folded
+#   flamegraph.pl prof.folded > prof.svg
+#
+# A symbol map has one "ADDR NAME" line per word (hex address of the first
+# opcode); a PC is attributed to the closest word at or below it.
+#
+# SPDX-License-Identifier: MIT OR Apache-2.0
+
+import argparse
+import bisect
+import os
+import select
+import struct
+import sys
+import termios
+import time
+
+STX = 0xA5
+CMD_PROFILE = 0x41
+OP_SUMMARY = 0
+OP_OPCODES = 1
+OP_SAMPLES = 2
+OP_RESET = 3
+PAGE_DONE = 0xFFFF
+NO_TASK = 0xFF
+
+
+def crc8(data):
+    crc = 0
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def encode_frame(cmd, payload):
+    body = bytes([len(payload) & 0xFF, len(payload) >> 8, cmd]) + payload
+    return bytes([STX]) + body + bytes([crc8(body)])
+
+
+def split_frames(data):
+    """Split a byte stream into (status, payload) tuples."""
+    frames = []
+    i = 0
+    while i + 5 <= len(data):
+        if data[i] != STX:
+            i += 1
+            continue
+        length = data[i + 1] | (data[i + 2] << 8)
+        end = i + 5 + length
+        if end > len(data):
+            break
+        if crc8(data[i + 1:end - 1]) == data[end - 1]:
+            frames.append((data[i + 3], data[i + 4:end - 1]))
+        i = end
+    return frames
+
+
+class Link:
+    """Request/response V4-link connection over a tty or pty."""
+
+    def __init__(self, path, timeout):
+        self.fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+        attrs = termios.tcgetattr(self.fd)
+        attrs[0] = 0  # iflag
+        attrs[1] = 0  # oflag
+        attrs[2] = termios.CS8 | termios.CREAD | termios.CLOCAL
+        attrs[3] = 0  # lflag (raw)
+        termios.tcsetattr(self.fd, termios.TCSANOW, attrs)
+        termios.tcflush(self.fd, termios.TCIOFLUSH)
+        self.timeout = timeout
+        self.raw = bytearray()
+
+    def request(self, payload):
+        os.write(self.fd, encode_frame(CMD_PROFILE, payload))
+        buf = bytearray()
+        deadline = time.monotonic() + self.timeout
+        while True:
+            remaining = deadline - time.monotonic()
+            if remaining <= 0:
+                sys.exit("v4prof: no response (is the runtime built with V4_PROFILE?)")
+            ready, _, _ = select.select([self.fd], [], [], remaining)
+            if ready:
+                buf += os.read(self.fd, 4096)
+            frames = split_frames(buf)
+            if frames:
+                status, data = frames[0]
+                if status != 0:
+                    sys.exit("v4prof: device answered status 0x%02X" % status)
+                self.raw += encode_frame(status, data)
+                return data
+
+
+def read_snapshot(link):
+    """Fetch summary, opcode pages and sample pages; return their payloads."""
+    payloads = [link.request(bytes([OP_SUMMARY]))]
+    for op in (OP_OPCODES, OP_SAMPLES):
+        start = 0
+        while start != PAGE_DONE:
+            data = link.request(bytes([op]) + struct.pack("<H", start))
+            payloads.append(data)
+            (start,) = struct.unpack_from("<H", data, 0)
+    return payloads
+
+
+def decode_snapshot(payloads):
+    summary = payloads[0]
+    elapsed, period, samples, dropped, current = struct.unpack_from("<IIIIB", summary, 0)
+    tasks = []
+    for off in range(17, len(summary), 13):
+        tasks.append(struct.unpack_from("<BIII", summary, off))
+
+    # Opcode pages come first, each ends the run when "next" is PAGE_DONE
+    opcodes = {}
+    pcs = []
+    section = OP_OPCODES
+    for data in payloads[1:]:
+        (nxt,) = struct.unpack_from("<H", data, 0)
+        if section == OP_OPCODES:
+            for off in range(2, len(data), 5):
+                op, count = struct.unpack_from("<BI", data, off)
+                opcodes[op] = count
+        else:
+            for off in range(2, len(data), 9):
+                pcs.append(struct.unpack_from("<BII", data, off))
+        if nxt == PAGE_DONE:
+            section = OP_SAMPLES
+
+    return {
+        "elapsed_us": elapsed,
+        "sample_period": period,
+        "samples": samples,
+        "dropped": dropped,
+        "current": current,
+        "tasks": tasks,
+        "opcodes": opcodes,
+        "pcs": pcs,
+    }
+
+
+def load_symbols(path):
+    syms = []
+    with open(path) as f:
+        for line in f:
+            parts = line.split()
+            if len(parts) >= 2 and not line.startswith("#"):
+                syms.append((int(parts[0], 16), parts[1]))
+    syms.sort()
+    return syms
+
+
+def symbolize(pc, syms, addrs):
+    i = bisect.bisect_right(addrs, pc) - 1
+    if i < 0:
+        return "0x%08X" % pc
+    return syms[i][1]
+
+
+def print_report(prof, out):
+    elapsed = prof["elapsed_us"]
+    print("window: %.3f s, %d PC samples (1/%d opcodes), %d dropped"
+          % (elapsed / 1e6, prof["samples"], prof["sample_period"], prof["dropped"]),
+          file=out)
+    print("%-6s %12s %7s %10s %12s" % ("task", "run_us", "cpu%", "switches", "preemptions"),
+          file=out)
+    for tid, run_us, switches, preempt in prof["tasks"]:
+        share = 100.0 * run_us / elapsed if elapsed else 0.0
+        print("%-6d %12d %6.1f%% %10d %12d" % (tid, run_us, share, switches, preempt),
+              file=out)
+    total = sum(prof["opcodes"].values())
+    top = sorted(prof["opcodes"].items(), key=lambda kv: -kv[1])[:10]
+    print("opcodes: %d executed, top:" % total, file=out)
+    for op, count in top:
+        print("  0x%02X %12d %6.1f%%" % (op, count, 100.0 * count / total), file=out)
+
+
+def main():
+    ap = argparse.ArgumentParser(description="V4 VM profiler client")
+    ap.add_argument("-p", "--port", help="Serial device or pty of the runtime")
+    ap.add_argument("--load", help="Decode a snapshot saved with --save instead")
+    ap.add_argument("--save", help="Write the raw snapshot (V4-link frames) here")
+    ap.add_argument("--duration", type=float, default=0,
+                    help="Reset counters, wait this many seconds, then read")
+    ap.add_argument("--symbols", help="Word map (ADDR NAME per line)")
+    ap.add_argument("--timeout", type=float, default=2.0,
+                    help="Response timeout (s)")
+    args = ap.parse_args()
+
+    if args.load:
+        with open(args.load, "rb") as f:
+            raw = f.read()
+        payloads = [data for _, data in split_frames(raw)]
+    elif args.port:
+        link = Link(args.port, args.timeout)
+        if args.duration > 0:
+            link.request(bytes([OP_RESET]))
+            time.sleep(args.duration)
+        link.raw.clear()
+        payloads = read_snapshot(link)
+        raw = bytes(link.raw)
+    else:
+        ap.error("one of --port or --load is required")
+
+    if args.save:
+        with open(args.save, "wb") as f:
+            f.write(raw)
+
+    prof = decode_snapshot(payloads)
+    print_report(prof, sys.stderr)
+
+    syms = load_symbols(args.symbols) if args.symbols else []
+    addrs = [a for a, _ in syms]
+    folded = {}
+    for task, pc, count in prof["pcs"]:
+        frame = "task%d" % task if task != NO_TASK else "main"
+        key = "%s;%s" % (frame, symbolize(pc, syms, addrs))
+        folded[key] = folded.get(key, 0) + count
+    for key, count in sorted(folded.items()):
+        print("%s %d" % (key, count))
+
+
+if __name__ == "__main__":
+    main()
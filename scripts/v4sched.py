@@ -0,0 +1,153 @@
+#!/usr/bin/env python3
+# Read task scheduler wakeup latency over V4-link
+#
+# Talks to a runtime built with priority scheduling (ESP32-C6:
+# CONFIG_V4_SCHED_PRIORITY, POSIX: -DV4_SCHED_PRIORITY=ON) via the SCHED
+# runtime command (0x48) and prints, per task priority, how many times a
+# task became ready and how long it waited for the CPU, followed by the
+# state and inherited priority of every task.
+#
+# Usage:
+#   scripts/v4sched.py -p /dev/ttyACM0                 # counters since boot
+#   scripts/v4sched.py -p /dev/ttyACM0 --duration 10   # reset, wait, read
+#   scripts/v4sched.py -p /tmp/v4pty --vm 1            # another pool VM
+#
+# SPDX-License-Identifier: MIT OR Apache-2.0
+
+import argparse
+import os
+import select
+import struct
+import sys
+import termios
+import time
+
+STX = 0xA5
+CMD_SCHED = 0x48
+OP_STATUS = 0
+OP_RESET = 1
+NO_TASK = 0xFF
+STATES = {0: "unused", 1: "ready", 2: "running", 3: "blocked"}
+
+
+def crc8(data):
+    crc = 0
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def encode_frame(cmd, payload):
+    body = bytes([len(payload) & 0xFF, len(payload) >> 8, cmd]) + payload
+    return bytes([STX]) + body + bytes([crc8(body)])
+
+
+def split_frames(data):
+    """Split a byte stream into (status, payload) tuples."""
+    frames = []
+    i = 0
+    while i + 5 <= len(data):
+        if data[i] != STX:
+            i += 1
+            continue
+        length = data[i + 1] | (data[i + 2] << 8)
+        end = i + 5 + length
+        if end > len(data):
+            break
+        if crc8(data[i + 1:end - 1]) == data[end - 1]:
+            frames.append((data[i + 3], data[i + 4:end - 1]))
+        i = end
+    return frames
+
+
+class Link:
+    """Request/response V4-link connection over a tty or pty."""
+
+    def __init__(self, path, timeout):
+        self.fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+        attrs = termios.tcgetattr(self.fd)
+        attrs[0] = 0  # iflag
+        attrs[1] = 0  # oflag
+        attrs[2] = termios.CS8 | termios.CREAD | termios.CLOCAL
+        attrs[3] = 0  # lflag (raw)
+        termios.tcsetattr(self.fd, termios.TCSANOW, attrs)
+        termios.tcflush(self.fd, termios.TCIOFLUSH)
+        self.timeout = timeout
+
+    def request(self, payload):
+        os.write(self.fd, encode_frame(CMD_SCHED, payload))
+        buf = bytearray()
+        deadline = time.monotonic() + self.timeout
+        while True:
+            remaining = deadline - time.monotonic()
+            if remaining <= 0:
+                sys.exit("v4sched: no response (is the runtime built with "
+                         "V4_SCHED_PRIORITY?)")
+            ready, _, _ = select.select([self.fd], [], [], remaining)
+            if ready:
+                buf += os.read(self.fd, 4096)
+            frames = split_frames(buf)
+            if frames:
+                status, data = frames[0]
+                if status != 0:
+                    sys.exit("v4sched: device answered status 0x%02X (no such VM?)"
+                             % status)
+                return data
+
+
+def decode_status(data):
+    current, inheritance, priorities = struct.unpack_from("<BBB", data, 0)
+    off = 3
+    levels = []
+    for prio in range(priorities):
+        slice_ms, wakeups, max_us, avg_us = struct.unpack_from("<HIII", data, off)
+        levels.append((prio, slice_ms, wakeups, max_us, avg_us))
+        off += 14
+    tasks = []
+    while off + 13 <= len(data):
+        tasks.append(struct.unpack_from("<BBBBBII", data, off))
+        off += 13
+    return current, inheritance, levels, tasks
+
+
+def print_status(status):
+    current, inheritance, levels, tasks = status
+    print("priority inheritance %s, running task %s"
+          % ("on" if inheritance else "off",
+             "-" if current == NO_TASK else current))
+    print("%4s %8s %10s %10s %10s" % ("prio", "slice", "wakeups", "max_us", "avg_us"))
+    for prio, slice_ms, wakeups, max_us, avg_us in levels:
+        if wakeups == 0:
+            continue
+        print("%4d %8s %10d %10d %10d"
+              % (prio, "%d ms" % slice_ms if slice_ms else "-", wakeups, max_us, avg_us))
+    print("%4s %8s %4s %9s %7s %10s %12s"
+          % ("task", "state", "base", "effective", "mutex", "switches", "preemptions"))
+    for tid, state, base, effective, mutex, switches, preempt in tasks:
+        print("%4d %8s %4d %9d %7s %10d %12d"
+              % (tid, STATES.get(state, "?"), base, effective,
+                 "-" if mutex == NO_TASK else mutex, switches, preempt))
+
+
+def main():
+    ap = argparse.ArgumentParser(description="V4 task scheduler latency client")
+    ap.add_argument("-p", "--port", required=True,
+                    help="Serial device or pty of the runtime")
+    ap.add_argument("--vm", type=int, default=0, help="Pool VM (default 0)")
+    ap.add_argument("--duration", type=float, default=0,
+                    help="Reset counters, wait this many seconds, then read")
+    ap.add_argument("--timeout", type=float, default=2.0,
+                    help="Response timeout (s)")
+    args = ap.parse_args()
+
+    link = Link(args.port, args.timeout)
+    if args.duration > 0:
+        link.request(bytes([OP_RESET, args.vm]))
+        time.sleep(args.duration)
+    print_status(decode_status(link.request(bytes([OP_STATUS, args.vm]))))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,419 @@
+#!/usr/bin/env python3
+# Capture the binary event trace over V4-link and convert it for trace viewers
+#
+# Talks to a runtime built with the event trace (ESP32-C6: CONFIG_V4_TRACE,
+# POSIX: -DV4_TRACE=ON) via the TRACE runtime command (0x49). The per-core
+# rings are drained every --interval seconds for --duration seconds, and the
+# records are written as:
+#
+#   perfetto  Chrome JSON trace (ui.perfetto.dev, chrome://tracing): one
+#             process per core, one thread per V4 task with "running" and
+#             SYS call slices, instants for messages, link frames, panics
+#   ctf       CTF 1.8 directory (babeltrace2, Trace Compass): TSDL metadata
+#             and one binary stream per core
+#
+# Usage:
+#   scripts/v4trace.py -p /dev/ttyACM0 --duration 5 -o trace.json
+#   scripts/v4trace.py -p /dev/ttyACM0 --duration 5 --save trace.bin
+#   scripts/v4trace.py --load trace.bin --format ctf -o trace.ctf
+#   scripts/v4trace.py -p /tmp/v4pty --enable 0x07 --clear --duration 1 -o t.json
+#
+# Timestamps are 32-bit on the device; they are unwrapped against the clock
+# value of every READ, so the rings must be drained more often than the
+# clock wraps (26 s for a 160 MHz cycle counter, 4.2 s for the POSIX ns
+# clock). --interval defaults to 50 ms.
+#
+# SPDX-License-Identifier: MIT OR Apache-2.0
+
+import argparse
+import json
+import os
+import select
+import struct
+import sys
+import termios
+import time
+
+STX = 0xA5
+CMD_TRACE = 0x49
+OP_INFO = 0
+OP_READ = 1
+OP_ENABLE = 2
+OP_CLEAR = 3
+NO_TASK = 0xFF
+READ_HEADER = 10
+RECORD = 12
+
+# Event types, with the CTF field of each record member (type, name, member)
+TASK_SWITCH, SYS_ENTER, SYS_EXIT, MSG_SEND, MSG_RECV, LINK_RX, LINK_TX, PANIC = range(8)
+EVENTS = [
+    ("task_switch", [("uint8_t", "next_task", "task"),
+                     ("uint8_t", "prev_task", "arg16"),
+                     ("uint8_t", "preempted", "arg")]),
+    ("sys_enter", [("uint8_t", "task", "task"),
+                   ("uint16_t", "sys_id", "arg16")]),
+    ("sys_exit", [("uint8_t", "task", "task"),
+                  ("uint16_t", "sys_id", "arg16"),
+                  ("int32_t", "error", "arg")]),
+    ("msg_send", [("uint8_t", "receiver", "task"),
+                  ("uint16_t", "length", "arg16"),
+                  ("uint32_t", "address", "arg")]),
+    ("msg_recv", [("uint8_t", "receiver", "task"),
+                  ("uint16_t", "length", "arg16"),
+                  ("uint32_t", "address", "arg")]),
+    ("link_rx", [("uint16_t", "command", "arg16"),
+                 ("uint32_t", "payload_length", "arg")]),
+    ("link_tx", [("uint16_t", "status", "arg16"),
+                 ("uint32_t", "frame_length", "arg")]),
+    ("panic", [("uint8_t", "task", "task"),
+               ("uint16_t", "vm", "arg16"),
+               ("int32_t", "error", "arg")]),
+]
+PACK = {"uint8_t": "B", "uint16_t": "H", "uint32_t": "I", "int32_t": "i"}
+
+
+def crc8(data):
+    crc = 0
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def encode_frame(cmd, payload):
+    body = bytes([len(payload) & 0xFF, len(payload) >> 8, cmd]) + payload
+    return bytes([STX]) + body + bytes([crc8(body)])
+
+
+def split_frames(data):
+    """Split a byte stream into (status, payload) tuples."""
+    frames = []
+    i = 0
+    while i + 5 <= len(data):
+        if data[i] != STX:
+            i += 1
+            continue
+        length = data[i + 1] | (data[i + 2] << 8)
+        end = i + 5 + length
+        if end > len(data):
+            break
+        if crc8(data[i + 1:end - 1]) == data[end - 1]:
+            frames.append((data[i + 3], data[i + 4:end - 1]))
+        i = end
+    return frames
+
+
+class Link:
+    """Request/response V4-link connection over a tty or pty."""
+
+    def __init__(self, path, timeout):
+        self.fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+        attrs = termios.tcgetattr(self.fd)
+        attrs[0] = 0  # iflag
+        attrs[1] = 0  # oflag
+        attrs[2] = termios.CS8 | termios.CREAD | termios.CLOCAL
+        attrs[3] = 0  # lflag (raw)
+        termios.tcsetattr(self.fd, termios.TCSANOW, attrs)
+        termios.tcflush(self.fd, termios.TCIOFLUSH)
+        self.timeout = timeout
+        self.raw = bytearray()
+
+    def request(self, payload, keep=True):
+        os.write(self.fd, encode_frame(CMD_TRACE, payload))
+        buf = bytearray()
+        deadline = time.monotonic() + self.timeout
+        while True:
+            remaining = deadline - time.monotonic()
+            if remaining <= 0:
+                sys.exit("v4trace: no response (is the runtime built with V4_TRACE?)")
+            ready, _, _ = select.select([self.fd], [], [], remaining)
+            if ready:
+                buf += os.read(self.fd, 4096)
+            frames = split_frames(buf)
+            if frames:
+                status, data = frames[0]
+                if status != 0:
+                    sys.exit("v4trace: device answered status 0x%02X" % status)
+                if keep:
+                    self.raw += encode_frame(status, data)
+                return data
+
+
+def decode_info(data):
+    cores, ticks_per_us, enabled, capacity = struct.unpack_from("<BIIH", data, 0)
+    rings = [struct.unpack_from("<HI", data, 11 + 6 * i) for i in range(cores)]
+    return {"cores": cores, "ticks_per_us": ticks_per_us, "enabled": enabled,
+            "capacity": capacity, "rings": rings}
+
+
+def decode_read(data):
+    core, more, now, dropped = struct.unpack_from("<BBII", data, 0)
+    records = [struct.unpack_from("<IBBHI", data, off)
+               for off in range(READ_HEADER, len(data) - RECORD + 1, RECORD)]
+    return core, more, now, dropped, records
+
+
+def capture(link, cores, duration, interval):
+    """Drain every ring until --duration has passed (at least once)."""
+    end = time.monotonic() + duration
+    while True:
+        for core in range(cores):
+            more = 1
+            while more:
+                _, more, _, _, _ = decode_read(link.request(bytes([OP_READ, core])))
+        if time.monotonic() >= end:
+            return
+        time.sleep(interval)
+
+
+def decode_capture(payloads):
+    """Return (info, events, dropped per core); events are (t64, core, record)."""
+    info = decode_info(payloads[0])
+    events = []
+    dropped = [0] * info["cores"]
+    now64 = None
+    last_now = 0
+    for data in payloads[1:]:
+        core, _, now, lost, records = decode_read(data)
+        # READs are chronological: one 64-bit clock across them, starting one
+        # wrap in so that records older than the first READ stay positive
+        if now64 is None:
+            now64 = now + (1 << 32)
+        else:
+            now64 += (now - last_now) & 0xFFFFFFFF
+        last_now = now
+        dropped[core] = lost
+        for rec in records:
+            events.append((now64 - ((now - rec[0]) & 0xFFFFFFFF), core, rec))
+    events.sort(key=lambda e: e[0])
+    return info, events, dropped
+
+
+def s32(v):
+    return v - (1 << 32) if v & 0x80000000 else v
+
+
+def task_name(task):
+    return "runtime" if task == NO_TASK else "task%d" % task
+
+
+def to_perfetto(info, events):
+    """Chrome JSON trace events; "X" slices are paired here so drops stay local."""
+    tpu = float(info["ticks_per_us"])
+    t0 = events[0][0] if events else 0
+    out = []
+    threads = set()
+
+    def ts(t):
+        return (t - t0) / tpu
+
+    def thread(core, task):
+        if (core, task) not in threads:
+            threads.add((core, task))
+            out.append({"ph": "M", "name": "thread_name", "pid": core, "tid": task,
+                        "args": {"name": task_name(task)}})
+
+    def instant(t, core, task, name, args):
+        thread(core, task)
+        out.append({"ph": "i", "s": "t", "name": name, "pid": core, "tid": task,
+                    "ts": ts(t), "args": args})
+
+    running = {}  # core -> (task, start)
+    in_sys = {}   # (core, task) -> (id, start)
+    for core in range(info["cores"]):
+        out.append({"ph": "M", "name": "process_name", "pid": core,
+                    "args": {"name": "core%d" % core}})
+    for t, core, (_, typ, task, arg16, arg) in events:
+        if typ == TASK_SWITCH:
+            prev = running.pop(core, None)
+            if prev is not None and prev[0] != NO_TASK:
+                thread(core, prev[0])
+                out.append({"ph": "X", "name": "running", "pid": core, "tid": prev[0],
+                            "ts": ts(prev[1]), "dur": ts(t) - ts(prev[1]),
+                            "args": {"preempted": arg}})
+            running[core] = (task, t)
+        elif typ == SYS_ENTER:
+            in_sys[(core, task)] = (arg16, t)
+        elif typ == SYS_EXIT:
+            start = in_sys.pop((core, task), None)
+            if start is not None and start[0] == arg16:
+                thread(core, task)
+                out.append({"ph": "X", "name": "SYS %d" % arg16, "pid": core,
+                            "tid": task, "ts": ts(start[1]),
+                            "dur": ts(t) - ts(start[1]), "args": {"error": s32(arg)}})
+        elif typ in (MSG_SEND, MSG_RECV):
+            instant(t, core, task, EVENTS[typ][0],
+                    {"length": arg16, "address": "0x%08X" % arg})
+        elif typ == LINK_RX:
+            instant(t, core, NO_TASK, "link_rx 0x%02X" % arg16, {"payload": arg})
+        elif typ == LINK_TX:
+            instant(t, core, NO_TASK, "link_tx", {"status": arg16, "bytes": arg})
+        elif typ == PANIC:
+            instant(t, core, task, "PANIC", {"vm": arg16, "error": s32(arg)})
+    return {"traceEvents": out, "displayTimeUnit": "ns"}
+
+
+def ctf_metadata(info):
+    lines = [
+        "/* CTF 1.8 */",
+        "",
+        "typealias integer { size = 8; align = 8; signed = false; } := uint8_t;",
+        "typealias integer { size = 16; align = 8; signed = false; } := uint16_t;",
+        "typealias integer { size = 32; align = 8; signed = false; } := uint32_t;",
+        "typealias integer { size = 64; align = 8; signed = false; } := uint64_t;",
+        "typealias integer { size = 32; align = 8; signed = true; } := int32_t;",
+        "",
+        "trace {",
+        "  major = 1;",
+        "  minor = 8;",
+        "  byte_order = le;",
+        "  packet.header := struct {",
+        "    uint32_t magic;",
+        "    uint32_t stream_id;",
+        "  };",
+        "};",
+        "",
+        "env {",
+        "  domain = \"v4\";",
+        "  tracer_name = \"v4trace\";",
+        "};",
+        "",
+        "clock {",
+        "  name = v4_clock;",
+        "  freq = %d;" % (info["ticks_per_us"] * 1000000),
+        "  offset = 0;",
+        "};",
+        "",
+        "typealias integer { size = 64; align = 8; signed = false;",
+        "                    map = clock.v4_clock.value; } := v4_clock_t;",
+        "",
+        "stream {",
+        "  id = 0;",
+        "  packet.context := struct {",
+        "    v4_clock_t timestamp_begin;",
+        "    v4_clock_t timestamp_end;",
+        "    uint64_t content_size;",
+        "    uint64_t packet_size;",
+        "    uint64_t events_discarded;",
+        "    uint32_t cpu_id;",
+        "  };",
+        "  event.header := struct {",
+        "    uint8_t id;",
+        "    v4_clock_t timestamp;",
+        "  };",
+        "};",
+    ]
+    for eid, (name, fields) in enumerate(EVENTS):
+        lines += ["", "event {", "  name = \"%s\";" % name, "  id = %d;" % eid,
+                  "  stream_id = 0;", "  fields := struct {"]
+        lines += ["    %s %s;" % (ctype, field) for ctype, field, _ in fields]
+        lines += ["  };", "};"]
+    return "\n".join(lines) + "\n"
+
+
+def ctf_stream(core, events, dropped):
+    """One packet holding every event of @p core."""
+    body = bytearray()
+    begin = end = 0
+    for t, c, (_, typ, task, arg16, arg) in events:
+        if c != core or typ >= len(EVENTS):
+            continue
+        if not body:
+            begin = t
+        end = t
+        members = {"task": task, "arg16": arg16, "arg": arg}
+        fields = EVENTS[typ][1]
+        values = [s32(members[m]) if ctype == "int32_t" else members[m]
+                  for ctype, _, m in fields]
+        fmt = "<BQ" + "".join(PACK[ctype] for ctype, _, _ in fields)
+        body += struct.pack(fmt, typ, t, *values)
+    bits = (8 + 44 + len(body)) * 8  # Packet header, context, events
+    header = struct.pack("<II", 0xC1FC1FC1, 0)
+    context = struct.pack("<QQQQQI", begin, end, bits, bits, dropped, core)
+    return header + context + bytes(body)
+
+
+def write_ctf(path, info, events, dropped):
+    os.makedirs(path, exist_ok=True)
+    with open(os.path.join(path, "metadata"), "w") as f:
+        f.write(ctf_metadata(info))
+    for core in range(info["cores"]):
+        with open(os.path.join(path, "stream_%d" % core), "wb") as f:
+            f.write(ctf_stream(core, events, dropped[core]))
+
+
+def print_summary(info, events, dropped, out):
+    tpu = info["ticks_per_us"]
+    span = (events[-1][0] - events[0][0]) / tpu if events else 0
+    print("%d cores, %d ticks/us, %d records per ring, event mask 0x%02X"
+          % (info["cores"], tpu, info["capacity"], info["enabled"]), file=out)
+    print("%d events over %.3f ms, %d dropped"
+          % (len(events), span / 1000.0, sum(dropped)), file=out)
+    counts = {}
+    for _, _, rec in events:
+        counts[rec[1]] = counts.get(rec[1], 0) + 1
+    for typ, count in sorted(counts.items()):
+        name = EVENTS[typ][0] if typ < len(EVENTS) else "type%d" % typ
+        print("  %-12s %10d" % (name, count), file=out)
+
+
+def main():
+    ap = argparse.ArgumentParser(description="V4 binary event trace client")
+    ap.add_argument("-p", "--port", help="Serial device or pty of the runtime")
+    ap.add_argument("--load", help="Convert a capture saved with --save instead")
+    ap.add_argument("--save", help="Write the raw capture (V4-link frames) here")
+    ap.add_argument("--duration", type=float, default=1.0,
+                    help="Capture time (s, default 1)")
+    ap.add_argument("--interval", type=float, default=0.05,
+                    help="Time between drains (s, default 0.05)")
+    ap.add_argument("--enable", type=lambda s: int(s, 0),
+                    help="Event mask to record (bit n: event type n)")
+    ap.add_argument("--clear", action="store_true",
+                    help="Discard records buffered before the capture")
+    ap.add_argument("--format", choices=("perfetto", "ctf"), default="perfetto")
+    ap.add_argument("-o", "--output",
+                    help="Output file (perfetto, default stdout) or directory (ctf)")
+    ap.add_argument("--timeout", type=float, default=2.0,
+                    help="Response timeout (s)")
+    args = ap.parse_args()
+
+    if args.load:
+        with open(args.load, "rb") as f:
+            raw = f.read()
+        payloads = [data for _, data in split_frames(raw)]
+        if not payloads:
+            sys.exit("v4trace: %s holds no capture" % args.load)
+    elif args.port:
+        link = Link(args.port, args.timeout)
+        if args.enable is not None:
+            link.request(bytes([OP_ENABLE]) + struct.pack("<I", args.enable), keep=False)
+        if args.clear:
+            link.request(bytes([OP_CLEAR]), keep=False)
+        payloads = [link.request(bytes([OP_INFO]))]
+        capture(link, payloads[0][0], args.duration, args.interval)
+        raw = bytes(link.raw)
+        payloads = [data for _, data in split_frames(raw)]
+    else:
+        ap.error("one of --port or --load is required")
+
+    if args.save:
+        with open(args.save, "wb") as f:
+            f.write(raw)
+
+    info, events, dropped = decode_capture(payloads)
+    print_summary(info, events, dropped, sys.stderr)
+
+    if args.format == "ctf":
+        if not args.output:
+            ap.error("--format ctf needs -o DIRECTORY")
+        write_ctf(args.output, info, events, dropped)
+    elif args.output:
+        with open(args.output, "w") as f:
+            json.dump(to_perfetto(info, events), f)
+    elif not args.save:
+        json.dump(to_perfetto(info, events), sys.stdout)
+
+
+if __name__ == "__main__":
+    main()